@@ -6,14 +6,20 @@
 #include <eepp/graphics/particle.hpp>
 
 #include <eepp/system/time.hpp>
+#include <vector>
 using namespace EE::System;
 
+namespace EE { namespace System {
+class ThreadPool;
+}} // namespace EE::System
+
 namespace EE { namespace Graphics {
 
 class Texture;
 
 /** @enum EE::Graphics::ParticleEffect Predefined effects for the particle system. Use Callback when
- * wan't to create a new effect, o set the parameters using NoFx, but it's much more limited. */
+ * wan't to create a new effect, o set the parameters using NoFx, but it's much more limited.
+ * The Particle passed to the Callback is temporary, see ParticleSystem::setCallbackReset. */
 enum class ParticleEffect : Uint32 {
 	Nofx = 0, //!< User defined effect
 	BlueBall,
@@ -37,7 +43,10 @@ enum class ParticleEffect : Uint32 {
 	Callback //!< Callback defined effect. Set the callback before creating the effect.
 };
 
-/** @brief Basic but powerfull Particle System */
+/** @brief Basic but powerfull Particle System
+**	The particles are stored as a structure of arrays ( positions, speeds, accelerations, colors ),
+**	with the alive particles packed at the beginning, so the update integrates them with SIMD
+**	instructions. The Particle class is only used to reset ( spawn ) a particle. */
 class EE_API ParticleSystem {
   public:
 	typedef cb::Callback2<void, Particle*, ParticleSystem*> ParticleCallback;
@@ -80,6 +89,13 @@ class EE_API ParticleSystem {
 	/** Update the particles effect taking the elapsed time from Engine */
 	void update();
 
+	/** Updates several independent particle systems in parallel using the thread pool.
+	 * The reset callbacks of the systems are called from the worker threads. The predefined
+	 * effects use a random generator per system, so they don't share any state.
+	 * @param pool The thread pool, if NULL the systems are updated from the calling thread. */
+	static void update( const std::vector<ParticleSystem*>& systems, const Time& time,
+						ThreadPool* pool );
+
 	/** Stop using the effect but wait to end the animation */
 	void end();
 
@@ -120,7 +136,11 @@ class EE_API ParticleSystem {
 	const Vector2f& getPosition2() const;
 
 	/** Set a callback function for the reset effect of the particles. \n The reset it's where do
-	 * you create the effect for every single particle. */
+	 * you create the effect for every single particle. \n The Particle received is temporary: it
+	 * holds the current state of the particle being reset ( id, position, speed, acceleration,
+	 * color and alpha decay ), and the values set on it are copied back into the system after the
+	 * callback returns. Don't keep the pointer. The particle size isn't kept per particle, every
+	 * particle is drawn with the size of the system. */
 	void setCallbackReset( const ParticleCallback& pc );
 
 	/** @return The effect blend mode */
@@ -153,11 +173,26 @@ class EE_API ParticleSystem {
 	/** Set The Acceleration of the effect */
 	void setAcceleration( const Vector2f& acc );
 
+	/** @return The number of particles of the effect */
+	const Uint32& getCount() const;
+
+	/** @return The number of particles alive */
+	const Uint32& getAliveCount() const;
+
   private:
-	Particle* mParticle;
+	// The particles from 0 to mAlive are alive. On the last loop the dead particles are swapped
+	// with the last alive particle instead of being reset.
+	std::vector<Vector2f> mPositions;
+	std::vector<Vector2f> mSpeeds;
+	std::vector<Vector2f> mAccelerations;
+	std::vector<ColorAf> mColors;
+	std::vector<Float> mAlphas;
+	std::vector<Float> mAlphaDecays;
+	std::vector<Uint32> mIds;
+	Particle mSpawn;
 	Uint32 mPCount;
+	Uint32 mAlive;
 	const Texture* mTexture;
-	Uint32 mPLeft;
 	Uint32 mLoops;
 
 	ParticleEffect mEffect;
@@ -180,9 +215,21 @@ class EE_API ParticleSystem {
 	bool mLoop;
 	bool mUsed;
 	bool mPointsSup;
+	// The random generator state of the effects, every system keeps its own so the systems can be
+	// updated in parallel.
+	Uint32 mRandState;
 
 	void begin();
 
+	/** @return A random number between fMin and fMax from the generator of the system. */
+	Float randf( const Float& fMin = 0.0f, const Float& fMax = 1.0f );
+
+	/** Resets the particle at the index. */
+	void spawn( const Uint32& index );
+
+	/** Swaps the particles at the indexes. */
+	void swap( const Uint32& a, const Uint32& b );
+
 	virtual void reset( Particle* P );
 
 	ParticleCallback mPC;
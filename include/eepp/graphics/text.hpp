@@ -150,12 +150,26 @@ class EE_API Text {
 	/** Sets text background color. */
 	void setBackgroundColor( const Color& backgroundColor );
 
-  protected:
 	struct VertexCoords {
 		Vector2f texCoords;
 		Vector2f position;
 	};
 
+	/** Appends the text geometry translated by offset and its colors to the arrays.
+	**	Texts that share the font and the character size can be drawn with a single draw call
+	**	with drawGeometry. Shadows and outlines are not included. */
+	void appendGeometry( std::vector<VertexCoords>& vertices, std::vector<Color>& colors,
+						 const Vector2f& offset = Vector2f::Zero );
+
+	/** @return The font texture used to draw the text. */
+	Texture* getFontTexture() const;
+
+	/** Draws the geometry created with appendGeometry at the position. */
+	static void drawGeometry( Texture* texture, const std::vector<VertexCoords>& vertices,
+							  const std::vector<Color>& colors, const Vector2f& position,
+							  BlendMode effect = BlendAlpha );
+
+  protected:
 	String mString;			///< String to display
 	Font* mFont;			///< FontTrueType used to display the string
 	unsigned int mFontSize; ///< Base size of characters, in pixels
@@ -120,7 +120,11 @@ enum EE_MAP_FLAGS {
 	( MAP_FLAG_LIGHTS_ENABLED | MAP_FLAG_LIGHTS_BYVERTEX | MAP_FLAG_CLAMP_BORDERS | \
 	  MAP_FLAG_CLIP_AREA | MAP_FLAG_DRAW_GRID | MAP_FLAG_DRAW_BACKGROUND )
 
-enum EE_LAYER_FLAGS { LAYER_FLAG_VISIBLE = ( 1 << 0 ), LAYER_FLAG_LIGHTS_ENABLED = ( 1 << 1 ) };
+enum EE_LAYER_FLAGS {
+	LAYER_FLAG_VISIBLE = ( 1 << 0 ),
+	LAYER_FLAG_LIGHTS_ENABLED = ( 1 << 1 ),
+	LAYER_FLAG_BATCHED = ( 1 << 2 )
+};
 
 }} // namespace EE::Maps
 
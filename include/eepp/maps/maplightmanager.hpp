@@ -4,11 +4,17 @@
 #include <eepp/maps/base.hpp>
 #include <eepp/maps/maplight.hpp>
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace EE { namespace Maps {
 
 class TileMap;
 
+/** @brief Computes the light colors of the tiles of a map.
+**	The lights are indexed in a grid of cells of tiles. Every update only the colors of the visible
+**	tiles covered by a light that was added, removed, moved or modified since the last update are
+**	recomputed, from the lights that cover their cell. */
 class EE_API MapLightManager {
   public:
 	typedef std::list<MapLight*> LightsList;
@@ -39,12 +45,40 @@ class EE_API MapLightManager {
 
 	MapLight* getLightOver( const Vector2f& OverPos, MapLight* LightCurrent = NULL );
 
+	/** Forces the recomputation of the colors of every tile. */
+	void invalidate();
+
   protected:
+	/** The state of a light on the last update. */
+	struct LightState {
+		MapLight* light;
+		Uint32 index;
+		Uint32 generation;
+		Rectf aabb;
+		Float radius;
+		RGB color;
+		MapLightType type;
+		bool active;
+		bool indexed;
+	};
+
 	TileMap* mMap;
 	Int32 mNumVertex;
-	Color**** mTileColors;
 	LightsList mLights;
 	bool mIsByVertex;
+	// The colors are computed on points, the corners of the tiles when the colors are by vertex
+	// ( shared by the neighbor tiles ) or the center of the tiles.
+	Sizei mPointsSize;
+	Vector2f mPointsOffset;
+	std::vector<Color> mColors;
+	std::vector<Uint8> mDirty;
+	Sizei mCellsSize;
+	std::vector<Uint32> mCellsDirtyCount;
+	// The lights covering every cell, in the order of the lights list.
+	std::vector<std::vector<LightState*>> mCells;
+	std::unordered_map<MapLight*, LightState> mLightStates;
+	Uint32 mGeneration;
+	Color mBaseColor;
 
 	void allocateColors();
 
@@ -55,6 +89,22 @@ class EE_API MapLightManager {
 	virtual void updateByVertex();
 
 	virtual void updateByTile();
+
+	/** Finds the lights added, removed or modified and invalidates the points they cover. */
+	void syncLights();
+
+	/** Recomputes the invalid points in the range. */
+	void updatePoints( const Vector2i& start, const Vector2i& end );
+
+	Color computePoint( const Int32& x, const Int32& y );
+
+	bool getPointsRange( const Rectf& aabb, Vector2i& start, Vector2i& end );
+
+	void invalidatePoints( const Rectf& aabb );
+
+	void addToCells( LightState* state );
+
+	void removeFromCells( LightState* state );
 };
 
 }} // namespace EE::Maps
@@ -3,11 +3,26 @@
 
 #include <eepp/maps/gameobject.hpp>
 #include <eepp/maps/maplayer.hpp>
+#include <map>
+
+namespace EE { namespace Graphics {
+class Texture;
+class TextureRegion;
+class VertexBuffer;
+}} // namespace EE::Graphics
 
 namespace EE { namespace Maps {
 
+class GameObjectTextureRegion;
+
 class EE_API TileMapLayer : public MapLayer {
   public:
+	/** The tiles are stored in square chunks of ChunkSize x ChunkSize tiles.
+	 * The texture region tiles loaded from a map file are stored as a compact tile id ( the
+	 * texture region and the game object flags ), without a GameObject. Any other tile, and the
+	 * tiles added with addGameObject, are stored as its GameObject. */
+	static const Int32 ChunkSize = 32;
+
 	virtual ~TileMapLayer();
 
 	virtual void draw( const Vector2f& Offset = Vector2f( 0, 0 ) );
@@ -20,6 +35,8 @@ class EE_API TileMapLayer : public MapLayer {
 
 	virtual void moveTileObject( const Vector2i& FromPos, const Vector2i& ToPos );
 
+	/** @return The game object of the tile. A compact tile is converted into a GameObject the
+	 * first time is requested, so the object can be modified and kept as any other tile. */
 	virtual GameObject* getGameObject( const Vector2i& TilePos );
 
 	const Vector2i& getCurrentTile() const;
@@ -28,12 +45,60 @@ class EE_API TileMapLayer : public MapLayer {
 
 	Vector2f getPosFromTilePos( const Vector2i& TilePos );
 
+	/** Enables the batched rendering of the layer.
+	 * The static texture region tiles of every chunk are kept in a vertex buffer per texture, that
+	 * is rebuilt only when a tile of the chunk changes, so the visible chunks are drawn with a few
+	 * draw calls. The other tiles are drawn one by one, keeping the column by column order of
+	 * the tiles inside a chunk. The chunks are drawn one after another, so a tile bigger than the
+	 * map tile size can overlap the tiles of its neighbour chunks in a different order than when
+	 * the layer isn't batched. Tiles are drawn one by one while the lights are enabled for the
+	 * layer. */
+	void setBatched( const bool& batched );
+
+	bool isBatched();
+
+	/** Must be called after modifying a tile game object in place ( i.e. changing its flags or
+	 * its texture region ), so the batch of its chunk is rebuilt. */
+	void invalidateTile( const Vector2i& TilePos );
+
+	/** @return The number of chunks with at least one tile. */
+	Uint32 getChunkCount() const;
+
   protected:
 	friend class TileMap;
-
-	GameObject*** mTiles;
+	friend class GameObject;
+
+	// A compact tile keeps the index + 1 of its texture region in mRegions in the low 24 bits
+	// and the game object flags in the high 8 bits. 0 is an empty tile.
+	static const Uint32 TileRegionMask = 0x00FFFFFF;
+	static const Uint32 TileFlagsShift = 24;
+	// The tile is stored as a GameObject in Chunk::objects.
+	static const Uint32 ObjectTile = 0xFFFFFFFF;
+
+	// A run of consecutive batched tiles with the same texture, or a single tile drawn by its
+	// game object when vertexBuffer is NULL.
+	struct Batch {
+		Texture* texture;
+		VertexBuffer* vertexBuffer;
+		Uint16 tile;
+	};
+
+	struct Chunk {
+		// Column-major, the tiles are visited column by column.
+		Uint32 tiles[ChunkSize * ChunkSize];
+		Uint32 count;
+		bool dirty;
+		std::map<Uint16, GameObject*> objects;
+		std::vector<Batch> batches;
+	};
+
+	std::vector<Chunk*> mChunks;
+	Sizei mChunksSize;
 	Sizei mSize;
 	Vector2i mCurTile;
+	std::vector<TextureRegion*> mRegions;
+	std::map<TextureRegion*, Uint32> mRegionIds;
+	GameObjectTextureRegion* mTileObject;
 
 	TileMapLayer( TileMap* map, Sizei size, Uint32 flags, std::string name = "",
 				  Vector2f offset = Vector2f( 0, 0 ) );
@@ -41,6 +106,27 @@ class EE_API TileMapLayer : public MapLayer {
 	void allocateLayer();
 
 	void deallocateLayer();
+
+	Chunk* getChunk( const Int32& x, const Int32& y ) const;
+
+	/** Adds a texture region tile as a compact tile.
+	 * @return False if the tile can't be stored compacted ( unknown texture region or flags that
+	 * don't fit ), and must be added as a game object. */
+	bool addTile( const Vector2i& TilePos, const Uint32& RegionId, const Uint32& Flags );
+
+	/** @return The game object of the tile, for a compact tile a shared game object that is
+	 * valid until the next call. */
+	GameObject* findTile( const Int32& x, const Int32& y );
+
+	GameObject* getTileObject( Chunk* chunk, const Uint16& index, const Int32& x, const Int32& y );
+
+	void setTile( const Vector2i& TilePos, const Uint32& tile, GameObject* obj = NULL );
+
+	void clearBatches( Chunk* chunk );
+
+	void buildBatches( Chunk* chunk, const Int32& cx, const Int32& cy );
+
+	void drawBatched( const Vector2i& start, const Vector2i& end );
 };
 
 }} // namespace EE::Maps
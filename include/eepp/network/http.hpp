@@ -5,24 +5,36 @@
 #include <eepp/core/noncopyable.hpp>
 #include <eepp/network/ipaddress.hpp>
 #include <eepp/network/tcpsocket.hpp>
+#include <eepp/network/udpsocket.hpp>
 #include <eepp/network/uri.hpp>
 #include <eepp/system/lock.hpp>
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/thread.hpp>
 #include <eepp/system/threadlocalptr.hpp>
 #include <eepp/system/time.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace EE { namespace System {
 class IOStream;
+class ThreadPool;
 }} // namespace EE::System
 
 using namespace EE::System;
 
 namespace EE { namespace Network {
 
+namespace Private {
+class HttpResponseParser;
+}
+
 /** @brief A HTTP client */
 class EE_API Http : NonCopyable {
   public:
@@ -136,6 +148,7 @@ class EE_API Http : NonCopyable {
 
 	  private:
 		friend class Http;
+		friend class Private::HttpResponseParser;
 
 		/** @brief Construct the header from a response string
 		**  This function is used by Http to build the response
@@ -143,12 +156,6 @@ class EE_API Http : NonCopyable {
 		**  @param data Content of the response to parse */
 		void parse( const std::string& data );
 
-		/** @brief Read values passed in the answer header
-		**  This function is used by Http to extract values passed
-		**  in the response.
-		**  @param in String stream containing the header values */
-		void parseFields( std::istream& in );
-
 		// Member data
 		FieldTable mFields;			///< Fields of the header
 		Status mStatus;				///< Status code
@@ -332,6 +339,16 @@ class EE_API Http : NonCopyable {
 		/** @return If must continue a download previously started. */
 		const bool& isContinue() const;
 
+		/** @brief Sets the number of ranges of a file downloaded in parallel.
+		**  Only used when downloading to a file path ( downloadRequest with a path ) and the
+		**  server accepts byte ranges. The file is split in up to that many ranges, each one
+		**  fetched from its own connection and written at its offset of the file. Resumed
+		**  downloads and small files are downloaded over a single connection. Default: 1. */
+		void setSegments( const unsigned int& segments );
+
+		/** @return The number of ranges of a file downloaded in parallel. */
+		const unsigned int& getSegments() const;
+
 		// Types
 		typedef std::map<std::string, std::string> FieldTable;
 
@@ -359,6 +376,7 @@ class EE_API Http : NonCopyable {
 		bool mFollowRedirect;		///< Follows redirect response codes
 		bool mCompressedResponse;	///< Request comrpessed response
 		bool mContinue;				///< Resume download
+		unsigned int mSegments;		///< Ranges downloaded in parallel
 		mutable bool mCancel;		///< Cancel state of current request
 		ProgressCallback mProgressCallback;		///< Progress callback
 		unsigned int mMaxRedirections;			///< Maximun number of redirections allowed
@@ -454,21 +472,21 @@ class EE_API Http : NonCopyable {
 	typedef std::function<void( const Http&, Http::Request&, Http::Response& )>
 		AsyncResponseCallback;
 
-	/** @brief Sends the request and creates a new thread, when got the response informs the result
+	/** @brief Queues the request in the async client, when got the response informs the result
 	 *to the callback. *	This function does not lock the caller thread.
-	 **  @see sendRequest */
+	 **  @see sendRequest, setAsyncClient */
 	void sendAsyncRequest( const AsyncResponseCallback& cb, const Http::Request& request,
 						   Time timeout = Time::Zero );
 
-	/** @brief Sends the request and creates a new thread, when got the response informs the result
+	/** @brief Queues the request in the async client, when got the response informs the result
 	 *to the callback. *	This function does not lock the caller thread.
-	 **  @see downloadRequest */
+	 **  @see downloadRequest, setAsyncClient */
 	void downloadAsyncRequest( const AsyncResponseCallback& cb, const Http::Request& request,
 							   IOStream& writeTo, Time timeout = Time::Zero );
 
-	/** @brief Sends the request and creates a new thread, when got the response informs the result
+	/** @brief Queues the request in the async client, when got the response informs the result
 	 *to the callback. *	This function does not lock the caller thread.
-	 **  @see downloadRequest */
+	 **  @see downloadRequest, setAsyncClient */
 	void downloadAsyncRequest( const AsyncResponseCallback& cb, const Http::Request& request,
 							   std::string writePath, Time timeout = Time::Zero );
 
@@ -552,6 +570,112 @@ class EE_API Http : NonCopyable {
 		std::map<std::string, std::string> mParams;
 	};
 
+	/** @brief A cache of HTTP responses.
+	 * Keeps the responses to the GET requests in memory ( least recently used responses are
+	 * evicted first ) and optionally in a content addressed store on disk, so they survive
+	 * between runs. The Cache-Control, Expires, ETag and Last-Modified fields are honored: fresh
+	 * responses are served without touching the network, and stale responses are revalidated
+	 * with If-None-Match / If-Modified-Since requests. The responses to requests with an
+	 * Authorization field are only stored when marked as Cache-Control: public.
+	 * The cache is opt-in: set it to a client ( Http::setCache ) or to a pool of clients
+	 * ( Pool::setCache ). Only the requests sent with sendRequest use the cache.
+	 */
+	class EE_API Cache : NonCopyable {
+	  public:
+		struct Metrics {
+			Uint64 hits{ 0 };		   ///< Requests served without touching the network
+			Uint64 revalidations{ 0 }; ///< Stale responses validated by the server
+			Uint64 misses{ 0 };		   ///< Requests answered with a new response
+			Uint64 stores{ 0 };		   ///< Responses stored in memory or on disk
+			Uint64 bytesSaved{ 0 };	   ///< Bytes of the bodies served from the cache
+		};
+
+		/** @param diskPath The directory of the disk store. An empty path means a memory only
+		 * cache.
+		 * @param maxMemorySize The maximum size of the bodies kept in memory.
+		 * @param maxDiskSize The maximum size of the bodies kept on disk. */
+		Cache( const std::string& diskPath = "", Uint64 maxMemorySize = 16 * 1024 * 1024,
+			   Uint64 maxDiskSize = 256 * 1024 * 1024 );
+
+		~Cache();
+
+		const std::string& getDiskPath() const;
+
+		void setMaxMemorySize( Uint64 maxMemorySize );
+
+		Uint64 getMaxMemorySize() const;
+
+		void setMaxDiskSize( Uint64 maxDiskSize );
+
+		Uint64 getMaxDiskSize() const;
+
+		/** @return The size of the bodies kept in memory. */
+		Uint64 getMemorySize() const;
+
+		/** @return The size of the bodies kept on disk. */
+		Uint64 getDiskSize();
+
+		Metrics getMetrics() const;
+
+		void resetMetrics();
+
+		/** Removes every response from the memory and the disk. */
+		void clear();
+
+		/** Removes the response of an URL ( scheme + host + port + path and query ). */
+		void remove( const URI& uri );
+
+		/** @brief Sends the request through the cache.
+		 * Requests that can't be cached ( not GET requests, ranges, requests with a body or with
+		 * Cache-Control: no-store ) are sent as usual. */
+		Response sendRequest( Http& http, const Request& request, Time timeout = Time::Zero );
+
+	  protected:
+		struct Entry;
+		typedef std::list<std::shared_ptr<Entry>> EntryList;
+
+		mutable std::mutex mMutex;
+		std::string mDiskPath;
+		Uint64 mMaxMemorySize;
+		Uint64 mMaxDiskSize;
+		Uint64 mMemorySize;
+		Uint64 mDiskSize;
+		bool mDiskSizeKnown;
+		EntryList mEntries; ///< Most recently used first
+		std::unordered_map<std::string, EntryList::iterator> mEntriesMap;
+		Metrics mMetrics;
+
+		static bool isCacheable( const Request& request );
+
+		static std::string getKey( const std::string& scheme, const std::string& host,
+								   unsigned short port, const std::string& path );
+
+		std::shared_ptr<Entry> find( const std::string& key );
+
+		std::shared_ptr<Entry> store( const std::string& key, const Response& response,
+									  Int64 now );
+
+		void revalidated( const std::shared_ptr<Entry>& entry, const Response& response,
+						  Int64 now );
+
+		/** @return If the entry is kept in memory. */
+		bool insert( const std::shared_ptr<Entry>& entry );
+
+		void erase( const std::string& key );
+
+		void evictMemory();
+
+		std::string getEntryPath( const std::string& key ) const;
+
+		std::string getObjectPath( const std::string& hash ) const;
+
+		std::shared_ptr<Entry> readEntry( const std::string& key );
+
+		bool writeEntry( const Entry& entry );
+
+		void evictDisk();
+	};
+
 	/** HTTP Client Pool.
 	 * Will keep the instances of the HTTP clients until the Pool is destroyed.
 	 * Acts as a host client cache.
@@ -582,14 +706,189 @@ class EE_API Http : NonCopyable {
 		 */
 		Http* get( const URI& host, const URI& proxy = URI() );
 
+		/** Sets the response cache used by the clients of the pool ( NULL to disable it ). The
+		 * cache must outlive the pool. */
+		void setCache( Cache* cache );
+
+		Cache* getCache() const;
+
 	  protected:
 		std::map<Uint32, Http*> mHttps;
+		Cache* mCache;
 
 		static std::string getHostKey( const URI& host, const URI& proxy );
 
 		static String::HashType getHostHash( const URI& host, const URI& proxy );
 	};
 
+	/** @brief Runs the async requests of many HTTP clients from a single I/O thread.
+	 * Plain HTTP requests are multiplexed over non-blocking sockets: the connections are kept
+	 * alive and reused, the number of connections per host is limited and requests to the same
+	 * host can be pipelined. Requests that can't be run by the I/O loop ( HTTPS, proxied requests
+	 * and resumed downloads ) are run by a bounded pool of blocking workers, once every worker is
+	 * busy the next ones wait for a free worker. The host names are resolved by a small pool of
+	 * threads.
+	 * The response callbacks are run by the executor, by default from the I/O thread.
+	 * The threads are only started once the first request is queued.
+	 */
+	class EE_API AsyncClient : NonCopyable {
+	  public:
+		/** Runs a response callback. It can run it right away or queue it to be run from
+		 * another thread ( i.e. the main thread ), but it must always run it. */
+		typedef std::function<void( const std::function<void()>& )> Executor;
+
+		/** @returns The reference to the global async client, used by default by every Http
+		 * instance. */
+		static AsyncClient& getGlobal();
+
+		AsyncClient();
+
+		/** Stops the threads. The requests still pending are dropped without calling their
+		 * callbacks. */
+		~AsyncClient();
+
+		/** Sets the executor of the response callbacks.
+		 * For example to run the callbacks from the main thread:
+		 * @code
+		 * client.setExecutor( [sceneNode]( const std::function<void()>& callback ) {
+		 *	sceneNode->runOnMainThread( callback );
+		 * } );
+		 * @endcode
+		 */
+		void setExecutor( const Executor& executor );
+
+		/** Sets the maximum number of simultaneous connections to a host ( 6 by default ). */
+		void setMaxConnectionsPerHost( const Uint32& maxConnections );
+
+		Uint32 getMaxConnectionsPerHost() const;
+
+		/** Sets the maximum number of requests sent through a connection before receiving
+		 * their responses. Only GET and HEAD requests are pipelined, and only through connections
+		 * that the server already kept alive. 1 disables pipelining ( the default ), since many
+		 * servers and proxies don't handle it properly. */
+		void setMaxPipelinedRequests( const Uint32& maxRequests );
+
+		Uint32 getMaxPipelinedRequests() const;
+
+		/** Sets the time that an idle connection is kept open to be reused ( 30 seconds by
+		 * default ). */
+		void setKeepAliveTimeout( const Time& timeout );
+
+		Time getKeepAliveTimeout() const;
+
+		/** Sets the number of threads that resolve the host names ( 2 by default ). Must be set
+		 * before any request is queued. */
+		void setResolverThreads( const Uint32& threads );
+
+		Uint32 getResolverThreads() const;
+
+		/** Sets the number of workers that run the requests that the I/O loop can't run ( HTTPS,
+		 * proxied requests and resumed downloads ), 6 by default. It's the maximum number of
+		 * those requests run at the same time. Must be set before any request is queued. */
+		void setBlockingThreads( const Uint32& threads );
+
+		Uint32 getBlockingThreads() const;
+
+		/** @return The number of threads started by the client. */
+		Uint32 getThreadCount() const;
+
+		/** @return The number of requests queued or being processed. */
+		size_t getPendingRequestsCount() const;
+
+		/** @return The number of connections open by the I/O loop. */
+		size_t getConnectionsCount() const;
+
+	  protected:
+		friend class Http;
+
+		struct Task;
+		struct Host;
+		struct Connection;
+
+		std::unique_ptr<Thread> mThread;
+		std::unique_ptr<ThreadPool> mResolverPool;
+		std::unique_ptr<ThreadPool> mBlockingPool;
+		UdpSocket mWakeSocket;
+		UdpSocket mWakeSender;
+		unsigned short mWakePort;
+		std::atomic<bool> mWakePending;
+		std::atomic<bool> mRunning;
+		mutable std::mutex mMutex;
+		std::vector<std::function<void()>> mPosted;
+		Executor mExecutor;
+		std::map<std::string, Host*> mHosts;
+		std::atomic<size_t> mPendingCount;
+		std::atomic<size_t> mConnectionsCount;
+		std::atomic<Uint32> mMaxConnectionsPerHost;
+		std::atomic<Uint32> mMaxPipelinedRequests;
+		std::atomic<Int64> mKeepAliveTimeout;
+		Uint32 mResolverThreads;
+		Uint32 mBlockingThreads;
+
+		void request( Http* http, const AsyncResponseCallback& cb, const Http::Request& request,
+					  IOStream* writeTo, bool streamOwned, Time timeout );
+
+		void start();
+
+		ThreadPool& resolverPool();
+
+		ThreadPool& blockingPool();
+
+		void post( const std::function<void()>& func );
+
+		void wake();
+
+		void run();
+
+		void runBlocking( Task* task );
+
+		void enqueue( Task* task, const std::string& hostName, unsigned short port );
+
+		void resolve( Host* host );
+
+		void dispatch( Host* host );
+
+		void openConnection( Host* host, Task* task );
+
+		void sendTask( Connection* connection, Task* task );
+
+		bool finishConnect( Connection* connection );
+
+		bool flush( Connection* connection );
+
+		bool read( Connection* connection );
+
+		bool processInput( Connection* connection, const char* data, std::size_t size );
+
+		void headerReceived( Connection* connection );
+
+		void finishResponse( Connection* connection );
+
+		void redirect( Connection* connection, Task* task );
+
+		void closeConnection( Connection* connection );
+
+		Time checkTimeouts();
+
+		void complete( Task* task );
+
+		void finishTask( Task* task );
+	};
+
+	/** Sets the async client that runs the async requests of this client. By default the global
+	 * async client is used. Must be set before any async request is sent. */
+	void setAsyncClient( AsyncClient* asyncClient );
+
+	/** @return The async client that runs the async requests of this client. */
+	AsyncClient* getAsyncClient() const;
+
+	/** Sets the response cache used by sendRequest ( NULL to disable it ). The cache must
+	 * outlive the client. */
+	void setCache( Cache* cache );
+
+	/** @return The response cache used by the client. */
+	Cache* getCache() const;
+
 	/** Creates an HTTP Request using the global HTTP Client Pool */
 	static Response
 	request( const URI& uri, Request::Method method = Request::Method::Get,
@@ -637,33 +936,6 @@ class EE_API Http : NonCopyable {
 		const bool& validateCertificate = true, const URI& proxy = URI() );
 
   private:
-	class AsyncRequest : public Thread {
-	  public:
-		AsyncRequest( Http* http, const AsyncResponseCallback& cb, Http::Request request,
-					  Time timeout );
-
-		AsyncRequest( Http* http, const AsyncResponseCallback& cb, Http::Request request,
-					  IOStream& writeTo, Time timeout );
-
-		AsyncRequest( Http* http, const AsyncResponseCallback& cb, Http::Request request,
-					  std::string writePath, Time timeout );
-
-		~AsyncRequest();
-
-		void run();
-
-	  protected:
-		friend class Http;
-		Http* mHttp;
-		AsyncResponseCallback mCb;
-		Http::Request mRequest;
-		Time mTimeout;
-		bool mRunning;
-		bool mStreamed;
-		bool mStreamOwned;
-		IOStream* mStream;
-	};
-
 	class HttpConnection {
 	  public:
 		HttpConnection();
@@ -702,18 +974,25 @@ class EE_API Http : NonCopyable {
 		bool mIsKeepAlive;
 	};
 
-	friend class AsyncRequest;
 	ThreadLocalPtr<HttpConnection> mConnection; ///< Connection to the host
 	IpAddress mHost;							///< Web host address
 	std::string mHostName;						///< Web host name
 	unsigned short mPort;						///< Port used for connection with host
-	std::list<AsyncRequest*> mThreads;
-	Mutex mThreadsMutex;
+	AsyncClient* mAsyncClient;
+	Cache* mCache;
+	std::mutex mAsyncMutex;
+	std::condition_variable mAsyncFinished;
+	Uint32 mAsyncCount;
 	bool mIsSSL;
 	bool mHostSolved;
 	URI mProxy;
 
-	void removeOldThreads();
+	void destroyConnection();
+
+	Response sendUncachedRequest( const Request& request, Time timeout );
+
+	Response downloadSegmented( const Request& request, const std::string& writePath,
+								Time timeout );
 
 	Request prepareFields( const Http::Request& request );
 };
@@ -38,6 +38,20 @@ class EE_API SocketSelector {
 	**  @see Add, Clear */
 	void remove( Socket& socket );
 
+	/** @brief Add a socket to the selector to wait until it's ready to send data
+	**  A socket that finished connecting in non-blocking mode is
+	**  ready to send, so this is also used to wait for pending
+	**  connections. A socket can be added to wait for both.
+	**  This function does nothing if the socket is not valid.
+	**  @param socket Reference to the socket to add
+	**  @see removeWrite, isReadyToWrite */
+	void addWrite( Socket& socket );
+
+	/** @brief Stop waiting for a socket to be ready to send data
+	**  @param socket Reference to the socket to remove
+	**  @see addWrite */
+	void removeWrite( Socket& socket );
+
 	/** @brief Remove all the sockets stored in the selector
 	**  This function doesn't destroy any instance, it simply
 	**  removes all the references that the selector has to
@@ -47,8 +61,9 @@ class EE_API SocketSelector {
 
 	/** @brief Wait until one or more sockets are ready to receive
 	**  This function returns as soon as at least one socket has
-	**  some data available to be received. To know which sockets are
-	**  ready, use the isReady function.
+	**  some data available to be received, or one of the sockets
+	**  added with addWrite is ready to send. To know which sockets are
+	**  ready, use the isReady and isReadyToWrite functions.
 	**  If you use a timeout and no socket is ready before the timeout
 	**  is over, the function returns false.
 	**  @param timeout Maximum time to wait, (use Time::Zero for infinity)
@@ -68,6 +83,15 @@ class EE_API SocketSelector {
 	**  @see IsReady */
 	bool isReady( Socket& socket ) const;
 
+	/** @brief Test a socket added with addWrite to know if it is ready to send data
+	**  For a socket that was connecting in non-blocking mode, this
+	**  means that the connection attempt finished ( successfully or
+	**  not ).
+	**  @param socket Socket to test
+	**  @return True if the socket is ready to write, false otherwise
+	**  @see addWrite */
+	bool isReadyToWrite( Socket& socket ) const;
+
 	/** @brief Overload of assignment operator
 	**  @param right Instance to assign
 	**  @return Reference to self */
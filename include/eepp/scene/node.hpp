@@ -488,6 +488,10 @@ class EE_API Node : public Transformable {
 
 	virtual void drawChilds();
 
+	/** @return True if the child can be skipped from drawing because it's outside the visible
+	 * area. */
+	bool isChildCulled( Node* child );
+
 	virtual void onChildCountChange( Node* child, const bool& removed );
 
 	virtual void onAngleChange();
@@ -115,6 +115,17 @@ class EE_API SceneNode : public Node {
 
 	const Float& getDPI() const;
 
+	/** @return The number of nodes drawn in the last frame. */
+	const Uint32& getDrawnNodesCount() const;
+
+	/** @return The number of nodes skipped in the last frame because they were outside of the
+	 * visible area. */
+	const Uint32& getCulledNodesCount() const;
+
+	/** @return The area currently visible while drawing, in world coordinates. Nodes outside this
+	 * area are not drawn. */
+	const Rectf& getCullRect() const;
+
   protected:
 	friend class Node;
 	typedef std::unordered_set<Node*> CloseList;
@@ -142,6 +153,11 @@ class EE_API SceneNode : public Node {
 	std::unordered_set<Node*> mScheduledUpdateRemove;
 	std::unordered_set<Node*> mMouseOverNodes;
 	Float mDPI;
+	std::vector<Rectf> mCullRects;
+	Uint32 mDrawnNodes;
+	Uint32 mCulledNodes;
+	Uint32 mLastDrawnNodes;
+	Uint32 mLastCulledNodes;
 
 	virtual void onSizeChange();
 
@@ -168,6 +184,12 @@ class EE_API SceneNode : public Node {
 	void drawFrameBuffer();
 
 	Sizei getFrameBufferSize();
+
+	/** Pushes the visible area of a clipped node, intersected with the current one unless the
+	 * node is drawn into its own frame buffer. */
+	void pushCullRect( const Rectf& rect, bool intersectCurrent = true );
+
+	void popCullRect();
 };
 
 }} // namespace EE::Scene
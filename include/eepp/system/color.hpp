@@ -88,7 +88,7 @@ template <typename T> class tColor {
 	*/
 	tColor( const tRGB<T>& Col, T a ) : r( Col.r ), g( Col.g ), b( Col.b ), a( a ) {}
 
-	tColor( const tColor<T>& Col ) : Value( Col.Value ) {}
+	tColor( const tColor<T>& Col ) : r( Col.r ), g( Col.g ), b( Col.b ), a( Col.a ) {}
 
 	/** From a 32 bits value with RGBA byte order */
 	tColor( const Uint32& Col ) : Value( BitOp::swapBE32( Col ) ) {}
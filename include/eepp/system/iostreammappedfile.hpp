@@ -0,0 +1,56 @@
+#ifndef EE_SYSTEMCIOSTREAMMAPPEDFILE_HPP
+#define EE_SYSTEMCIOSTREAMMAPPEDFILE_HPP
+
+#include <eepp/system/iostream.hpp>
+#include <string>
+
+namespace EE { namespace System {
+
+/** @brief A read-only file system file stream backed by a memory mapping of the whole file.
+**	The file contents can be accessed directly with getData() without copying them. Pages are
+**	loaded by the operating system on demand, so mapping very large files is cheap. */
+class EE_API IOStreamMappedFile : public IOStream {
+  public:
+	static IOStreamMappedFile* New( const std::string& path );
+
+	/** @brief Maps a file from the file system
+	**	@param path File to map */
+	IOStreamMappedFile( const std::string& path );
+
+	virtual ~IOStreamMappedFile();
+
+	ios_size read( char* data, ios_size size );
+
+	/** The mapping is read-only, nothing is written. */
+	ios_size write( const char* data, ios_size size );
+
+	ios_size seek( ios_size position );
+
+	ios_size tell();
+
+	ios_size getSize();
+
+	bool isOpen();
+
+	void close();
+
+	/** @return The mapped file contents, or NULL if the file is not open. */
+	const char* getData() const;
+
+	/** @return The path of the mapped file */
+	const std::string& getPath() const;
+
+  protected:
+	std::string mPath;
+	const char* mData;
+	ios_size mSize;
+	ios_size mPos;
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	void* mFile;
+	void* mMapping;
+#endif
+};
+
+}} // namespace EE::System
+
+#endif
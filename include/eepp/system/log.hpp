@@ -9,6 +9,12 @@
 
 namespace EE { namespace System {
 
+class Thread;
+
+namespace Private {
+class LogQueue;
+}
+
 /** @brief The reader interface is useful if you want to keep track of what is write in the log, for
  * example for a console. */
 class LogReaderInterface {
@@ -27,7 +33,18 @@ enum class LogLevel : int {
 	Assert,	  ///< Asserted critical condition.
 };
 
-/** @brief Global log file. The engine will log everything in this file. */
+#define EE_LOG_LEVEL_COUNT ( static_cast<int>( LogLevel::Assert ) + 1 )
+
+/** @brief What an asynchronous log does with a message when its queue is full. */
+enum class LogOverflowPolicy {
+	Block, ///< Waits until the writer thread makes room for the message.
+	Drop   ///< Discards the message. The number of discarded messages is logged later.
+};
+
+/** @brief Global log file. The engine will log everything in this file.
+**	By default every write is processed by the calling thread. In asynchronous mode the writes are
+**	queued in a lock-free bounded queue and a background thread writes them to the file, the
+**	console and the readers. In both modes only the tail of the log is kept in memory. */
 class EE_API Log : protected Mutex {
 	SINGLETON_DECLARE_HEADERS( Log )
 
@@ -42,7 +59,7 @@ class EE_API Log : protected Mutex {
 	*/
 	void save( const std::string& filepath = "" );
 
-	/** @brief Writes the text to the log
+	/** @brief Writes the text to the log ( with the overflow policy of LogLevel::Info )
 	**	@param text The text to write */
 	void write( const std::string& text );
 
@@ -70,9 +87,47 @@ class EE_API Log : protected Mutex {
 	/** @brief Writes a formated string to the log */
 	void writef( const char* format, ... );
 
-	/** @returns A copy of the current writed log. */
+	/** @returns A copy of the tail of the current writed log. */
 	std::string getBuffer() const;
 
+	/** @brief Sets the maximum number of bytes of the log kept in memory ( 1 MiB by default ).
+	**	The oldest lines are discarded ( or written to the file if the log is saved ). 0 for no
+	**	limit. */
+	void setBufferLimit( const size_t& bytes );
+
+	/** @return The maximum number of bytes of the log kept in memory. */
+	const size_t& getBufferLimit() const;
+
+	/** @brief Enables or disables the asynchronous mode.
+	**	While enabled the readers and the console output are called from the writer thread. It must
+	**	not be called while other threads are writing to the log.
+	**	@param queueCapacity The maximum number of messages waiting to be written, rounded up to
+	**	a power of two. */
+	void setAsync( const bool& async, const size_t& queueCapacity = 4096 );
+
+	/** @return If the writes are processed by a background thread. */
+	bool isAsync() const;
+
+	/** @brief Sets what to do with the messages of the level when the asynchronous queue is full.
+	**	By default the messages below LogLevel::Warning are dropped and the rest block. */
+	void setOverflowPolicy( const LogLevel& level, const LogOverflowPolicy& policy );
+
+	/** @return The overflow policy of the level. */
+	const LogOverflowPolicy& getOverflowPolicy( const LogLevel& level ) const;
+
+	/** @return The number of messages dropped because the asynchronous queue was full. */
+	Uint64 getDroppedCount() const;
+
+	/** @brief Waits until every queued message was written and flushes the log file. */
+	void flush();
+
+	/** @brief Rotates the log file when it grows over a size.
+	**	log.log is renamed to log.1.log, log.1.log to log.2.log and so on, the oldest file is
+	**	removed.
+	**	@param maxFileSize The maximum size of the log file in bytes, 0 disables the rotation.
+	**	@param maxFiles The number of rotated files kept. */
+	void setFileRotation( const Uint64& maxFileSize, const Uint32& maxFiles = 4 );
+
 	/** @returns If the log Writes are outputed to the terminal. */
 	const bool& isConsoleOutput() const;
 
@@ -170,13 +225,32 @@ class EE_API Log : protected Mutex {
 	LogLevel mLogLevelThreshold{LogLevel::Notice};
 #endif
 	IOStreamFile* mFS;
+	Uint64 mFileSize{ 0 };
+	Uint64 mMaxFileSize{ 0 };
+	Uint32 mMaxFiles{ 4 };
+	size_t mBufferLimit{ 1024 * 1024 };
+	LogOverflowPolicy mOverflowPolicy[EE_LOG_LEVEL_COUNT];
 	std::list<LogReaderInterface*> mReaders;
+	Private::LogQueue* mQueue{ NULL };
+	Thread* mThread{ NULL };
 
 	void openFS();
 
 	void closeFS();
 
 	void writeToReaders( const std::string& text );
+
+	void dispatch( const LogLevel& level, std::string&& text );
+
+	void process( const std::string& text );
+
+	void appendToBuffer( const std::string& text );
+
+	void writeToFile( const std::string& text );
+
+	void rotateFile();
+
+	void writerThread();
 };
 
 }} // namespace EE::System
@@ -1,6 +1,7 @@
 #ifndef EE_SYSTEM_LUAPATTERNMATCHER_HPP
 #define EE_SYSTEM_LUAPATTERNMATCHER_HPP
 
+#include <bitset>
 #include <eepp/config.hpp>
 #include <string>
 #include <vector>
@@ -115,6 +116,12 @@ class EE_API LuaPattern {
 
 	const std::string& getPatern() const { return mPattern; }
 
+	/** Fills the set of bytes that can start a match of the pattern. Useful to quickly discard
+	 * positions where the pattern can't match without running the matcher.
+	 * @return False if the first byte of a match can't be determined.
+	 */
+	bool getFirstByteSet( std::bitset<256>& set ) const;
+
 	LuaPattern::Match gmatch( const char* s ) &;
 
 	LuaPattern::Match gmatch( const char* s ) &&;
@@ -1,20 +1,33 @@
 #ifndef EE_SYSTEMCRESOURCELOADER
 #define EE_SYSTEMCRESOURCELOADER
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <eepp/core.hpp>
+#include <eepp/system/clock.hpp>
 #include <eepp/system/thread.hpp>
+#include <eepp/system/time.hpp>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace EE { namespace System {
 
+class ThreadPool;
+
 #define THREADS_AUTO ( eeINDEX_NOT_FOUND )
 
-/** @brief A simple resource loader that can load a batch of resources synchronously or
- * asynchronously */
+/** @brief A resource loader that can load a batch of resources synchronously or asynchronously.
+**	Resources can depend on other resources, a resource starts loading once all its dependencies
+**	were loaded, and independent resources are loaded in parallel.
+**	Resources that must be loaded from the main thread ( i.e. uploading the decoded data to the
+**	GPU ) can be added with addMainThread, they are run from update() in bounded batches. */
 class EE_API ResourceLoader {
   public:
 	typedef std::function<void( ResourceLoader* )> ResLoadCallback;
 	typedef std::function<void()> ObjectLoaderTask;
+	typedef Uint32 TaskId;
 
 	/** @param MaxThreads Set the maximun simultaneous threads to load resources, THREADS_AUTO will
 	 * use the cpu number of cores. */
@@ -24,11 +37,17 @@ class EE_API ResourceLoader {
 
 	/** @brief Adds a resource to load.
 	**	Must be called before the loading starts.
-	**	Once an object loader is added to the resource loader, the instance of that object will be
-	*managed and released by the loader. *	@param objectLoaderTask The function callback of the
-	*load process
-	*/
-	void add( const ObjectLoaderTask& objectLoaderTask );
+	**	@param objectLoaderTask The function callback of the load process
+	**	@param dependencies The resources that must be loaded before this one.
+	**	@return The id of the resource task. */
+	TaskId add( const ObjectLoaderTask& objectLoaderTask,
+				const std::vector<TaskId>& dependencies = {} );
+
+	/** @brief Adds a resource to load that must run in the main thread.
+	**	When the loader is threaded these tasks are run from update().
+	**	@see add */
+	TaskId addMainThread( const ObjectLoaderTask& objectLoaderTask,
+						  const std::vector<TaskId>& dependencies = {} );
 
 	/** @brief Starts loading the resources.
 	**	@param callback A callback that is called when the resources finished loading. */
@@ -37,6 +56,11 @@ class EE_API ResourceLoader {
 	/** @brief Starts loading the resources. */
 	void load();
 
+	/** @brief Runs the main thread tasks that are ready to be run.
+	**	Must be called from the main thread while loading, usually once per frame.
+	**	At most getMaxMainThreadTasksPerUpdate tasks are run per call. */
+	void update();
+
 	/** @returns If the resources were loaded. */
 	virtual bool isLoaded();
 
@@ -50,34 +74,83 @@ class EE_API ResourceLoader {
 	**	This must be called before the load starts. */
 	void setThreaded( const bool& setThreaded );
 
+	/** @brief Sets the thread pool used to load the resources.
+	**	By default a thread pool shared by every resource loader is used.
+	**	This must be called before the load starts. */
+	void setThreadPool( std::shared_ptr<ThreadPool> pool );
+
+	const std::shared_ptr<ThreadPool>& getThreadPool() const;
+
+	/** @brief Sets the maximum number of main thread tasks run per update call. 0 means no limit.
+	 */
+	void setMaxMainThreadTasksPerUpdate( const Uint32& maxTasks );
+
+	const Uint32& getMaxMainThreadTasksPerUpdate() const;
+
 	/** @brief Clears the resources added to load that werent loaded, and delete the instances of
 	 * the loaders. */
 	bool clear();
 
-	/** @return The aproximate percent of progress ( between 0 and 100 ) */
+	/** @return The percent of progress ( between 0 and 100 ) */
 	Float getProgress();
 
 	/** @returns The number of resources added to load. */
 	Uint32 getCount() const;
 
+	/** @returns The number of resources already loaded. */
+	Uint32 getLoadedCount() const;
+
+	/** @returns The time spent running the task ( valid once the task was loaded ). */
+	Time getTaskTime( const TaskId& taskId ) const;
+
+	/** @returns The time since the load started until the last resource was loaded. */
+	Time getLoadTime() const;
+
   protected:
-	bool mLoaded;
-	bool mLoading;
+	struct Task {
+		ObjectLoaderTask func;
+		std::vector<TaskId> dependents;
+		Uint32 dependencies{ 0 };
+		Uint32 pendingDependencies{ 0 };
+		bool mainThread{ false };
+		Time time;
+	};
+
+	std::atomic<bool> mLoaded;
+	std::atomic<bool> mLoading;
 	bool mThreaded;
 	Uint32 mThreads;
-	Uint32 mTotalLoaded;
-	Thread mThread;
+	std::atomic<Uint32> mTotalLoaded;
+	Uint32 mMaxMainThreadTasks;
+	std::shared_ptr<ThreadPool> mPool;
+	Clock mLoadClock;
+	Time mLoadTime;
 
 	std::vector<ResLoadCallback> mLoadCbs;
-	std::vector<ObjectLoaderTask> mTasks;
+	std::vector<Task> mTasks;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mTaskFinished;
+	std::deque<TaskId> mReadyTasks;
+	std::deque<TaskId> mReadyMainThreadTasks;
+	Uint32 mRunning;
+	Uint32 mActive;
+	bool mCancelled;
 
 	void setThreads();
 
 	virtual void setLoaded();
 
-	void taskRunner();
+	TaskId addTask( const ObjectLoaderTask& objectLoaderTask,
+					const std::vector<TaskId>& dependencies, bool mainThread );
+
+	void threadedLoad();
 
 	void serializedLoad();
+
+	void dispatch();
+
+	void runTask( const TaskId& taskId );
 };
 
 }} // namespace EE::System
@@ -1,6 +1,7 @@
 #ifndef EE_SYSTEM_THREADPOOL_HPP
 #define EE_SYSTEM_THREADPOOL_HPP
 
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <eepp/core/noncopyable.hpp>
@@ -8,13 +9,45 @@
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/thread.hpp>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <type_traits>
+#include <vector>
 
 namespace EE { namespace System {
 
+/** @brief A token used to cancel work queued in a ThreadPool.
+**	Copies of a token share the same state. Work that was not started when the token is cancelled
+**	is discarded, running work can poll isCancelled() to stop early. */
+class EE_API CancellationToken {
+  public:
+	/** @return A new token that can be cancelled. */
+	static CancellationToken create();
+
+	/** An empty token, it can never be cancelled. */
+	CancellationToken();
+
+	void cancel();
+
+	bool isCancelled() const;
+
+  protected:
+	std::shared_ptr<std::atomic<bool>> mCancelled;
+};
+
+/** @brief A work-stealing thread pool.
+**	Every worker owns its queues. Work queued from a worker goes to its own queue and work queued
+**	from any other thread is distributed between the workers. Idle workers steal work from the
+**	other workers before going to sleep, and interactive work is always taken before background
+**	work. */
 class EE_API ThreadPool : NonCopyable {
   public:
+	enum class Priority {
+		Interactive, //! Work that the user is waiting for.
+		Background	 //! Everything else.
+	};
+
 	static std::shared_ptr<ThreadPool> createShared( Uint32 numThreads );
 
 	static std::unique_ptr<ThreadPool> createUnique( Uint32 numThreads );
@@ -25,21 +58,60 @@ class EE_API ThreadPool : NonCopyable {
 
 	virtual ~ThreadPool();
 
-	void run( const std::function<void()>& func, const std::function<void()>& doneCallback );
+	/** Queues func, doneCallback is called from the worker thread after func is run.
+	**	If the token is cancelled before the work starts neither func nor doneCallback are
+	**	called. */
+	void run( const std::function<void()>& func, const std::function<void()>& doneCallback,
+			  const Priority& priority = Priority::Background,
+			  const CancellationToken& token = CancellationToken() );
+
+	/** Queues func and returns a future for its result.
+	**	If the work is discarded, because the token was cancelled or the pool is being destroyed,
+	**	the future holds a std::future_error with a broken_promise error code. */
+	template <typename F>
+	std::future<typename std::result_of<F()>::type>
+	submit( F func, const Priority& priority = Priority::Background,
+			const CancellationToken& token = CancellationToken() ) {
+		typedef typename std::result_of<F()>::type ResultType;
+		auto task = std::make_shared<std::packaged_task<ResultType()>>( std::move( func ) );
+		std::future<ResultType> future( task->get_future() );
+		run( [task] { ( *task )(); }, nullptr, priority, token );
+		return future;
+	}
+
+	/** Calls func( chunkBegin, chunkEnd ) for consecutive chunks of [begin, end) in parallel and
+	**	waits until every chunk is processed. The calling thread processes chunks too, so it's safe
+	**	to call it from a worker.
+	**	@param grainSize The number of elements of every chunk, 0 to pick one based on the number
+	**	of threads. */
+	void parallelFor( size_t begin, size_t end, const std::function<void( size_t, size_t )>& func,
+					  size_t grainSize = 0, const Priority& priority = Priority::Interactive );
 
 	Uint32 numThreads() const;
 
   private:
 	struct Work {
-		const std::function<void()> func;
-		const std::function<void()> callback;
+		std::function<void()> func;
+		std::function<void()> callback;
+		CancellationToken token;
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Work> work[2];
 	};
 
 	void threadFunc();
 
+	bool popWork( const Uint32& worker, Work& work );
+
 	std::vector<std::unique_ptr<Thread>> mThreads;
-	std::deque<std::unique_ptr<Work>> mWork;
-	bool mShuttingDown = false;
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	std::atomic<Uint32> mNextQueue{ 0 };
+	std::atomic<Uint32> mNextWorker{ 0 };
+	std::atomic<Int64> mPending{ 0 };
+	std::atomic<Uint32> mSleeping{ 0 };
+	std::atomic<bool> mShuttingDown{ false };
 	mutable std::mutex mMutex;
 	std::condition_variable mWorkAvailable;
 };
@@ -146,8 +146,12 @@ class EE_API MediaQueryList {
 
 	bool applyMediaFeatures( const MediaFeatures& features ); // returns true if the isUsed changed
 
+	/** @return The media query list string that was parsed. */
+	const std::string& getQueryString() const;
+
   private:
 	MediaQuery::vector mQueries;
+	std::string mQueryString;
 	bool mUsed;
 };
 
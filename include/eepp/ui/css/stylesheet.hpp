@@ -5,7 +5,9 @@
 #include <eepp/ui/css/keyframesdefinition.hpp>
 #include <eepp/ui/css/mediaquery.hpp>
 #include <eepp/ui/css/stylesheetstyle.hpp>
+#include <eepp/system/threadpool.hpp>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace EE { namespace UI { namespace CSS {
@@ -14,6 +16,10 @@ class EE_API StyleSheet {
   public:
 	StyleSheet();
 
+	StyleSheet( const StyleSheet& styleSheet );
+
+	StyleSheet& operator=( const StyleSheet& styleSheet );
+
 	void addStyle( std::shared_ptr<StyleSheetStyle> node );
 
 	bool isEmpty() const;
@@ -22,9 +28,22 @@ class EE_API StyleSheet {
 
 	void combineStyleSheet( const StyleSheet& styleSheet );
 
+	/** @brief Finds the styles that apply to the element.
+	**	The result is cached by element signature ( tag, id, classes and pseudo classes of the
+	**	element and its ancestors ), so elements with the same signature reuse it without matching
+	**	the selectors again. It's safe to call it from several threads as long as the elements are
+	**	not modified meanwhile. */
 	std::shared_ptr<ElementDefinition> getElementStyles( UIWidget* element,
 														 const bool& applyPseudo = false ) const;
 
+	/** @brief Finds the styles of the elements in parallel, with and without pseudo classes.
+	**	The results are cached, so the following getElementStyles calls for these elements are
+	**	resolved without matching selectors. The elements must not be modified until it returns. */
+	void preloadElementStyles( const std::vector<UIWidget*>& elements, ThreadPool& pool ) const;
+
+	/** @brief Clears the cached element styles. */
+	void invalidateCache();
+
 	const std::vector<std::shared_ptr<StyleSheetStyle>>& getStyles() const;
 
 	bool updateMediaLists( const MediaFeatures& features );
@@ -53,6 +72,19 @@ class EE_API StyleSheet {
 	using ElementDefinitionCache = std::unordered_map<size_t, std::shared_ptr<ElementDefinition>>;
 	mutable ElementDefinitionCache mNodeCache;
 
+	struct SharedStyles {
+		// The matching styles with shareable selectors, in candidate order.
+		StyleSheetStyleVector styles;
+		// If any candidate style isn't shareable the definition must be resolved per element.
+		bool hasUnshareableStyles{ false };
+		std::shared_ptr<ElementDefinition> definition;
+	};
+	using SharedStylesCache = std::unordered_map<size_t, SharedStyles>;
+	mutable SharedStylesCache mSharedStylesCache;
+	mutable std::mutex mCacheMutex;
+
+	static size_t elementSignature( UIWidget* element, const bool& applyPseudo );
+
 	void addMediaQueryList( MediaQueryList::ptr list );
 
 	bool addStyleToNodeIndex( StyleSheetStyle* style );
@@ -45,6 +45,14 @@ class EE_API StyleSheetProperty {
 								 const Uint32& specificity, const bool& isVolatile = false,
 								 const Uint32& index = 0 );
 
+	/** Creates a property from a value already processed by another property ( i.e. restored from
+	 * a compiled layout ), the value is neither cleaned nor checked for !important.
+	 * The value is also pre-parsed ( see asParsedValue ), since a restored property is usually
+	 * applied to many widgets. */
+	explicit StyleSheetProperty( const std::string& name, const PropertyDefinition* definition,
+								 const std::string& value, const Uint32& specificity,
+								 const bool& isImportant, const bool& isVolatile );
+
 	Uint32 getId() const;
 
 	const std::string& getName() const;
@@ -67,6 +75,8 @@ class EE_API StyleSheetProperty {
 
 	const bool& isVolatile() const;
 
+	const bool& isImportant() const;
+
 	void setVolatile( const bool& isVolatile );
 
 	bool operator==( const StyleSheetProperty& property ) const;
@@ -96,6 +106,13 @@ class EE_API StyleSheetProperty {
 
 	Color asColor() const;
 
+	/** Parses the values that the widgets read as a number: the color of a color property, the
+	 * SizePolicy of a layout-width or layout-height keyword and the alignment flags of a
+	 * layout-gravity or a gravity. A gravity also keeps the masks of the alignments it sets
+	 * shifted 16 bits, since it can set only one of them.
+	 * @return False if the value isn't one of them ( i.e. a length or a var() ). */
+	bool asParsedValue( Uint32& value ) const;
+
 	Float asDpDimension( const std::string& defaultValue = "" ) const;
 
 	int asDpDimensionI( const std::string& defaultValue = "" ) const;
@@ -185,6 +202,8 @@ class EE_API StyleSheetProperty {
 	bool mVolatile;
 	bool mImportant;
 	bool mIsVarValue;
+	bool mHasParsedValue;
+	Uint32 mParsedValue;
 	const PropertyDefinition* mPropertyDefinition;
 	const ShorthandDefinition* mShorthandDefinition;
 	std::vector<StyleSheetProperty> mIndexedProperty;
@@ -199,6 +218,7 @@ class EE_API StyleSheetProperty {
 	void createIndexed();
 	void checkVars();
 	std::vector<VariableFunctionCache> checkVars( const std::string& value );
+	bool parseValue( Uint32& value ) const;
 };
 
 typedef std::map<Uint32, StyleSheetProperty> StyleSheetProperties;
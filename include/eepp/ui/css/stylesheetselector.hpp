@@ -30,6 +30,11 @@ class EE_API StyleSheetSelector {
 
 	const bool& isStructurallyVolatile() const;
 
+	/** @return True if the selector only depends on the tag, id, classes and pseudo classes of the
+	 * element and its ancestors. Elements with the same signature share the result of these
+	 * selectors. */
+	const bool& isShareable() const;
+
 	const StyleSheetSelectorRule& getRule( const Uint32& index );
 
 	const std::string& getSelectorId() const;
@@ -42,6 +47,7 @@ class EE_API StyleSheetSelector {
 	std::vector<StyleSheetSelectorRule> mSelectorRules;
 	bool mCacheable;
 	bool mStructurallyVolatile;
+	bool mShareable;
 
 	void addSelectorRule( std::string& buffer,
 						  StyleSheetSelectorRule::PatternMatch& curPatternMatch,
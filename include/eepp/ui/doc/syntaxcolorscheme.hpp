@@ -4,6 +4,7 @@
 #include <eepp/system/color.hpp>
 #include <eepp/system/iostream.hpp>
 #include <eepp/system/pack.hpp>
+#include <eepp/ui/doc/syntaxdefinition.hpp>
 #include <unordered_map>
 #include <vector>
 
@@ -57,6 +58,8 @@ class EE_API SyntaxColorScheme {
 
 	const Style& getSyntaxStyle( const std::string& type ) const;
 
+	const Style& getSyntaxStyle( const SyntaxStyleType& type ) const;
+
 	void setSyntaxStyles( const std::unordered_map<std::string, Style>& styles );
 
 	void setSyntaxStyle( const std::string& type, const Style& style );
@@ -75,8 +78,8 @@ class EE_API SyntaxColorScheme {
 
   protected:
 	std::string mName;
-	std::unordered_map<std::string, Style> mSyntaxColors;
-	std::unordered_map<std::string, Style> mEditorColors;
+	std::unordered_map<SyntaxStyleType, Style> mSyntaxColors;
+	std::unordered_map<SyntaxStyleType, Style> mEditorColors;
 };
 
 }}} // namespace EE::UI::Doc
@@ -1,18 +1,60 @@
 #ifndef EE_UI_DOC_DEFINITION_HPP
 #define EE_UI_DOC_DEFINITION_HPP
 
+#include <bitset>
 #include <eepp/config.hpp>
+#include <eepp/core/string.hpp>
+#include <eepp/system/luapattern.hpp>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace EE { namespace UI { namespace Doc {
 
+/** Interned syntax style type. It's the hash of the style type name ( "normal", "comment", etc ),
+ * so it can be resolved directly by the SyntaxColorScheme without keeping the type name around.
+ */
+typedef String::HashType SyntaxStyleType;
+
+namespace SyntaxStyleTypes {
+constexpr SyntaxStyleType Normal = EE::String::hash( "normal" );
+constexpr SyntaxStyleType Symbol = EE::String::hash( "symbol" );
+constexpr SyntaxStyleType Comment = EE::String::hash( "comment" );
+constexpr SyntaxStyleType Keyword = EE::String::hash( "keyword" );
+constexpr SyntaxStyleType Keyword2 = EE::String::hash( "keyword2" );
+constexpr SyntaxStyleType Number = EE::String::hash( "number" );
+constexpr SyntaxStyleType Literal = EE::String::hash( "literal" );
+constexpr SyntaxStyleType String = EE::String::hash( "string" );
+constexpr SyntaxStyleType Operator = EE::String::hash( "operator" );
+constexpr SyntaxStyleType Function = EE::String::hash( "function" );
+constexpr SyntaxStyleType Link = EE::String::hash( "link" );
+} // namespace SyntaxStyleTypes
+
 struct EE_API SyntaxPattern {
 	std::vector<std::string> patterns;
 	std::string type;
 };
 
+/** A SyntaxPattern prepared for the tokenizer. The start pattern is already anchored and the
+ * set of bytes that can start a match is precomputed, so the tokenizer can discard most
+ * positions without running the pattern matcher. */
+struct EE_API SyntaxPatternProgram {
+	SyntaxPatternProgram( const SyntaxPattern& pattern );
+
+	System::LuaPattern start;
+	System::LuaPattern end;
+	SyntaxStyleType type;
+	std::bitset<256> startSet;
+	std::bitset<256> endSet;
+	/** Escape character ( 0 if the pattern doesn't define one ). */
+	char escape{0};
+	/** The pattern only matches at the beginning of a line. */
+	bool lineStart{false};
+	bool hasStartSet{false};
+	bool hasEndSet{false};
+	bool multiLine{false};
+};
+
 class EE_API SyntaxDefinition {
   public:
 	SyntaxDefinition();
@@ -32,12 +74,18 @@ class EE_API SyntaxDefinition {
 
 	const std::vector<SyntaxPattern>& getPatterns() const;
 
+	/** @return The precompiled patterns, in the same order as getPatterns(). */
+	const std::vector<SyntaxPatternProgram>& getPatternPrograms() const;
+
 	const std::string& getComment() const;
 
 	const std::unordered_map<std::string, std::string>& getSymbols() const;
 
 	std::string getSymbol( const std::string& symbol ) const;
 
+	/** @return The style type of the symbol or 0 if the symbol is not defined. */
+	SyntaxStyleType getSymbolType( const std::string& symbol ) const;
+
 	/** Accepts lua patterns and file extensions. */
 	SyntaxDefinition& addFileType( const std::string& fileType );
 
@@ -65,9 +113,12 @@ class EE_API SyntaxDefinition {
 	std::string mLanguageName;
 	std::vector<std::string> mFiles;
 	std::vector<SyntaxPattern> mPatterns;
+	std::vector<SyntaxPatternProgram> mPatternPrograms;
 	std::unordered_map<std::string, std::string> mSymbols;
 	std::string mComment;
 	std::vector<std::string> mHeaders;
+
+	void compilePatterns();
 };
 
 }}} // namespace EE::UI::Doc
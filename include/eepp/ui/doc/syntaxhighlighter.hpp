@@ -1,9 +1,11 @@
 #ifndef EE_UI_DOC_SYNTAXHIGHLIGHTER_HPP
 #define EE_UI_DOC_SYNTAXHIGHLIGHTER_HPP
 
+#include <eepp/system/threadpool.hpp>
 #include <eepp/ui/doc/syntaxtokenizer.hpp>
 #include <eepp/ui/doc/textdocument.hpp>
 #include <map>
+#include <memory>
 
 namespace EE { namespace UI { namespace Doc {
 
@@ -14,10 +16,14 @@ struct TokenizedLine {
 	int state;
 };
 
+struct SyntaxHighlighterAsyncState;
+
 class EE_API SyntaxHighlighter {
   public:
 	SyntaxHighlighter( TextDocument* doc );
 
+	~SyntaxHighlighter();
+
 	void changeDoc( TextDocument* doc );
 
 	void reset();
@@ -32,12 +38,51 @@ class EE_API SyntaxHighlighter {
 
 	bool updateDirty( int visibleLinesCount = 40 );
 
+	/** Enables the asynchronous highlighting mode. The document is tokenized in batches on the
+	 * thread pool, starting from the first invalid line and up to the end of the document. The
+	 * results are tagged with the document change id and the ones that were computed for a
+	 * previous version of the document are discarded. Passing a nullptr restores the synchronous
+	 * mode.
+	 * Lines of a memory mapped document that weren't decoded yet are highlighted only up to the
+	 * last line requested with getLine, the highlighting resumes once they are decoded. */
+	void setThreadPool( std::shared_ptr<ThreadPool> pool );
+
+	const std::shared_ptr<ThreadPool>& getThreadPool() const;
+
+	bool isAsync() const;
+
+	/** Number of lines tokenized by every asynchronous job. */
+	void setAsyncBatchSize( const Uint32& batchSize );
+
+	const Uint32& getAsyncBatchSize() const;
+
+	/** @return True if an asynchronous job is still running. */
+	bool isAsyncRunning() const;
+
   protected:
 	TextDocument* mDoc;
 	std::map<size_t, TokenizedLine> mLines;
 	Int64 mFirstInvalidLine;
 	Int64 mMaxWantedLine;
+	std::shared_ptr<ThreadPool> mPool;
+	std::shared_ptr<SyntaxHighlighterAsyncState> mAsync;
+	std::shared_ptr<const SyntaxDefinition> mAsyncDefinition;
+	Uint32 mAsyncBatchSize{512};
+	bool mAsyncRunning{false};
+
 	TokenizedLine tokenizeLine( const size_t& line, const int& state );
+
+	int getPrevLineState( const Int64& index ) const;
+
+	bool updateDirtyAsync();
+
+	bool isAsyncLineAvailable( const Int64& index ) const;
+
+	bool applyAsyncResults();
+
+	void dispatchAsyncBatch();
+
+	void cancelAsync();
 };
 
 }}} // namespace EE::UI::Doc
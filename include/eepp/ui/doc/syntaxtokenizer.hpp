@@ -8,15 +8,20 @@
 
 namespace EE { namespace UI { namespace Doc {
 
+/** A token is a span of a line with its syntax style type. start and len are measured in
+ * characters ( unicode code points ) of the line, not in bytes. */
 struct EE_API SyntaxToken {
-	std::string type;
-	std::string text;
+	SyntaxStyleType type;
+	Uint32 start;
+	Uint32 len;
 };
 
 #define SYNTAX_TOKENIZER_STATE_NONE ( -1 )
 
 class EE_API SyntaxTokenizer {
   public:
+	/** Tokenizes an UTF-8 line. startIndex is a byte offset in text, the returned tokens are
+	 * measured in characters from the beginning of text. */
 	std::pair<std::vector<SyntaxToken>, int> static tokenize( const SyntaxDefinition& syntax,
 															  const std::string& text,
 															  const int& state,
@@ -5,13 +5,18 @@
 #include <eepp/system/clock.hpp>
 #include <eepp/system/fileinfo.hpp>
 #include <eepp/system/iostreamfile.hpp>
+#include <eepp/system/iostreammappedfile.hpp>
+#include <eepp/system/mutex.hpp>
 #include <eepp/system/pack.hpp>
+#include <eepp/system/thread.hpp>
 #include <eepp/system/time.hpp>
 #include <eepp/ui/doc/syntaxdefinition.hpp>
 #include <eepp/ui/doc/textdocumentline.hpp>
+#include <eepp/ui/doc/textdocumentlinestore.hpp>
 #include <eepp/ui/doc/textposition.hpp>
 #include <eepp/ui/doc/textrange.hpp>
 #include <eepp/ui/doc/undostack.hpp>
+#include <atomic>
 #include <functional>
 #include <map>
 #include <unordered_set>
@@ -94,7 +99,7 @@ class EE_API TextDocument {
 
 	size_t linesCount() const;
 
-	std::vector<TextDocumentLine>& lines();
+	TextDocumentLineStore& lines();
 
 	bool hasSelection() const;
 
@@ -366,12 +371,38 @@ class EE_API TextDocument {
 
 	bool isSaving() const;
 
+	/** Files with a size equal or greater than the threshold are memory mapped when loaded from
+	 * the file system. Their lines are indexed in a background thread and decoded only when
+	 * accessed. 0 disables it. */
+	void setLazyLoadingThreshold( const size_t& threshold );
+
+	const size_t& getLazyLoadingThreshold() const;
+
+	/** @return If the document lines are still being indexed from a memory mapped file. */
+	bool isIndexing() const;
+
+	/** @return The indexing progress, from 0 to 1. */
+	Float getIndexingProgress() const;
+
+	/** Appends the lines indexed in the background to the document. Must be called from the main
+	 * thread while isIndexing(), usually from the editor update. */
+	void updateIndexing();
+
+	/** Waits for the background indexing to finish and appends the remaining lines. */
+	void finishIndexing();
+
+	/** @return If the line was already decoded from the memory mapped file. */
+	bool isLineLoaded( const size_t& index ) const;
+
+	/** @return If the document has lines that weren't decoded from the memory mapped file. */
+	bool hasUnloadedLines() const;
+
   protected:
 	friend class UndoStack;
 	UndoStack mUndoStack;
 	std::string mFilePath;
 	FileInfo mFileRealPath;
-	std::vector<TextDocumentLine> mLines;
+	TextDocumentLineStore mLines;
 	TextRange mSelection;
 	std::unordered_set<Client*> mClients;
 	LineEnding mLineEnding{ LineEnding::LF };
@@ -394,6 +425,21 @@ class EE_API TextDocument {
 	std::map<std::string, DocumentCommand> mCommands;
 	String mNonWordChars;
 	Client* mActiveClient{ nullptr };
+	size_t mLazyLoadingThreshold{ EE_1MB * 64 };
+	struct MappedLines {
+		size_t offset;
+		size_t size;
+		size_t count;
+	};
+	std::shared_ptr<IOStreamMappedFile> mMappedFile;
+	Thread* mIndexer{ nullptr };
+	Mutex mIndexerMutex;
+	std::vector<MappedLines> mIndexedLines;
+	size_t mIndexerOffset{ 0 };
+	std::atomic<size_t> mIndexedBytes{ 0 };
+	std::atomic<bool> mIndexing{ false };
+	std::atomic<bool> mIndexerDone{ false };
+	std::atomic<bool> mIndexerCancel{ false };
 
 	void initializeCommands();
 
@@ -431,6 +477,16 @@ class EE_API TextDocument {
 	void guessIndentType();
 
 	bool loadFromStream( IOStream& file, std::string path, bool callReset );
+
+	bool loadFromMappedFile( const std::string& path, bool callReset );
+
+	size_t indexMappedLines( size_t offset, size_t limit );
+
+	void indexMappedFile();
+
+	void stopIndexing();
+
+	bool saveToMappedFile( const std::string& path );
 };
 
 }}} // namespace EE::UI::Doc
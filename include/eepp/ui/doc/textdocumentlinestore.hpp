@@ -0,0 +1,132 @@
+#ifndef EE_UI_DOC_TEXTDOCUMENTLINESTORE_HPP
+#define EE_UI_DOC_TEXTDOCUMENTLINESTORE_HPP
+
+#include <atomic>
+#include <eepp/system/iostreammappedfile.hpp>
+#include <eepp/system/mutex.hpp>
+#include <eepp/ui/doc/textdocumentline.hpp>
+#include <memory>
+#include <vector>
+
+using namespace EE::System;
+
+namespace EE { namespace UI { namespace Doc {
+
+/** The line storage of a TextDocument.
+ * Lines are kept in blocks of at most twice the block size, indexed by a Fenwick tree of the
+ * block sizes. Random access and the index update after inserting or removing lines in a block
+ * cost O(log blocks), plus moving the lines of the affected block, instead of shifting every line
+ * below the edit as a single vector does. Splitting, merging or removing whole blocks rebuilds the
+ * index in O(blocks), which happens at most once every half block size of inserted or removed
+ * lines, so edits are O(log n) amortized for a fixed block size.
+ * Blocks can also reference a range of lines of a memory mapped file, those lines are decoded the
+ * first time any line of the block is accessed. This allows opening very large files without
+ * decoding them completely.
+ */
+class EE_API TextDocumentLineStore {
+  public:
+	explicit TextDocumentLineStore( const size_t& blockSize = 1024 );
+
+	size_t size() const;
+
+	bool empty() const;
+
+	void clear();
+
+	TextDocumentLine& operator[]( const size_t& index );
+
+	const TextDocumentLine& operator[]( const size_t& index ) const;
+
+	TextDocumentLine& back();
+
+	const TextDocumentLine& back() const;
+
+	void push_back( const TextDocumentLine& line );
+
+	void push_back( TextDocumentLine&& line );
+
+	/** Inserts the line before the line at index ( index == size() appends it ). */
+	void insert( const size_t& index, TextDocumentLine&& line );
+
+	/** Inserts the lines before the line at index ( index == size() appends them ). */
+	void insert( const size_t& index, std::vector<TextDocumentLine>&& lines );
+
+	void erase( const size_t& index );
+
+	/** Removes the lines in the range [first, last). */
+	void erase( const size_t& first, const size_t& last );
+
+	const size_t& getBlockSize() const;
+
+	size_t getBlockCount() const;
+
+	/** Sets the file that mapped lines reference.
+	 * @param crlf If the lines of the file end with CRLF, they will be converted to LF when decoded.
+	 */
+	void setMappedFile( const std::shared_ptr<IOStreamMappedFile>& file, bool crlf );
+
+	const std::shared_ptr<IOStreamMappedFile>& getMappedFile() const;
+
+	bool isMappedCRLF() const;
+
+	/** Appends lineCount lines that will be decoded on demand from the mapped file.
+	 * @param offset Byte offset of the first line in the mapped file.
+	 * @param size Size in bytes of the lines.
+	 */
+	void pushMappedLines( const size_t& offset, const size_t& size, const size_t& lineCount );
+
+	/** If the line at index is the first line of a block that wasn't decoded yet, returns the
+	 * number of lines in the block and its raw bytes, otherwise returns 0. */
+	size_t getMappedLines( const size_t& index, const char** data, size_t* size ) const;
+
+	/** @return If any line is still pending to be decoded from the mapped file. */
+	bool hasMappedLines() const;
+
+	bool isLineLoaded( const size_t& index ) const;
+
+	/** Decodes every pending line and releases the mapped file. */
+	void loadAll();
+
+  protected:
+	struct Block {
+		std::vector<TextDocumentLine> lines;
+		/** Raw bytes of the lines while the block is not decoded. */
+		const char* data{ nullptr };
+		size_t dataSize{ 0 };
+		size_t mappedLines{ 0 };
+
+		size_t size() const { return data ? mappedLines : lines.size(); }
+	};
+
+	size_t mBlockSize;
+	size_t mSize;
+	std::vector<Block> mBlocks;
+	/** Fenwick tree of the block sizes ( 1-based ). */
+	std::vector<size_t> mBlockIndex;
+	std::shared_ptr<IOStreamMappedFile> mMappedFile;
+	bool mMappedCRLF{ false };
+	mutable std::atomic<size_t> mMappedBlocks{ 0 };
+	mutable Mutex mMappedMutex;
+
+	/** @return The block that contains the line at index, and the line offset in the block. */
+	size_t findBlock( const size_t& index, size_t& offset ) const;
+
+	void loadBlock( const size_t& block ) const;
+
+	void appendBlock( Block&& block );
+
+	void removeBlocks( const size_t& block, const size_t& count );
+
+	/** Adds delta ( modulo 2^n, so it can be negative ) to the size of the block in the index. */
+	void addToIndex( const size_t& block, const size_t& delta );
+
+	void rebuildIndex();
+
+	void splitBlock( const size_t& block );
+
+	void mergeBlock( const size_t& block );
+};
+
+}}} // namespace EE::UI::Doc
+
+#endif // EE_UI_DOC_TEXTDOCUMENTLINESTORE_HPP
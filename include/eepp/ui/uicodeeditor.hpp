@@ -1,12 +1,14 @@
 ﻿#ifndef EE_UI_UICODEEDIT_HPP
 #define EE_UI_UICODEEDIT_HPP
 
+#include <eepp/graphics/text.hpp>
 #include <eepp/ui/doc/syntaxcolorscheme.hpp>
 #include <eepp/ui/doc/syntaxhighlighter.hpp>
 #include <eepp/ui/doc/textdocument.hpp>
 #include <eepp/ui/keyboardshortcut.hpp>
 #include <eepp/ui/uifontstyleconfig.hpp>
 #include <eepp/ui/uiwidget.hpp>
+#include <unordered_map>
 
 using namespace EE::Graphics;
 using namespace EE::UI::Doc;
@@ -204,6 +206,8 @@ class EE_API UICodeEditor : public UIWidget, public TextDocument::Client {
 
 	void setDocument( std::shared_ptr<TextDocument> doc );
 
+	SyntaxHighlighter* getHighlighter();
+
 	bool isDirty() const;
 
 	const bool& isLocked() const;
@@ -431,6 +435,19 @@ class EE_API UICodeEditor : public UIWidget, public TextDocument::Client {
 	TextRange mPreviewColorRange;
 	std::vector<UICodeEditorModule*> mModules;
 
+	// The prebuilt geometry of a line, valid while the line text, its tokens and the rendering
+	// state of the editor don't change.
+	struct GlyphRun {
+		String::HashType lineHash{ 0 };
+		size_t tokensHash{ 0 };
+		Texture* texture{ nullptr };
+		std::vector<Text::VertexCoords> vertices;
+		std::vector<Color> colors;
+		std::vector<std::pair<Rectf, Color>> backgrounds;
+	};
+	std::unordered_map<Int64, GlyphRun> mGlyphRuns;
+	size_t mGlyphRunsState{ 0 };
+
 	UICodeEditor( const std::string& elementTag, const bool& autoRegisterBaseCommands = true,
 				  const bool& autoRegisterBaseKeybindings = true );
 
@@ -532,6 +549,16 @@ class EE_API UICodeEditor : public UIWidget, public TextDocument::Client {
 	virtual void drawLineText( const Int64& index, Vector2f position, const Float& fontSize,
 							   const Float& lineHeight );
 
+	void drawLineTextUncached( const Int64& index, Vector2f position, const Float& fontSize,
+							   const Float& lineHeight );
+
+	bool buildGlyphRun( GlyphRun& run, const Int64& index, const Float& fontSize,
+						const Float& lineHeight );
+
+	void updateGlyphRunsState();
+
+	void clearGlyphRuns( const std::pair<int, int>& lineRange );
+
 	virtual void drawWhitespaces( const std::pair<int, int>& lineRange, const Vector2f& startScroll,
 								  const Float& lineHeight );
 
@@ -34,6 +34,8 @@ class EE_API UIComboBox : public UIWidget {
 
 	void loadFromXmlNode( const pugi::xml_node& node );
 
+	void loadFromProperties( const std::vector<StyleSheetProperty>& properties );
+
   protected:
 	UIDropDownList* mDropDownList;
 	UINode* mButton;
@@ -0,0 +1,77 @@
+#ifndef EE_UI_UICOMPILEDLAYOUT_HPP
+#define EE_UI_UICOMPILEDLAYOUT_HPP
+
+#include <eepp/system/iostream.hpp>
+#include <eepp/ui/css/stylesheet.hpp>
+#include <eepp/ui/css/stylesheetproperty.hpp>
+#include <eepp/ui/uiwidgetcreator.hpp>
+#include <string>
+#include <vector>
+
+namespace pugi {
+class xml_node;
+}
+
+using namespace EE::System;
+
+namespace EE { namespace UI {
+
+/** @brief A layout compiled to a binary form, so UISceneNode can instantiate it without parsing
+**	any XML or CSS.
+**	The compiler resolves the widget types and the property definitions, expands the shorthand
+**	attributes, parses the style sheets of the layout ( including the imported ones ) and interns
+**	every string. Loading a compiled layout restores its properties and style sheets once, creating
+**	its widgets only applies them.
+**	Widgets with child elements that are not widgets ( i.e. the items of a list box or the menus of
+**	a menu bar ) are kept as XML fragments, since they read their children themselves.
+**	A layout must be compiled with the same widgets registered that are available when it's loaded.
+*/
+class EE_API UICompiledLayout {
+  public:
+	enum NodeType : Uint8 { Widget, Style, Fragment };
+
+	/** Compiles the node and its siblings, as UISceneNode::loadLayoutNodes loads them. */
+	static bool compile( const pugi::xml_node& node, IOStream& stream );
+
+	static bool compileFromString( const std::string& layoutString, IOStream& stream );
+
+	static bool compileFromFile( const std::string& layoutPath, const std::string& outputPath );
+
+	UICompiledLayout();
+
+	bool loadFromFile( const std::string& path );
+
+	bool loadFromMemory( const void* buffer, size_t bufferSize );
+
+	bool loadFromStream( IOStream& stream );
+
+	const bool& isLoaded() const;
+
+  protected:
+	friend class UISceneNode;
+
+	struct CompiledNode {
+		NodeType type;
+		// The widget factory, the style sheet or the XML fragment of the node.
+		Uint32 index;
+		Uint32 childCount;
+		// The number of nodes of the subtree, to skip it if the widget can't be created.
+		Uint32 descendantCount;
+		std::vector<CSS::StyleSheetProperty> properties;
+	};
+
+	std::vector<UIWidgetCreator::RegisterWidgetCb> mFactories;
+	std::vector<CSS::StyleSheet> mStyleSheets;
+	std::vector<std::string> mFragments;
+	// The nodes in document order, the children follow its parent.
+	std::vector<CompiledNode> mNodes;
+	bool mLoaded;
+
+	bool load( const char* data, size_t size );
+
+	void clear();
+};
+
+}} // namespace EE::UI
+
+#endif
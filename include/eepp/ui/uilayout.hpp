@@ -43,6 +43,8 @@ class EE_API UILayout : public UIWidget {
 	std::unordered_set<UILayout*> mLayouts;
 	bool mDirtyLayout;
 	bool mPacking;
+	// If the layout is waiting in the scene dirty layouts list.
+	bool mLayoutScheduled;
 };
 
 }} // namespace EE::UI
@@ -21,6 +21,7 @@ class UIWindow;
 class UIWidget;
 class UILayout;
 class UIIcon;
+class UICompiledLayout;
 
 class EE_API UISceneNode : public SceneNode {
   public:
@@ -63,6 +64,14 @@ class EE_API UISceneNode : public SceneNode {
 
 	UIWidget* loadLayoutNodes( pugi::xml_node node, Node* parent );
 
+	/** Instantiates a layout compiled with UICompiledLayout. */
+	UIWidget* loadLayoutFromCompiled( const UICompiledLayout& layout, Node* parent = NULL );
+
+	UIWidget* loadLayoutFromCompiledFile( const std::string& layoutPath, Node* parent = NULL );
+
+	UIWidget* loadLayoutFromCompiledMemory( const void* buffer, size_t bufferSize,
+											Node* parent = NULL );
+
 	void setStyleSheet( const CSS::StyleSheet& styleSheet );
 
 	void setStyleSheet( const std::string& inlineStyleSheet );
@@ -103,6 +112,12 @@ class EE_API UISceneNode : public SceneNode {
 
 	const bool& isUpdatingLayouts() const;
 
+	/** @return The time spent updating the dirty layouts during the last frame. */
+	const Time& getLayoutUpdateTime() const;
+
+	/** @return The number of layout trees updated during the last frame. */
+	const Uint32& getLayoutUpdateCount() const;
+
 	UIIconThemeManager* getUIIconThemeManager() const;
 
 	UIIcon* findIcon( const std::string& iconName );
@@ -133,6 +148,12 @@ class EE_API UISceneNode : public SceneNode {
 
 	UIEventDispatcher* getUIEventDispatcher() const;
 
+	/** @brief Sets the thread pool used to resolve the styles of the widgets in parallel when the
+	 * style sheet is reloaded. */
+	void setThreadPool( std::shared_ptr<ThreadPool> pool );
+
+	const std::shared_ptr<ThreadPool>& getThreadPool() const;
+
   protected:
 	friend class EE::UI::UIWindow;
 	friend class EE::UI::UIWidget;
@@ -154,7 +175,13 @@ class EE_API UISceneNode : public SceneNode {
 	std::unordered_set<UIWidget*> mDirtyStyleState;
 	std::unordered_map<UIWidget*, bool> mDirtyStyleStateCSSAnimations;
 	std::unordered_set<UILayout*> mDirtyLayouts;
+	std::vector<std::pair<size_t, UILayout*>> mLayoutUpdateList;
+	Time mLayoutUpdateTime;
+	Time mFrameLayoutUpdateTime;
+	Uint32 mLayoutUpdateCount;
+	Uint32 mFrameLayoutUpdateCount;
 	std::vector<std::pair<Float, std::string>> mTimes;
+	std::shared_ptr<ThreadPool> mThreadPool;
 
 	virtual void resizeNode( EE::Window::Window* win );
 
@@ -190,6 +217,12 @@ class EE_API UISceneNode : public SceneNode {
 
 	std::vector<UIWidget*> loadNode( pugi::xml_node node, Node* parent );
 
+	std::vector<UIWidget*> loadCompiledNodes( const UICompiledLayout& layout, size_t& index,
+											  size_t count, Node* parent );
+
+	UIWidget* loadLayout( const std::string& id,
+						  const std::function<std::vector<UIWidget*>()>& loadNodes );
+
 	virtual Uint32 onKeyDown( const KeyEvent& event );
 
 	void onWidgetDelete( Node* node );
@@ -99,6 +99,9 @@ class EE_API UITreeView : public UIAbstractTableView {
 
 	bool isExpanded( const ModelIndex& index ) const;
 
+	/** Expands or contracts a single index. */
+	void setExpanded( const ModelIndex& index, bool expanded );
+
 	void expandAll( const ModelIndex& index = {} );
 
 	void contractAll( const ModelIndex& index = {} );
@@ -150,12 +153,37 @@ class EE_API UITreeView : public UIAbstractTableView {
 		bool open{false};
 	};
 
-	template <typename Callback> void traverseTree( Callback ) const;
+	/** A row of the expanded tree. */
+	struct FlatRow {
+		ModelIndex index;
+		size_t indentLevel;
+	};
+
+	/** Calls the callback for every row of the expanded tree starting from the row index. */
+	template <typename Callback> void traverseTree( Callback, size_t fromRow = 0 ) const;
 
 	mutable std::map<void*, MetadataForIndex> mViewMetadata;
+	/** The rows of the expanded tree, the rows are flattened again after a model update and
+	 * updated in place when a single index is expanded or contracted. */
+	mutable std::vector<FlatRow> mFlatRows;
+	mutable bool mFlatRowsDirty{true};
 
 	virtual size_t getItemCount() const;
 
+	virtual void onModelUpdate( unsigned flags );
+
+	const std::vector<FlatRow>& getFlatRows() const;
+
+	void flattenTree( const ModelIndex& parent, size_t indentLevel,
+					  std::vector<FlatRow>& rows ) const;
+
+	/** @return The position of the index in the flattened rows, searching from the visible rows,
+	 * or -1 if the index is not visible. */
+	Int64 findFlatRow( const ModelIndex& index ) const;
+
+	/** @return The first row that can be inside the visible area. */
+	size_t getFirstVisibleRow() const;
+
 	UITreeView::MetadataForIndex& getIndexMetadata( const ModelIndex& index ) const;
 
 	virtual void onColumnSizeChange( const size_t& colIndex, bool fromUserInteraction = false );
@@ -105,6 +105,10 @@ class EE_API UIWidget : public UINode {
 
 	virtual void loadFromXmlNode( const pugi::xml_node& node );
 
+	/** Applies the attributes of a layout node already converted to properties ( see
+	 * UICompiledLayout ), it's the equivalent of loadFromXmlNode without the children. */
+	virtual void loadFromProperties( const std::vector<StyleSheetProperty>& properties );
+
 	void notifyLayoutAttrChange();
 
 	void notifyLayoutAttrChangeParent();
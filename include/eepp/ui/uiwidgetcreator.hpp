@@ -16,6 +16,10 @@ class EE_API UIWidgetCreator {
 
 	static UIWidget* createFromName( std::string widgetName );
 
+	/** @return The function that creates the widget, resolved once to create many widgets of the
+	 * same type. Empty if the widget is not registered. */
+	static RegisterWidgetCb getWidgetFactory( std::string widgetName );
+
 	static void addCustomWidgetCallback( std::string widgetName, const CustomWidgetCb& cb );
 
 	static void removeCustomWidgetCallback( std::string widgetName );
@@ -140,6 +140,8 @@ class EE_API UIWindow : public UIWidget {
 
 	virtual void loadFromXmlNode( const pugi::xml_node& node );
 
+	virtual void loadFromProperties( const std::vector<StyleSheetProperty>& properties );
+
 	virtual bool applyProperty( const StyleSheetProperty& attribute );
 
 	virtual void nodeDraw();
@@ -1123,6 +1123,76 @@ solution "eepp"
 		includedirs { "src/thirdparty" }
 		build_link_configuration( "eepp-ui-perf-test", true )
 
+	project "eepp-syntax-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/syntax_perf_test/*.cpp" }
+		build_link_configuration( "eepp-syntax-perf-test", true )
+
+	project "eepp-highlighter-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/highlighter_perf_test/*.cpp" }
+		build_link_configuration( "eepp-highlighter-perf-test", true )
+
+	project "eepp-textdocument-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/textdocument_perf_test/*.cpp" }
+		build_link_configuration( "eepp-textdocument-perf-test", true )
+
+	project "eepp-threadpool-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/threadpool_perf_test/*.cpp" }
+		build_link_configuration( "eepp-threadpool-perf-test", true )
+
+	project "eepp-http-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/http_perf_test/*.cpp" }
+		build_link_configuration( "eepp-http-perf-test", true )
+
+	project "eepp-httpparser-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/httpparser_perf_test/*.cpp" }
+		build_link_configuration( "eepp-httpparser-perf-test", true )
+
+	project "eepp-log-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/log_perf_test/*.cpp" }
+		build_link_configuration( "eepp-log-perf-test", true )
+
+	project "eepp-particle-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/particle_perf_test/*.cpp" }
+		build_link_configuration( "eepp-particle-perf-test", true )
+
+	project "eepp-projectscan-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/projectscan_perf_test/*.cpp",
+				"src/tools/codeeditor/ignorematcher.cpp",
+				"src/tools/codeeditor/projectdirectorytree.cpp" }
+		build_link_configuration( "eepp-projectscan-perf-test", true )
+
+	project "eepp-projectsearch-perf-test"
+		kind "ConsoleApp"
+		language "C++"
+		files { "src/tests/projectsearch_perf_test/*.cpp",
+				"src/tools/codeeditor/projectsearch.cpp",
+				"src/tools/codeeditor/projectsearchindex.cpp" }
+		build_link_configuration( "eepp-projectsearch-perf-test", true )
+
+	project "eepp-layout-perf-test"
+		set_kind()
+		language "C++"
+		files { "src/tests/layout_perf_test/*.cpp" }
+		build_link_configuration( "eepp-layout-perf-test", true )
+
 if os.isfile("external_projects.lua") then
 	dofile("external_projects.lua")
 end
@@ -5,17 +5,109 @@
 #include <eepp/graphics/renderer/renderer.hpp>
 #include <eepp/graphics/texture.hpp>
 #include <eepp/graphics/texturefactory.hpp>
+#include <eepp/system/threadpool.hpp>
 #include <eepp/window/engine.hpp>
 
+#if !defined( EE_USE_DOUBLES ) &&                                  \
+	( defined( __SSE__ ) || defined( _M_X64 ) || defined( _M_AMD64 ) || \
+	  ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 ) )
+#define EE_PARTICLES_SSE
+#include <xmmintrin.h>
+#elif !defined( EE_USE_DOUBLES ) && ( defined( __ARM_NEON ) || defined( __ARM_NEON__ ) )
+#define EE_PARTICLES_NEON
+#include <arm_neon.h>
+#endif
+
 using namespace EE::Window;
 
 namespace EE { namespace Graphics {
 
+// position += speed * time, speed += acceleration * time
+static void integrate( Float* position, Float* speed, const Float* acceleration, size_t count,
+					   Float time ) {
+	size_t i = 0;
+
+#if defined( EE_PARTICLES_SSE )
+	__m128 t = _mm_set1_ps( time );
+
+	for ( ; i + 4 <= count; i += 4 ) {
+		__m128 p = _mm_loadu_ps( position + i );
+		__m128 s = _mm_loadu_ps( speed + i );
+		__m128 a = _mm_loadu_ps( acceleration + i );
+		_mm_storeu_ps( position + i, _mm_add_ps( p, _mm_mul_ps( s, t ) ) );
+		_mm_storeu_ps( speed + i, _mm_add_ps( s, _mm_mul_ps( a, t ) ) );
+	}
+#elif defined( EE_PARTICLES_NEON )
+	float32x4_t t = vdupq_n_f32( time );
+
+	for ( ; i + 4 <= count; i += 4 ) {
+		float32x4_t p = vld1q_f32( position + i );
+		float32x4_t s = vld1q_f32( speed + i );
+		float32x4_t a = vld1q_f32( acceleration + i );
+		vst1q_f32( position + i, vaddq_f32( p, vmulq_f32( s, t ) ) );
+		vst1q_f32( speed + i, vaddq_f32( s, vmulq_f32( a, t ) ) );
+	}
+#endif
+
+	for ( ; i < count; i++ ) {
+		position[i] = position[i] + speed[i] * time;
+		speed[i] = speed[i] + acceleration[i] * time;
+	}
+}
+
+// @return The index of the first alpha from begin that is zero, end if none
+static Uint32 findDead( const Float* alpha, Uint32 begin, Uint32 end ) {
+#if defined( EE_PARTICLES_SSE )
+	__m128 zero = _mm_setzero_ps();
+
+	for ( ; begin + 4 <= end; begin += 4 ) {
+		if ( _mm_movemask_ps( _mm_cmple_ps( _mm_loadu_ps( alpha + begin ), zero ) ) )
+			break;
+	}
+#endif
+
+	for ( ; begin < end; begin++ ) {
+		if ( alpha[begin] <= 0.f )
+			return begin;
+	}
+
+	return end;
+}
+
+// alpha = max( alpha - decay * time, 0 )
+static void decay( Float* alpha, const Float* decay, size_t count, Float time ) {
+	size_t i = 0;
+
+#if defined( EE_PARTICLES_SSE )
+	__m128 t = _mm_set1_ps( time );
+	__m128 zero = _mm_setzero_ps();
+
+	for ( ; i + 4 <= count; i += 4 ) {
+		__m128 d = _mm_mul_ps( _mm_loadu_ps( decay + i ), t );
+		_mm_storeu_ps( alpha + i, _mm_max_ps( _mm_sub_ps( _mm_loadu_ps( alpha + i ), d ), zero ) );
+	}
+#elif defined( EE_PARTICLES_NEON )
+	float32x4_t t = vdupq_n_f32( time );
+	float32x4_t zero = vdupq_n_f32( 0.f );
+
+	for ( ; i + 4 <= count; i += 4 ) {
+		float32x4_t d = vmulq_f32( vld1q_f32( decay + i ), t );
+		vst1q_f32( alpha + i, vmaxq_f32( vsubq_f32( vld1q_f32( alpha + i ), d ), zero ) );
+	}
+#endif
+
+	for ( ; i < count; i++ ) {
+		alpha[i] -= decay[i] * time;
+
+		if ( alpha[i] < 0 )
+			alpha[i] = 0;
+	}
+}
+
 ParticleSystem::ParticleSystem() :
-	mParticle( NULL ),
 	mPCount( 0 ),
+	mAlive( 0 ),
 	mTexture( 0 ),
-	mPLeft( 0 ),
 	mLoops( 0 ),
 	mEffect( ParticleEffect::Nofx ),
 	mBlend( BlendAdd ),
@@ -32,18 +124,17 @@ ParticleSystem::ParticleSystem() :
 	mTime( 0.01f ),
 	mLoop( false ),
 	mUsed( false ),
-	mPointsSup( false ) {}
+	mPointsSup( false ),
+	mRandState( static_cast<Uint32>( rand() ) * 2 + 1 ) {}
 
-ParticleSystem::~ParticleSystem() {
-	eeSAFE_DELETE_ARRAY( mParticle );
-}
+ParticleSystem::~ParticleSystem() {}
 
 void ParticleSystem::create( const ParticleEffect& Effect, const Uint32& NumParticles,
 							 const Uint32& TexId, const Vector2f& Pos, const Float& PartSize,
 							 const bool& AnimLoop, const Uint32& NumLoops, const ColorAf& Color,
 							 const Vector2f& Pos2, const Float& AlphaDecay, const Vector2f& Speed,
 							 const Vector2f& Acc ) {
-	mPointsSup = GLi->pointSpriteSupported();
+	mPointsSup = NULL != GLi && GLi->pointSpriteSupported();
 	mEffect = Effect;
 	mPos = Pos;
 	mPCount = NumParticles;
@@ -75,27 +166,73 @@ void ParticleSystem::create( const ParticleEffect& Effect, const Uint32& NumPart
 }
 
 void ParticleSystem::begin() {
-	mPLeft = mPCount;
+	mAlive = mPCount;
 
-	eeSAFE_DELETE_ARRAY( mParticle );
-
-	mParticle = eeNewArray( Particle, mPCount );
-
-	Particle* P;
+	// Same initial state than a new Particle.
+	mPositions.assign( mPCount, Vector2f() );
+	mSpeeds.assign( mPCount, Vector2f() );
+	mAccelerations.assign( mPCount, Vector2f() );
+	mColors.assign( mPCount, ColorAf( 1.0f, 1.0f, 1.0f, 1.0f ) );
+	mAlphas.assign( mPCount, 1.0f );
+	mAlphaDecays.assign( mPCount, 0.01f );
+	mIds.resize( mPCount );
 
 	for ( Uint32 i = 0; i < mPCount; i++ ) {
-		P = &mParticle[i];
-		P->setUsed( true );
-		P->setId( i + 1 );
+		mIds[i] = i + 1;
 
-		reset( P );
+		spawn( i );
 	}
 }
 
+void ParticleSystem::spawn( const Uint32& index ) {
+	// The reset starts from the current state of the particle, as when every particle was an
+	// object.
+	ColorAf color( mColors[index] );
+	color.a = mAlphas[index];
+
+	mSpawn.setUsed( true );
+	mSpawn.setId( mIds[index] );
+	mSpawn.setX( mPositions[index].x );
+	mSpawn.setY( mPositions[index].y );
+	mSpawn.setXSpeed( mSpeeds[index].x );
+	mSpawn.setYSpeed( mSpeeds[index].y );
+	mSpawn.setXAcc( mAccelerations[index].x );
+	mSpawn.setYAcc( mAccelerations[index].y );
+	mSpawn.setColor( color, mAlphaDecays[index] );
+
+	reset( &mSpawn );
+
+	mPositions[index] = Vector2f( mSpawn.getX(), mSpawn.getY() );
+	mSpeeds[index] = Vector2f( mSpawn.getXSpeed(), mSpawn.getYSpeed() );
+	mAccelerations[index] = Vector2f( mSpawn.getXAcc(), mSpawn.getYAcc() );
+	mColors[index] = mSpawn.getColor();
+	mAlphas[index] = mSpawn.getColor().a;
+	mAlphaDecays[index] = mSpawn.getAlphaDecay();
+}
+
+void ParticleSystem::swap( const Uint32& a, const Uint32& b ) {
+	std::swap( mPositions[a], mPositions[b] );
+	std::swap( mSpeeds[a], mSpeeds[b] );
+	std::swap( mAccelerations[a], mAccelerations[b] );
+	std::swap( mColors[a], mColors[b] );
+	std::swap( mAlphas[a], mAlphas[b] );
+	std::swap( mAlphaDecays[a], mAlphaDecays[b] );
+	std::swap( mIds[a], mIds[b] );
+}
+
 void ParticleSystem::setCallbackReset( const ParticleCallback& pc ) {
 	mPC = pc;
 }
 
+Float ParticleSystem::randf( const Float& fMin, const Float& fMax ) {
+	// xorshift32
+	mRandState ^= mRandState << 13;
+	mRandState ^= mRandState >> 17;
+	mRandState ^= mRandState << 5;
+
+	return fMin + ( fMax - fMin ) * ( ( mRandState >> 8 ) / 16777216.f );
+}
+
 void ParticleSystem::reset( Particle* P ) {
 	Float x, y, radio, q, z, w;
 
@@ -106,65 +243,65 @@ void ParticleSystem::reset( Particle* P ) {
 			break;
 		}
 		case ParticleEffect::BlueBall: {
-			P->reset( mPos.x, mPos.y, -10, ( -1 * Math::randf() ), 0.01f, Math::randf(), mSize );
-			P->setColor( ColorAf( 0.25f, 0.25f, 1, 1 ), 0.1f + ( 0.1f * Math::randf() ) );
+			P->reset( mPos.x, mPos.y, -10, ( -1 * randf() ), 0.01f, randf(), mSize );
+			P->setColor( ColorAf( 0.25f, 0.25f, 1, 1 ), 0.1f + ( 0.1f * randf() ) );
 			break;
 		}
 		case ParticleEffect::Fire: {
-			x = ( mPos2.x - mPos.x + 1 ) * Math::randf() + mPos.x;
-			y = ( mPos2.y - mPos.y + 1 ) * Math::randf() + mPos.y;
+			x = ( mPos2.x - mPos.x + 1 ) * randf() + mPos.x;
+			y = ( mPos2.y - mPos.y + 1 ) * randf() + mPos.y;
 
-			P->reset( x, y, Math::randf() - 0.5f, ( Math::randf() - 1.1f ) * 8.5f, 0.f, 0.05f,
+			P->reset( x, y, randf() - 0.5f, ( randf() - 1.1f ) * 8.5f, 0.f, 0.05f,
 					  mSize );
-			P->setColor( ColorAf( 1.f, 0.5f, 0.1f, ( Math::randf() * 0.5f ) ),
-						 Math::randf() * 0.4f + 0.01f );
+			P->setColor( ColorAf( 1.f, 0.5f, 0.1f, ( randf() * 0.5f ) ),
+						 randf() * 0.4f + 0.01f );
 			break;
 		}
 		case ParticleEffect::Smoke: {
-			x = ( mPos2.x - mPos.x + 1 ) * Math::randf() + mPos.x;
-			y = ( mPos2.y - mPos.y + 1 ) * Math::randf() + mPos.y;
+			x = ( mPos2.x - mPos.x + 1 ) * randf() + mPos.x;
+			y = ( mPos2.y - mPos.y + 1 ) * randf() + mPos.y;
 
-			P->reset( x, y, -( Math::randf() / 3.f + 0.1f ),
-					  ( ( Math::randf() * 0.5f ) - 0.7f ) * 3, ( Math::randf() / 200.f ),
-					  ( Math::randf() - 0.5f ) / 200.f );
-			P->setColor( ColorAf( 0.8f, 0.8f, 0.8f, 0.3f ), ( Math::randf() * 0.005f ) + 0.005f );
+			P->reset( x, y, -( randf() / 3.f + 0.1f ),
+					  ( ( randf() * 0.5f ) - 0.7f ) * 3, ( randf() / 200.f ),
+					  ( randf() - 0.5f ) / 200.f );
+			P->setColor( ColorAf( 0.8f, 0.8f, 0.8f, 0.3f ), ( randf() * 0.005f ) + 0.005f );
 			break;
 		}
 		case ParticleEffect::Snow: {
-			x = ( mPos2.x - mPos.x + 1 ) * Math::randf() + mPos.x;
-			y = ( mPos2.y - mPos.y + 1 ) * Math::randf() + mPos.y;
-			w = ( Math::randf() + 0.3f ) * 4;
+			x = ( mPos2.x - mPos.x + 1 ) * randf() + mPos.x;
+			y = ( mPos2.y - mPos.y + 1 ) * randf() + mPos.y;
+			w = ( randf() + 0.3f ) * 4;
 
-			P->reset( x, y, Math::randf() - 0.5f, w, 0.f, 0.f, w * 3 );
+			P->reset( x, y, randf() - 0.5f, w, 0.f, 0.f, w * 3 );
 			P->setColor( ColorAf( 1.f, 1.f, 1.f, 0.5f ), 0 );
 			break;
 		}
 		case ParticleEffect::MagicFire: {
-			P->reset( mPos.x + Math::randf(), mPos.y, -0.4f + Math::randf() * 0.8f,
-					  -0.5f - Math::randf() * 0.4f, 0.f, -( Math::randf() * 0.3f ) );
-			P->setColor( ColorAf( 1.f, 0.5f, 0.1f, 0.7f + 0.2f * Math::randf() ),
-						 0.01f + Math::randf() * 0.05f );
+			P->reset( mPos.x + randf(), mPos.y, -0.4f + randf() * 0.8f,
+					  -0.5f - randf() * 0.4f, 0.f, -( randf() * 0.3f ) );
+			P->setColor( ColorAf( 1.f, 0.5f, 0.1f, 0.7f + 0.2f * randf() ),
+						 0.01f + randf() * 0.05f );
 			break;
 		}
 		case ParticleEffect::LevelUp: {
-			P->reset( mPos.x, mPos.y, Math::randf() * 1.5f - 0.75f, Math::randf() * 1.5f - 0.75f,
-					  Math::randf() * 4 - 2, Math::randf() * -4 + 2 );
-			P->setColor( ColorAf( 1.f, 0.5f, 0.1f, 1.f ), 0.07f + Math::randf() * 0.01f );
+			P->reset( mPos.x, mPos.y, randf() * 1.5f - 0.75f, randf() * 1.5f - 0.75f,
+					  randf() * 4 - 2, randf() * -4 + 2 );
+			P->setColor( ColorAf( 1.f, 0.5f, 0.1f, 1.f ), 0.07f + randf() * 0.01f );
 			break;
 		}
 		case ParticleEffect::LevelUp2: {
-			P->reset( mPos.x + Math::randf() * 32 - 16, mPos.y + Math::randf() * 64 - 32,
-					  Math::randf() - 0.5f, Math::randf() - 0.5f, Math::randf() - 0.5f,
-					  Math::randf() * -0.9f + 0.45f );
-			P->setColor( ColorAf( 0.1f + Math::randf() * 0.1f, 0.1f + Math::randf() * 0.1f,
-								  0.8f + Math::randf() * 0.3f, 1 ),
-						 0.07f + Math::randf() * 0.01f );
+			P->reset( mPos.x + randf() * 32 - 16, mPos.y + randf() * 64 - 32,
+					  randf() - 0.5f, randf() - 0.5f, randf() - 0.5f,
+					  randf() * -0.9f + 0.45f );
+			P->setColor( ColorAf( 0.1f + randf() * 0.1f, 0.1f + randf() * 0.1f,
+								  0.8f + randf() * 0.3f, 1 ),
+						 0.07f + randf() * 0.01f );
 			break;
 		}
 		case ParticleEffect::Heal: {
-			P->reset( mPos.x, mPos.y, Math::randf() * 1.4f - 0.7f, Math::randf() * -0.4f - 1.5f,
-					  Math::randf() - 0.5f, Math::randf() * -0.2f + 0.1f );
-			P->setColor( ColorAf( 0.2f, 0.3f, 0.9f, 0.4f ), 0.01f + Math::randf() * 0.01f );
+			P->reset( mPos.x, mPos.y, randf() * 1.4f - 0.7f, randf() * -0.4f - 1.5f,
+					  randf() - 0.5f, randf() * -0.2f + 0.1f );
+			P->setColor( ColorAf( 0.2f, 0.3f, 0.9f, 0.4f ), 0.01f + randf() * 0.01f );
 			break;
 		}
 		case ParticleEffect::WormHole: {
@@ -172,20 +309,20 @@ void ParticleSystem::reset( Particle* P ) {
 			Float VarB[4];
 
 			for ( lo = 0; lo <= 3; lo++ ) {
-				VarB[lo] = Math::randf() * 5;
-				la = (int)( Math::randf() * 8 );
+				VarB[lo] = randf() * 5;
+				la = (int)( randf() * 8 );
 
 				if ( ( la * 0.5f ) != (int)( la * 0.5f ) )
 					VarB[lo] = -VarB[lo];
 			}
 
-			mProgression = (int)Math::randf() * 10;
+			mProgression = (int)randf() * 10;
 			radio = ( P->getId() * 0.125f ) * mProgression;
 			x = mPos.x + ( radio * eecos( (Float)P->getId() ) );
 			y = mPos.y + ( radio * eesin( (Float)P->getId() ) );
 
 			P->reset( x, y, VarB[0], VarB[1], VarB[2], VarB[3] );
-			P->setColor( ColorAf( 1.f, 0.6f, 0.3f, 1.f ), 0.02f + Math::randf() * 0.3f );
+			P->setColor( ColorAf( 1.f, 0.6f, 0.3f, 1.f ), 0.02f + randf() * 0.3f );
 			break;
 		}
 		case ParticleEffect::Twirl: {
@@ -204,7 +341,7 @@ void ParticleSystem::reset( Particle* P ) {
 			y = mPos.y - z * eecos( q );
 
 			P->reset( x, y, 1, 1, 0, 0 );
-			P->setColor( ColorAf( 1.f, 0.25f, 0.25f, 1 ), 0.6f + Math::randf() * 0.3f );
+			P->setColor( ColorAf( 1.f, 0.25f, 0.25f, 1 ), 0.6f + randf() * 0.3f );
 			break;
 		}
 		case ParticleEffect::Flower: {
@@ -214,17 +351,17 @@ void ParticleSystem::reset( Particle* P ) {
 
 			P->reset( x, y, 1, 1, 0, 0 );
 			P->setColor( ColorAf( 1.f, 0.25f, 0.1f, 0.1f ),
-						 0.3f + ( 0.2f * Math::randf() ) + Math::randf() * 0.3f );
+						 0.3f + ( 0.2f * randf() ) + randf() * 0.3f );
 			break;
 		}
 		case ParticleEffect::Galaxy: {
-			radio = ( Math::randf( 1.f, 1.2f ) + eesin( 20.f / (Float)P->getId() ) ) * 60;
+			radio = ( randf( 1.f, 1.2f ) + eesin( 20.f / (Float)P->getId() ) ) * 60;
 			x = mPos.x + radio * eecos( (Float)P->getId() );
 			y = mPos.y + radio * eesin( (Float)P->getId() );
 
 			P->reset( x, y, 0, 0, 0, 0 );
-			P->setColor( ColorAf( 0.2f, 0.2f, 0.6f + 0.4f * Math::randf(), 1.f ),
-						 Math::randf( 0.05f, 0.15f ) );
+			P->setColor( ColorAf( 0.2f, 0.2f, 0.6f + 0.4f * randf(), 1.f ),
+						 randf( 0.05f, 0.15f ) );
 			break;
 		}
 		case ParticleEffect::Heart: {
@@ -232,9 +369,9 @@ void ParticleSystem::reset( Particle* P ) {
 			x = mPos.x - 50 * eesin( q * 2 ) * eesqrt( eeabs( eecos( q ) ) );
 			y = mPos.y - 50 * eecos( q * 2 ) * eesqrt( eeabs( eesin( q ) ) );
 
-			P->reset( x, y, 0.f, 0.f, 0.f, -( Math::randf() * 0.2f ) );
-			P->setColor( ColorAf( 1.f, 0.5f, 0.2f, 0.6f + 0.2f * Math::randf() ),
-						 0.01f + Math::randf() * 0.08f );
+			P->reset( x, y, 0.f, 0.f, 0.f, -( randf() * 0.2f ) );
+			P->setColor( ColorAf( 1.f, 0.5f, 0.2f, 0.6f + 0.2f * randf() ),
+						 0.01f + randf() * 0.08f );
 			break;
 		}
 		case ParticleEffect::BlueExplosion: {
@@ -250,12 +387,12 @@ void ParticleSystem::reset( Particle* P ) {
 			break;
 		}
 		case ParticleEffect::GP: {
-			radio = 50 + Math::randf() * 15 * eecos( (Float)P->getId() * 3.5f );
+			radio = 50 + randf() * 15 * eecos( (Float)P->getId() * 3.5f );
 			x = mPos.x + ( radio * eecos( (Float)P->getId() * (Float)0.01428571428 ) );
 			y = mPos.y + ( radio * eesin( (Float)P->getId() * (Float)0.01428571428 ) );
 
 			P->reset( x, y, 0, 0, 0, 0 );
-			P->setColor( ColorAf( 0.2f, 0.8f, 0.4f, 0.5f ), Math::randf() * 0.3f );
+			P->setColor( ColorAf( 0.2f, 0.8f, 0.4f, 0.5f ), randf() * 0.3f );
 			break;
 		}
 		case ParticleEffect::BTwirl: {
@@ -274,7 +411,7 @@ void ParticleSystem::reset( Particle* P ) {
 
 			P->reset( x, y, 1, 1, 0, 0 );
 			P->setColor( ColorAf( 0.25f, 0.25f, 1.f, 1.f ),
-						 0.1f + Math::randf() * 0.3f + Math::randf() * 0.3f );
+						 0.1f + randf() * 0.3f + randf() * 0.3f );
 			break;
 		}
 		case ParticleEffect::BT: {
@@ -291,9 +428,9 @@ void ParticleSystem::reset( Particle* P ) {
 			x = mPos.x + w * eesin( q );
 			y = mPos.y - w * eecos( q );
 
-			P->reset( x, y, -10, -1 * Math::randf(), 0, Math::randf() );
+			P->reset( x, y, -10, -1 * randf(), 0, randf() );
 			P->setColor( ColorAf( 0.25f, 0.25f, 1.f, 1.f ),
-						 0.1f + Math::randf() * 0.1f + Math::randf() * 0.3f );
+						 0.1f + randf() * 0.1f + randf() * 0.3f );
 			break;
 		}
 		case ParticleEffect::Atomic: {
@@ -303,7 +440,7 @@ void ParticleSystem::reset( Particle* P ) {
 
 			P->reset( x, y, 1, 1, 0, 0 );
 			P->setColor( ColorAf( 0.4f, 0.25f, 1.f, 1.f ),
-						 0.3f + Math::randf() * 0.2f + Math::randf() * 0.3f );
+						 0.3f + randf() * 0.2f + randf() * 0.3f );
 			break;
 		}
 		case ParticleEffect::Callback: {
@@ -317,7 +454,7 @@ void ParticleSystem::reset( Particle* P ) {
 }
 
 void ParticleSystem::draw() {
-	if ( !mUsed )
+	if ( !mUsed || 0 == mAlive )
 		return;
 
 	BlendMode::setMode( mBlend );
@@ -333,35 +470,33 @@ void ParticleSystem::draw() {
 		GLi->enable( GL_POINT_SPRITE );
 		GLi->pointSize( mSize );
 
-		Uint32 alloc = mPCount * sizeof( Particle );
+		// The alpha is only updated in the colors when they are needed.
+		for ( Uint32 i = 0; i < mAlive; i++ )
+			mColors[i].a = mAlphas[i];
 
-		GLi->colorPointer( 4, GL_FP, sizeof( Particle ),
-						   reinterpret_cast<char*>( &mParticle[0] ) + sizeof( Float ) * 2, alloc );
-		GLi->vertexPointer( 2, GL_FP, sizeof( Particle ), reinterpret_cast<char*>( &mParticle[0] ),
-							alloc );
+		GLi->colorPointer( 4, GL_FP, sizeof( ColorAf ), reinterpret_cast<char*>( &mColors[0] ),
+						   mAlive * sizeof( ColorAf ) );
+		GLi->vertexPointer( 2, GL_FP, sizeof( Vector2f ), reinterpret_cast<char*>( &mPositions[0] ),
+							mAlive * sizeof( Vector2f ) );
 
-		GLi->drawArrays( GL_POINTS, 0, (int)mPCount );
+		GLi->drawArrays( GL_POINTS, 0, (int)mAlive );
 
 		GLi->disable( GL_POINT_SPRITE );
 		GLi->enable( GL_TEXTURE_2D );
 		GLi->enableClientState( GL_TEXTURE_COORD_ARRAY );
 	} else {
-		Particle* P;
-
 		BatchRenderer* BR = GlobalBatchRenderer::instance();
 		BR->setTexture( mTexture );
 		BR->setBlendMode( mBlend );
 		BR->quadsBegin();
 
-		for ( Uint32 i = 0; i < mPCount; i++ ) {
-			P = &mParticle[i];
+		for ( Uint32 i = 0; i < mAlive; i++ ) {
+			const ColorAf& C = mColors[i];
 
-			if ( P->isUsed() ) {
-				BR->quadsSetColor( Color(
-					static_cast<Uint8>( P->r() * 255 ), static_cast<Uint8>( P->g() * 255 ),
-					static_cast<Uint8>( P->b() * 255 ), static_cast<Uint8>( P->a() * 255 ) ) );
-				BR->batchQuad( P->getX() - mHSize, P->getY() - mHSize, mSize, mSize );
-			}
+			BR->quadsSetColor( Color(
+				static_cast<Uint8>( C.r * 255 ), static_cast<Uint8>( C.g * 255 ),
+				static_cast<Uint8>( C.b * 255 ), static_cast<Uint8>( mAlphas[i] * 255 ) ) );
+			BR->batchQuad( mPositions[i].x - mHSize, mPositions[i].y - mHSize, mSize, mSize );
 		}
 
 		BR->drawOpt();
@@ -373,39 +508,58 @@ void ParticleSystem::update() {
 }
 
 void ParticleSystem::update( const System::Time& time ) {
-	if ( !mUsed )
+	if ( !mUsed || 0 == mAlive )
 		return;
 
-	Particle* P;
+	Float pTime = time.asMilliseconds() * mTime;
 
-	for ( Uint32 i = 0; i < mPCount; i++ ) {
-		P = &mParticle[i];
-
-		if ( P->isUsed() || P->a() > 0.f ) {
-			P->update( time.asMilliseconds() * mTime );
-
-			// If not alive
-			if ( P->a() <= 0.f ) {
-				if ( !mLoop ) {			 // If not loop
-					if ( mLoops == 1 ) { // If left only one loop
-						P->setUsed( false );
-						mPLeft--;
-					} else { // more than one
-						if ( i == 0 )
-							if ( mLoops > 0 )
-								mLoops--;
-
-						reset( P );
-					}
-
-					if ( mPLeft == 0 ) // Last mParticle?
-						mUsed = false;
-				} else {
-					reset( P );
-				}
+	// Vector2f arrays are integrated as plain arrays of floats.
+	integrate( &mPositions[0].x, &mSpeeds[0].x, &mAccelerations[0].x, mAlive * 2, pTime );
+	decay( &mAlphas[0], &mAlphaDecays[0], mAlive, pTime );
+
+	Uint32 i = 0;
+
+	// Only the particles without alpha left are visited
+	while ( ( i = findDead( &mAlphas[0], i, mAlive ) ) < mAlive ) {
+		if ( !mLoop ) {			 // If not loop
+			if ( mLoops == 1 ) { // If left only one loop
+				// The last alive particle takes its place and is checked next.
+				mAlive--;
+				swap( i, mAlive );
+
+				if ( mAlive == 0 ) // Last particle?
+					mUsed = false;
+
+				continue;
+			} else { // more than one
+				if ( mIds[i] == 1 )
+					if ( mLoops > 0 )
+						mLoops--;
+
+				spawn( i );
 			}
+		} else {
+			spawn( i );
 		}
+
+		i++;
+	}
+}
+
+void ParticleSystem::update( const std::vector<ParticleSystem*>& systems, const Time& time,
+							 ThreadPool* pool ) {
+	if ( NULL == pool || systems.size() < 2 ) {
+		for ( auto& system : systems )
+			system->update( time );
+		return;
 	}
+
+	pool->parallelFor( 0, systems.size(),
+					   [&]( size_t begin, size_t end ) {
+						   for ( size_t i = begin; i < end; i++ )
+							   systems[i]->update( time );
+					   },
+					   1 );
 }
 
 void ParticleSystem::end() {
@@ -417,8 +571,8 @@ void ParticleSystem::reuse() {
 	mLoop = true;
 	mLoops = 0;
 
-	for ( Uint32 i = 0; i < mPCount; i++ )
-		mParticle[i].setUsed( true );
+	// The dead particles have no alpha left, they are reset on the next update.
+	mAlive = mPCount;
 }
 
 void ParticleSystem::kill() {
@@ -509,4 +663,12 @@ void ParticleSystem::setAcceleration( const Vector2f& acc ) {
 	mAcc = acc;
 }
 
+const Uint32& ParticleSystem::getCount() const {
+	return mPCount;
+}
+
+const Uint32& ParticleSystem::getAliveCount() const {
+	return mAlive;
+}
+
 }} // namespace EE::Graphics
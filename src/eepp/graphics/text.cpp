@@ -674,6 +674,62 @@ void Text::draw( const Float& X, const Float& Y, const Vector2f& scale, const Fl
 	}
 }
 
+void Text::appendGeometry( std::vector<VertexCoords>& vertices, std::vector<Color>& colors,
+						   const Vector2f& offset ) {
+	if ( NULL == mFont )
+		return;
+
+	ensureColorUpdate();
+	ensureGeometryUpdate();
+
+	vertices.reserve( vertices.size() + mVertices.size() );
+	for ( const auto& vertex : mVertices )
+		vertices.push_back( { vertex.texCoords, vertex.position + offset } );
+
+	colors.insert( colors.end(), mColors.begin(),
+				   mColors.begin() + eemin( mColors.size(), mVertices.size() ) );
+	colors.resize( vertices.size(), mFillColor );
+}
+
+Texture* Text::getFontTexture() const {
+	return NULL != mFont ? mFont->getTexture( mRealFontSize ) : NULL;
+}
+
+void Text::drawGeometry( Texture* texture, const std::vector<VertexCoords>& vertices,
+						 const std::vector<Color>& colors, const Vector2f& position,
+						 BlendMode effect ) {
+	unsigned int numvert = vertices.size();
+
+	if ( NULL == texture || 0 == numvert || colors.size() < numvert )
+		return;
+
+	GlobalBatchRenderer::instance()->draw();
+
+	GLi->translatef( position.x, position.y, 0 );
+
+	texture->bind();
+	BlendMode::setMode( effect );
+
+	Uint32 alloc = numvert * sizeof( VertexCoords );
+	Uint32 allocC = numvert * GLi->quadVertexs();
+
+	GLi->colorPointer( 4, GL_UNSIGNED_BYTE, 0, reinterpret_cast<const char*>( &colors[0] ),
+					   allocC );
+	GLi->texCoordPointer( 2, GL_FP, sizeof( VertexCoords ),
+						  reinterpret_cast<const char*>( &vertices[0] ), alloc );
+	GLi->vertexPointer( 2, GL_FP, sizeof( VertexCoords ),
+						reinterpret_cast<const char*>( &vertices[0] ) + sizeof( Float ) * 2,
+						alloc );
+
+	if ( GLi->quadsSupported() ) {
+		GLi->drawArrays( GL_QUADS, 0, numvert );
+	} else {
+		GLi->drawArrays( GL_TRIANGLES, 0, numvert );
+	}
+
+	GLi->translatef( -position.x, -position.y, 0 );
+}
+
 void Text::ensureGeometryUpdate() {
 	cacheWidth();
 
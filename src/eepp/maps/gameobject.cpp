@@ -141,7 +141,7 @@ void GameObject::autoFixTilePos() {
 		if ( CurPos != NewPos ) {
 			TileMapLayer* TLayer = static_cast<TileMapLayer*>( mLayer );
 
-			if ( TLayer->getGameObject( CurPos ) == this ) {
+			if ( TLayer->findTile( CurPos.x, CurPos.y ) == this ) {
 				TLayer->moveTileObject( CurPos, NewPos );
 			}
 		}
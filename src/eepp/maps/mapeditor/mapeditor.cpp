@@ -1570,6 +1570,8 @@ void MapEditor::onMapMouseClick( const Event* Event ) {
 
 				if ( NULL != tObj ) {
 					tObj->setMirrored( !tObj->isMirrored() );
+					reinterpret_cast<TileMapLayer*>( mCurLayer )
+						->invalidateTile( mUIMap->Map()->getMouseTilePos() );
 				}
 			}
 		} else if ( MEvent->getFlags() & EE_BUTTON_WDMASK ) {
@@ -1578,6 +1580,8 @@ void MapEditor::onMapMouseClick( const Event* Event ) {
 
 				if ( NULL != tObj ) {
 					tObj->setRotated( !tObj->isRotated() );
+					reinterpret_cast<TileMapLayer*>( mCurLayer )
+						->invalidateTile( mUIMap->Map()->getMouseTilePos() );
 				}
 			}
 		}
@@ -1,9 +1,14 @@
+#include <algorithm>
 #include <eepp/maps/maplightmanager.hpp>
 #include <eepp/maps/tilemap.hpp>
 
 namespace EE { namespace Maps {
 
-MapLightManager::MapLightManager( TileMap* Map, bool ByVertex ) : mMap( Map ), mTileColors( NULL ) {
+// The width and height, in tiles, of the cells of the lights grid.
+#define LIGHT_CELL_SIZE ( 8 )
+
+MapLightManager::MapLightManager( TileMap* Map, bool ByVertex ) :
+	mMap( Map ), mGeneration( 0 ) {
 	mIsByVertex = ByVertex;
 
 	if ( mIsByVertex )
@@ -20,6 +25,8 @@ MapLightManager::~MapLightManager() {
 }
 
 void MapLightManager::update() {
+	syncLights();
+
 	if ( mIsByVertex ) {
 		updateByVertex();
 	} else {
@@ -32,107 +39,215 @@ const bool& MapLightManager::isByVertex() const {
 }
 
 void MapLightManager::updateByVertex() {
-	Vector2i start = mMap->getStartTile();
-	Vector2i end = mMap->getEndTile();
-	Rectf VisibleArea = mMap->getViewAreaAABB();
-	Sizei TileSize = mMap->getTileSize();
-	Color BaseColor = mMap->getBaseColor();
-	bool firstLight = true;
-	Vector2i Pos;
+	if ( !mLights.size() )
+		return;
+
+	// The tiles from start to end have the corners from start to end + 1.
+	updatePoints( mMap->getStartTile(), mMap->getEndTile() + Vector2i( 1, 1 ) );
+}
 
+void MapLightManager::updateByTile() {
 	if ( !mLights.size() )
 		return;
 
-	for ( LightsList::iterator it = mLights.begin(); it != mLights.end(); ++it ) {
-		MapLight* Light = ( *it );
+	updatePoints( mMap->getStartTile(), mMap->getEndTile() );
+}
 
-		if ( firstLight || VisibleArea.intersect( Light->getAABB() ) ) {
-			for ( Int32 x = start.x; x < end.x; x++ ) {
-				for ( Int32 y = start.y; y < end.y; y++ ) {
-					if ( firstLight ) {
-						mTileColors[x][y][0]->r = mTileColors[x][y][1]->r =
-							mTileColors[x][y][2]->r = mTileColors[x][y][3]->r = BaseColor.r;
-						mTileColors[x][y][0]->g = mTileColors[x][y][1]->g =
-							mTileColors[x][y][2]->g = mTileColors[x][y][3]->g = BaseColor.g;
-						mTileColors[x][y][0]->b = mTileColors[x][y][1]->b =
-							mTileColors[x][y][2]->b = mTileColors[x][y][3]->b = BaseColor.b;
-					}
+void MapLightManager::syncLights() {
+	mGeneration++;
 
-					Pos.x = x * TileSize.x;
-					Pos.y = y * TileSize.y;
-
-					Rectf TileAABB( Pos.x, Pos.y, Pos.x + TileSize.x, Pos.y + TileSize.y );
-
-					if ( TileAABB.intersect( Light->getAABB() ) ) {
-						if ( y > 0 )
-							mTileColors[x][y][0]->assign( *mTileColors[x][y - 1][1] );
-						else
-							mTileColors[x][y][0]->assign(
-								Light->processVertex( Pos.x, Pos.y, *( mTileColors[x][y][0] ),
-													  *( mTileColors[x][y][0] ) ) );
-
-						mTileColors[x][y][1]->assign( Light->processVertex(
-							Pos.x, Pos.y + TileSize.getHeight(), *( mTileColors[x][y][1] ),
-							*( mTileColors[x][y][1] ) ) );
-
-						mTileColors[x][y][2]->assign( Light->processVertex(
-							Pos.x + TileSize.getWidth(), Pos.y + TileSize.getHeight(),
-							*( mTileColors[x][y][2] ), *( mTileColors[x][y][2] ) ) );
-
-						if ( y > 0 )
-							mTileColors[x][y][3]->assign( *mTileColors[x][y - 1][2] );
-						else
-							mTileColors[x][y][3]->assign( Light->processVertex(
-								Pos.x + TileSize.getWidth(), Pos.y, *( mTileColors[x][y][3] ),
-								*( mTileColors[x][y][3] ) ) );
-					}
-				}
+	if ( mMap->getBaseColor() != mBaseColor ) {
+		mBaseColor = mMap->getBaseColor();
+		invalidate();
+	}
+
+	Uint32 index = 0;
+	bool reordered = false;
+
+	for ( LightsList::iterator it = mLights.begin(); it != mLights.end(); ++it, ++index ) {
+		MapLight* Light = ( *it );
+		auto found = mLightStates.find( Light );
+		LightState* state;
+
+		if ( found == mLightStates.end() ) {
+			state = &mLightStates[Light];
+			state->light = Light;
+			state->indexed = false;
+		} else {
+			state = &found->second;
+
+			if ( state->index == index && state->aabb == Light->getAABB() &&
+				 state->radius == Light->getRadius() && state->color == Light->getColor() &&
+				 state->type == Light->getType() && state->active == Light->isActive() ) {
+				state->generation = mGeneration;
+				continue;
 			}
 
-			firstLight = false;
+			invalidatePoints( state->aabb );
+			removeFromCells( state );
+			reordered |= state->index != index;
+		}
+
+		state->index = index;
+		state->generation = mGeneration;
+		state->aabb = Light->getAABB();
+		state->radius = Light->getRadius();
+		state->color = Light->getColor();
+		state->type = Light->getType();
+		state->active = Light->isActive();
+
+		invalidatePoints( state->aabb );
+		addToCells( state );
+	}
+
+	// The lights not found in the list were removed ( and could be already released ).
+	for ( auto it = mLightStates.begin(); it != mLightStates.end(); ) {
+		if ( it->second.generation != mGeneration ) {
+			invalidatePoints( it->second.aabb );
+			removeFromCells( &it->second );
+			it = mLightStates.erase( it );
+		} else {
+			++it;
+		}
+	}
+
+	// The lights are applied in the order of the list.
+	if ( reordered ) {
+		for ( auto& cell : mCells ) {
+			std::sort( cell.begin(), cell.end(), []( const LightState* a, const LightState* b ) {
+				return a->index < b->index;
+			} );
 		}
 	}
 }
 
-void MapLightManager::updateByTile() {
-	Vector2i start = mMap->getStartTile();
-	Vector2i end = mMap->getEndTile();
-	Rectf VisibleArea = mMap->getViewAreaAABB();
-	Sizei TileSize = mMap->getTileSize();
-	Sizei HalfTileSize = mMap->getTileSize() / 2;
-	Color BaseColor = mMap->getBaseColor();
-	bool firstLight = true;
-	Vector2i Pos;
+void MapLightManager::updatePoints( const Vector2i& start, const Vector2i& end ) {
+	Int32 endX = eemin( end.x, mPointsSize.x );
+	Int32 endY = eemin( end.y, mPointsSize.y );
 
-	if ( !mLights.size() )
+	if ( start.x >= endX || start.y >= endY )
 		return;
 
-	for ( LightsList::iterator it = mLights.begin(); it != mLights.end(); ++it ) {
-		MapLight* Light = ( *it );
+	for ( Int32 cy = start.y / LIGHT_CELL_SIZE; cy <= ( endY - 1 ) / LIGHT_CELL_SIZE; cy++ ) {
+		for ( Int32 cx = start.x / LIGHT_CELL_SIZE; cx <= ( endX - 1 ) / LIGHT_CELL_SIZE; cx++ ) {
+			Uint32& dirtyCount = mCellsDirtyCount[cx + cy * mCellsSize.x];
 
-		if ( firstLight || VisibleArea.intersect( Light->getAABB() ) ) {
-			for ( Int32 x = start.x; x < end.x; x++ ) {
-				for ( Int32 y = start.y; y < end.y; y++ ) {
-					if ( firstLight ) {
-						mTileColors[x][y][0]->r = BaseColor.r;
-						mTileColors[x][y][0]->g = BaseColor.g;
-						mTileColors[x][y][0]->b = BaseColor.b;
-					}
+			if ( 0 == dirtyCount )
+				continue;
 
-					Pos.x = x * TileSize.x;
-					Pos.y = y * TileSize.y;
+			Int32 x0 = eemax( start.x, cx * LIGHT_CELL_SIZE );
+			Int32 x1 = eemin( endX, ( cx + 1 ) * LIGHT_CELL_SIZE );
+			Int32 y0 = eemax( start.y, cy * LIGHT_CELL_SIZE );
+			Int32 y1 = eemin( endY, ( cy + 1 ) * LIGHT_CELL_SIZE );
 
-					Rectf TileAABB( Pos.x, Pos.y, Pos.x + TileSize.x, Pos.y + TileSize.y );
+			for ( Int32 y = y0; y < y1; y++ ) {
+				for ( Int32 x = x0; x < x1; x++ ) {
+					Int32 i = x + y * mPointsSize.x;
 
-					if ( TileAABB.intersect( Light->getAABB() ) ) {
-						mTileColors[x][y][0]->assign( Light->processVertex(
-							Pos.x + HalfTileSize.getWidth(), Pos.y + HalfTileSize.getHeight(),
-							*( mTileColors[x][y][0] ), *( mTileColors[x][y][0] ) ) );
+					if ( mDirty[i] ) {
+						mColors[i] = computePoint( x, y );
+						mDirty[i] = 0;
+						dirtyCount--;
 					}
 				}
 			}
+		}
+	}
+}
+
+Color MapLightManager::computePoint( const Int32& x, const Int32& y ) {
+	Sizei TileSize = mMap->getTileSize();
+	Vector2f Pos( x * TileSize.x + mPointsOffset.x, y * TileSize.y + mPointsOffset.y );
+	Color Col( mBaseColor.r, mBaseColor.g, mBaseColor.b, 255 );
+	const std::vector<LightState*>& cell =
+		mCells[x / LIGHT_CELL_SIZE + ( y / LIGHT_CELL_SIZE ) * mCellsSize.x];
+
+	for ( const auto& state : cell ) {
+		if ( state->aabb.contains( Pos ) )
+			Col = state->light->processVertex( Pos.x, Pos.y, Col, Col );
+	}
+
+	return Col;
+}
+
+bool MapLightManager::getPointsRange( const Rectf& aabb, Vector2i& start, Vector2i& end ) {
+	Sizei TileSize = mMap->getTileSize();
+
+	if ( TileSize.x <= 0 || TileSize.y <= 0 )
+		return false;
+
+	// Inclusive range, it can contain some points outside the AABB.
+	start.x = eemax( 0, (Int32)eefloor( ( aabb.Left - mPointsOffset.x ) / TileSize.x ) );
+	start.y = eemax( 0, (Int32)eefloor( ( aabb.Top - mPointsOffset.y ) / TileSize.y ) );
+	end.x = eemin( mPointsSize.x - 1,
+				   (Int32)eeceil( ( aabb.Right - mPointsOffset.x ) / TileSize.x ) );
+	end.y = eemin( mPointsSize.y - 1,
+				   (Int32)eeceil( ( aabb.Bottom - mPointsOffset.y ) / TileSize.y ) );
 
-			firstLight = false;
+	return start.x <= end.x && start.y <= end.y;
+}
+
+void MapLightManager::invalidatePoints( const Rectf& aabb ) {
+	Vector2i start, end;
+
+	if ( !getPointsRange( aabb, start, end ) )
+		return;
+
+	for ( Int32 y = start.y; y <= end.y; y++ ) {
+		for ( Int32 x = start.x; x <= end.x; x++ ) {
+			Int32 i = x + y * mPointsSize.x;
+
+			if ( !mDirty[i] ) {
+				mDirty[i] = 1;
+				mCellsDirtyCount[x / LIGHT_CELL_SIZE + ( y / LIGHT_CELL_SIZE ) * mCellsSize.x]++;
+			}
+		}
+	}
+}
+
+void MapLightManager::addToCells( LightState* state ) {
+	Vector2i start, end;
+
+	if ( !getPointsRange( state->aabb, start, end ) )
+		return;
+
+	for ( Int32 cy = start.y / LIGHT_CELL_SIZE; cy <= end.y / LIGHT_CELL_SIZE; cy++ ) {
+		for ( Int32 cx = start.x / LIGHT_CELL_SIZE; cx <= end.x / LIGHT_CELL_SIZE; cx++ ) {
+			std::vector<LightState*>& cell = mCells[cx + cy * mCellsSize.x];
+			cell.insert( std::upper_bound( cell.begin(), cell.end(), state,
+										   []( const LightState* a, const LightState* b ) {
+											   return a->index < b->index;
+										   } ),
+						 state );
+		}
+	}
+
+	state->indexed = true;
+}
+
+void MapLightManager::removeFromCells( LightState* state ) {
+	Vector2i start, end;
+
+	if ( !state->indexed || !getPointsRange( state->aabb, start, end ) )
+		return;
+
+	for ( Int32 cy = start.y / LIGHT_CELL_SIZE; cy <= end.y / LIGHT_CELL_SIZE; cy++ ) {
+		for ( Int32 cx = start.x / LIGHT_CELL_SIZE; cx <= end.x / LIGHT_CELL_SIZE; cx++ ) {
+			std::vector<LightState*>& cell = mCells[cx + cy * mCellsSize.x];
+			cell.erase( std::remove( cell.begin(), cell.end(), state ), cell.end() );
+		}
+	}
+
+	state->indexed = false;
+}
+
+void MapLightManager::invalidate() {
+	std::fill( mDirty.begin(), mDirty.end(), 1 );
+	std::fill( mCellsDirtyCount.begin(), mCellsDirtyCount.end(), 0 );
+
+	for ( Int32 y = 0; y < mPointsSize.y; y++ ) {
+		for ( Int32 x = 0; x < mPointsSize.x; x++ ) {
+			mCellsDirtyCount[x / LIGHT_CELL_SIZE + ( y / LIGHT_CELL_SIZE ) * mCellsSize.x]++;
 		}
 	}
 }
@@ -183,7 +298,7 @@ const Color* MapLightManager::getTileColor( const Vector2i& TilePos ) {
 	if ( !mLights.size() )
 		return &mMap->getBaseColor();
 
-	return mTileColors[TilePos.x][TilePos.y][0];
+	return &mColors[TilePos.x + TilePos.y * mPointsSize.x];
 }
 
 const Color* MapLightManager::getTileColor( const Vector2i& TilePos, const Uint32& Vertex ) {
@@ -192,42 +307,42 @@ const Color* MapLightManager::getTileColor( const Vector2i& TilePos, const Uint3
 	if ( !mLights.size() )
 		return &mMap->getBaseColor();
 
-	return mTileColors[TilePos.x][TilePos.y][Vertex];
+	// The vertices are the top left, bottom left, bottom right and top right corners.
+	Int32 x = TilePos.x + ( Vertex >= 2 ? 1 : 0 );
+	Int32 y = TilePos.y + ( Vertex == 1 || Vertex == 2 ? 1 : 0 );
+
+	return &mColors[x + y * mPointsSize.x];
 }
 
 void MapLightManager::allocateColors() {
 	Sizei Size = mMap->getSize();
-	mTileColors = eeNewArray( Color***, Size.getWidth() );
+	Sizei TileSize = mMap->getTileSize();
 
-	for ( Int32 x = 0; x < Size.x; x++ ) {
-		mTileColors[x] = eeNewArray( Color**, Size.getHeight() );
+	if ( mIsByVertex ) {
+		mPointsSize = Sizei( Size.x + 1, Size.y + 1 );
+		mPointsOffset = Vector2f( 0, 0 );
+	} else {
+		mPointsSize = Size;
+		mPointsOffset = Vector2f( TileSize.x / 2, TileSize.y / 2 );
+	}
 
-		for ( Int32 y = 0; y < Size.y; y++ ) {
-			mTileColors[x][y] = eeNewArray( Color*, mNumVertex );
+	mCellsSize = Sizei( ( mPointsSize.x + LIGHT_CELL_SIZE - 1 ) / LIGHT_CELL_SIZE,
+						( mPointsSize.y + LIGHT_CELL_SIZE - 1 ) / LIGHT_CELL_SIZE );
+	mColors.assign( mPointsSize.x * mPointsSize.y, Color( 255, 255, 255, 255 ) );
+	mDirty.resize( mColors.size() );
+	mCellsDirtyCount.resize( mCellsSize.x * mCellsSize.y );
+	mCells.assign( mCellsDirtyCount.size(), std::vector<LightState*>() );
+	mBaseColor = mMap->getBaseColor();
 
-			for ( Int32 v = 0; v < mNumVertex; v++ ) {
-				mTileColors[x][y][v] = eeNew( Color, ( 255, 255, 255, 255 ) );
-			}
-		}
-	}
+	invalidate();
 }
 
 void MapLightManager::deallocateColors() {
-	Sizei Size = mMap->getSize();
-
-	for ( Int32 x = 0; x < Size.x; x++ ) {
-		for ( Int32 y = 0; y < Size.y; y++ ) {
-			for ( Int32 v = 0; v < mNumVertex; v++ ) {
-				eeSAFE_DELETE( mTileColors[x][y][v] );
-			}
-
-			eeSAFE_DELETE_ARRAY( mTileColors[x][y] );
-		}
-
-		eeSAFE_DELETE_ARRAY( mTileColors[x] );
-	}
-
-	eeSAFE_DELETE_ARRAY( mTileColors );
+	mColors.clear();
+	mDirty.clear();
+	mCellsDirtyCount.clear();
+	mCells.clear();
+	mLightStates.clear();
 }
 
 void MapLightManager::destroyLights() {
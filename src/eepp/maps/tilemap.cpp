@@ -958,6 +958,13 @@ bool TileMap::loadFromStream( IOStream& IOS ) {
 
 									IOS.read( (char*)&tTGOHdr, sizeof( sMapTileGOHdr ) );
 
+									//! The texture region tiles are stored as compact tiles,
+									//! without creating a game object.
+									if ( tTGOHdr.Type == GAMEOBJECT_TYPE_TEXTUREREGION &&
+										 tTLayer->addTile( Vector2i( x, y ), tTGOHdr.Id,
+														   tTGOHdr.Flags ) )
+										continue;
+
 									tGO = createGameObject( tTGOHdr.Type, tTGOHdr.Flags, mLayers[i],
 															tTGOHdr.Id );
 
@@ -1268,7 +1275,9 @@ void TileMap::saveToStream( IOStream& IOS ) {
 						if ( NULL != tLayer && tLayer->getType() == MAP_LAYER_TILED ) {
 							tTLayer = reinterpret_cast<TileMapLayer*>( tLayer );
 
-							tObj = tTLayer->getGameObject( Vector2i( x, y ) );
+							//! Compact tiles are returned as a game object of the layer that
+							//! is valid until the next call, one per layer is kept.
+							tObj = tTLayer->findTile( x, y );
 
 							if ( NULL != tObj ) {
 								tReadFlag |= 1 << i;
@@ -1475,7 +1484,7 @@ bool TileMap::isTileBlocked( const Vector2i& TilePos ) {
 	for ( Uint32 i = 0; i < mLayerCount; i++ ) {
 		if ( mLayers[i]->getType() == MAP_LAYER_TILED ) {
 			TLayer = static_cast<TileMapLayer*>( mLayers[i] );
-			TObj = TLayer->getGameObject( TilePos );
+			TObj = TLayer->findTile( TilePos.x, TilePos.y );
 
 			if ( NULL != TObj && TObj->isBlocked() ) {
 				return true;
@@ -1500,12 +1509,12 @@ GameObject* TileMap::IsTypeInTilePos( const Uint32& Type, const Vector2i& TilePo
 	for ( Uint32 i = 0; i < mLayerCount; i++ ) {
 		if ( mLayers[i]->getType() == MAP_LAYER_TILED ) {
 			TileMapLayer* tLayer = reinterpret_cast<TileMapLayer*>( mLayers[i] );
-			GameObject* tObj = NULL;
+			GameObject* tObj = tLayer->findTile( TilePos.x, TilePos.y );
 
-			if ( ( tObj = tLayer->getGameObject( TilePos ) ) ) {
-				if ( tObj->isType( Type ) ) {
-					return tObj;
-				}
+			if ( NULL != tObj && tObj->isType( Type ) ) {
+				// A compact tile is found as a shared object, only a matching tile is converted
+				// into its own game object, so the returned pointer stays valid.
+				return tObj == tLayer->mTileObject ? tLayer->getGameObject( TilePos ) : tObj;
 			}
 		}
 	}
@@ -1,21 +1,31 @@
+#include <eepp/maps/gameobjecttextureregion.hpp>
 #include <eepp/maps/tilemap.hpp>
 #include <eepp/maps/tilemaplayer.hpp>
 
 #include <eepp/graphics/globalbatchrenderer.hpp>
 #include <eepp/graphics/renderer/renderer.hpp>
 #include <eepp/graphics/texture.hpp>
+#include <eepp/graphics/textureatlasmanager.hpp>
+#include <eepp/graphics/vertexbuffer.hpp>
 using namespace EE::Graphics;
 
 namespace EE { namespace Maps {
 
+static Uint16 getTileIndex( const Int32& x, const Int32& y ) {
+	return static_cast<Uint16>( ( x % TileMapLayer::ChunkSize ) * TileMapLayer::ChunkSize +
+								y % TileMapLayer::ChunkSize );
+}
+
 TileMapLayer::TileMapLayer( TileMap* map, Sizei size, Uint32 flags, std::string name,
 							Vector2f offset ) :
-	MapLayer( map, MAP_LAYER_TILED, flags, name, offset ), mSize( size ) {
+	MapLayer( map, MAP_LAYER_TILED, flags, name, offset ), mSize( size ), mTileObject( NULL ) {
 	allocateLayer();
 }
 
 TileMapLayer::~TileMapLayer() {
 	deallocateLayer();
+
+	eeSAFE_DELETE( mTileObject );
 }
 
 void TileMapLayer::draw( const Vector2f& Offset ) {
@@ -27,13 +37,19 @@ void TileMapLayer::draw( const Vector2f& Offset ) {
 	Vector2i start = mMap->getStartTile();
 	Vector2i end = mMap->getEndTile();
 
-	for ( Int32 x = start.x; x < end.x; x++ ) {
-		for ( Int32 y = start.y; y < end.y; y++ ) {
-			mCurTile.x = x;
-			mCurTile.y = y;
+	if ( isBatched() && !( mMap->getLightsEnabled() && getLightsEnabled() ) ) {
+		drawBatched( start, end );
+	} else {
+		for ( Int32 x = start.x; x < end.x; x++ ) {
+			for ( Int32 y = start.y; y < end.y; y++ ) {
+				GameObject* obj = findTile( x, y );
+
+				if ( NULL != obj ) {
+					mCurTile.x = x;
+					mCurTile.y = y;
 
-			if ( NULL != mTiles[x][y] ) {
-				mTiles[x][y]->draw();
+					obj->draw();
+				}
 			}
 		}
 	}
@@ -43,11 +59,11 @@ void TileMapLayer::draw( const Vector2f& Offset ) {
 	if ( mMap->getShowBlocked() && NULL != Tex ) {
 		for ( Int32 x = start.x; x < end.x; x++ ) {
 			for ( Int32 y = start.y; y < end.y; y++ ) {
-				if ( NULL != mTiles[x][y] ) {
-					if ( mTiles[x][y]->isBlocked() ) {
-						Tex->draw( x * mMap->getTileSize().x, y * mMap->getTileSize().y, 0,
-								   Vector2f::One, Color( 255, 0, 0, 200 ) );
-					}
+				GameObject* obj = findTile( x, y );
+
+				if ( NULL != obj && obj->isBlocked() ) {
+					Tex->draw( x * mMap->getTileSize().x, y * mMap->getTileSize().y, 0,
+							   Vector2f::One, Color( 255, 0, 0, 200 ) );
 				}
 			}
 		}
@@ -58,44 +74,308 @@ void TileMapLayer::draw( const Vector2f& Offset ) {
 	GLi->popMatrix();
 }
 
+void TileMapLayer::drawBatched( const Vector2i& start, const Vector2i& end ) {
+	if ( start.x >= end.x || start.y >= end.y )
+		return;
+
+	for ( Int32 cx = start.x / ChunkSize; cx <= ( end.x - 1 ) / ChunkSize; cx++ ) {
+		for ( Int32 cy = start.y / ChunkSize; cy <= ( end.y - 1 ) / ChunkSize; cy++ ) {
+			Chunk* chunk = mChunks[cx + cy * mChunksSize.x];
+
+			if ( NULL == chunk )
+				continue;
+
+			if ( chunk->dirty )
+				buildBatches( chunk, cx, cy );
+
+			for ( auto& batch : chunk->batches ) {
+				if ( NULL != batch.vertexBuffer ) {
+					// The tiles drawn before must be flushed to keep the draw order.
+					GlobalBatchRenderer::instance()->draw();
+
+					BlendMode::setMode( BlendAlpha );
+
+					batch.texture->bind();
+					batch.vertexBuffer->bind();
+					batch.vertexBuffer->draw();
+					batch.vertexBuffer->unbind();
+					continue;
+				}
+
+				// Only the visible tiles that aren't batched are drawn.
+				Int32 x = cx * ChunkSize + batch.tile / ChunkSize;
+				Int32 y = cy * ChunkSize + batch.tile % ChunkSize;
+
+				if ( x >= start.x && x < end.x && y >= start.y && y < end.y ) {
+					mCurTile.x = x;
+					mCurTile.y = y;
+
+					getTileObject( chunk, batch.tile, x, y )->draw();
+				}
+			}
+		}
+	}
+}
+
 void TileMapLayer::update( const Time& dt ) {
 	Vector2i start = mMap->getStartTile();
 	Vector2i end = mMap->getEndTile();
 
 	for ( Int32 x = start.x; x < end.x; x++ ) {
 		for ( Int32 y = start.y; y < end.y; y++ ) {
-			mCurTile.x = x;
-			mCurTile.y = y;
+			Chunk* chunk = getChunk( x, y );
+
+			// Compact tiles are static, only the game objects are updated.
+			if ( NULL != chunk && ObjectTile == chunk->tiles[getTileIndex( x, y )] ) {
+				mCurTile.x = x;
+				mCurTile.y = y;
 
-			if ( NULL != mTiles[x][y] ) {
-				mTiles[x][y]->update( dt );
+				chunk->objects[getTileIndex( x, y )]->update( dt );
 			}
 		}
 	}
 }
 
 void TileMapLayer::allocateLayer() {
-	mTiles = eeNewArray( GameObject**, mSize.getWidth() );
+	// The chunks are allocated when their first tile is added, empty regions of the map don't use
+	// memory.
+	mChunksSize = Sizei( ( mSize.getWidth() + ChunkSize - 1 ) / ChunkSize,
+						 ( mSize.getHeight() + ChunkSize - 1 ) / ChunkSize );
+	mChunks.assign( mChunksSize.getWidth() * mChunksSize.getHeight(), NULL );
+}
 
-	for ( Int32 x = 0; x < mSize.x; x++ ) {
-		mTiles[x] = eeNewArray( GameObject*, mSize.getHeight() );
+void TileMapLayer::deallocateLayer() {
+	for ( auto& chunk : mChunks ) {
+		if ( NULL != chunk ) {
+			for ( auto& object : chunk->objects )
+				eeDelete( object.second );
 
-		for ( Int32 y = 0; y < mSize.y; y++ ) {
-			mTiles[x][y] = NULL;
+			clearBatches( chunk );
+			eeSAFE_DELETE( chunk );
 		}
 	}
+
+	mChunks.clear();
 }
 
-void TileMapLayer::deallocateLayer() {
-	for ( Int32 x = 0; x < mSize.x; x++ ) {
-		for ( Int32 y = 0; y < mSize.y; y++ ) {
-			eeSAFE_DELETE( mTiles[x][y] );
+TileMapLayer::Chunk* TileMapLayer::getChunk( const Int32& x, const Int32& y ) const {
+	return mChunks[x / ChunkSize + ( y / ChunkSize ) * mChunksSize.x];
+}
+
+bool TileMapLayer::addTile( const Vector2i& TilePos, const Uint32& RegionId,
+							const Uint32& Flags ) {
+	eeASSERT( TilePos.x >= 0 && TilePos.y >= 0 );
+
+	if ( TilePos.x >= mSize.x || TilePos.y >= mSize.y )
+		return true;
+
+	if ( Flags >> ( 32 - TileFlagsShift ) )
+		return false;
+
+	TextureRegion* region = TextureAtlasManager::instance()->getTextureRegionById( RegionId );
+
+	if ( NULL == region )
+		return false;
+
+	Uint32 id;
+	auto it = mRegionIds.find( region );
+
+	if ( it != mRegionIds.end() ) {
+		id = it->second;
+	} else {
+		// The highest id is reserved, with all the flags set it would be an ObjectTile.
+		if ( mRegions.size() + 1 >= TileRegionMask )
+			return false;
+
+		mRegions.push_back( region );
+		id = mRegions.size();
+		mRegionIds[region] = id;
+	}
+
+	removeGameObject( TilePos );
+
+	setTile( TilePos, id | ( Flags << TileFlagsShift ) );
+
+	return true;
+}
+
+GameObject* TileMapLayer::findTile( const Int32& x, const Int32& y ) {
+	Chunk* chunk = getChunk( x, y );
+
+	if ( NULL == chunk )
+		return NULL;
+
+	return getTileObject( chunk, getTileIndex( x, y ), x, y );
+}
+
+GameObject* TileMapLayer::getTileObject( Chunk* chunk, const Uint16& index, const Int32& x,
+										 const Int32& y ) {
+	Uint32 tile = chunk->tiles[index];
+
+	if ( 0 == tile )
+		return NULL;
+
+	if ( ObjectTile == tile )
+		return chunk->objects[index];
+
+	if ( NULL == mTileObject )
+		mTileObject = eeNew( GameObjectTextureRegion, ( 0, this ) );
+
+	// The flags are set after the position, so the shared object never tries to move its tile.
+	mTileObject->clearFlag( 0xFFFFFFFF );
+	mTileObject->setTextureRegion( mRegions[( tile & TileRegionMask ) - 1] );
+	mTileObject->setPosition(
+		Vector2f( x * mMap->getTileSize().x, y * mMap->getTileSize().y ) );
+	mTileObject->setFlag( tile >> TileFlagsShift );
+
+	return mTileObject;
+}
+
+void TileMapLayer::setTile( const Vector2i& TilePos, const Uint32& tile, GameObject* obj ) {
+	Chunk*& chunk = mChunks[TilePos.x / ChunkSize + ( TilePos.y / ChunkSize ) * mChunksSize.x];
+
+	if ( NULL == chunk ) {
+		if ( 0 == tile )
+			return;
+
+		chunk = eeNew( Chunk, () );
+		chunk->count = 0;
+
+		for ( Int32 i = 0; i < ChunkSize * ChunkSize; i++ )
+			chunk->tiles[i] = 0;
+	}
+
+	Uint16 index = getTileIndex( TilePos.x, TilePos.y );
+	Uint32& current = chunk->tiles[index];
+
+	if ( 0 == current && 0 != tile ) {
+		chunk->count++;
+	} else if ( 0 != current && 0 == tile ) {
+		chunk->count--;
+	}
+
+	if ( ObjectTile == current )
+		chunk->objects.erase( index );
+
+	if ( ObjectTile == tile )
+		chunk->objects[index] = obj;
+
+	current = tile;
+	chunk->dirty = true;
+
+	if ( 0 == chunk->count ) {
+		clearBatches( chunk );
+		eeSAFE_DELETE( chunk );
+	}
+}
+
+void TileMapLayer::clearBatches( Chunk* chunk ) {
+	for ( auto& batch : chunk->batches )
+		eeSAFE_DELETE( batch.vertexBuffer );
+
+	chunk->batches.clear();
+}
+
+void TileMapLayer::buildBatches( Chunk* chunk, const Int32& cx, const Int32& cy ) {
+	clearBatches( chunk );
+
+	bool quads = GLi->quadsSupported();
+	Uint32 unbatchedFlags = GObjFlags::GAMEOBJECT_MIRRORED | GObjFlags::GAMEOBJECT_FLIPED |
+							GObjFlags::GAMEOBJECT_ROTATE_90DEG | GObjFlags::GAMEOBJECT_BLEND_ADD;
+
+	for ( Int32 i = 0; i < ChunkSize * ChunkSize; i++ ) {
+		Uint32 tile = chunk->tiles[i];
+
+		if ( 0 == tile )
+			continue;
+
+		TextureRegion* region = NULL;
+		Vector2f pos;
+
+		if ( ObjectTile == tile ) {
+			GameObject* obj = chunk->objects[i];
+
+			if ( obj->getType() == GAMEOBJECT_TYPE_TEXTUREREGION &&
+				 !( obj->getFlags() & unbatchedFlags ) )
+				region = static_cast<GameObjectTextureRegion*>( obj )->getTextureRegion();
+
+			pos = obj->getPosition();
+		} else {
+			if ( !( ( tile >> TileFlagsShift ) & unbatchedFlags ) )
+				region = mRegions[( tile & TileRegionMask ) - 1];
+
+			pos = Vector2f( ( cx * ChunkSize + i / ChunkSize ) * mMap->getTileSize().x,
+							( cy * ChunkSize + i % ChunkSize ) * mMap->getTileSize().y );
+		}
+
+		Texture* texture = NULL != region ? region->getTexture() : NULL;
+
+		if ( NULL == texture || texture->getClampMode() == Texture::ClampMode::ClampRepeat ) {
+			chunk->batches.push_back( { NULL, NULL, static_cast<Uint16>( i ) } );
+			continue;
+		}
+
+		// Consecutive tiles with the same texture share the vertex buffer, a tile drawn by its game
+		// object or with another texture starts a new one, so the tiles keep their draw order.
+		if ( chunk->batches.empty() || chunk->batches.back().texture != texture ) {
+			chunk->batches.push_back(
+				{ texture,
+				  VertexBuffer::New( VERTEX_FLAGS_DEFAULT,
+									 quads ? PRIMITIVE_QUADS : PRIMITIVE_TRIANGLES ),
+				  static_cast<Uint16>( i ) } );
 		}
 
-		eeSAFE_DELETE_ARRAY( mTiles[x] );
+		VertexBuffer* vertexBuffer = chunk->batches.back().vertexBuffer;
+
+		// Same geometry that GameObjectTextureRegion::draw renders.
+		pos += Vector2f( region->getOffset().x, region->getOffset().y );
+		Sizei size( region->getRealSize() );
+		const Rect& src = region->getSrcRect();
+		Float w = (Float)texture->getImageWidth();
+		Float h = (Float)texture->getImageHeight();
+		Vector2f pos0( pos.x, pos.y );
+		Vector2f pos1( pos.x, pos.y + size.getHeight() );
+		Vector2f pos2( pos.x + size.getWidth(), pos.y + size.getHeight() );
+		Vector2f pos3( pos.x + size.getWidth(), pos.y );
+		Vector2f tex0( src.Left / w, src.Top / h );
+		Vector2f tex1( src.Left / w, src.Bottom / h );
+		Vector2f tex2( src.Right / w, src.Bottom / h );
+		Vector2f tex3( src.Right / w, src.Top / h );
+
+		if ( quads ) {
+			vertexBuffer->addVertex( pos0 );
+			vertexBuffer->addVertex( pos1 );
+			vertexBuffer->addVertex( pos2 );
+			vertexBuffer->addVertex( pos3 );
+			vertexBuffer->addTextureCoord( tex0 );
+			vertexBuffer->addTextureCoord( tex1 );
+			vertexBuffer->addTextureCoord( tex2 );
+			vertexBuffer->addTextureCoord( tex3 );
+		} else {
+			vertexBuffer->addVertex( pos1 );
+			vertexBuffer->addVertex( pos0 );
+			vertexBuffer->addVertex( pos3 );
+			vertexBuffer->addVertex( pos1 );
+			vertexBuffer->addVertex( pos2 );
+			vertexBuffer->addVertex( pos3 );
+			vertexBuffer->addTextureCoord( tex1 );
+			vertexBuffer->addTextureCoord( tex0 );
+			vertexBuffer->addTextureCoord( tex3 );
+			vertexBuffer->addTextureCoord( tex1 );
+			vertexBuffer->addTextureCoord( tex2 );
+			vertexBuffer->addTextureCoord( tex3 );
+		}
+
+		for ( Int32 v = 0; v < ( quads ? 4 : 6 ); v++ )
+			vertexBuffer->addColor( Color::White );
+	}
+
+	for ( auto& batch : chunk->batches ) {
+		if ( NULL != batch.vertexBuffer )
+			batch.vertexBuffer->compile();
 	}
 
-	eeSAFE_DELETE_ARRAY( mTiles );
+	chunk->dirty = false;
 }
 
 void TileMapLayer::addGameObject( GameObject* obj, const Vector2i& TilePos ) {
@@ -104,7 +384,7 @@ void TileMapLayer::addGameObject( GameObject* obj, const Vector2i& TilePos ) {
 	if ( TilePos.x < mSize.x && TilePos.y < mSize.y ) {
 		removeGameObject( TilePos );
 
-		mTiles[TilePos.x][TilePos.y] = obj;
+		setTile( TilePos, ObjectTile, obj );
 
 		obj->setPosition(
 			Vector2f( TilePos.x * mMap->getTileSize().x, TilePos.y * mMap->getTileSize().y ) );
@@ -115,24 +395,83 @@ void TileMapLayer::removeGameObject( const Vector2i& TilePos ) {
 	eeASSERT( TilePos.x >= 0 && TilePos.y >= 0 );
 
 	if ( TilePos.x < mSize.x && TilePos.y < mSize.y ) {
-		if ( NULL != mTiles[TilePos.x][TilePos.y] ) {
-			eeSAFE_DELETE( mTiles[TilePos.x][TilePos.y] );
-		}
+		Chunk* chunk = getChunk( TilePos.x, TilePos.y );
+
+		if ( NULL == chunk )
+			return;
+
+		Uint16 index = getTileIndex( TilePos.x, TilePos.y );
+		GameObject* obj = ObjectTile == chunk->tiles[index] ? chunk->objects[index] : NULL;
+
+		setTile( TilePos, 0 );
+
+		eeSAFE_DELETE( obj );
 	}
 }
 
 void TileMapLayer::moveTileObject( const Vector2i& FromPos, const Vector2i& ToPos ) {
 	removeGameObject( ToPos );
 
-	GameObject* tObj = mTiles[FromPos.x][FromPos.y];
+	// A compact tile is converted into a GameObject, since the object keeps its position.
+	GameObject* tObj = getGameObject( FromPos );
 
-	mTiles[FromPos.x][FromPos.y] = NULL;
+	setTile( FromPos, 0 );
 
-	mTiles[ToPos.x][ToPos.y] = tObj;
+	if ( NULL != tObj )
+		setTile( ToPos, ObjectTile, tObj );
 }
 
 GameObject* TileMapLayer::getGameObject( const Vector2i& TilePos ) {
-	return mTiles[TilePos.x][TilePos.y];
+	Chunk* chunk = getChunk( TilePos.x, TilePos.y );
+
+	if ( NULL == chunk )
+		return NULL;
+
+	Uint16 index = getTileIndex( TilePos.x, TilePos.y );
+	Uint32 tile = chunk->tiles[index];
+
+	if ( 0 == tile )
+		return NULL;
+
+	if ( ObjectTile == tile )
+		return chunk->objects[index];
+
+	TextureRegion* region = mRegions[( tile & TileRegionMask ) - 1];
+	Vector2f pos( TilePos.x * mMap->getTileSize().x, TilePos.y * mMap->getTileSize().y );
+	GameObject* obj =
+		eeNew( GameObjectTextureRegion, ( tile >> TileFlagsShift, this, region, pos ) );
+
+	setTile( TilePos, ObjectTile, obj );
+
+	return obj;
+}
+
+void TileMapLayer::setBatched( const bool& batched ) {
+	batched ? setFlag( LAYER_FLAG_BATCHED ) : clearFlag( LAYER_FLAG_BATCHED );
+}
+
+bool TileMapLayer::isBatched() {
+	return 0 != getFlag( LAYER_FLAG_BATCHED );
+}
+
+void TileMapLayer::invalidateTile( const Vector2i& TilePos ) {
+	if ( TilePos.x >= 0 && TilePos.y >= 0 && TilePos.x < mSize.x && TilePos.y < mSize.y ) {
+		Chunk* chunk = getChunk( TilePos.x, TilePos.y );
+
+		if ( NULL != chunk )
+			chunk->dirty = true;
+	}
+}
+
+Uint32 TileMapLayer::getChunkCount() const {
+	Uint32 count = 0;
+
+	for ( const auto& chunk : mChunks ) {
+		if ( NULL != chunk )
+			count++;
+	}
+
+	return count;
 }
 
 const Vector2i& TileMapLayer::getCurrentTile() const {
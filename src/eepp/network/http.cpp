@@ -1,7 +1,7 @@
 #include <algorithm>
 #include <cctype>
 #include <eepp/network/http.hpp>
-#include <eepp/network/http/httpstreamchunked.hpp>
+#include <eepp/network/http/httpresponseparser.hpp>
 #include <eepp/network/ssl/sslsocket.hpp>
 #include <eepp/network/uri.hpp>
 #include <eepp/system/compression.hpp>
@@ -78,6 +78,7 @@ Http::Request::Request( const std::string& uri, Method method, const std::string
 	mFollowRedirect( followRedirect ),
 	mCompressedResponse( compressedResponse ),
 	mContinue( false ),
+	mSegments( 1 ),
 	mCancel( false ),
 	mMaxRedirections( 10 ),
 	mRedirectionCount( 0 ) {
@@ -202,6 +203,14 @@ const bool& Http::Request::isContinue() const {
 	return mContinue;
 }
 
+void Http::Request::setSegments( const unsigned int& segments ) {
+	mSegments = eemax( 1u, segments );
+}
+
+const unsigned int& Http::Request::getSegments() const {
+	return mSegments;
+}
+
 const bool& Http::Request::isCompressedResponse() const {
 	return mCompressedResponse;
 }
@@ -465,65 +474,10 @@ const std::string& Http::Response::getBody() const {
 }
 
 void Http::Response::parse( const std::string& data ) {
-	std::istringstream in( data );
-
-	// Extract the HTTP version from the first line
-	std::string version;
-
-	if ( in >> version ) {
-		std::locale loc;
-		if ( ( version.size() >= 8 ) && ( version[6] == '.' ) &&
-			 ( String::toLower( version.substr( 0, 5 ) ) == "http/" ) &&
-			 std::isdigit( version[5], loc ) && std::isdigit( version[7], loc ) ) {
-			mMajorVersion = version[5] - '0';
-			mMinorVersion = version[7] - '0';
-		} else {
-			// Invalid HTTP version
-			mStatus = InvalidResponse;
-			return;
-		}
-	}
-
-	// Extract the status code from the first line
-	int status = InvalidResponse;
-
-	if ( in >> status ) {
-		mStatus = static_cast<Status>( status );
-	} else {
-		// Invalid status code
-		mStatus = InvalidResponse;
-		return;
-	}
-
-	// Ignore the end of the first line
-	in.ignore( std::numeric_limits<std::streamsize>::max(), '\n' );
-
-	// Parse the other lines, which contain fields, one by one
-	parseFields( in );
-
+	HttpResponseParser::parseHeader( data.data(), data.size(), *this );
 	mBody.clear();
 }
 
-void Http::Response::parseFields( std::istream& in ) {
-	std::string line;
-	while ( std::getline( in, line ) && ( line.size() > 2 ) ) {
-		std::string::size_type pos = line.find( ": " );
-
-		if ( pos != std::string::npos ) {
-			// Extract the field name and its value
-			std::string field = line.substr( 0, pos );
-			std::string value = line.substr( pos + 2 );
-
-			// Remove any trailing \r
-			if ( !value.empty() && ( *value.rbegin() == '\r' ) )
-				value.erase( value.size() - 1 );
-
-			// Add the field
-			mFields[String::toLower( field )] = value;
-		}
-	}
-}
-
 static Http::Pool sGlobalHttpPool = Http::Pool();
 
 Http::Response Http::request( const URI& uri, Request::Method method, const Time& timeout,
@@ -589,12 +543,23 @@ void Http::postAsync( const Http::AsyncResponseCallback& cb, const URI& uri, con
 				  validateCertificate, proxy );
 }
 
-Http::Http() : mConnection( NULL ), mHost(), mPort( 0 ), mIsSSL( false ), mHostSolved( false ) {}
+Http::Http() :
+	mConnection( NULL ),
+	mHost(),
+	mPort( 0 ),
+	mAsyncClient( NULL ),
+	mCache( NULL ),
+	mAsyncCount( 0 ),
+	mIsSSL( false ),
+	mHostSolved( false ) {}
 
 Http::Http( const std::string& host, unsigned short port, bool useSSL, URI proxy ) :
 	mConnection( NULL ),
 	mHostName( host ),
 	mPort( port ),
+	mAsyncClient( NULL ),
+	mCache( NULL ),
+	mAsyncCount( 0 ),
 	mIsSSL( useSSL ),
 	mHostSolved( false ),
 	mProxy( proxy ) {
@@ -602,21 +567,20 @@ Http::Http( const std::string& host, unsigned short port, bool useSSL, URI proxy
 }
 
 Http::~Http() {
-	std::list<AsyncRequest*>::iterator itt;
-
 	// First we wait to finish any request pending
-	for ( auto&& itt : mThreads ) {
-		itt->wait();
-	}
-
-	for ( auto&& itt : mThreads ) {
-		eeDelete( itt );
+	{
+		std::unique_lock<std::mutex> lock( mAsyncMutex );
+		mAsyncFinished.wait( lock, [this] { return mAsyncCount == 0; } );
 	}
 
 	// Then we destroy the last open connection
-	HttpConnection* connection = mConnection;
+	destroyConnection();
+}
 
+void Http::destroyConnection() {
+	HttpConnection* connection = mConnection;
 	eeSAFE_DELETE( connection );
+	mConnection = NULL;
 }
 
 void Http::setHost( const std::string& host, unsigned short port, bool useSSL, URI proxy ) {
@@ -662,13 +626,18 @@ void Http::setHost( const std::string& host, unsigned short port, bool useSSL, U
 	// and there's an open connection to the host, we close
 	// the old connection to prepare a new one.
 	if ( !sameHost && NULL != mConnection ) {
-		HttpConnection* connection = mConnection;
-		eeSAFE_DELETE( connection );
-		mConnection = NULL;
+		destroyConnection();
 	}
 }
 
 Http::Response Http::sendRequest( const Http::Request& request, Time timeout ) {
+	if ( NULL != mCache )
+		return mCache->sendRequest( *this, request, timeout );
+
+	return sendUncachedRequest( request, timeout );
+}
+
+Http::Response Http::sendUncachedRequest( const Http::Request& request, Time timeout ) {
 	IOStreamString stream;
 	Response response = downloadRequest( request, stream, timeout );
 	response.mBody = std::move( stream.getStream() );
@@ -775,16 +744,14 @@ Http::Response Http::downloadRequest( const Http::Request& request, IOStream& wr
 
 			// Send the request
 			if ( sslSocket->tcpSend( tunnelStr.c_str(), tunnelStr.size(), sent ) == Socket::Done ) {
-				char buffer[PACKET_BUFFER_SIZE + 1];
+				char buffer[PACKET_BUFFER_SIZE];
 				std::size_t readed = 0;
 
 				// Get the proxy server response
 				if ( sslSocket->tcpReceive( buffer, PACKET_BUFFER_SIZE, readed ) == Socket::Done ) {
 					// Parse the HTTP Tunnel request response
 					Response tunnelResponse;
-					std::string header;
-					header.append( buffer, readed );
-					tunnelResponse.parse( header );
+					HttpResponseParser::parseHeader( buffer, readed, tunnelResponse );
 
 					if ( tunnelResponse.getStatus() == Response::Ok ) {
 						// Stablish the SSL connection if the response is positive
@@ -835,7 +802,7 @@ Http::Response Http::downloadRequest( const Http::Request& request, IOStream& wr
 		std::string requestStr = toSend.prepare( *this );
 
 		if ( !requestStr.empty() ) {
-			Socket::Status status;
+			Socket::Status status = Socket::Done;
 
 			// Send it through the socket
 			if ( mConnection->getSocket()->send( requestStr.c_str(), requestStr.size() ) ==
@@ -844,197 +811,76 @@ Http::Response Http::downloadRequest( const Http::Request& request, IOStream& wr
 					request.mCancel = true;
 				}
 
-				// Wait for the server's response
-				std::size_t currentTotalBytes = 0;
-				std::size_t len = 0;
+				// Wait for the server's response, the body is written as it arrives.
+				char buffer[PACKET_BUFFER_SIZE];
 				std::size_t readed = 0;
-				char* eol = NULL; // end of line
-				char* bol = NULL; // beginning of line
-				char buffer[PACKET_BUFFER_SIZE + 1];
-				bool isnheader = false;
-				bool chunked = false;
-				bool compressed = false;
-				std::size_t contentLength = 0;
-				std::string headerBuffer;
-				HttpStreamChunked* chunkedStream = NULL;
-				IOStreamInflate* inflateStream = NULL;
-				IOStream* bufferStream = NULL;
-
-				while ( !request.isCancelled() &&
-						( status = mConnection->getSocket()->receive( buffer, PACKET_BUFFER_SIZE,
-																	  readed ) ) == Socket::Done ) {
-					char* readBuffer = buffer;
-
-					// If we didn't receive the header yet, we will try to find the end of the
-					// header
-					if ( !isnheader ) {
-						// calculate combined length of unprocessed data and new data
-						len += readed;
-
-						// NULL terminate buffer for string functions
-						readBuffer[len] = '\0';
-
-						// process each line in buffer looking for header break
-						bol = readBuffer;
-
-						while ( !isnheader && ( eol = strchr( bol, '\n' ) ) != NULL ) {
-							// update bol based upon the value of eol
-							bol = eol + 1;
-
-							// test if end of headers has been reached
-							if ( 0 == strncmp( bol, "\r\n", 2 ) || 0 == strncmp( bol, "\n", 1 ) ) {
-								// note that end of headers has been reached
-								isnheader = true;
-
-								// update the value of bol to reflect the beginning of the line
-								// immediately after the headers
-								if ( bol[0] != '\n' )
-									bol += 1;
-
-								bol += 1;
-
-								// calculate the amount of data remaining in the buffer
-								len = readed - ( bol - readBuffer );
-
-								// Fill the header buffer
-								headerBuffer.append( readBuffer, ( bol - readBuffer ) );
-
-								if ( !headerBuffer.empty() ) {
-									// Build the Response object from the received data
-									received.parse( headerBuffer );
-
-									// Check if the response is chunked
-									chunked = received.getField( "transfer-encoding" ) == "chunked";
-
-									// Check if the content is compressed
-									std::string encoding( received.getField( "content-encoding" ) );
-									compressed = encoding == "gzip" || encoding == "deflate";
-
-									if ( compressed ) {
-										Compression::Mode compressionMode =
-											"gzip" == encoding ? Compression::MODE_GZIP
-															   : Compression::MODE_DEFLATE;
-
-										inflateStream =
-											IOStreamInflate::New( writeTo, compressionMode );
-									}
-
-									IOStream& writeToStream = compressed ? *inflateStream : writeTo;
-
-									if ( chunked )
-										chunkedStream =
-											eeNew( HttpStreamChunked, ( writeToStream ) );
-
-									bufferStream = chunked
-													   ? chunkedStream
-													   : ( compressed ? inflateStream : &writeTo );
-
-									// Get the content length
-									if ( !received.getField( "content-length" ).empty() ) {
-										if ( !String::fromString(
-												 contentLength,
-												 received.getField( "content-length" ) ) )
-											contentLength = 0;
-									}
-
-									if ( received.getField( "connection" ) == "closed" ) {
-										mConnection->setConnected( false );
-										mConnection->setTunneled( false );
-									}
-
-									// If a redirection is requested, and requests follows
-									// redirections, send a new request to the redirection location.
-									if ( ( received.getStatus() == Response::MovedPermanently ||
-										   received.getStatus() == Response::MovedTemporarily ) &&
-										 request.getFollowRedirect() ) {
-
-										// Only continue redirecting if less than 10 redirections
-										// were done
-										if ( request.mRedirectionCount <
-											 request.getMaxRedirects() ) {
-											std::string location( received.getField( "location" ) );
-											URI uri( location );
-											Http http( uri.getHost(), uri.getPort(),
-													   uri.getScheme() == "https" ? true : false );
-											Http::Request newRequest( request );
-											newRequest.setUri( uri.getPathEtc() );
-
-											// Close the connection
-											if ( !mConnection->isKeepAlive() )
-												mConnection->disconnect();
-
-											request.mRedirectionCount++;
-
-											eeSAFE_DELETE( chunkedStream );
-											eeSAFE_DELETE( inflateStream );
-											return http.downloadRequest( request, writeTo,
-																		 timeout );
-										}
-									}
-
-									if ( !sendProgress( *this, request, received,
-														Request::HeaderReceived, contentLength,
-														0 ) ) {
-										request.mCancel = true;
-									}
-
-									// Move the readBuffer to the starting point
-									// of the file buffer
-									if ( len > 0 ) {
-										readBuffer = bol;
-										readed = len;
-									} else {
-										readed = 0;
-									}
-
-									headerBuffer.clear();
-								}
-							}
-						}
-
-						if ( !isnheader ) {
-							headerBuffer.append( readBuffer, ( bol - readBuffer ) );
-						}
+				std::string location;
+				HttpResponseParser parser;
+				parser.reset( request.getMethod() == Request::Head );
+
+				parser.setHeaderCallback( [&]( HttpResponseParser& parser ) {
+					parser.fillResponse( received );
+
+					// If a redirection is requested, and requests follows redirections, the body
+					// is discarded and a new request is sent to the redirection location.
+					if ( ( received.getStatus() == Response::MovedPermanently ||
+						   received.getStatus() == Response::MovedTemporarily ) &&
+						 request.getFollowRedirect() &&
+						 request.mRedirectionCount < request.getMaxRedirects() &&
+						 received.hasField( "location" ) ) {
+						location = received.getField( "location" );
+						parser.discardBody();
 					}
 
-					if ( isnheader ) {
-						currentTotalBytes += readed;
+					if ( !sendProgress( *this, request, received, Request::HeaderReceived,
+										parser.getContentLength(), 0 ) )
+						request.mCancel = true;
 
-						if ( readed > 0 )
-							bufferStream->write( readBuffer, readed );
+					return !request.isCancelled();
+				} );
 
-						if ( !sendProgress( *this, request, received, Request::ContentReceived,
-											contentLength, currentTotalBytes ) ) {
-							request.mCancel = true;
-							break;
-						}
+				parser.setBodyCallback( [&writeTo]( const char* data, std::size_t size ) {
+					writeTo.write( data, size );
+					return true;
+				} );
 
-						// If the response is compressed and the stream ended means that we received
-						// the message. So we can skip the socket receive call.
-						if ( ( compressed && NULL != inflateStream && !inflateStream->isOpen() ) ||
-							 ( contentLength > 0 && contentLength == currentTotalBytes ) ) {
-							break;
-						}
+				while ( !request.isCancelled() && !parser.isDone() && !parser.hasError() &&
+						( status = mConnection->getSocket()->receive( buffer, sizeof( buffer ),
+																	  readed ) ) == Socket::Done ) {
+					parser.parse( buffer, readed );
+
+					if ( parser.isHeaderComplete() &&
+						 !sendProgress( *this, request, received, Request::ContentReceived,
+										parser.getContentLength(), parser.getReceived() ) ) {
+						request.mCancel = true;
 					}
 				}
 
-				if ( chunked && NULL != chunkedStream &&
-					 !chunkedStream->getHeaderBuffer().empty() ) {
-					headerBuffer.append( chunkedStream->getHeaderBuffer() );
-				}
+				if ( status == Socket::Status::Disconnected )
+					parser.finish();
 
-				if ( !headerBuffer.empty() ) {
-					std::istringstream in( headerBuffer );
-					received.parseFields( in );
-				}
+				// Adds the trailer fields of the chunked responses.
+				if ( parser.isHeaderComplete() )
+					parser.fillResponse( received );
 
-				if ( status == Socket::Status::Disconnected ) {
-					mConnection->setConnected( false );
+				// A connection with an unfinished response can't be reused.
+				if ( !parser.isDone() || !parser.isKeepAlive() ) {
+					mConnection->disconnect();
 					mConnection->setTunneled( false );
 				}
 
-				eeSAFE_DELETE( chunkedStream );
-				eeSAFE_DELETE( inflateStream );
+				if ( parser.isDone() && !location.empty() ) {
+					URI uri( location );
+					Http::Request newRequest( request );
+					newRequest.mRedirectionCount++;
+					newRequest.setUri( uri.getPathEtc() );
+
+					if ( uri.getHost().empty() )
+						return downloadRequest( newRequest, writeTo, timeout );
+
+					Http http( uri.getHost(), uri.getPort(), uri.getScheme() == "https", mProxy );
+					return http.downloadRequest( newRequest, writeTo, timeout );
+				}
 			} else {
 				mConnection->setConnected( false );
 				mConnection->setTunneled( false );
@@ -1051,90 +897,14 @@ Http::Response Http::downloadRequest( const Http::Request& request, IOStream& wr
 
 Http::Response Http::downloadRequest( const Http::Request& request, std::string writePath,
 									  Time timeout ) {
+	if ( request.getSegments() > 1 && !request.isContinue() &&
+		 request.getMethod() == Request::Get )
+		return downloadSegmented( request, writePath, timeout );
+
 	IOStreamFile file( writePath, request.isContinue() ? "ab+" : "wb+" );
 	return downloadRequest( request, file, timeout );
 }
 
-Http::AsyncRequest::AsyncRequest( Http* http, const Http::AsyncResponseCallback& cb,
-								  Http::Request request, Time timeout ) :
-	mHttp( http ),
-	mCb( cb ),
-	mRequest( request ),
-	mTimeout( timeout ),
-	mRunning( true ),
-	mStreamed( false ),
-	mStreamOwned( false ),
-	mStream( NULL ) {}
-
-Http::AsyncRequest::AsyncRequest( Http* http, const Http::AsyncResponseCallback& cb,
-								  Http::Request request, IOStream& writeTo, Time timeout ) :
-	mHttp( http ),
-	mCb( cb ),
-	mRequest( request ),
-	mTimeout( timeout ),
-	mRunning( true ),
-	mStreamed( true ),
-	mStreamOwned( false ),
-	mStream( &writeTo ) {}
-
-Http::AsyncRequest::AsyncRequest( Http* http, const Http::AsyncResponseCallback& cb,
-								  Http::Request request, std::string writePath, Time timeout ) :
-	mHttp( http ),
-	mCb( cb ),
-	mRequest( request ),
-	mTimeout( timeout ),
-	mRunning( true ),
-	mStreamed( true ),
-	mStreamOwned( true ),
-	mStream( IOStreamFile::New( writePath, "wb" ) ) {}
-
-Http::AsyncRequest::~AsyncRequest() {
-	if ( mStreamOwned )
-		eeSAFE_DELETE( mStream );
-}
-
-void Http::AsyncRequest::run() {
-	Http::Response response = mStreamed ? mHttp->downloadRequest( mRequest, *mStream, mTimeout )
-										: mHttp->sendRequest( mRequest, mTimeout );
-
-	mCb( *mHttp, mRequest, response );
-
-	if ( mStreamed && mStreamOwned ) {
-		eeSAFE_DELETE( mStream );
-	}
-
-	// The Async Request destroys the socket used to create the request
-	HttpConnection* connection = mHttp->mConnection;
-	eeSAFE_DELETE( connection );
-	mHttp->mConnection = NULL;
-
-	mRunning = false;
-}
-
-void Http::removeOldThreads() {
-	std::list<AsyncRequest*> remove;
-
-	std::list<AsyncRequest*>::iterator it = mThreads.begin();
-
-	for ( ; it != mThreads.end(); ++it ) {
-		AsyncRequest* ar = ( *it );
-
-		if ( !ar->mRunning ) {
-			// We need to be sure, since the state is set in the thread, this will not block the
-			// thread anyway
-			ar->wait();
-
-			eeDelete( ar );
-
-			remove.push_back( ar );
-		}
-	}
-
-	for ( it = remove.begin(); it != remove.end(); ++it ) {
-		mThreads.remove( ( *it ) );
-	}
-}
-
 Http::Request Http::prepareFields( const Http::Request& request ) {
 	Request toSend( request );
 
@@ -1185,6 +955,22 @@ bool Http::isProxied() const {
 	return !mProxy.empty();
 }
 
+void Http::setAsyncClient( Http::AsyncClient* asyncClient ) {
+	mAsyncClient = asyncClient;
+}
+
+Http::AsyncClient* Http::getAsyncClient() const {
+	return NULL != mAsyncClient ? mAsyncClient : &AsyncClient::getGlobal();
+}
+
+void Http::setCache( Http::Cache* cache ) {
+	mCache = cache;
+}
+
+Http::Cache* Http::getCache() const {
+	return mCache;
+}
+
 #if EE_PLATFORM == EE_PLATFORM_EMSCRIPTEN
 struct WGetAsyncRequest {
 	Http* http;
@@ -1255,16 +1041,7 @@ void Http::sendAsyncRequest( const Http::AsyncResponseCallback& cb, const Http::
 								 emscripten_async_wget2_got_data,
 								 emscripten_async_wget2_got_error_data, NULL );
 #else
-	AsyncRequest* thread = eeNew( AsyncRequest, ( this, cb, request, timeout ) );
-
-	thread->launch();
-
-	// Clean old threads
-	Lock l( mThreadsMutex );
-
-	removeOldThreads();
-
-	mThreads.push_back( thread );
+	getAsyncClient()->request( this, cb, request, NULL, false, timeout );
 #endif
 }
 
@@ -1282,16 +1059,7 @@ void Http::downloadAsyncRequest( const Http::AsyncResponseCallback& cb,
 								 emscripten_async_wget2_got_data,
 								 emscripten_async_wget2_got_error_data, NULL );
 #else
-	AsyncRequest* thread = eeNew( AsyncRequest, ( this, cb, request, writeTo, timeout ) );
-
-	thread->launch();
-
-	// Clean old threads
-	Lock l( mThreadsMutex );
-
-	removeOldThreads();
-
-	mThreads.push_back( thread );
+	getAsyncClient()->request( this, cb, request, &writeTo, false, timeout );
 #endif
 }
 
@@ -1309,16 +1077,8 @@ void Http::downloadAsyncRequest( const Http::AsyncResponseCallback& cb,
 							emscripten_async_wget2_got_file, emscripten_async_wget2_got_error_file,
 							NULL );
 #else
-	AsyncRequest* thread = eeNew( AsyncRequest, ( this, cb, request, writePath, timeout ) );
-
-	thread->launch();
-
-	// Clean old threads
-	Lock l( mThreadsMutex );
-
-	removeOldThreads();
-
-	mThreads.push_back( thread );
+	getAsyncClient()->request( this, cb, request, IOStreamFile::New( writePath, "wb" ), true,
+							   timeout );
 #endif
 }
 
@@ -1351,7 +1111,11 @@ Http::HttpConnection::HttpConnection() :
 	mIsKeepAlive( false ) {}
 
 Http::HttpConnection::HttpConnection( TcpSocket* socket ) :
-	mSocket( socket ), mIsConnected( false ), mIsTunneled( false ), mIsSSL( false ) {}
+	mSocket( socket ),
+	mIsConnected( false ),
+	mIsTunneled( false ),
+	mIsSSL( false ),
+	mIsKeepAlive( false ) {}
 
 Http::HttpConnection::~HttpConnection() {
 	eeSAFE_DELETE( mSocket );
@@ -1408,7 +1172,7 @@ Http::Pool& Http::Pool::getGlobal() {
 	return sGlobalHttpPool;
 }
 
-Http::Pool::Pool() {}
+Http::Pool::Pool() : mCache( NULL ) {}
 
 Http::Pool::~Pool() {
 	clear();
@@ -1446,10 +1210,22 @@ Http* Http::Pool::get( const URI& host, const URI& proxy ) {
 	}
 
 	Http* http = eeNew( Http, ( host.getHost(), host.getPort(), host.getScheme() == "https" ) );
+	http->setCache( mCache );
 	mHttps[getHostHash( host, proxy )] = http;
 	return http;
 }
 
+void Http::Pool::setCache( Http::Cache* cache ) {
+	mCache = cache;
+
+	for ( auto& http : mHttps )
+		http.second->setCache( cache );
+}
+
+Http::Cache* Http::Pool::getCache() const {
+	return mCache;
+}
+
 static constexpr const char* TWO_HYPHENS = "--";
 static constexpr const char* LINE_END = "\r\n";
 
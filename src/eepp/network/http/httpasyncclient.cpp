@@ -0,0 +1,862 @@
+#include <algorithm>
+#include <cstdlib>
+#include <eepp/network/http.hpp>
+#include <eepp/network/http/httpresponseparser.hpp>
+#include <eepp/network/socketselector.hpp>
+#include <eepp/system/clock.hpp>
+#include <eepp/system/iostreamstring.hpp>
+#include <eepp/system/threadpool.hpp>
+
+using namespace EE::Network::Private;
+
+namespace EE { namespace Network {
+
+#define ASYNC_READ_BUFFER_SIZE ( 16384 )
+
+struct Http::AsyncClient::Task {
+	Http* http{ NULL };
+	AsyncResponseCallback cb;
+	Http::Request request;
+	Http::Response response;
+	Time timeout;
+	IOStream* writeTo{ NULL };
+	bool streamOwned{ false };
+	IOStreamString body;
+	// Started when the request is the next one to be answered in its connection.
+	Clock clock;
+	std::string redirect;
+	// Where the request starts in the output of its connection.
+	std::size_t outputOffset{ 0 };
+	bool sent{ false };
+	bool started{ false };
+	bool retried{ false };
+
+	IOStream& output() { return NULL != writeTo ? *writeTo : body; }
+
+	bool isPipelinable() const {
+		return ( request.getMethod() == Request::Get || request.getMethod() == Request::Head ) &&
+			   request.mBody.empty();
+	}
+
+	// Non idempotent requests can only be sent again if none of their bytes were written.
+	bool canResend( const Connection& connection ) const;
+};
+
+struct Http::AsyncClient::Host {
+	std::string name;
+	unsigned short port{ 0 };
+	IpAddress address;
+	bool resolved{ false };
+	bool resolving{ false };
+	std::deque<Task*> queue;
+	std::vector<Connection*> connections;
+};
+
+struct Http::AsyncClient::Connection {
+	Host* host{ NULL };
+	TcpSocket socket;
+	bool connecting{ true };
+	// The requests sent or being sent, in the order that they will be answered.
+	std::deque<Task*> tasks;
+	std::string output;
+	std::size_t outputOffset{ 0 };
+	// The response of the first task is parsed as it arrives.
+	HttpResponseParser parser;
+	Task* parsing{ NULL };
+	Uint32 responses{ 0 };
+	bool keepAlive{ false };
+	Clock idleClock;
+};
+
+bool Http::AsyncClient::Task::canResend( const Connection& connection ) const {
+	return isPipelinable() || ( !sent && connection.outputOffset <= outputOffset );
+}
+
+static bool sendProgress( const Http& http, const Http::Request& request,
+						  const Http::Response& response, const Http::Request::Status& status,
+						  const std::size_t& totalBytes, const std::size_t& currentBytes ) {
+	if ( request.getProgressCallback() )
+		return request.getProgressCallback()( http, request, response, status, totalBytes,
+											  currentBytes );
+	return true;
+}
+
+Http::AsyncClient& Http::AsyncClient::getGlobal() {
+	static AsyncClient sGlobal;
+	return sGlobal;
+}
+
+Http::AsyncClient::AsyncClient() :
+	mWakePort( 0 ),
+	mWakePending( false ),
+	mRunning( false ),
+	mPendingCount( 0 ),
+	mConnectionsCount( 0 ),
+	mMaxConnectionsPerHost( 6 ),
+	mMaxPipelinedRequests( 1 ),
+	mKeepAliveTimeout( Seconds( 30 ).asMicroseconds() ),
+	mResolverThreads( 2 ),
+	mBlockingThreads( 6 ) {}
+
+Http::AsyncClient::~AsyncClient() {
+	if ( mThread ) {
+		mRunning = false;
+		wake();
+		mThread->wait();
+	}
+
+	// Waits for the blocking requests being run and the queued ones.
+	mBlockingPool.reset();
+	mResolverPool.reset();
+
+	// Once stopped the tasks are released without calling their callbacks.
+	std::vector<std::function<void()>> posted;
+	posted.swap( mPosted );
+
+	for ( auto& func : posted )
+		func();
+
+	for ( auto& hostIt : mHosts ) {
+		Host* host = hostIt.second;
+
+		for ( Task* task : host->queue )
+			finishTask( task );
+
+		for ( Connection* connection : host->connections ) {
+			for ( Task* task : connection->tasks )
+				finishTask( task );
+
+			connection->socket.disconnect();
+			eeDelete( connection );
+		}
+
+		eeDelete( host );
+	}
+
+	mHosts.clear();
+}
+
+void Http::AsyncClient::setExecutor( const Http::AsyncClient::Executor& executor ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	mExecutor = executor;
+}
+
+void Http::AsyncClient::setMaxConnectionsPerHost( const Uint32& maxConnections ) {
+	mMaxConnectionsPerHost = eemax<Uint32>( 1, maxConnections );
+}
+
+Uint32 Http::AsyncClient::getMaxConnectionsPerHost() const {
+	return mMaxConnectionsPerHost;
+}
+
+void Http::AsyncClient::setMaxPipelinedRequests( const Uint32& maxRequests ) {
+	mMaxPipelinedRequests = eemax<Uint32>( 1, maxRequests );
+}
+
+Uint32 Http::AsyncClient::getMaxPipelinedRequests() const {
+	return mMaxPipelinedRequests;
+}
+
+void Http::AsyncClient::setKeepAliveTimeout( const Time& timeout ) {
+	mKeepAliveTimeout = timeout.asMicroseconds();
+}
+
+Time Http::AsyncClient::getKeepAliveTimeout() const {
+	return Microseconds( mKeepAliveTimeout );
+}
+
+void Http::AsyncClient::setResolverThreads( const Uint32& threads ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	if ( !mResolverPool )
+		mResolverThreads = eemax<Uint32>( 1, threads );
+}
+
+Uint32 Http::AsyncClient::getResolverThreads() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mResolverThreads;
+}
+
+void Http::AsyncClient::setBlockingThreads( const Uint32& threads ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	if ( !mBlockingPool )
+		mBlockingThreads = eemax<Uint32>( 1, threads );
+}
+
+Uint32 Http::AsyncClient::getBlockingThreads() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mBlockingThreads;
+}
+
+Uint32 Http::AsyncClient::getThreadCount() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return ( mThread ? 1 : 0 ) + ( mResolverPool ? mResolverPool->numThreads() : 0 ) +
+		   ( mBlockingPool ? mBlockingPool->numThreads() : 0 );
+}
+
+size_t Http::AsyncClient::getPendingRequestsCount() const {
+	return mPendingCount;
+}
+
+size_t Http::AsyncClient::getConnectionsCount() const {
+	return mConnectionsCount;
+}
+
+void Http::AsyncClient::request( Http* http, const Http::AsyncResponseCallback& cb,
+								 const Http::Request& request, IOStream* writeTo,
+								 bool streamOwned, Time timeout ) {
+	Task* task = eeNew( Task, () );
+	task->http = http;
+	task->cb = cb;
+	task->request = request;
+	task->timeout = timeout;
+	task->writeTo = writeTo;
+	task->streamOwned = streamOwned;
+
+	{
+		std::lock_guard<std::mutex> lock( http->mAsyncMutex );
+		http->mAsyncCount++;
+	}
+
+	mPendingCount++;
+
+	start();
+
+	// The I/O loop only speaks plain HTTP, everything else is run by the blocking workers.
+	if ( http->isProxied() || http->isSSL() || request.isContinue() ||
+		 http->getHostName().empty() ) {
+		runBlocking( task );
+		return;
+	}
+
+	std::string hostName( http->getHostName() );
+	unsigned short port = http->getPort();
+
+	post( [this, task, hostName, port] { enqueue( task, hostName, port ); } );
+}
+
+void Http::AsyncClient::start() {
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	if ( mThread )
+		return;
+
+	// Other threads wake up the I/O loop sending a datagram to it.
+	mWakeSocket.setBlocking( false );
+	mWakeSocket.bind( Socket::AnyPort, IpAddress::LocalHost );
+	mWakePort = mWakeSocket.getLocalPort();
+	mWakeSender.bind( Socket::AnyPort, IpAddress::LocalHost );
+
+	mRunning = true;
+	mThread = std::make_unique<Thread>( &Http::AsyncClient::run, this );
+	mThread->launch();
+}
+
+ThreadPool& Http::AsyncClient::resolverPool() {
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	if ( !mResolverPool )
+		mResolverPool = ThreadPool::createUnique( mResolverThreads );
+
+	return *mResolverPool;
+}
+
+ThreadPool& Http::AsyncClient::blockingPool() {
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	if ( !mBlockingPool )
+		mBlockingPool = ThreadPool::createUnique( mBlockingThreads );
+
+	return *mBlockingPool;
+}
+
+void Http::AsyncClient::post( const std::function<void()>& func ) {
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		mPosted.push_back( func );
+	}
+
+	wake();
+}
+
+void Http::AsyncClient::wake() {
+	if ( !mWakePending.exchange( true ) ) {
+		char signal = 0;
+		mWakeSender.send( &signal, 1, IpAddress::LocalHost, mWakePort );
+	}
+}
+
+void Http::AsyncClient::run() {
+	SocketSelector selector;
+	std::vector<Connection*> connections;
+	std::vector<std::function<void()>> posted;
+
+	while ( mRunning ) {
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			posted.swap( mPosted );
+		}
+
+		for ( auto& func : posted )
+			func();
+
+		posted.clear();
+
+		for ( auto& host : mHosts )
+			dispatch( host.second );
+
+		Time timeout = checkTimeouts();
+
+		selector.clear();
+		selector.add( mWakeSocket );
+		connections.clear();
+
+		for ( auto& host : mHosts ) {
+			for ( Connection* connection : host.second->connections ) {
+				connections.push_back( connection );
+
+				if ( connection->connecting ||
+					 connection->outputOffset < connection->output.size() )
+					selector.addWrite( connection->socket );
+
+				// Idle connections are watched too, to know when the server closes them.
+				if ( !connection->connecting )
+					selector.add( connection->socket );
+			}
+		}
+
+		selector.wait( timeout );
+
+		if ( !mRunning )
+			break;
+
+		if ( selector.isReady( mWakeSocket ) ) {
+			char buffer[16];
+			std::size_t received;
+			IpAddress address;
+			unsigned short port;
+
+			while ( mWakeSocket.receive( buffer, sizeof( buffer ), received, address, port ) ==
+					Socket::Done ) {
+			}
+
+			mWakePending = false;
+		}
+
+		for ( Connection* connection : connections ) {
+			bool alive = true;
+
+			if ( connection->connecting ) {
+				if ( selector.isReadyToWrite( connection->socket ) )
+					alive = finishConnect( connection );
+			} else {
+				if ( connection->outputOffset < connection->output.size() &&
+					 selector.isReadyToWrite( connection->socket ) )
+					alive = flush( connection );
+
+				if ( alive && selector.isReady( connection->socket ) )
+					alive = read( connection );
+			}
+
+			if ( !alive )
+				closeConnection( connection );
+		}
+	}
+}
+
+void Http::AsyncClient::runBlocking( Http::AsyncClient::Task* task ) {
+	// The workers are bounded, so the number of threads doesn't grow with the requests. Requests
+	// cancelled while waiting for a worker are completed without being sent.
+	blockingPool().run(
+		[this, task] {
+			if ( task->request.isCancelled() ) {
+				complete( task );
+				return;
+			}
+
+			if ( !task->redirect.empty() ) {
+				URI uri( task->redirect );
+				Http http( uri.getHost(), uri.getPort(), uri.getScheme() == "https" );
+				task->response =
+					http.downloadRequest( task->request, task->output(), task->timeout );
+			} else {
+				task->response = task->http->downloadRequest( task->request, task->output(),
+															  task->timeout );
+				// The workers are shared by every client, their connections are not kept.
+				task->http->destroyConnection();
+			}
+
+			complete( task );
+		},
+		nullptr );
+}
+
+void Http::AsyncClient::enqueue( Http::AsyncClient::Task* task, const std::string& hostName,
+								 unsigned short port ) {
+	std::string key( String::format( "%s:%d", hostName.c_str(), port ) );
+	auto it = mHosts.find( key );
+	Host* host;
+
+	if ( it == mHosts.end() ) {
+		host = eeNew( Host, () );
+		host->name = hostName;
+		host->port = port;
+		mHosts[key] = host;
+	} else {
+		host = it->second;
+	}
+
+	host->queue.push_back( task );
+}
+
+void Http::AsyncClient::resolve( Http::AsyncClient::Host* host ) {
+	if ( host->resolving )
+		return;
+
+	host->resolving = true;
+	std::string name( host->name );
+
+	resolverPool().run(
+		[this, host, name] {
+			IpAddress address( name );
+
+			post( [this, host, address] {
+				host->resolving = false;
+
+				if ( address == IpAddress::None ) {
+					while ( !host->queue.empty() ) {
+						Task* task = host->queue.front();
+						host->queue.pop_front();
+						complete( task );
+					}
+				} else {
+					host->address = address;
+					host->resolved = true;
+				}
+			} );
+		},
+		nullptr );
+}
+
+void Http::AsyncClient::dispatch( Http::AsyncClient::Host* host ) {
+	if ( host->queue.empty() )
+		return;
+
+	if ( !host->resolved ) {
+		resolve( host );
+		return;
+	}
+
+	Uint32 maxConnections = mMaxConnectionsPerHost;
+	Uint32 maxPipelined = mMaxPipelinedRequests;
+
+	while ( !host->queue.empty() ) {
+		Task* task = host->queue.front();
+
+		// Cancelled requests are never sent ( again ).
+		if ( task->request.isCancelled() ) {
+			host->queue.pop_front();
+			complete( task );
+			continue;
+		}
+
+		Connection* idle = NULL;
+		Connection* pipeline = NULL;
+
+		for ( Connection* connection : host->connections ) {
+			if ( connection->connecting )
+				continue;
+
+			if ( connection->tasks.empty() ) {
+				idle = connection;
+				break;
+			}
+
+			if ( maxPipelined > 1 && connection->keepAlive && connection->responses > 0 &&
+				 connection->tasks.size() < maxPipelined && task->isPipelinable() &&
+				 connection->tasks.front()->isPipelinable() &&
+				 ( NULL == pipeline || connection->tasks.size() < pipeline->tasks.size() ) )
+				pipeline = connection;
+		}
+
+		// Idle connections first, then new connections and only then pipelining.
+		if ( NULL != idle ) {
+			host->queue.pop_front();
+			sendTask( idle, task );
+		} else if ( host->connections.size() < maxConnections ) {
+			host->queue.pop_front();
+			openConnection( host, task );
+		} else if ( NULL != pipeline ) {
+			host->queue.pop_front();
+			sendTask( pipeline, task );
+		} else {
+			break;
+		}
+	}
+}
+
+void Http::AsyncClient::openConnection( Http::AsyncClient::Host* host,
+										Http::AsyncClient::Task* task ) {
+	Connection* connection = eeNew( Connection, () );
+	connection->host = host;
+	connection->parser.setHeaderCallback( [this, connection]( HttpResponseParser& ) {
+		headerReceived( connection );
+		return true;
+	} );
+	connection->parser.setBodyCallback( [connection]( const char* data, std::size_t size ) {
+		connection->tasks.front()->output().write( data, size );
+		return true;
+	} );
+	host->connections.push_back( connection );
+	mConnectionsCount++;
+
+	sendTask( connection, task );
+
+	connection->socket.setBlocking( false );
+
+	Socket::Status status = connection->socket.connect( host->address, host->port );
+
+	if ( status == Socket::Done ) {
+		if ( !finishConnect( connection ) )
+			closeConnection( connection );
+	} else if ( status != Socket::NotReady ) {
+		closeConnection( connection );
+	}
+}
+
+void Http::AsyncClient::sendTask( Http::AsyncClient::Connection* connection,
+								  Http::AsyncClient::Task* task ) {
+	// The timeout counts from the moment the request is the next one to be answered.
+	if ( connection->tasks.empty() )
+		task->clock.restart();
+
+	connection->tasks.push_back( task );
+	task->outputOffset = connection->output.size();
+
+	Request toSend( task->http->prepareFields( task->request ) );
+
+	// The request could have been redirected to another host.
+	if ( !task->request.hasField( "Host" ) )
+		toSend.setField( "Host", connection->host->name );
+
+	if ( !task->request.hasField( "Connection" ) )
+		toSend.setField( "Connection", "keep-alive" );
+
+	// Sent once the socket is ready to write.
+	connection->output.append( toSend.prepare( *task->http ) );
+}
+
+bool Http::AsyncClient::finishConnect( Http::AsyncClient::Connection* connection ) {
+	// A refused connection is also reported as ready to write.
+	if ( connection->socket.getRemoteAddress() == IpAddress::None )
+		return false;
+
+	connection->connecting = false;
+	connection->idleClock.restart();
+
+	if ( !connection->tasks.empty() ) {
+		Task* task = connection->tasks.front();
+
+		if ( !sendProgress( *task->http, task->request, task->response, Request::Connected, 0,
+							0 ) ) {
+			task->request.mCancel = true;
+			task->retried = true;
+			return false;
+		}
+	}
+
+	return flush( connection );
+}
+
+bool Http::AsyncClient::flush( Http::AsyncClient::Connection* connection ) {
+	while ( connection->outputOffset < connection->output.size() ) {
+		std::size_t sent = 0;
+		Socket::Status status =
+			connection->socket.send( connection->output.data() + connection->outputOffset,
+									 connection->output.size() - connection->outputOffset, sent );
+
+		connection->outputOffset += sent;
+
+		if ( status == Socket::Partial || status == Socket::NotReady )
+			return true;
+
+		if ( status != Socket::Done )
+			return false;
+	}
+
+	connection->output.clear();
+	connection->outputOffset = 0;
+
+	for ( Task* task : connection->tasks ) {
+		if ( !task->sent ) {
+			task->sent = true;
+
+			if ( !sendProgress( *task->http, task->request, task->response, Request::Sent, 0,
+								0 ) )
+				task->request.mCancel = true;
+		}
+	}
+
+	return true;
+}
+
+bool Http::AsyncClient::read( Http::AsyncClient::Connection* connection ) {
+	char buffer[ASYNC_READ_BUFFER_SIZE];
+	std::size_t received = 0;
+	Socket::Status status = connection->socket.receive( buffer, sizeof( buffer ), received );
+
+	if ( status == Socket::NotReady )
+		return true;
+
+	// Whatever was received is processed before closing the connection.
+	bool alive = processInput( connection, buffer, received );
+
+	return alive && status == Socket::Done;
+}
+
+bool Http::AsyncClient::processInput( Http::AsyncClient::Connection* connection,
+									  const char* data, std::size_t size ) {
+	HttpResponseParser& parser = connection->parser;
+	std::size_t pos = 0;
+
+	// The data after the end of a response belongs to the next pipelined response.
+	while ( !connection->tasks.empty() ) {
+		Task* task = connection->tasks.front();
+
+		if ( task->request.isCancelled() ) {
+			task->retried = true;
+			return false;
+		}
+
+		if ( connection->parsing != task ) {
+			parser.reset( task->request.getMethod() == Request::Head );
+			connection->parsing = task;
+		}
+
+		if ( pos < size ) {
+			pos += parser.parse( data + pos, size - pos );
+			task->started = task->started || parser.isStarted();
+
+			if ( parser.hasError() )
+				return false;
+
+			if ( parser.isHeaderComplete() &&
+				 !sendProgress( *task->http, task->request, task->response,
+								Request::ContentReceived, parser.getContentLength(),
+								parser.getReceived() ) )
+				task->request.mCancel = true;
+		}
+
+		if ( !parser.isDone() )
+			break;
+
+		bool keepAlive = parser.isKeepAlive();
+
+		finishResponse( connection );
+
+		if ( !keepAlive )
+			return false;
+	}
+
+	// Data that doesn't belong to any request.
+	return pos == size;
+}
+
+void Http::AsyncClient::headerReceived( Http::AsyncClient::Connection* connection ) {
+	HttpResponseParser& parser = connection->parser;
+	Task* task = connection->tasks.front();
+	Response& response = task->response;
+
+	parser.fillResponse( response );
+	connection->keepAlive = parser.isKeepAlive();
+
+	if ( ( response.getStatus() == Response::MovedPermanently ||
+		   response.getStatus() == Response::MovedTemporarily ) &&
+		 task->request.getFollowRedirect() &&
+		 task->request.mRedirectionCount < task->request.getMaxRedirects() &&
+		 response.hasField( "location" ) ) {
+		// The body of the redirection is discarded.
+		task->redirect = response.getField( "location" );
+		parser.discardBody();
+	}
+
+	if ( !sendProgress( *task->http, task->request, response, Request::HeaderReceived,
+						parser.getContentLength(), 0 ) )
+		task->request.mCancel = true;
+}
+
+void Http::AsyncClient::finishResponse( Http::AsyncClient::Connection* connection ) {
+	Task* task = connection->tasks.front();
+	connection->tasks.pop_front();
+
+	// Adds the trailer fields of the chunked responses.
+	connection->parser.fillResponse( task->response );
+	connection->keepAlive = connection->parser.isKeepAlive();
+	connection->parsing = NULL;
+	connection->responses++;
+	connection->idleClock.restart();
+
+	if ( !connection->tasks.empty() )
+		connection->tasks.front()->clock.restart();
+
+	if ( !task->redirect.empty() ) {
+		redirect( connection, task );
+	} else {
+		complete( task );
+	}
+}
+
+void Http::AsyncClient::redirect( Http::AsyncClient::Connection* connection,
+								  Http::AsyncClient::Task* task ) {
+	URI uri( task->redirect );
+
+	task->request.mRedirectionCount++;
+	task->request.setUri( uri.getPathEtc() );
+	task->response = Response();
+	task->sent = false;
+	task->started = false;
+	task->retried = false;
+
+	if ( uri.getHost().empty() ) {
+		task->redirect.clear();
+		connection->host->queue.push_back( task );
+	} else if ( uri.getScheme() == "http" ) {
+		task->redirect.clear();
+		enqueue( task, uri.getHost(), uri.getPort() );
+	} else {
+		runBlocking( task );
+	}
+}
+
+void Http::AsyncClient::closeConnection( Http::AsyncClient::Connection* connection ) {
+	Host* host = connection->host;
+
+	// A response without length finishes when the connection is closed.
+	if ( !connection->connecting && !connection->tasks.empty() &&
+		 connection->parsing == connection->tasks.front() && connection->parser.finish() )
+		finishResponse( connection );
+
+	// Requests that didn't get any answer are retried once, the server could have closed a kept
+	// alive connection while the request was being sent. Those sent in a new connection are only
+	// retried if they are idempotent, and the others only if none of their bytes were written.
+	// Cancelled requests and the ones that timed out are completed.
+	std::vector<Task*> retry;
+	bool reused = connection->responses > 0;
+
+	for ( Task* task : connection->tasks ) {
+		if ( !connection->connecting && !task->started && !task->retried &&
+			 !task->request.isCancelled() && ( reused || task->isPipelinable() ) &&
+			 task->canResend( *connection ) ) {
+			task->retried = true;
+			task->sent = false;
+			retry.push_back( task );
+		} else {
+			complete( task );
+		}
+	}
+
+	connection->tasks.clear();
+
+	for ( auto it = retry.rbegin(); it != retry.rend(); ++it )
+		host->queue.push_front( *it );
+
+	host->connections.erase(
+		std::find( host->connections.begin(), host->connections.end(), connection ) );
+
+	connection->socket.disconnect();
+	eeDelete( connection );
+	mConnectionsCount--;
+}
+
+Time Http::AsyncClient::checkTimeouts() {
+	Time wait = Time::Zero;
+	Time keepAliveTimeout( Microseconds( mKeepAliveTimeout ) );
+	std::vector<Connection*> expired;
+
+	for ( auto& host : mHosts ) {
+		for ( Connection* connection : host.second->connections ) {
+			Time remaining;
+
+			if ( connection->tasks.empty() ) {
+				remaining = keepAliveTimeout - connection->idleClock.getElapsedTime();
+			} else if ( connection->tasks.front()->timeout != Time::Zero ) {
+				Task* task = connection->tasks.front();
+				remaining = task->timeout - task->clock.getElapsedTime();
+			} else {
+				continue;
+			}
+
+			if ( remaining <= Time::Zero ) {
+				expired.push_back( connection );
+			} else if ( wait == Time::Zero || remaining < wait ) {
+				wait = remaining;
+			}
+		}
+	}
+
+	for ( Connection* connection : expired ) {
+		// The request that timed out fails, the ones behind it are retried.
+		if ( !connection->tasks.empty() )
+			connection->tasks.front()->retried = true;
+
+		closeConnection( connection );
+	}
+
+	// The retried requests are dispatched in the next iteration.
+	if ( !expired.empty() )
+		wait = Milliseconds( 1 );
+
+	// Time::Zero waits forever.
+	if ( wait != Time::Zero && wait < Milliseconds( 1 ) )
+		wait = Milliseconds( 1 );
+
+	return wait;
+}
+
+void Http::AsyncClient::complete( Http::AsyncClient::Task* task ) {
+	if ( !mRunning ) {
+		finishTask( task );
+		return;
+	}
+
+	if ( NULL == task->writeTo )
+		task->response.mBody = std::move( task->body.getStream() );
+
+	// The downloaded file is complete once the callback is run.
+	if ( task->streamOwned )
+		eeSAFE_DELETE( task->writeTo );
+
+	Executor executor;
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		executor = mExecutor;
+	}
+
+	auto callback = [this, task] {
+		task->cb( *task->http, task->request, task->response );
+		finishTask( task );
+	};
+
+	if ( executor ) {
+		executor( callback );
+	} else {
+		callback();
+	}
+}
+
+void Http::AsyncClient::finishTask( Http::AsyncClient::Task* task ) {
+	Http* http = task->http;
+
+	if ( task->streamOwned )
+		eeSAFE_DELETE( task->writeTo );
+
+	eeDelete( task );
+	mPendingCount--;
+
+	// Notified with the lock held, once released the client can be destroyed.
+	std::lock_guard<std::mutex> lock( http->mAsyncMutex );
+	http->mAsyncCount--;
+	http->mAsyncFinished.notify_all();
+}
+
+}} // namespace EE::Network
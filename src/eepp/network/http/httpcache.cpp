@@ -0,0 +1,530 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <eepp/network/http.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/md5.hpp>
+
+namespace EE { namespace Network {
+
+#define CACHE_ENTRY_SIGNATURE "eepp-http-cache 1"
+
+struct Http::Cache::Entry {
+	std::string key;
+	// The response, including its body.
+	Response response;
+	// Seconds since the epoch when the response was stored or revalidated.
+	Int64 storedAt{ 0 };
+	// Seconds that the response is fresh since it was stored.
+	Int64 freshFor{ 0 };
+	// The md5 of the body, the name of the body in the disk store.
+	std::string hash;
+
+	Uint64 size() const { return response.mBody.size(); }
+
+	bool isFresh( Int64 now ) const { return now - storedAt < freshFor; }
+};
+
+static Int64 currentTime() {
+	return static_cast<Int64>( std::time( NULL ) );
+}
+
+// Days since the epoch of a date of the proleptic gregorian calendar.
+static Int64 daysFromCivil( Int64 year, unsigned month, unsigned day ) {
+	year -= month <= 2;
+	const Int64 era = ( year >= 0 ? year : year - 399 ) / 400;
+	const unsigned yoe = static_cast<unsigned>( year - era * 400 );
+	const unsigned doy = ( 153 * ( month > 2 ? month - 3 : month + 9 ) + 2 ) / 5 + day - 1;
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + static_cast<Int64>( doe ) - 719468;
+}
+
+// Parses an HTTP date ( "Sun, 06 Nov 1994 08:49:37 GMT" ).
+// @return The seconds since the epoch, -1 if the date is not valid.
+static Int64 parseHttpDate( const std::string& date ) {
+	static const char* months[] = { "jan", "feb", "mar", "apr", "may", "jun",
+									"jul", "aug", "sep", "oct", "nov", "dec" };
+	int day, year, hour, minute, second;
+	char monthName[4] = { 0 };
+
+	if ( date.empty() || sscanf( date.c_str(), "%*[^,], %d %3s %d %d:%d:%d", &day, monthName,
+								 &year, &hour, &minute, &second ) != 6 )
+		return -1;
+
+	std::string month( String::toLower( std::string( monthName ) ) );
+
+	for ( unsigned i = 0; i < 12; i++ ) {
+		if ( month == months[i] )
+			return daysFromCivil( year, i + 1, day ) * 86400 + hour * 3600 + minute * 60 +
+				   second;
+	}
+
+	return -1;
+}
+
+// @return The seconds that the response is fresh since it was received.
+static Int64 getFreshness( const Http::Response& response, Int64 now ) {
+	std::string cacheControl( String::toLower( response.getField( "cache-control" ) ) );
+
+	if ( cacheControl.find( "no-cache" ) != std::string::npos )
+		return 0;
+
+	Int64 freshness = 0;
+	std::size_t maxAge = cacheControl.find( "max-age=" );
+
+	if ( maxAge != std::string::npos ) {
+		freshness = std::strtoll( cacheControl.c_str() + maxAge + 8, NULL, 10 );
+	} else if ( response.hasField( "expires" ) ) {
+		// An invalid date means that the response already expired.
+		Int64 expires = parseHttpDate( response.getField( "expires" ) );
+		Int64 date = parseHttpDate( response.getField( "date" ) );
+
+		if ( expires >= 0 )
+			freshness = expires - ( date >= 0 ? date : now );
+	}
+
+	if ( response.hasField( "age" ) )
+		freshness -= std::strtoll( response.getField( "age" ).c_str(), NULL, 10 );
+
+	return eemax<Int64>( 0, freshness );
+}
+
+static bool isStorable( const Http::Request& request, const Http::Response& response,
+						Int64 freshness ) {
+	std::string cacheControl( String::toLower( response.getField( "cache-control" ) ) );
+
+	if ( response.getStatus() != Http::Response::Ok ||
+		 cacheControl.find( "no-store" ) != std::string::npos )
+		return false;
+
+	// The key doesn't include the credentials, the response to a request with credentials is
+	// only stored if the server allows sharing it.
+	if ( request.hasField( "authorization" ) && cacheControl.find( "public" ) == std::string::npos )
+		return false;
+
+	// The body is stored decoded, so it doesn't vary with the accepted encodings.
+	std::string vary( String::toLower( response.getField( "vary" ) ) );
+
+	if ( !vary.empty() && vary != "accept-encoding" )
+		return false;
+
+	// Responses that can't be revalidated are only useful while they are fresh.
+	return freshness > 0 || response.hasField( "etag" ) || response.hasField( "last-modified" );
+}
+
+// Writes to a temporary file that replaces the file once complete, so a crash never leaves a
+// partially written file in the store.
+static bool writeFile( const std::string& path, const std::string& data ) {
+	std::string tmpPath( path + ".tmp" );
+
+	if ( !FileSystem::fileWrite( tmpPath, reinterpret_cast<const Uint8*>( data.data() ),
+								 data.size() ) )
+		return false;
+
+	if ( FileSystem::fileExists( path ) )
+		FileSystem::fileRemove( path );
+
+	if ( std::rename( tmpPath.c_str(), path.c_str() ) != 0 ) {
+		FileSystem::fileRemove( tmpPath );
+		return false;
+	}
+
+	return true;
+}
+
+Http::Cache::Cache( const std::string& diskPath, Uint64 maxMemorySize, Uint64 maxDiskSize ) :
+	mDiskPath( diskPath ),
+	mMaxMemorySize( maxMemorySize ),
+	mMaxDiskSize( maxDiskSize ),
+	mMemorySize( 0 ),
+	mDiskSize( 0 ),
+	mDiskSizeKnown( false ) {
+	if ( !mDiskPath.empty() ) {
+		FileSystem::dirAddSlashAtEnd( mDiskPath );
+
+		if ( !FileSystem::isDirectory( mDiskPath ) )
+			FileSystem::makeDir( mDiskPath );
+
+		if ( !FileSystem::isDirectory( mDiskPath + "entries" ) )
+			FileSystem::makeDir( mDiskPath + "entries" );
+
+		if ( !FileSystem::isDirectory( mDiskPath + "objects" ) )
+			FileSystem::makeDir( mDiskPath + "objects" );
+	}
+}
+
+Http::Cache::~Cache() {}
+
+const std::string& Http::Cache::getDiskPath() const {
+	return mDiskPath;
+}
+
+void Http::Cache::setMaxMemorySize( Uint64 maxMemorySize ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	mMaxMemorySize = maxMemorySize;
+	evictMemory();
+}
+
+Uint64 Http::Cache::getMaxMemorySize() const {
+	return mMaxMemorySize;
+}
+
+void Http::Cache::setMaxDiskSize( Uint64 maxDiskSize ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	mMaxDiskSize = maxDiskSize;
+	evictDisk();
+}
+
+Uint64 Http::Cache::getMaxDiskSize() const {
+	return mMaxDiskSize;
+}
+
+Uint64 Http::Cache::getMemorySize() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mMemorySize;
+}
+
+Uint64 Http::Cache::getDiskSize() {
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	if ( !mDiskSizeKnown && !mDiskPath.empty() ) {
+		mDiskSize = 0;
+
+		for ( const auto& object : FileSystem::filesGetInPath( mDiskPath + "objects" ) )
+			mDiskSize += FileSystem::fileSize( mDiskPath + "objects/" + object );
+
+		mDiskSizeKnown = true;
+	}
+
+	return mDiskSize;
+}
+
+Http::Cache::Metrics Http::Cache::getMetrics() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mMetrics;
+}
+
+void Http::Cache::resetMetrics() {
+	std::lock_guard<std::mutex> lock( mMutex );
+	mMetrics = Metrics();
+}
+
+void Http::Cache::clear() {
+	std::lock_guard<std::mutex> lock( mMutex );
+	mEntries.clear();
+	mEntriesMap.clear();
+	mMemorySize = 0;
+
+	if ( !mDiskPath.empty() ) {
+		for ( const auto& dir : { "entries/", "objects/" } ) {
+			for ( const auto& file : FileSystem::filesGetInPath( mDiskPath + dir ) )
+				FileSystem::fileRemove( mDiskPath + dir + file );
+		}
+
+		mDiskSize = 0;
+		mDiskSizeKnown = true;
+	}
+}
+
+void Http::Cache::remove( const URI& uri ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	erase( getKey( uri.getScheme(), uri.getHost(), uri.getPort(), uri.getPathAndQuery() ) );
+}
+
+Http::Response Http::Cache::sendRequest( Http& http, const Http::Request& request,
+										 Time timeout ) {
+	if ( !isCacheable( request ) )
+		return http.sendUncachedRequest( request, timeout );
+
+	std::string key( getKey( http.mIsSSL ? "https" : "http", http.mHostName, http.mPort,
+							 request.getUri() ) );
+	bool noCache = String::toLower( request.getField( "cache-control" ) ).find( "no-cache" ) !=
+				   std::string::npos;
+	std::shared_ptr<Entry> entry;
+	Request toSend( request );
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		entry = find( key );
+
+		if ( entry ) {
+			if ( !noCache && entry->isFresh( currentTime() ) ) {
+				mMetrics.hits++;
+				mMetrics.bytesSaved += entry->size();
+				return entry->response;
+			}
+
+			if ( entry->response.hasField( "etag" ) )
+				toSend.setField( "If-None-Match", entry->response.getField( "etag" ) );
+
+			if ( entry->response.hasField( "last-modified" ) )
+				toSend.setField( "If-Modified-Since",
+								 entry->response.getField( "last-modified" ) );
+		}
+	}
+
+	Response response( http.sendUncachedRequest( toSend, timeout ) );
+	Int64 now = currentTime();
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	if ( entry && response.getStatus() == Response::NotModified ) {
+		revalidated( entry, response, now );
+		mMetrics.revalidations++;
+		mMetrics.bytesSaved += entry->size();
+		return entry->response;
+	}
+
+	mMetrics.misses++;
+
+	if ( isStorable( request, response, getFreshness( response, now ) ) ) {
+		store( key, response, now );
+	} else if ( entry && response.getStatus() == Response::Ok ) {
+		erase( key );
+	}
+
+	return response;
+}
+
+bool Http::Cache::isCacheable( const Http::Request& request ) {
+	return request.getMethod() == Request::Get && request.mBody.empty() && !request.isContinue() &&
+		   !request.hasField( "range" ) && !request.hasField( "if-none-match" ) &&
+		   !request.hasField( "if-modified-since" ) &&
+		   String::toLower( request.getField( "cache-control" ) ).find( "no-store" ) ==
+			   std::string::npos;
+}
+
+std::string Http::Cache::getKey( const std::string& scheme, const std::string& host,
+								 unsigned short port, const std::string& path ) {
+	return String::format( "%s://%s:%d%s", String::toLower( scheme ).c_str(),
+						   String::toLower( host ).c_str(), port,
+						   path.empty() ? "/" : path.c_str() );
+}
+
+std::shared_ptr<Http::Cache::Entry> Http::Cache::find( const std::string& key ) {
+	auto it = mEntriesMap.find( key );
+
+	if ( it != mEntriesMap.end() ) {
+		mEntries.splice( mEntries.begin(), mEntries, it->second );
+		return *it->second;
+	}
+
+	std::shared_ptr<Entry> entry( readEntry( key ) );
+
+	if ( entry )
+		insert( entry );
+
+	return entry;
+}
+
+std::shared_ptr<Http::Cache::Entry>
+Http::Cache::store( const std::string& key, const Http::Response& response, Int64 now ) {
+	std::shared_ptr<Entry> entry( std::make_shared<Entry>() );
+	entry->key = key;
+	entry->response = response;
+	entry->storedAt = now;
+	entry->freshFor = getFreshness( response, now );
+	entry->hash = MD5::fromString( response.mBody ).toHexString();
+
+	erase( key );
+	bool stored = insert( entry );
+
+	// Bodies bigger than the disk store would be evicted right away.
+	if ( !mDiskPath.empty() && entry->size() <= mMaxDiskSize && writeEntry( *entry ) ) {
+		stored = true;
+		evictDisk();
+	}
+
+	if ( stored )
+		mMetrics.stores++;
+
+	return entry;
+}
+
+void Http::Cache::revalidated( const std::shared_ptr<Http::Cache::Entry>& entry,
+							   const Http::Response& response, Int64 now ) {
+	// The fields of a 304 response update the stored ones.
+	for ( const auto& field : response.mFields ) {
+		if ( field.first != "content-length" && field.first != "transfer-encoding" &&
+			 field.first != "content-encoding" && field.first != "connection" )
+			entry->response.mFields[field.first] = field.second;
+	}
+
+	entry->storedAt = now;
+	entry->freshFor = getFreshness( entry->response, now );
+
+	if ( !mDiskPath.empty() )
+		writeEntry( *entry );
+}
+
+bool Http::Cache::insert( const std::shared_ptr<Http::Cache::Entry>& entry ) {
+	// Bodies bigger than the memory cache are only kept on disk.
+	if ( entry->size() > mMaxMemorySize )
+		return false;
+
+	mEntries.push_front( entry );
+	mEntriesMap[entry->key] = mEntries.begin();
+	mMemorySize += entry->size();
+	evictMemory();
+	return true;
+}
+
+void Http::Cache::erase( const std::string& key ) {
+	auto it = mEntriesMap.find( key );
+
+	if ( it != mEntriesMap.end() ) {
+		mMemorySize -= ( *it->second )->size();
+		mEntries.erase( it->second );
+		mEntriesMap.erase( it );
+	}
+
+	// The body stays in the store until the disk eviction, other entries could share it.
+	if ( !mDiskPath.empty() && FileSystem::fileExists( getEntryPath( key ) ) )
+		FileSystem::fileRemove( getEntryPath( key ) );
+}
+
+void Http::Cache::evictMemory() {
+	while ( mMemorySize > mMaxMemorySize && !mEntries.empty() ) {
+		mMemorySize -= mEntries.back()->size();
+		mEntriesMap.erase( mEntries.back()->key );
+		mEntries.pop_back();
+	}
+}
+
+std::string Http::Cache::getEntryPath( const std::string& key ) const {
+	return mDiskPath + "entries/" + MD5::fromString( key ).toHexString();
+}
+
+std::string Http::Cache::getObjectPath( const std::string& hash ) const {
+	return mDiskPath + "objects/" + hash;
+}
+
+std::shared_ptr<Http::Cache::Entry> Http::Cache::readEntry( const std::string& key ) {
+	std::string data;
+
+	if ( mDiskPath.empty() || !FileSystem::fileGet( getEntryPath( key ), data ) )
+		return std::shared_ptr<Entry>();
+
+	// signature, key, "storedAt freshFor status major minor size", hash and the fields.
+	std::vector<std::string> lines( String::split( data, '\n' ) );
+	std::shared_ptr<Entry> entry( std::make_shared<Entry>() );
+	Response& response = entry->response;
+	long long storedAt, freshFor;
+	unsigned long long size;
+	int status;
+
+	if ( lines.size() < 4 || lines[0] != CACHE_ENTRY_SIGNATURE || lines[1] != key ||
+		 sscanf( lines[2].c_str(), "%lld %lld %d %u %u %llu", &storedAt, &freshFor, &status,
+				 &response.mMajorVersion, &response.mMinorVersion, &size ) != 6 )
+		return std::shared_ptr<Entry>();
+
+	if ( !FileSystem::fileGet( getObjectPath( lines[3] ), response.mBody ) ||
+		 response.mBody.size() != size )
+		return std::shared_ptr<Entry>();
+
+	for ( std::size_t i = 4; i < lines.size(); i++ ) {
+		std::size_t pos = lines[i].find( ": " );
+
+		if ( pos != std::string::npos )
+			response.mFields[lines[i].substr( 0, pos )] = lines[i].substr( pos + 2 );
+	}
+
+	entry->key = key;
+	entry->storedAt = storedAt;
+	entry->freshFor = freshFor;
+	entry->hash = lines[3];
+	response.mStatus = static_cast<Response::Status>( status );
+	return entry;
+}
+
+bool Http::Cache::writeEntry( const Http::Cache::Entry& entry ) {
+	const Response& response = entry.response;
+	std::string objectPath( getObjectPath( entry.hash ) );
+
+	// The bodies are content addressed, equal bodies are stored once.
+	if ( !FileSystem::fileExists( objectPath ) ) {
+		if ( !writeFile( objectPath, response.mBody ) )
+			return false;
+
+		mDiskSize += entry.size();
+	}
+
+	std::string data( String::format(
+		"%s\n%s\n%lld %lld %d %u %u %llu\n%s\n", CACHE_ENTRY_SIGNATURE, entry.key.c_str(),
+		(long long)entry.storedAt, (long long)entry.freshFor, (int)response.mStatus,
+		response.mMajorVersion, response.mMinorVersion, (unsigned long long)entry.size(),
+		entry.hash.c_str() ) );
+
+	for ( const auto& field : response.mFields )
+		data += field.first + ": " + field.second + "\n";
+
+	return writeFile( getEntryPath( entry.key ), data );
+}
+
+void Http::Cache::evictDisk() {
+	if ( mDiskPath.empty() || ( mDiskSizeKnown && mDiskSize <= mMaxDiskSize ) )
+		return;
+
+	struct DiskEntry {
+		std::string path;
+		std::string hash;
+		Int64 storedAt;
+	};
+
+	std::vector<DiskEntry> entries;
+	std::map<std::string, Uint32> references;
+	std::map<std::string, Uint64> objects;
+	std::string entriesPath( mDiskPath + "entries/" );
+	std::string objectsPath( mDiskPath + "objects/" );
+	Uint64 diskSize = 0;
+
+	for ( const auto& object : FileSystem::filesGetInPath( objectsPath ) ) {
+		Uint64 size = FileSystem::fileSize( objectsPath + object );
+		objects[object] = size;
+		diskSize += size;
+	}
+
+	for ( const auto& file : FileSystem::filesGetInPath( entriesPath ) ) {
+		std::string data;
+
+		if ( !FileSystem::fileGet( entriesPath + file, data ) )
+			continue;
+
+		std::vector<std::string> lines( String::split( data, '\n' ) );
+		long long storedAt = 0;
+
+		if ( lines.size() < 4 || sscanf( lines[2].c_str(), "%lld", &storedAt ) != 1 ) {
+			FileSystem::fileRemove( entriesPath + file );
+			continue;
+		}
+
+		entries.push_back( { entriesPath + file, lines[3], storedAt } );
+		references[lines[3]]++;
+	}
+
+	// Bodies that no entry references anymore.
+	for ( const auto& object : objects ) {
+		if ( references.find( object.first ) == references.end() ) {
+			FileSystem::fileRemove( objectsPath + object.first );
+			diskSize -= object.second;
+		}
+	}
+
+	// The entries stored or revalidated least recently are evicted first.
+	std::sort( entries.begin(), entries.end(),
+			   []( const DiskEntry& a, const DiskEntry& b ) { return a.storedAt < b.storedAt; } );
+
+	for ( std::size_t i = 0; i < entries.size() && diskSize > mMaxDiskSize; i++ ) {
+		FileSystem::fileRemove( entries[i].path );
+
+		if ( --references[entries[i].hash] == 0 && objects.count( entries[i].hash ) ) {
+			FileSystem::fileRemove( objectsPath + entries[i].hash );
+			diskSize -= objects[entries[i].hash];
+		}
+	}
+
+	mDiskSize = diskSize;
+	mDiskSizeKnown = true;
+}
+
+}} // namespace EE::Network
@@ -0,0 +1,426 @@
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <eepp/network/http/httpresponseparser.hpp>
+
+namespace EE { namespace Network { namespace Private {
+
+#define HTTP_MAX_HEADER_SIZE ( 64 * 1024 )
+
+static bool equalsNoCase( const char* a, const char* b, std::size_t size ) {
+	for ( std::size_t i = 0; i < size; i++ ) {
+		if ( std::tolower( static_cast<unsigned char>( a[i] ) ) !=
+			 std::tolower( static_cast<unsigned char>( b[i] ) ) )
+			return false;
+	}
+
+	return true;
+}
+
+static bool isBlank( char c ) {
+	return ' ' == c || '\t' == c;
+}
+
+bool HttpResponseParser::StringView::equals( const char* str ) const {
+	std::size_t len = strlen( str );
+	return len == size && equalsNoCase( data, str, size );
+}
+
+bool HttpResponseParser::StringView::contains( const char* str ) const {
+	std::size_t len = strlen( str );
+
+	for ( std::size_t i = 0; i + len <= size; i++ ) {
+		if ( equalsNoCase( data + i, str, len ) )
+			return true;
+	}
+
+	return false;
+}
+
+ios_size HttpResponseParser::SinkStream::write( const char* data, ios_size size ) {
+	if ( !mParser.mDiscardBody && !mParser.mSinkFailed && mParser.mBodyCallback &&
+		 !mParser.mBodyCallback( data, size ) )
+		mParser.mSinkFailed = true;
+
+	return size;
+}
+
+HttpResponseParser::HttpResponseParser() : mSink( *this ), mInflate( NULL ), mDecompress( true ) {
+	reset();
+}
+
+HttpResponseParser::~HttpResponseParser() {
+	mDiscardBody = true;
+	eeSAFE_DELETE( mInflate );
+}
+
+void HttpResponseParser::setHeaderCallback( const HeaderCallback& headerCallback ) {
+	mHeaderCallback = headerCallback;
+}
+
+void HttpResponseParser::setBodyCallback( const BodyCallback& bodyCallback ) {
+	mBodyCallback = bodyCallback;
+}
+
+void HttpResponseParser::setDecompress( bool decompress ) {
+	mDecompress = decompress;
+}
+
+void HttpResponseParser::reset( bool headRequest ) {
+	// The pending decompressed data of an unfinished response is dropped.
+	mDiscardBody = true;
+	eeSAFE_DELETE( mInflate );
+
+	mState = State::Header;
+	mHeader.clear();
+	mLineStart = 0;
+	mFields.clear();
+	mRemaining = 0;
+	mContentLength = 0;
+	mReceived = 0;
+	mStatus = 0;
+	mMajorVersion = 0;
+	mMinorVersion = 0;
+	mHeadRequest = headRequest;
+	mDiscardBody = false;
+	mStarted = false;
+	mHeaderComplete = false;
+	mKeepAlive = false;
+	mSinkFailed = false;
+}
+
+void HttpResponseParser::discardBody() {
+	mDiscardBody = true;
+}
+
+std::size_t HttpResponseParser::parse( const char* data, std::size_t size ) {
+	std::size_t pos = 0;
+
+	if ( size > 0 )
+		mStarted = true;
+
+	while ( pos < size && State::Done != mState && State::Error != mState ) {
+		switch ( mState ) {
+			case State::Body:
+			case State::ChunkData: {
+				std::size_t length = eemin( mRemaining, size - pos );
+
+				writeBody( data + pos, length );
+				pos += length;
+				mRemaining -= length;
+
+				if ( 0 == mRemaining && State::Error != mState ) {
+					if ( State::Body == mState ) {
+						setDone();
+					} else {
+						mState = State::ChunkEnd;
+					}
+				}
+				break;
+			}
+			case State::UntilClose: {
+				writeBody( data + pos, size - pos );
+				pos = size;
+				break;
+			}
+			default: {
+				// The header, the chunk sizes and the trailer are read line by line.
+				bool complete;
+				pos += readLine( data + pos, size - pos, complete );
+
+				if ( complete && State::Error != mState )
+					parseLine();
+				break;
+			}
+		}
+	}
+
+	return pos;
+}
+
+bool HttpResponseParser::finish() {
+	if ( State::UntilClose == mState )
+		setDone();
+
+	return isDone();
+}
+
+std::size_t HttpResponseParser::readLine( const char* data, std::size_t size, bool& complete ) {
+	const char* eol = static_cast<const char*>( memchr( data, '\n', size ) );
+	std::size_t length = NULL != eol ? eol - data + 1 : size;
+
+	complete = NULL != eol;
+
+	if ( mHeader.size() + length > HTTP_MAX_HEADER_SIZE ) {
+		mState = State::Error;
+	} else {
+		mHeader.append( data, length );
+	}
+
+	return length;
+}
+
+void HttpResponseParser::parseLine() {
+	std::size_t start = mLineStart;
+	std::size_t end = mHeader.size() - 1;
+
+	if ( end > start && '\r' == mHeader[end - 1] )
+		end--;
+
+	switch ( mState ) {
+		case State::Header: {
+			mLineStart = mHeader.size();
+
+			if ( 0 == start ) {
+				if ( !parseStatusLine( mHeader.data(), end ) )
+					mState = State::Error;
+			} else if ( start == end ) {
+				headerReceived();
+			} else {
+				parseFieldLine( start, end );
+			}
+			break;
+		}
+		case State::ChunkSize: {
+			// Any chunk extension after the size is ignored.
+			const char* line = mHeader.data() + start;
+			char* sizeEnd = NULL;
+			unsigned long length = std::strtoul( line, &sizeEnd, 16 );
+
+			mHeader.resize( start );
+
+			if ( sizeEnd == line ) {
+				mState = State::Error;
+			} else if ( 0 == length ) {
+				mState = State::Trailer;
+			} else {
+				mRemaining = length;
+				mState = State::ChunkData;
+			}
+			break;
+		}
+		case State::ChunkEnd: {
+			mHeader.resize( start );
+			mState = State::ChunkSize;
+			break;
+		}
+		case State::Trailer: {
+			mLineStart = mHeader.size();
+
+			if ( start == end ) {
+				setDone();
+			} else {
+				parseFieldLine( start, end );
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+bool HttpResponseParser::parseStatusLine( const char* line, std::size_t size ) {
+	// HTTP/x.y status reason
+	if ( size < 12 || !equalsNoCase( line, "http/", 5 ) || !std::isdigit( line[5] ) ||
+		 '.' != line[6] || !std::isdigit( line[7] ) || !isBlank( line[8] ) )
+		return false;
+
+	mMajorVersion = line[5] - '0';
+	mMinorVersion = line[7] - '0';
+
+	std::size_t pos = 8;
+
+	while ( pos < size && isBlank( line[pos] ) )
+		pos++;
+
+	int status = 0;
+	std::size_t digits = 0;
+
+	while ( pos < size && std::isdigit( line[pos] ) && digits < 3 ) {
+		status = status * 10 + ( line[pos++] - '0' );
+		digits++;
+	}
+
+	if ( 0 == digits )
+		return false;
+
+	mStatus = status;
+	return true;
+}
+
+void HttpResponseParser::parseFieldLine( std::size_t start, std::size_t end ) {
+	const char* line = mHeader.data();
+	const char* colon = static_cast<const char*>( memchr( line + start, ':', end - start ) );
+
+	if ( NULL == colon || colon == line + start )
+		return;
+
+	std::size_t nameEnd = colon - line;
+	std::size_t value = nameEnd + 1;
+
+	while ( value < end && isBlank( line[value] ) )
+		value++;
+
+	while ( end > value && isBlank( line[end - 1] ) )
+		end--;
+
+	FieldOffsets field;
+	field.name = static_cast<Uint32>( start );
+	field.nameSize = static_cast<Uint32>( nameEnd - start );
+	field.value = static_cast<Uint32>( value );
+	field.valueSize = static_cast<Uint32>( end - value );
+	mFields.push_back( field );
+}
+
+void HttpResponseParser::headerReceived() {
+	// Interim responses are followed by the final response.
+	if ( mStatus >= 100 && mStatus < 200 ) {
+		mHeader.clear();
+		mLineStart = 0;
+		mFields.clear();
+		mStatus = 0;
+		return;
+	}
+
+	mHeaderComplete = true;
+
+	StringView connection( getField( "connection" ) );
+
+	if ( mMajorVersion * 10 + mMinorVersion >= 11 ) {
+		mKeepAlive = !connection.equals( "close" );
+	} else {
+		mKeepAlive = connection.equals( "keep-alive" );
+	}
+
+	bool chunked = getField( "transfer-encoding" ).contains( "chunked" );
+	StringView length( getField( "content-length" ) );
+	bool hasLength = !length.empty();
+
+	mContentLength = 0;
+
+	for ( std::size_t i = 0; i < length.size && hasLength; i++ ) {
+		if ( std::isdigit( length.data[i] ) ) {
+			mContentLength = mContentLength * 10 + ( length.data[i] - '0' );
+		} else {
+			hasLength = false;
+			mContentLength = 0;
+		}
+	}
+
+	if ( mHeaderCallback && !mHeaderCallback( *this ) ) {
+		mState = State::Error;
+		return;
+	}
+
+	if ( mDecompress && !mDiscardBody ) {
+		StringView encoding( getField( "content-encoding" ) );
+
+		if ( encoding.equals( "gzip" ) || encoding.equals( "deflate" ) ) {
+			mInflate = IOStreamInflate::New( mSink, encoding.equals( "gzip" )
+														? Compression::MODE_GZIP
+														: Compression::MODE_DEFLATE );
+		}
+	}
+
+	if ( mHeadRequest || 204 == mStatus || 304 == mStatus ) {
+		setDone();
+	} else if ( chunked ) {
+		mState = State::ChunkSize;
+	} else if ( hasLength ) {
+		mRemaining = mContentLength;
+
+		if ( mRemaining > 0 ) {
+			mState = State::Body;
+		} else {
+			setDone();
+		}
+	} else {
+		// The body ends when the server closes the connection.
+		mState = State::UntilClose;
+		mKeepAlive = false;
+	}
+}
+
+void HttpResponseParser::writeBody( const char* data, std::size_t size ) {
+	mReceived += size;
+
+	if ( mDiscardBody )
+		return;
+
+	if ( NULL != mInflate ) {
+		mInflate->write( data, size );
+	} else if ( mBodyCallback && !mBodyCallback( data, size ) ) {
+		mSinkFailed = true;
+	}
+
+	if ( mSinkFailed )
+		mState = State::Error;
+}
+
+void HttpResponseParser::setDone() {
+	eeSAFE_DELETE( mInflate );
+	mState = mSinkFailed ? State::Error : State::Done;
+}
+
+HttpResponseParser::StringView HttpResponseParser::view( Uint32 offset, Uint32 size ) const {
+	StringView view;
+	view.data = mHeader.data() + offset;
+	view.size = size;
+	return view;
+}
+
+HttpResponseParser::Field HttpResponseParser::getField( std::size_t index ) const {
+	Field field;
+	field.name = view( mFields[index].name, mFields[index].nameSize );
+	field.value = view( mFields[index].value, mFields[index].valueSize );
+	return field;
+}
+
+HttpResponseParser::StringView HttpResponseParser::getField( const char* name ) const {
+	std::size_t len = strlen( name );
+
+	for ( const auto& field : mFields ) {
+		if ( field.nameSize == len && equalsNoCase( mHeader.data() + field.name, name, len ) )
+			return view( field.value, field.valueSize );
+	}
+
+	return StringView();
+}
+
+bool HttpResponseParser::hasField( const char* name ) const {
+	return NULL != getField( name ).data;
+}
+
+void HttpResponseParser::fillResponse( Http::Response& response ) const {
+	response.mStatus = 0 != mStatus ? static_cast<Http::Response::Status>( mStatus )
+									: Http::Response::InvalidResponse;
+	response.mMajorVersion = mMajorVersion;
+	response.mMinorVersion = mMinorVersion;
+	response.mFields.clear();
+
+	for ( const auto& field : mFields ) {
+		std::string name( mHeader, field.name, field.nameSize );
+
+		for ( auto& c : name )
+			c = static_cast<char>( std::tolower( static_cast<unsigned char>( c ) ) );
+
+		response.mFields[name].assign( mHeader, field.value, field.valueSize );
+	}
+}
+
+bool HttpResponseParser::parseHeader( const char* data, std::size_t size,
+									  Http::Response& response ) {
+	HttpResponseParser parser;
+	parser.mHeaderCallback = []( HttpResponseParser& ) { return false; };
+	parser.parse( data, size );
+
+	if ( 0 == parser.mStatus ) {
+		response.mStatus = Http::Response::InvalidResponse;
+		return false;
+	}
+
+	parser.fillResponse( response );
+	return true;
+}
+
+}}} // namespace EE::Network::Private
@@ -0,0 +1,206 @@
+#ifndef EE_NETWORK_HTTPRESPONSEPARSER_HPP
+#define EE_NETWORK_HTTPRESPONSEPARSER_HPP
+
+#include <eepp/network/http.hpp>
+#include <eepp/system/iostream.hpp>
+#include <eepp/system/iostreaminflate.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EE::System;
+
+namespace EE { namespace Network { namespace Private {
+
+/** @brief Incremental HTTP/1.1 response parser.
+**	The received data can be fed in pieces of any size. The header is kept in a single buffer and
+**	its fields are exposed as views over it, the body ( de-chunked and decompressed ) is delivered
+**	to a sink as it arrives, so the memory used doesn't depend on the size of the body.
+**	The buffers keep their capacity between responses, parsing a kept alive connection doesn't
+**	allocate once the first response was received. */
+class EE_API HttpResponseParser {
+  public:
+	/** A non-owning view of a string. */
+	struct StringView {
+		const char* data{ NULL };
+		std::size_t size{ 0 };
+
+		bool empty() const { return 0 == size; }
+
+		std::string toString() const { return std::string( data, size ); }
+
+		/** @return If the view is equal to the string, ignoring the case. */
+		bool equals( const char* str ) const;
+
+		/** @return If the view contains the string, ignoring the case. */
+		bool contains( const char* str ) const;
+	};
+
+	struct Field {
+		StringView name;
+		StringView value;
+	};
+
+	enum class State {
+		Header,
+		Body,
+		UntilClose,
+		ChunkSize,
+		ChunkData,
+		ChunkEnd,
+		Trailer,
+		Done,
+		Error
+	};
+
+	/** Called once the header of the final response was received. Returning false stops the
+	 * parsing. */
+	typedef std::function<bool( HttpResponseParser& )> HeaderCallback;
+
+	/** Receives the body. Returning false stops the parsing. */
+	typedef std::function<bool( const char* data, std::size_t size )> BodyCallback;
+
+	HttpResponseParser();
+
+	~HttpResponseParser();
+
+	void setHeaderCallback( const HeaderCallback& headerCallback );
+
+	void setBodyCallback( const BodyCallback& bodyCallback );
+
+	/** Sets if the gzip and deflate content encodings are decoded before being delivered to the
+	 * body callback. Enabled by default. */
+	void setDecompress( bool decompress );
+
+	/** Prepares the parser for the next response.
+	**	@param headRequest If the response is the answer to a HEAD request ( it has no body ). */
+	void reset( bool headRequest = false );
+
+	/** Parses the data received.
+	**	@return The number of bytes consumed. Less than size when the response ended ( the rest
+	**	belongs to the next response ) or the parsing stopped. */
+	std::size_t parse( const char* data, std::size_t size );
+
+	/** Must be called when the connection is closed. Finishes the responses whose body ends with
+	 * the connection.
+	 * @return If the response is complete. */
+	bool finish();
+
+	/** Ignores the body of the current response. Can be called from the header callback. */
+	void discardBody();
+
+	const State& getState() const { return mState; }
+
+	bool isDone() const { return State::Done == mState; }
+
+	bool hasError() const { return State::Error == mState; }
+
+	/** @return If any byte of the response was received. */
+	bool isStarted() const { return mStarted; }
+
+	/** @return If the header of the final response was received. */
+	bool isHeaderComplete() const { return mHeaderComplete; }
+
+	int getStatus() const { return mStatus; }
+
+	unsigned int getMajorHttpVersion() const { return mMajorVersion; }
+
+	unsigned int getMinorHttpVersion() const { return mMinorVersion; }
+
+	/** @return The number of fields of the header, including the trailer fields of chunked
+	 * responses. */
+	std::size_t getFieldCount() const { return mFields.size(); }
+
+	Field getField( std::size_t index ) const;
+
+	/** @return The value of the field ( the name is case insensitive ), empty if not found. */
+	StringView getField( const char* name ) const;
+
+	bool hasField( const char* name ) const;
+
+	/** @return If the connection can be used for the next request. */
+	bool isKeepAlive() const { return mKeepAlive; }
+
+	/** @return The content length declared in the header, 0 if unknown. */
+	std::size_t getContentLength() const { return mContentLength; }
+
+	/** @return The number of body bytes received, as sent by the server. */
+	std::size_t getReceived() const { return mReceived; }
+
+	/** Copies the status, version and fields parsed to the response. */
+	void fillResponse( Http::Response& response ) const;
+
+	/** Parses a complete header and copies it to the response. */
+	static bool parseHeader( const char* data, std::size_t size, Http::Response& response );
+
+  protected:
+	struct FieldOffsets {
+		Uint32 name;
+		Uint32 nameSize;
+		Uint32 value;
+		Uint32 valueSize;
+	};
+
+	class SinkStream : public IOStream {
+	  public:
+		SinkStream( HttpResponseParser& parser ) : mParser( parser ) {}
+
+		virtual ios_size read( char*, ios_size ) { return 0; }
+
+		virtual ios_size write( const char* data, ios_size size );
+
+		virtual ios_size seek( ios_size ) { return 0; }
+
+		virtual ios_size tell() { return 0; }
+
+		virtual ios_size getSize() { return 0; }
+
+		virtual bool isOpen() { return true; }
+
+	  protected:
+		HttpResponseParser& mParser;
+	};
+
+	HeaderCallback mHeaderCallback;
+	BodyCallback mBodyCallback;
+	SinkStream mSink;
+	IOStreamInflate* mInflate;
+	State mState;
+	// The header, the trailer fields and the chunk size being read.
+	std::string mHeader;
+	std::size_t mLineStart;
+	std::vector<FieldOffsets> mFields;
+	std::size_t mRemaining;
+	std::size_t mContentLength;
+	std::size_t mReceived;
+	int mStatus;
+	unsigned int mMajorVersion;
+	unsigned int mMinorVersion;
+	bool mDecompress;
+	bool mHeadRequest;
+	bool mDiscardBody;
+	bool mStarted;
+	bool mHeaderComplete;
+	bool mKeepAlive;
+	bool mSinkFailed;
+
+	std::size_t readLine( const char* data, std::size_t size, bool& complete );
+
+	void parseLine();
+
+	bool parseStatusLine( const char* line, std::size_t size );
+
+	void parseFieldLine( std::size_t start, std::size_t end );
+
+	void headerReceived();
+
+	void writeBody( const char* data, std::size_t size );
+
+	void setDone();
+
+	StringView view( Uint32 offset, Uint32 size ) const;
+};
+
+}}} // namespace EE::Network::Private
+
+#endif // EE_NETWORK_HTTPRESPONSEPARSER_HPP
@@ -0,0 +1,230 @@
+#include <atomic>
+#include <eepp/network/http.hpp>
+#include <eepp/system/iostreamfile.hpp>
+#include <eepp/system/iostreamstring.hpp>
+#include <eepp/system/thread.hpp>
+
+namespace EE { namespace Network {
+
+// The minimum size of a range, smaller files use less ranges.
+#define SEGMENT_MIN_SIZE ( 256 * 1024 )
+
+namespace {
+
+// Writes a range of the file from its own file handle. Anything beyond the range ( i.e. a server
+// that ignores the Range field ) is discarded.
+class SegmentStream : public IOStream {
+  public:
+	SegmentStream( const std::string& path, Uint64 offset, Uint64 size ) :
+		mFile( path, "rb+" ), mSize( size ), mWritten( 0 ), mOverflow( false ) {
+		mFile.seek( offset );
+	}
+
+	virtual ios_size read( char*, ios_size ) { return 0; }
+
+	virtual ios_size write( const char* data, ios_size size ) {
+		Uint64 length = eemin<Uint64>( size, mSize - mWritten );
+
+		if ( length < static_cast<Uint64>( size ) )
+			mOverflow = true;
+
+		if ( length > 0 ) {
+			mFile.write( data, length );
+			mWritten += length;
+		}
+
+		return size;
+	}
+
+	virtual ios_size seek( ios_size ) { return mWritten; }
+
+	virtual ios_size tell() { return mWritten; }
+
+	virtual ios_size getSize() { return mWritten; }
+
+	virtual bool isOpen() { return mFile.isOpen(); }
+
+	bool isComplete() const { return mWritten == mSize && !mOverflow; }
+
+  protected:
+	IOStreamFile mFile;
+	Uint64 mSize;
+	Uint64 mWritten;
+	bool mOverflow;
+};
+
+struct Segment {
+	Uint64 offset{ 0 };
+	Uint64 size{ 0 };
+	// Bytes of the segment already reported to the progress callback.
+	Uint64 reported{ 0 };
+	bool complete{ false };
+	Http::Response response;
+
+	// The data of any other range ( or of a file with another length ) would be written at the
+	// wrong offset.
+	bool isContentRange( const std::string& contentRange, Uint64 length ) const {
+		std::string range( String::format( "bytes %llu-%llu/", (unsigned long long)offset,
+										   (unsigned long long)( offset + size - 1 ) ) );
+		std::string value( String::toLower( String::trim( contentRange ) ) );
+
+		return value == range + String::toString( length ) || value == range + "*";
+	}
+};
+
+} // namespace
+
+Http::Response Http::downloadSegmented( const Http::Request& request,
+										const std::string& writePath, Time timeout ) {
+	// The ranges are of the encoded content, so the segments are requested without compression.
+	Request head( request );
+	head.setMethod( Request::Head );
+	head.setSegments( 1 );
+	head.setCompressedResponse( false );
+	head.setProgressCallback( Request::ProgressCallback() );
+
+	IOStreamString headBody;
+	Response headResponse( downloadRequest( head, headBody, timeout ) );
+	Uint64 length = 0;
+	bool acceptRanges =
+		headResponse.getStatus() == Response::Ok &&
+		String::toLower( headResponse.getField( "accept-ranges" ) ) == "bytes" &&
+		String::fromString( length, headResponse.getField( "content-length" ) ) &&
+		headResponse.getField( "content-encoding" ).empty();
+	Uint64 count = acceptRanges ? eemin<Uint64>( request.getSegments(), length / SEGMENT_MIN_SIZE )
+								: 1;
+
+	// Preallocates the file, so each segment can be written at its offset.
+	if ( count > 1 ) {
+		IOStreamFile file( writePath, "wb" );
+
+		if ( !file.isOpen() || file.seek( length - 1 ) != static_cast<ios_size>( length - 1 ) ||
+			 file.write( "", 1 ) != 1 )
+			count = 1;
+	}
+
+	if ( count <= 1 ) {
+		Request single( request );
+		single.setSegments( 1 );
+		return downloadRequest( single, writePath, timeout );
+	}
+
+	std::vector<Segment> segments( count );
+	Uint64 segmentSize = length / count;
+
+	for ( Uint64 i = 0; i < count; i++ ) {
+		segments[i].offset = i * segmentSize;
+		segments[i].size = i + 1 < count ? segmentSize : length - segments[i].offset;
+	}
+
+	std::mutex progressMutex;
+	std::atomic<Uint64> received( 0 );
+	std::atomic<bool> cancelled( false );
+	std::atomic<bool> rangesIgnored( false );
+
+	auto download = [&]( Segment& segment ) {
+		SegmentStream stream( writePath, segment.offset, segment.size );
+		Request segmentRequest( request );
+		segmentRequest.setSegments( 1 );
+		segmentRequest.setCompressedResponse( false );
+		segmentRequest.setField( "Range", String::format( "bytes=%llu-%llu",
+														  (unsigned long long)segment.offset,
+														  (unsigned long long)( segment.offset +
+																				segment.size -
+																				1 ) ) );
+
+		// The progress of every segment is reported as the progress of the whole file.
+		segmentRequest.setProgressCallback(
+			[&]( const Http&, const Request&, const Response& response,
+				 const Request::Status& status, std::size_t, std::size_t currentBytes ) {
+				if ( cancelled || rangesIgnored )
+					return false;
+
+				// The server answered with the whole file.
+				if ( status == Request::HeaderReceived && response.getStatus() == Response::Ok ) {
+					rangesIgnored = true;
+					return false;
+				}
+
+				if ( status != Request::ContentReceived || currentBytes <= segment.reported )
+					return true;
+
+				Uint64 total = received += currentBytes - segment.reported;
+				segment.reported = currentBytes;
+
+				if ( request.getProgressCallback() ) {
+					std::lock_guard<std::mutex> lock( progressMutex );
+
+					if ( !cancelled && !request.getProgressCallback()(
+										   *this, request, headResponse,
+										   Request::ContentReceived, length, total ) ) {
+						cancelled = true;
+						request.mCancel = true;
+					}
+				}
+
+				return !cancelled;
+			} );
+
+		segment.response = downloadRequest( segmentRequest, stream, timeout );
+		segment.complete =
+			segment.response.getStatus() == Response::PartialContent && stream.isComplete() &&
+			segment.isContentRange( segment.response.getField( "content-range" ), length );
+	};
+
+	// The first segment is downloaded from the calling thread.
+	std::vector<std::unique_ptr<Thread>> threads;
+
+	for ( Uint64 i = 1; i < count; i++ ) {
+		Segment& segment = segments[i];
+
+		threads.emplace_back( new Thread( [&, this] {
+			download( segment );
+			// The connections are per thread.
+			destroyConnection();
+		} ) );
+		threads.back()->launch();
+	}
+
+	download( segments[0] );
+
+	for ( auto& thread : threads )
+		thread->wait();
+
+	// The HEAD response promised ranges that the GET requests don't honor.
+	if ( rangesIgnored && !cancelled ) {
+		Request single( request );
+		single.setSegments( 1 );
+		return downloadRequest( single, writePath, timeout );
+	}
+
+	// Failed segments are retried once.
+	for ( auto& segment : segments ) {
+		if ( !segment.complete && !cancelled && !rangesIgnored ) {
+			received -= segment.reported;
+			segment.reported = 0;
+			download( segment );
+		}
+	}
+
+	for ( auto& segment : segments ) {
+		if ( !segment.complete ) {
+			Response response( segment.response );
+
+			if ( response.getStatus() == Response::PartialContent ||
+				 response.getStatus() == Response::Ok )
+				response.mStatus = Response::InvalidResponse;
+
+			return response;
+		}
+	}
+
+	// Every range was received, the response describes the whole file.
+	Response response( segments[0].response );
+	response.mStatus = Response::Ok;
+	response.mFields.erase( "content-range" );
+	response.mFields["content-length"] = String::toString( length );
+	return response;
+}
+
+}} // namespace EE::Network
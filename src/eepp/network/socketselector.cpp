@@ -19,8 +19,12 @@ namespace EE { namespace Network {
 struct SocketSelector::SocketSelectorImpl {
 	fd_set AllSockets;	 ///< Set containing all the sockets handles
 	fd_set SocketsReady; ///< Set containing handles of the sockets that are ready
+	fd_set WriteSockets; ///< Set containing the handles of the sockets waiting to write
+	fd_set WriteReady;	 ///< Set containing handles of the sockets that are ready to write
+	fd_set ErrorReady;	 ///< Set containing handles of the sockets that failed to connect
 	int MaxSocket;		 ///< Maximum socket handle
 	int SocketCount;	 ///< Number of socket handles
+	int WriteSocketCount; ///< Number of socket handles waiting to write
 };
 
 SocketSelector::SocketSelector() : mImpl( eeNew( SocketSelectorImpl, () ) ) {
@@ -83,12 +87,65 @@ void SocketSelector::remove( Socket& socket ) {
 	}
 }
 
+void SocketSelector::addWrite( Socket& socket ) {
+	SocketHandle handle = socket.getHandle();
+
+	if ( handle != Private::SocketImpl::invalidSocket() ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+		if ( mImpl->WriteSocketCount >= FD_SETSIZE ) {
+			Log::error( "The socket can't be added to the selector because its ID is too high. "
+						"This is a limitation of your operating system's FD_SETSIZE setting." );
+			return;
+		}
+
+		if ( FD_ISSET( handle, &mImpl->WriteSockets ) )
+			return;
+
+		mImpl->WriteSocketCount++;
+#else
+		if ( handle >= FD_SETSIZE ) {
+			Log::error( "The socket can't be added to the selector because its ID is too high. "
+						"This is a limitation of your operating system's FD_SETSIZE setting." );
+			return;
+		}
+
+		mImpl->MaxSocket = std::max( mImpl->MaxSocket, handle );
+#endif
+
+		FD_SET( handle, &mImpl->WriteSockets );
+	}
+}
+
+void SocketSelector::removeWrite( Socket& socket ) {
+	SocketHandle handle = socket.getHandle();
+
+	if ( handle != Private::SocketImpl::invalidSocket() ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+		if ( !FD_ISSET( handle, &mImpl->WriteSockets ) )
+			return;
+
+		mImpl->WriteSocketCount--;
+#else
+		if ( handle >= FD_SETSIZE )
+			return;
+#endif
+
+		FD_CLR( handle, &mImpl->WriteSockets );
+		FD_CLR( handle, &mImpl->WriteReady );
+		FD_CLR( handle, &mImpl->ErrorReady );
+	}
+}
+
 void SocketSelector::clear() {
 	FD_ZERO( &mImpl->AllSockets );
 	FD_ZERO( &mImpl->SocketsReady );
+	FD_ZERO( &mImpl->WriteSockets );
+	FD_ZERO( &mImpl->WriteReady );
+	FD_ZERO( &mImpl->ErrorReady );
 
 	mImpl->MaxSocket = 0;
 	mImpl->SocketCount = 0;
+	mImpl->WriteSocketCount = 0;
 }
 
 bool SocketSelector::wait( Time timeout ) {
@@ -97,12 +154,21 @@ bool SocketSelector::wait( Time timeout ) {
 	time.tv_sec = static_cast<long>( timeout.asMicroseconds() / 1000000 );
 	time.tv_usec = static_cast<long>( timeout.asMicroseconds() % 1000000 );
 
-	// Initialize the set that will contain the sockets that are ready
+	// Initialize the sets that will contain the sockets that are ready
 	mImpl->SocketsReady = mImpl->AllSockets;
+	mImpl->WriteReady = mImpl->WriteSockets;
+
+	// Windows reports the failed non-blocking connections as exceptions instead of as writable
+	mImpl->ErrorReady = mImpl->WriteSockets;
 
-	// Wait until one of the sockets is ready for reading, or timeout is reached
+	// Wait until one of the sockets is ready for reading or writing, or timeout is reached
 	// The first parameter is ignored on Windows
-	int count = select( mImpl->MaxSocket + 1, &mImpl->SocketsReady, NULL, NULL,
+	int count = select( mImpl->MaxSocket + 1, &mImpl->SocketsReady, &mImpl->WriteReady,
+#if EE_PLATFORM == EE_PLATFORM_WIN
+						&mImpl->ErrorReady,
+#else
+						NULL,
+#endif
 						timeout != Time::Zero ? &time : NULL );
 
 	return count > 0;
@@ -123,6 +189,24 @@ bool SocketSelector::isReady( Socket& socket ) const {
 	return false;
 }
 
+bool SocketSelector::isReadyToWrite( Socket& socket ) const {
+	SocketHandle handle = socket.getHandle();
+
+	if ( handle != Private::SocketImpl::invalidSocket() ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+		if ( handle >= FD_SETSIZE )
+			return false;
+
+		return FD_ISSET( handle, &mImpl->WriteReady ) != 0 ||
+			   FD_ISSET( handle, &mImpl->ErrorReady ) != 0;
+#else
+		return FD_ISSET( handle, &mImpl->WriteReady ) != 0;
+#endif
+	}
+
+	return false;
+}
+
 SocketSelector& SocketSelector::operator=( const SocketSelector& right ) {
 	SocketSelector temp( right );
 
@@ -492,7 +492,7 @@ void Node::drawChilds() {
 		Node* child = mChildLast;
 
 		while ( NULL != child ) {
-			if ( child->mVisible ) {
+			if ( child->mVisible && !isChildCulled( child ) ) {
 				child->nodeDraw();
 			}
 
@@ -502,7 +502,7 @@ void Node::drawChilds() {
 		Node* child = mChild;
 
 		while ( NULL != child ) {
-			if ( child->mVisible ) {
+			if ( child->mVisible && !isChildCulled( child ) ) {
 				child->nodeDraw();
 			}
 
@@ -511,6 +511,22 @@ void Node::drawChilds() {
 	}
 }
 
+bool Node::isChildCulled( Node* child ) {
+	if ( NULL == mSceneNode )
+		return false;
+
+	// Only nodes that can't draw outside their bounds can be culled: clipped nodes and nodes
+	// without children. Windows are kept since their shadow is drawn outside their bounds.
+	if ( ( NULL != child->mChild && !child->isClipped() ) || child->isWindow() ||
+		 child->getWorldBounds().intersect( mSceneNode->getCullRect() ) ) {
+		mSceneNode->mDrawnNodes++;
+		return false;
+	}
+
+	mSceneNode->mCulledNodes++;
+	return true;
+}
+
 void Node::nodeDraw() {
 	if ( mVisible ) {
 		if ( mNodeFlags & NODE_FLAG_POSITION_DIRTY )
@@ -547,15 +563,29 @@ const Vector2f& Node::getScreenPos() const {
 }
 
 void Node::clipStart() {
+	// A frame buffer is kept until it's invalidated, even while it's drawn outside the visible
+	// area. So its children are culled against the frame buffer, not against the visible area.
+	if ( mVisible && isFrameBuffer() && NULL != mSceneNode && mSceneNode != this )
+		mSceneNode->pushCullRect( getWorldBounds(), false );
+
 	if ( mVisible && isClipped() ) {
 		clipSmartEnable( mScreenPos.x, mScreenPos.y, mSize.getWidth(), mSize.getHeight() );
+
+		if ( NULL != mSceneNode )
+			mSceneNode->pushCullRect( getWorldBounds() );
 	}
 }
 
 void Node::clipEnd() {
 	if ( mVisible && isClipped() ) {
 		clipSmartDisable();
+
+		if ( NULL != mSceneNode )
+			mSceneNode->popCullRect();
 	}
+
+	if ( mVisible && isFrameBuffer() && NULL != mSceneNode && mSceneNode != this )
+		mSceneNode->popCullRect();
 }
 
 void Node::matrixSet() {
@@ -33,7 +33,11 @@ SceneNode::SceneNode( EE::Window::Window* window ) :
 	mHighlightInvalidation( false ),
 	mHighlightFocusColor( 234, 195, 123, 255 ),
 	mHighlightOverColor( 195, 123, 234, 255 ),
-	mHighlightInvalidationColor( 220, 0, 0, 255 ) {
+	mHighlightInvalidationColor( 220, 0, 0, 255 ),
+	mDrawnNodes( 0 ),
+	mCulledNodes( 0 ),
+	mLastDrawnNodes( 0 ),
+	mLastCulledNodes( 0 ) {
 	mNodeFlags |= NODE_FLAG_SCENENODE;
 	mSceneNode = this;
 
@@ -105,11 +109,18 @@ void SceneNode::draw() {
 		matrixSet();
 
 		if ( NULL == mFrameBuffer || !usesInvalidation() || invalidated() ) {
+			mDrawnNodes = mCulledNodes = 0;
+			mCullRects.clear();
+			mCullRects.push_back( getWorldBounds() );
+
 			clipStart();
 
 			drawChilds();
 
 			clipEnd();
+
+			mLastDrawnNodes = mDrawnNodes;
+			mLastCulledNodes = mCulledNodes;
 		}
 
 		matrixUnset();
@@ -481,4 +492,30 @@ const Float& SceneNode::getDPI() const {
 	return mDPI;
 }
 
+const Uint32& SceneNode::getDrawnNodesCount() const {
+	return mLastDrawnNodes;
+}
+
+const Uint32& SceneNode::getCulledNodesCount() const {
+	return mLastCulledNodes;
+}
+
+const Rectf& SceneNode::getCullRect() const {
+	return mCullRects.empty() ? mWorldBounds : mCullRects.back();
+}
+
+void SceneNode::pushCullRect( const Rectf& rect, bool intersectCurrent ) {
+	Rectf cullRect( rect );
+
+	if ( intersectCurrent && !mCullRects.empty() )
+		cullRect.shrink( mCullRects.back() );
+
+	mCullRects.push_back( cullRect );
+}
+
+void SceneNode::popCullRect() {
+	if ( mCullRects.size() > 1 )
+		mCullRects.pop_back();
+}
+
 }} // namespace EE::Scene
@@ -0,0 +1,141 @@
+#include <cstring>
+#include <eepp/core/memorymanager.hpp>
+#include <eepp/system/iostreammappedfile.hpp>
+
+#if EE_PLATFORM == EE_PLATFORM_WIN
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace EE { namespace System {
+
+IOStreamMappedFile* IOStreamMappedFile::New( const std::string& path ) {
+	return eeNew( IOStreamMappedFile, ( path ) );
+}
+
+IOStreamMappedFile::IOStreamMappedFile( const std::string& path ) :
+	mPath( path ),
+	mData( NULL ),
+	mSize( 0 ),
+	mPos( 0 )
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	,
+	mFile( NULL ),
+	mMapping( NULL )
+#endif
+{
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	HANDLE file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+							   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE )
+		return;
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 ) {
+		CloseHandle( file );
+		return;
+	}
+	HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( mapping == NULL ) {
+		CloseHandle( file );
+		return;
+	}
+	void* data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	if ( data == NULL ) {
+		CloseHandle( mapping );
+		CloseHandle( file );
+		return;
+	}
+	mFile = file;
+	mMapping = mapping;
+	mData = static_cast<const char*>( data );
+	mSize = static_cast<ios_size>( size.QuadPart );
+#else
+	int fd = open( path.c_str(), O_RDONLY );
+	if ( fd == -1 )
+		return;
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 || st.st_size == 0 ) {
+		::close( fd );
+		return;
+	}
+	void* data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	// The mapping keeps its own reference to the file.
+	::close( fd );
+	if ( data == MAP_FAILED )
+		return;
+	mData = static_cast<const char*>( data );
+	mSize = static_cast<ios_size>( st.st_size );
+#endif
+}
+
+IOStreamMappedFile::~IOStreamMappedFile() {
+	close();
+}
+
+ios_size IOStreamMappedFile::read( char* data, ios_size size ) {
+	if ( !isOpen() || mPos >= mSize )
+		return 0;
+	if ( mPos + size > mSize )
+		size = mSize - mPos;
+	memcpy( data, mData + mPos, size );
+	mPos += size;
+	return size;
+}
+
+ios_size IOStreamMappedFile::write( const char*, ios_size ) {
+	return 0;
+}
+
+ios_size IOStreamMappedFile::seek( ios_size position ) {
+	mPos = position < 0 ? 0 : ( position > mSize ? mSize : position );
+	return mPos;
+}
+
+ios_size IOStreamMappedFile::tell() {
+	return isOpen() ? mPos : -1;
+}
+
+ios_size IOStreamMappedFile::getSize() {
+	return mSize;
+}
+
+bool IOStreamMappedFile::isOpen() {
+	return NULL != mData;
+}
+
+void IOStreamMappedFile::close() {
+	if ( !isOpen() )
+		return;
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	UnmapViewOfFile( mData );
+	CloseHandle( mMapping );
+	CloseHandle( mFile );
+	mMapping = NULL;
+	mFile = NULL;
+#else
+	munmap( const_cast<char*>( mData ), mSize );
+#endif
+	mData = NULL;
+	mSize = 0;
+	mPos = 0;
+}
+
+const char* IOStreamMappedFile::getData() const {
+	return mData;
+}
+
+const std::string& IOStreamMappedFile::getPath() const {
+	return mPath;
+}
+
+}} // namespace EE::System
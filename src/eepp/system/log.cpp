@@ -1,6 +1,13 @@
+#include <atomic>
+#include <condition_variable>
 #include <cstdarg>
+#include <cstdio>
+#include <eepp/system/filesystem.hpp>
 #include <eepp/system/log.hpp>
+#include <eepp/system/thread.hpp>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 #if EE_PLATFORM == EE_PLATFORM_ANDROID
 #include <android/log.h>
@@ -18,8 +25,96 @@
 
 namespace EE { namespace System {
 
+namespace Private {
+
+/** Bounded multiple producer single consumer queue. The producers only contend on the enqueue
+ * position, every slot has a sequence number that tells if it's free or holds a message. */
+class LogQueue {
+  public:
+	LogQueue( size_t capacity ) : mMask( capacity - 1 ), mSlots( new Slot[capacity] ) {
+		for ( size_t i = 0; i < capacity; i++ )
+			mSlots[i].sequence.store( i, std::memory_order_relaxed );
+	}
+
+	~LogQueue() { delete[] mSlots; }
+
+	bool push( std::string& text ) {
+		size_t pos = mEnqueuePos.load( std::memory_order_relaxed );
+		Slot* slot;
+
+		while ( true ) {
+			slot = &mSlots[pos & mMask];
+			size_t sequence = slot->sequence.load( std::memory_order_acquire );
+			intptr_t diff = static_cast<intptr_t>( sequence ) - static_cast<intptr_t>( pos );
+
+			if ( diff == 0 ) {
+				if ( mEnqueuePos.compare_exchange_weak( pos, pos + 1,
+														std::memory_order_relaxed ) )
+					break;
+			} else if ( diff < 0 ) {
+				return false;
+			} else {
+				pos = mEnqueuePos.load( std::memory_order_relaxed );
+			}
+		}
+
+		slot->text.swap( text );
+		slot->sequence.store( pos + 1, std::memory_order_release );
+		return true;
+	}
+
+	/** Only called from the writer thread. */
+	bool pop( std::string& text ) {
+		Slot* slot = &mSlots[mDequeuePos & mMask];
+
+		if ( slot->sequence.load( std::memory_order_acquire ) != mDequeuePos + 1 )
+			return false;
+
+		text.swap( slot->text );
+		slot->text.clear();
+		slot->sequence.store( mDequeuePos + mMask + 1, std::memory_order_release );
+		mDequeuePos++;
+		return true;
+	}
+
+	/** Wakes the writer thread if it's sleeping. */
+	void notify() {
+		if ( mSleeping ) {
+			std::lock_guard<std::mutex> lock( mMutex );
+			mWakeUp.notify_one();
+		}
+	}
+
+	struct Slot {
+		std::atomic<size_t> sequence;
+		std::string text;
+	};
+
+	const size_t mMask;
+	Slot* mSlots;
+	std::atomic<size_t> mEnqueuePos{ 0 };
+	size_t mDequeuePos{ 0 };
+	std::atomic<Uint64> mQueued{ 0 };
+	std::atomic<Uint64> mProcessed{ 0 };
+	std::atomic<Uint64> mDropped{ 0 };
+	std::atomic<bool> mSleeping{ false };
+	std::atomic<bool> mStop{ false };
+	std::atomic<std::thread::id> mWriterId;
+	std::mutex mMutex;
+	std::condition_variable mWakeUp;
+	std::condition_variable mProcessedCond;
+};
+
+} // namespace Private
+
 SINGLETON_DECLARE_IMPLEMENTATION( Log )
 
+static void setDefaultOverflowPolicies( LogOverflowPolicy* policies ) {
+	for ( int i = 0; i < EE_LOG_LEVEL_COUNT; i++ )
+		policies[i] = i < static_cast<int>( LogLevel::Warning ) ? LogOverflowPolicy::Drop
+																 : LogOverflowPolicy::Block;
+}
+
 Log* Log::create( const LogLevel& level, bool consoleOutput, bool liveWrite ) {
 	if ( NULL == ms_singleton ) {
 		ms_singleton = eeNew( Log, ( level, consoleOutput, liveWrite ) );
@@ -28,6 +123,7 @@ Log* Log::create( const LogLevel& level, bool consoleOutput, bool liveWrite ) {
 }
 
 Log::Log() : mSave( false ), mConsoleOutput( false ), mLiveWrite( false ), mFS( NULL ) {
+	setDefaultOverflowPolicies( mOverflowPolicy );
 	writel( LogLevel::Info, "eepp initialized" );
 }
 
@@ -37,12 +133,15 @@ Log::Log( const LogLevel& level, bool consoleOutput, bool liveWrite ) :
 	mLiveWrite( liveWrite ),
 	mLogLevelThreshold( level ),
 	mFS( NULL ) {
+	setDefaultOverflowPolicies( mOverflowPolicy );
 	writel( LogLevel::Info, "eepp initialized" );
 }
 
 Log::~Log() {
 	writel( LogLevel::Info, "eepp stoped\n" );
 
+	setAsync( false );
+
 	if ( mSave && !mLiveWrite ) {
 		openFS();
 
@@ -71,33 +170,7 @@ void Log::save( const std::string& filepath ) {
 }
 
 void Log::write( const std::string& text ) {
-	lock();
-	mData += text;
-	unlock();
-
-	writeToReaders( text );
-
-	if ( mConsoleOutput ) {
-#if EE_PLATFORM == EE_PLATFORM_ANDROID
-		__android_log_print( ANDROID_LOG_INFO, "eepp", "%s", text.c_str() );
-#elif defined( EE_COMPILER_MSVC )
-#ifdef UNICODE
-		OutputDebugString( String::fromUtf8( text ).toWideString().c_str() );
-#else
-		OutputDebugString( text.c_str() );
-#endif
-#else
-		std::cout << text;
-#endif
-	}
-
-	if ( mLiveWrite ) {
-		openFS();
-
-		mFS->write( text.c_str(), text.size() );
-
-		mFS->flush();
-	}
+	dispatch( LogLevel::Info, std::string( text ) );
 }
 
 static std::string logLevelToString( const LogLevel& level ) {
@@ -129,45 +202,125 @@ static std::string logLevelWithTimestamp( const LogLevel& level, const std::stri
 
 void Log::write( const LogLevel& level, const std::string& text ) {
 	if ( level >= mLogLevelThreshold )
-		write( logLevelWithTimestamp( level, text, false ) );
+		dispatch( level, logLevelWithTimestamp( level, text, false ) );
 }
 
 void Log::writel( const std::string& text ) {
-	lock();
-	mData += text;
-	mData += "\n";
-	unlock();
+	dispatch( LogLevel::Info, text + "\n" );
+}
+
+void Log::writel( const LogLevel& level, const std::string& text ) {
+	if ( level >= mLogLevelThreshold )
+		dispatch( level, logLevelWithTimestamp( level, text, true ) );
+}
+
+void Log::dispatch( const LogLevel& level, std::string&& text ) {
+	Private::LogQueue* queue = mQueue;
+
+	// The writes of the readers called from the writer thread are processed right away.
+	if ( NULL == queue || queue->mWriterId == std::this_thread::get_id() ) {
+		process( text );
+		return;
+	}
+
+	while ( !queue->push( text ) ) {
+		if ( mOverflowPolicy[static_cast<int>( level )] == LogOverflowPolicy::Drop ) {
+			queue->mDropped++;
+			return;
+		}
+
+		queue->notify();
+		std::this_thread::yield();
+	}
+
+	queue->mQueued++;
+	queue->notify();
+}
+
+void Log::process( const std::string& text ) {
+	appendToBuffer( text );
 
 	writeToReaders( text );
-	writeToReaders( "\n" );
 
 	if ( mConsoleOutput ) {
 #if EE_PLATFORM == EE_PLATFORM_ANDROID
-		__android_log_print( ANDROID_LOG_INFO, "eepp", "%s\n", text.c_str() );
+		__android_log_print( ANDROID_LOG_INFO, "eepp", "%s", text.c_str() );
 #elif defined( EE_COMPILER_MSVC )
 #ifdef UNICODE
-		OutputDebugString( String::fromUtf8( text + "\n" ).toWideString().c_str() );
+		OutputDebugString( String::fromUtf8( text ).toWideString().c_str() );
 #else
-		OutputDebugString( ( text + "\n" ).c_str() );
+		OutputDebugString( text.c_str() );
 #endif
 #else
-		std::cout << text << std::endl;
+		std::cout << text;
 #endif
 	}
 
 	if ( mLiveWrite ) {
-		openFS();
+		lock();
 
-		mFS->write( text.c_str(), text.size() );
-		mFS->write( "\n", 1 );
+		writeToFile( text );
 
-		mFS->flush();
+		// The writer thread flushes once the queue is empty.
+		if ( NULL == mQueue && NULL != mFS )
+			mFS->flush();
+
+		unlock();
 	}
 }
 
-void Log::writel( const LogLevel& level, const std::string& text ) {
-	if ( level >= mLogLevelThreshold )
-		write( logLevelWithTimestamp( level, text, true ) );
+void Log::appendToBuffer( const std::string& text ) {
+	lock();
+
+	mData += text;
+
+	// The buffer is trimmed once it grows a half over the limit, so the trimming is amortized.
+	if ( mBufferLimit > 0 && mData.size() > mBufferLimit + mBufferLimit / 2 ) {
+		size_t cut = mData.size() - mBufferLimit;
+		size_t lineEnd = mData.find( '\n', cut );
+
+		if ( std::string::npos != lineEnd )
+			cut = lineEnd + 1;
+
+		// A saved log keeps everything, the head goes to the file before being discarded.
+		if ( mSave && !mLiveWrite )
+			writeToFile( mData.substr( 0, cut ) );
+
+		mData.erase( 0, cut );
+	}
+
+	unlock();
+}
+
+void Log::writeToFile( const std::string& text ) {
+	openFS();
+
+	if ( NULL == mFS )
+		return;
+
+	mFS->write( text.c_str(), text.size() );
+	mFileSize += text.size();
+
+	if ( mMaxFileSize > 0 && mFileSize >= mMaxFileSize )
+		rotateFile();
+}
+
+void Log::rotateFile() {
+	eeSAFE_DELETE( mFS );
+
+	std::string base( mFilePath + "log" );
+
+	if ( mMaxFiles > 0 ) {
+		FileSystem::fileRemove( base + "." + String::toString( mMaxFiles ) + ".log" );
+
+		for ( Uint32 i = mMaxFiles - 1; i >= 1; i-- )
+			std::rename( ( base + "." + String::toString( i ) + ".log" ).c_str(),
+						 ( base + "." + String::toString( i + 1 ) + ".log" ).c_str() );
+
+		std::rename( ( base + ".log" ).c_str(), ( base + ".1.log" ).c_str() );
+	} else {
+		FileSystem::fileRemove( base + ".log" );
+	}
 }
 
 void Log::openFS() {
@@ -179,6 +332,7 @@ void Log::openFS() {
 		std::string str = mFilePath + "log.log";
 
 		mFS = IOStreamFile::New( str, "a" );
+		mFileSize = FileSystem::fileSize( str );
 	}
 }
 
@@ -205,33 +359,7 @@ void Log::writef( const char* format, ... ) {
 			tstr.resize( n );
 			tstr += '\n';
 
-			lock();
-			mData += tstr;
-			unlock();
-
-			writeToReaders( tstr );
-
-			if ( mConsoleOutput ) {
-#if EE_PLATFORM == EE_PLATFORM_ANDROID
-				__android_log_print( ANDROID_LOG_INFO, "eepp", "%s", tstr.c_str() );
-#elif defined( EE_COMPILER_MSVC )
-#ifdef UNICODE
-				OutputDebugString( String::fromUtf8( tstr ).toWideString().c_str() );
-#else
-				OutputDebugString( tstr.c_str() );
-#endif
-#else
-				std::cout << tstr;
-#endif
-			}
-
-			if ( mLiveWrite ) {
-				openFS();
-
-				mFS->write( tstr.c_str(), tstr.size() );
-
-				mFS->flush();
-			}
+			dispatch( LogLevel::Info, std::move( tstr ) );
 
 			va_end( args );
 
@@ -253,7 +381,6 @@ void Log::writef( const LogLevel& level, const char* format, ... ) {
 
 	int n, size = 256;
 	std::string tstr( size, '\0' );
-	bool first = true;
 	va_list args;
 
 	while ( 1 ) {
@@ -265,38 +392,7 @@ void Log::writef( const LogLevel& level, const char* format, ... ) {
 			tstr.resize( n );
 			tstr += '\n';
 
-			if ( first ) {
-				tstr = logLevelWithTimestamp( level, tstr, false );
-				first = false;
-			}
-
-			lock();
-			mData += tstr;
-			unlock();
-
-			writeToReaders( tstr );
-
-			if ( mConsoleOutput ) {
-#if EE_PLATFORM == EE_PLATFORM_ANDROID
-				__android_log_print( ANDROID_LOG_INFO, "eepp", "%s", tstr.c_str() );
-#elif defined( EE_COMPILER_MSVC )
-#ifdef UNICODE
-				OutputDebugString( String::fromUtf8( tstr ).toWideString().c_str() );
-#else
-				OutputDebugString( tstr.c_str() );
-#endif
-#else
-				std::cout << tstr;
-#endif
-			}
-
-			if ( mLiveWrite ) {
-				openFS();
-
-				mFS->write( tstr.c_str(), tstr.size() );
-
-				mFS->flush();
-			}
+			dispatch( level, logLevelWithTimestamp( level, tstr, false ) );
 
 			va_end( args );
 
@@ -313,7 +409,138 @@ void Log::writef( const LogLevel& level, const char* format, ... ) {
 }
 
 std::string Log::getBuffer() const {
-	return mData;
+	const_cast<Log*>( this )->lock();
+	std::string data( mData );
+	const_cast<Log*>( this )->unlock();
+	return data;
+}
+
+void Log::setBufferLimit( const size_t& bytes ) {
+	mBufferLimit = bytes;
+}
+
+const size_t& Log::getBufferLimit() const {
+	return mBufferLimit;
+}
+
+void Log::setAsync( const bool& async, const size_t& queueCapacity ) {
+	if ( async == isAsync() )
+		return;
+
+	if ( async ) {
+		size_t capacity = 2;
+
+		while ( capacity < queueCapacity )
+			capacity *= 2;
+
+		mQueue = eeNew( Private::LogQueue, ( capacity ) );
+		mThread = eeNew( Thread, ( &Log::writerThread, this ) );
+		mThread->launch();
+	} else {
+		Private::LogQueue* queue = mQueue;
+
+		{
+			std::lock_guard<std::mutex> queueLock( queue->mMutex );
+			queue->mStop = true;
+			queue->mWakeUp.notify_one();
+		}
+
+		// The writer thread writes the pending messages before leaving.
+		mThread->wait();
+		eeSAFE_DELETE( mThread );
+
+		mQueue = NULL;
+		eeSAFE_DELETE( queue );
+	}
+}
+
+bool Log::isAsync() const {
+	return NULL != mQueue;
+}
+
+void Log::setOverflowPolicy( const LogLevel& level, const LogOverflowPolicy& policy ) {
+	mOverflowPolicy[static_cast<int>( level )] = policy;
+}
+
+const LogOverflowPolicy& Log::getOverflowPolicy( const LogLevel& level ) const {
+	return mOverflowPolicy[static_cast<int>( level )];
+}
+
+Uint64 Log::getDroppedCount() const {
+	return NULL != mQueue ? mQueue->mDropped.load() : 0;
+}
+
+void Log::flush() {
+	Private::LogQueue* queue = mQueue;
+
+	if ( NULL != queue && queue->mWriterId != std::this_thread::get_id() ) {
+		Uint64 queued = queue->mQueued;
+		std::unique_lock<std::mutex> queueLock( queue->mMutex );
+		queue->mWakeUp.notify_one();
+		queue->mProcessedCond.wait( queueLock, [&] { return queue->mProcessed >= queued; } );
+		return;
+	}
+
+	lock();
+
+	if ( NULL != mFS )
+		mFS->flush();
+
+	unlock();
+}
+
+void Log::writerThread() {
+	Private::LogQueue* queue = mQueue;
+	Uint64 dropped = 0;
+	std::string text;
+
+	queue->mWriterId = std::this_thread::get_id();
+
+	while ( true ) {
+		bool processed = false;
+
+		while ( queue->pop( text ) ) {
+			process( text );
+			processed = true;
+			queue->mProcessed++;
+		}
+
+		if ( queue->mDropped > dropped ) {
+			Uint64 count = queue->mDropped;
+			process( logLevelWithTimestamp(
+				LogLevel::Warning,
+				String::format( "%llu log messages were dropped",
+								static_cast<unsigned long long>( count - dropped ) ),
+				true ) );
+			dropped = count;
+			processed = true;
+		}
+
+		if ( processed ) {
+			lock();
+
+			if ( NULL != mFS )
+				mFS->flush();
+
+			unlock();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> queueLock( queue->mMutex );
+		queue->mProcessedCond.notify_all();
+
+		if ( queue->mStop )
+			break;
+
+		// The producers count the message before checking the sleeping flag, so either the
+		// producer sees the flag or the message is counted here.
+		queue->mSleeping = true;
+
+		if ( queue->mQueued == queue->mProcessed )
+			queue->mWakeUp.wait_for( queueLock, std::chrono::milliseconds( 100 ) );
+
+		queue->mSleeping = false;
+	}
 }
 
 const bool& Log::isConsoleOutput() const {
@@ -342,6 +569,11 @@ void Log::setLiveWrite( const bool& lw ) {
 	mLiveWrite = lw;
 }
 
+void Log::setFileRotation( const Uint64& maxFileSize, const Uint32& maxFiles ) {
+	mMaxFileSize = maxFileSize;
+	mMaxFiles = maxFiles;
+}
+
 void Log::addLogReader( LogReaderInterface* reader ) {
 	mReaders.push_back( reader );
 }
@@ -438,3 +438,31 @@ int lua_str_match( const char* s, int offset, size_t ls, const char* p, LuaMatch
 	} while ( s1++ < ms.src_end && !anchor );
 	return 0;
 }
+
+int lua_str_first_set( const char* p, unsigned char* set ) {
+	size_t lp = strlen( p );
+	MatchState ms;
+	char c;
+	int i;
+	if ( *p == '^' ) {
+		p++;
+		lp--;
+	}
+	ms.src_init = &c;
+	ms.src_end = &c + 1;
+	ms.p_end = p + lp;
+	/* only a plain pattern class without an optional suffix is guaranteed to consume the first
+	 * byte of the match */
+	if ( lp == 0 || *p == '(' || *p == ')' || ( *p == '$' && lp == 1 ) )
+		return 0;
+	if ( *p == L_ESC && ( p[1] == 'b' || p[1] == 'f' || isdigit( uchar( p[1] ) ) ) )
+		return 0;
+	const char* ep = classend( &ms, p );
+	if ( *ep == '*' || *ep == '?' || *ep == '-' )
+		return 0;
+	for ( i = 0; i < 256; i++ ) {
+		c = (char)i;
+		set[i] = singlematch( &ms, &c, p, ep ) ? 1 : 0;
+	}
+	return 1;
+}
@@ -14,4 +14,8 @@ struct LuaMatch {
 
 int lua_str_match( const char* text, int offset, size_t len, const char* pattern, LuaMatch* mm );
 
+/* Fills set (256 entries) with the bytes that can start a match of pattern.
+ * Returns 0 if the first byte of a match can't be determined. */
+int lua_str_first_set( const char* pattern, unsigned char* set );
+
 #endif // EE_SYSTEM_LUA_STR_HPP
@@ -87,6 +87,21 @@ bool LuaPattern::range( int indexGet, int& startMatch, int& endMatch,
 	return false;
 }
 
+bool LuaPattern::getFirstByteSet( std::bitset<256>& set ) const {
+	unsigned char bytes[256];
+	set.reset();
+	try {
+		if ( !lua_str_first_set( mPattern.c_str(), bytes ) )
+			return false;
+	} catch ( const std::string& patternError ) {
+		mErr = patternError;
+		return false;
+	}
+	for ( size_t i = 0; i < 256; i++ )
+		set[i] = bytes[i] != 0;
+	return true;
+}
+
 const size_t& LuaPattern::getNumMatches() const {
 	return mMatchNum;
 }
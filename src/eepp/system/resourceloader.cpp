@@ -4,20 +4,40 @@
 
 namespace EE { namespace System {
 
+// The thread pool shared by the resource loaders that don't set their own pool. It's released once
+// no loader uses it.
+static std::shared_ptr<ThreadPool> getSharedThreadPool() {
+	static std::mutex sMutex;
+	static std::weak_ptr<ThreadPool> sPool;
+	std::lock_guard<std::mutex> lock( sMutex );
+	std::shared_ptr<ThreadPool> pool( sPool.lock() );
+	if ( !pool ) {
+		pool = ThreadPool::createShared( eemax<Uint32>( 1, Sys::getCPUCount() ) );
+		sPool = pool;
+	}
+	return pool;
+}
+
 ResourceLoader::ResourceLoader( const Uint32& maxThreads ) :
 	mLoaded( false ),
 	mLoading( false ),
 	mThreaded( true ),
 	mThreads( maxThreads ),
 	mTotalLoaded( 0 ),
-	mThread( &ResourceLoader::taskRunner, this ) {
+	mMaxMainThreadTasks( 4 ),
+	mRunning( 0 ),
+	mActive( 0 ),
+	mCancelled( false ) {
 	setThreads();
 }
 
 ResourceLoader::~ResourceLoader() {
-	clear();
-
-	mThread.wait();
+	// Stops dispatching tasks and waits for the running ones.
+	std::unique_lock<std::mutex> lock( mMutex );
+	mCancelled = true;
+	mReadyTasks.clear();
+	mReadyMainThreadTasks.clear();
+	mTaskFinished.wait( lock, [this] { return mActive == 0; } );
 }
 
 void ResourceLoader::setThreads() {
@@ -38,16 +58,66 @@ Uint32 ResourceLoader::getCount() const {
 	return mTasks.size();
 }
 
+Uint32 ResourceLoader::getLoadedCount() const {
+	return mTotalLoaded;
+}
+
 void ResourceLoader::setThreaded( const bool& threaded ) {
 	if ( !mLoading ) {
 		mThreaded = threaded;
 	}
 }
 
-void ResourceLoader::add( const ObjectLoaderTask& objectLoaderTask ) {
+void ResourceLoader::setThreadPool( std::shared_ptr<ThreadPool> pool ) {
 	if ( !mLoading ) {
-		mTasks.emplace_back( objectLoaderTask );
+		mPool = pool;
+	}
+}
+
+const std::shared_ptr<ThreadPool>& ResourceLoader::getThreadPool() const {
+	return mPool;
+}
+
+void ResourceLoader::setMaxMainThreadTasksPerUpdate( const Uint32& maxTasks ) {
+	mMaxMainThreadTasks = maxTasks;
+}
+
+const Uint32& ResourceLoader::getMaxMainThreadTasksPerUpdate() const {
+	return mMaxMainThreadTasks;
+}
+
+ResourceLoader::TaskId ResourceLoader::add( const ObjectLoaderTask& objectLoaderTask,
+											const std::vector<TaskId>& dependencies ) {
+	return addTask( objectLoaderTask, dependencies, false );
+}
+
+ResourceLoader::TaskId ResourceLoader::addMainThread( const ObjectLoaderTask& objectLoaderTask,
+													  const std::vector<TaskId>& dependencies ) {
+	return addTask( objectLoaderTask, dependencies, true );
+}
+
+ResourceLoader::TaskId ResourceLoader::addTask( const ObjectLoaderTask& objectLoaderTask,
+												const std::vector<TaskId>& dependencies,
+												bool mainThread ) {
+	if ( mLoading )
+		return eeINDEX_NOT_FOUND;
+
+	TaskId id = static_cast<TaskId>( mTasks.size() );
+	Task task;
+	task.func = objectLoaderTask;
+	task.mainThread = mainThread;
+
+	// Tasks can only depend on tasks already added, so the dependencies can't form a cycle and the
+	// order of addition is always a valid loading order.
+	for ( const auto& dependency : dependencies ) {
+		if ( dependency < id ) {
+			mTasks[dependency].dependents.push_back( id );
+			task.dependencies++;
+		}
 	}
+
+	mTasks.emplace_back( std::move( task ) );
+	return id;
 }
 
 bool ResourceLoader::clear() {
@@ -76,13 +146,32 @@ void ResourceLoader::load() {
 	if ( mThreaded ) {
 		if ( !mLoading ) {
 			mLoading = true;
-			mThread.launch();
+			threadedLoad();
 		}
 	} else {
 		serializedLoad();
 	}
 }
 
+void ResourceLoader::update() {
+	for ( Uint32 count = 0; 0 == mMaxMainThreadTasks || count < mMaxMainThreadTasks; count++ ) {
+		TaskId id;
+
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+
+			if ( mCancelled || mReadyMainThreadTasks.empty() )
+				return;
+
+			id = mReadyMainThreadTasks.front();
+			mReadyMainThreadTasks.pop_front();
+			mActive++;
+		}
+
+		runTask( id );
+	}
+}
+
 bool ResourceLoader::isLoaded() {
 	return mLoaded;
 }
@@ -92,6 +181,7 @@ bool ResourceLoader::isLoading() {
 }
 
 void ResourceLoader::setLoaded() {
+	mLoadTime = mLoadClock.getElapsedTime();
 	mLoaded = true;
 	mLoading = false;
 
@@ -104,24 +194,41 @@ void ResourceLoader::setLoaded() {
 	}
 }
 
-void ResourceLoader::taskRunner() {
-	{
-		auto pool = ThreadPool::createUnique( eemin( mThreads, (Uint32)mTasks.size() ) );
+void ResourceLoader::threadedLoad() {
+	mLoadClock.restart();
 
-		for ( auto& task : mTasks ) {
-			pool->run( task, [&] { mTotalLoaded++; } );
-		}
+	if ( mTasks.empty() ) {
+		setLoaded();
+		return;
 	}
 
-	mLoading = false;
-	setLoaded();
+	if ( !mPool )
+		mPool = getSharedThreadPool();
+
+	std::lock_guard<std::mutex> lock( mMutex );
+
+	for ( TaskId id = 0; id < mTasks.size(); id++ ) {
+		Task& task = mTasks[id];
+		task.pendingDependencies = task.dependencies;
+
+		if ( 0 == task.dependencies )
+			( task.mainThread ? mReadyMainThreadTasks : mReadyTasks ).push_back( id );
+	}
+
+	dispatch();
 }
 
 void ResourceLoader::serializedLoad() {
 	mLoading = true;
+	mLoadClock.restart();
 
+	// The order of addition satisfies every dependency.
 	for ( auto& task : mTasks ) {
-		task();
+		Clock clock;
+
+		task.func();
+
+		task.time = clock.getElapsedTime();
 
 		mTotalLoaded++;
 	}
@@ -130,8 +237,73 @@ void ResourceLoader::serializedLoad() {
 	setLoaded();
 }
 
+void ResourceLoader::dispatch() {
+	// Must be called with the mutex locked. The number of tasks running in the pool is limited by
+	// the maximum number of threads of the loader, the pool can be shared with other work.
+	Uint32 maxRunning = eemax<Uint32>( 1, mThreads );
+
+	while ( !mCancelled && mRunning < maxRunning && !mReadyTasks.empty() ) {
+		TaskId id = mReadyTasks.front();
+		mReadyTasks.pop_front();
+		mRunning++;
+		mActive++;
+		mPool->run( [this, id] { runTask( id ); }, nullptr );
+	}
+}
+
+void ResourceLoader::runTask( const TaskId& taskId ) {
+	Task& task = mTasks[taskId];
+	Clock clock;
+
+	task.func();
+
+	Time elapsed( clock.getElapsedTime() );
+	bool finished = false;
+
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+
+		task.time = elapsed;
+
+		if ( !task.mainThread )
+			mRunning--;
+
+		for ( const auto& dependent : task.dependents ) {
+			Task& dependentTask = mTasks[dependent];
+
+			if ( --dependentTask.pendingDependencies == 0 )
+				( dependentTask.mainThread ? mReadyMainThreadTasks : mReadyTasks )
+					.push_back( dependent );
+		}
+
+		finished = ++mTotalLoaded == mTasks.size();
+
+		dispatch();
+	}
+
+	if ( finished )
+		setLoaded();
+
+	// Notified with the lock held, once released the loader can be destroyed.
+	std::lock_guard<std::mutex> lock( mMutex );
+	mActive--;
+	mTaskFinished.notify_all();
+}
+
 Float ResourceLoader::getProgress() {
-	return mTotalLoaded / (float)mTasks.size() * 100.f;
+	if ( mTasks.empty() )
+		return mLoaded ? 100.f : 0.f;
+
+	return mTotalLoaded / (Float)mTasks.size() * 100.f;
+}
+
+Time ResourceLoader::getTaskTime( const TaskId& taskId ) const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return taskId < mTasks.size() ? mTasks[taskId].time : Time::Zero;
+}
+
+Time ResourceLoader::getLoadTime() const {
+	return mLoaded ? mLoadTime : mLoadClock.getElapsedTime();
 }
 
 }} // namespace EE::System
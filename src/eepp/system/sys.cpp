@@ -591,10 +591,15 @@ std::string Sys::getDateTimeStr() {
 
 	char buf[64];
 
-	struct tm* timeinfo;
-	timeinfo = localtime( &rawtime );
+	// The reentrant versions, the log calls it from any thread.
+	struct tm timeinfo;
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	localtime_s( &timeinfo, &rawtime );
+#else
+	localtime_r( &rawtime, &timeinfo );
+#endif
 
-	strftime( buf, sizeof( buf ), "%Y-%m-%d %X", timeinfo );
+	strftime( buf, sizeof( buf ), "%Y-%m-%d %X", &timeinfo );
 
 	return std::string( buf );
 }
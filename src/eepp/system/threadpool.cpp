@@ -2,6 +2,28 @@
 
 namespace EE { namespace System {
 
+// The pool and queue index of the current worker thread, work queued from a worker goes to its own
+// queue.
+static thread_local ThreadPool* sWorkerPool = nullptr;
+static thread_local Uint32 sWorkerIndex = 0;
+
+CancellationToken CancellationToken::create() {
+	CancellationToken token;
+	token.mCancelled = std::make_shared<std::atomic<bool>>( false );
+	return token;
+}
+
+CancellationToken::CancellationToken() {}
+
+void CancellationToken::cancel() {
+	if ( mCancelled )
+		*mCancelled = true;
+}
+
+bool CancellationToken::isCancelled() const {
+	return mCancelled && *mCancelled;
+}
+
 std::shared_ptr<ThreadPool> ThreadPool::createShared( Uint32 numThreads ) {
 	std::shared_ptr<ThreadPool> pool( new ThreadPool( numThreads ) );
 	return pool;
@@ -17,6 +39,9 @@ ThreadPool* ThreadPool::createRaw( Uint32 numThreads ) {
 }
 
 ThreadPool::ThreadPool( Uint32 numThreads ) {
+	for ( Uint32 i = 0; i < numThreads; ++i )
+		mQueues.emplace_back( std::make_unique<WorkQueue>() );
+
 	for ( Uint32 i = 0; i < numThreads; ++i ) {
 		mThreads.emplace_back( std::make_unique<Thread>( &ThreadPool::threadFunc, this ) );
 		mThreads.back().get()->launch();
@@ -36,46 +61,148 @@ ThreadPool::~ThreadPool() {
 	}
 }
 
+bool ThreadPool::popWork( const Uint32& worker, Work& work ) {
+	Uint32 count = static_cast<Uint32>( mQueues.size() );
+	// Interactive work first, from the own queue and then stealing from the other workers. The
+	// owner takes the oldest work while thieves take the newest, so they rarely contend.
+	for ( int priority = 0; priority < 2; priority++ ) {
+		for ( Uint32 i = 0; i < count; i++ ) {
+			WorkQueue& queue = *mQueues[( worker + i ) % count];
+			std::unique_lock<std::mutex> lock( queue.mutex );
+			std::deque<Work>& works = queue.work[priority];
+			if ( works.empty() )
+				continue;
+			if ( i == 0 ) {
+				work = std::move( works.front() );
+				works.pop_front();
+			} else {
+				work = std::move( works.back() );
+				works.pop_back();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
 void ThreadPool::threadFunc() {
+	Uint32 worker = mNextWorker++;
+	sWorkerPool = this;
+	sWorkerIndex = worker;
+
 	while ( true ) {
-		std::unique_ptr<Work> work;
-		{
+		Work work;
+
+		if ( !popWork( worker, work ) ) {
 			std::unique_lock<std::mutex> lock( mMutex );
 
-			mWorkAvailable.wait( lock, [this]() { return !mWork.empty() || mShuttingDown; } );
+			mSleeping++;
+			mWorkAvailable.wait( lock, [this]() { return mPending > 0 || mShuttingDown; } );
+			mSleeping--;
 
-			if ( mShuttingDown && mWork.empty() ) {
+			if ( mShuttingDown && mPending == 0 ) {
 				return;
 			}
 
-			work = std::move( mWork.front() );
-			mWork.pop_front();
+			continue;
 		}
 
-		work->func();
+		mPending--;
+
+		if ( work.token.isCancelled() )
+			continue;
 
-		if ( work->callback != nullptr ) {
-			work->callback();
+		work.func();
+
+		if ( work.callback != nullptr ) {
+			work.callback();
 		}
 	}
 }
 
-void ThreadPool::run( const std::function<void()>& func,
-					  const std::function<void()>& doneCallback ) {
+void ThreadPool::run( const std::function<void()>& func, const std::function<void()>& doneCallback,
+					  const Priority& priority, const CancellationToken& token ) {
+	if ( mShuttingDown || mQueues.empty() )
+		return;
+
+	Uint32 queue = sWorkerPool == this ? sWorkerIndex : mNextQueue++ % mQueues.size();
+
+	// Counted before being queued, a worker can't take work that it's not accounted for.
+	mPending++;
+
 	{
-		std::unique_lock<std::mutex> lock( mMutex );
+		std::unique_lock<std::mutex> lock( mQueues[queue]->mutex );
+		mQueues[queue]->work[static_cast<int>( priority )].emplace_back(
+			Work{ func, doneCallback, token } );
+	}
+
+	// Workers count themselves as sleeping before checking the pending work, so either the worker
+	// sees the new work or it's seen here as sleeping. Taking the lock makes sure that it's already
+	// waiting when notified.
+	if ( mSleeping > 0 ) {
+		{
+			std::unique_lock<std::mutex> lock( mMutex );
+		}
+		mWorkAvailable.notify_one();
+	}
+}
 
-		if ( mShuttingDown )
-			return;
+void ThreadPool::parallelFor( size_t begin, size_t end,
+							  const std::function<void( size_t, size_t )>& func, size_t grainSize,
+							  const Priority& priority ) {
+	if ( begin >= end )
+		return;
 
-		mWork.emplace_back( new Work{func, doneCallback} );
+	size_t count = end - begin;
+	Uint32 threads = numThreads();
+
+	if ( 0 == grainSize )
+		grainSize = eemax<size_t>( 1, count / ( ( threads + 1 ) * 4 ) );
+
+	size_t chunks = ( count + grainSize - 1 ) / grainSize;
+
+	if ( chunks == 1 || threads == 0 ) {
+		func( begin, end );
+		return;
 	}
 
-	mWorkAvailable.notify_one();
+	struct State {
+		std::atomic<size_t> next{ 0 };
+		std::atomic<size_t> remaining{ 0 };
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+
+	// Helpers can start after every chunk was processed and parallelFor returned, they keep the
+	// state alive and only use func if they get a chunk to process.
+	auto state = std::make_shared<State>();
+	state->remaining = chunks;
+	const std::function<void( size_t, size_t )>* funcPtr = &func;
+
+	auto process = [state, funcPtr, begin, end, grainSize, chunks]() {
+		size_t chunk;
+		while ( ( chunk = state->next++ ) < chunks ) {
+			size_t chunkBegin = begin + chunk * grainSize;
+			( *funcPtr )( chunkBegin, eemin( chunkBegin + grainSize, end ) );
+			if ( --state->remaining == 0 ) {
+				std::unique_lock<std::mutex> lock( state->mutex );
+				state->done.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = eemin<size_t>( threads, chunks - 1 );
+
+	for ( size_t i = 0; i < helpers; i++ )
+		run( process, nullptr, priority );
+
+	process();
+
+	std::unique_lock<std::mutex> lock( state->mutex );
+	state->done.wait( lock, [&state]() { return state->remaining == 0; } );
 }
 
 Uint32 ThreadPool::numThreads() const {
-	std::unique_lock<std::mutex> lock( mMutex );
 	return mShuttingDown ? 0 : static_cast<Uint32>( mThreads.size() );
 }
 
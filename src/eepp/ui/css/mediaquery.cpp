@@ -41,12 +41,14 @@ MediaQuery::ptr MediaQuery::parse( const std::string& str ) {
 	std::vector<std::string> tokens = String::split( str, " \t\r\n", "", "(" );
 
 	for ( auto& tok : tokens ) {
-		if ( tok == "not" ) {
+		if ( tok.empty() ) {
+			continue;
+		} else if ( tok == "not" ) {
 			query->mNot = true;
-		} else if ( tok.at( 0 ) == '(' ) {
+		} else if ( tok[0] == '(' ) {
 			tok.erase( 0, 1 );
 
-			if ( tok.at( tok.length() - 1 ) == ')' ) {
+			if ( !tok.empty() && tok[tok.length() - 1] == ')' ) {
 				tok.erase( tok.length() - 1, 1 );
 			}
 
@@ -131,6 +133,7 @@ bool MediaQuery::check( const MediaFeatures& features ) const {
 
 MediaQueryList::ptr MediaQueryList::parse( const std::string& str ) {
 	MediaQueryList::ptr list = std::make_shared<MediaQueryList>();
+	list->mQueryString = str;
 
 	std::vector<std::string> tokens = String::split( str, "," );
 
@@ -392,6 +395,7 @@ bool MediaQueryExpression::check( const MediaFeatures& features ) const {
 MediaQueryList::MediaQueryList( const MediaQueryList& val ) {
 	mUsed = val.mUsed;
 	mQueries = val.mQueries;
+	mQueryString = val.mQueryString;
 }
 
 MediaQueryList::MediaQueryList() {
@@ -402,4 +406,8 @@ bool MediaQueryList::isUsed() const {
 	return mUsed;
 }
 
+const std::string& MediaQueryList::getQueryString() const {
+	return mQueryString;
+}
+
 }}} // namespace EE::UI::CSS
@@ -10,6 +10,26 @@ namespace EE { namespace UI { namespace CSS {
 
 StyleSheet::StyleSheet() {}
 
+StyleSheet::StyleSheet( const StyleSheet& styleSheet ) {
+	*this = styleSheet;
+}
+
+StyleSheet& StyleSheet::operator=( const StyleSheet& styleSheet ) {
+	if ( this != &styleSheet ) {
+		mNodes = styleSheet.mNodes;
+		mNodeIndex = styleSheet.mNodeIndex;
+		mMediaQueryList = styleSheet.mMediaQueryList;
+		mKeyframesMap = styleSheet.mKeyframesMap;
+
+		std::lock( mCacheMutex, styleSheet.mCacheMutex );
+		std::lock_guard<std::mutex> lock( mCacheMutex, std::adopt_lock );
+		std::lock_guard<std::mutex> otherLock( styleSheet.mCacheMutex, std::adopt_lock );
+		mNodeCache = styleSheet.mNodeCache;
+		mSharedStylesCache = styleSheet.mSharedStylesCache;
+	}
+	return *this;
+}
+
 template <class T> inline void HashCombine( std::size_t& seed, const T& v ) {
 	std::hash<T> hasher;
 	seed ^= hasher( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
@@ -44,6 +64,7 @@ bool StyleSheet::addStyleToNodeIndex( StyleSheetStyle* style ) {
 void StyleSheet::addStyle( std::shared_ptr<StyleSheetStyle> node ) {
 	if ( addStyleToNodeIndex( node.get() ) ) {
 		mNodes.push_back( node );
+		invalidateCache();
 	}
 	addMediaQueryList( node->getMediaQueryList() );
 }
@@ -70,14 +91,55 @@ inline static bool StyleSheetNodeSort( const StyleSheetStyle* lhs, const StyleSh
 	return lhs->getSelector().getSpecificity() < rhs->getSelector().getSpecificity();
 }
 
+// Shareable selectors only look at the element and its ancestors, so this identifies the result of
+// matching them.
+size_t StyleSheet::elementSignature( UIWidget* element, const bool& applyPseudo ) {
+	size_t seed = applyPseudo ? 1 : 0;
+
+	for ( UIWidget* cur = element; NULL != cur; cur = cur->getStyleSheetParentElement() ) {
+		HashCombine( seed, cur->getElementTag() );
+		HashCombine( seed, cur->getIdHash() );
+
+		const std::vector<std::string>& classes = cur->getStyleSheetClasses();
+		for ( const auto& cls : classes )
+			HashCombine( seed, cls );
+		HashCombine( seed, classes.size() );
+
+		if ( applyPseudo ) {
+			const std::vector<std::string>& pseudoClasses = cur->getStyleSheetPseudoClasses();
+			for ( const auto& cls : pseudoClasses )
+				HashCombine( seed, cls );
+			HashCombine( seed, pseudoClasses.size() );
+		}
+	}
+
+	return seed;
+}
+
 // This is based on the RmlUi implementation.
 std::shared_ptr<ElementDefinition> StyleSheet::getElementStyles( UIWidget* element,
 																 const bool& applyPseudo ) const {
-	static StyleSheetStyleVector applicableNodes;
-	applicableNodes.clear();
+	size_t signature = elementSignature( element, applyPseudo );
+	StyleSheetStyleVector sharedNodes;
+	bool cached = false;
+
+	{
+		std::lock_guard<std::mutex> lock( mCacheMutex );
+		auto it = mSharedStylesCache.find( signature );
+		if ( it != mSharedStylesCache.end() ) {
+			if ( !it->second.hasUnshareableStyles )
+				return it->second.definition;
+			sharedNodes = it->second.styles;
+			cached = true;
+		}
+	}
+
+	StyleSheetStyleVector applicableNodes;
+	bool hasUnshareableStyles = false;
+	size_t sharedIndex = 0;
 
 	const std::string& tag = element->getElementTag();
-	const std::string& id = element->getId();
+	const std::string id( element->getId() );
 
 	std::array<size_t, 4> nodeHash;
 	int numHashes = 2;
@@ -96,8 +158,27 @@ std::shared_ptr<ElementDefinition> StyleSheet::getElementStyles( UIWidget* eleme
 		if ( itNodes != mNodeIndex.end() ) {
 			const StyleSheetStyleVector& nodes = itNodes->second;
 			for ( StyleSheetStyle* node : nodes ) {
-				if ( node->isMediaValid() && node->getSelector().select( element, applyPseudo ) ) {
-					applicableNodes.push_back( node );
+				if ( node->getSelector().isShareable() ) {
+					if ( cached ) {
+						// Already matched for this signature, the candidates are visited in the
+						// same order so the cached matches are consumed in order.
+						if ( sharedIndex < sharedNodes.size() &&
+							 sharedNodes[sharedIndex] == node ) {
+							applicableNodes.push_back( node );
+							sharedIndex++;
+						}
+					} else if ( node->isMediaValid() &&
+								node->getSelector().select( element, applyPseudo ) ) {
+						applicableNodes.push_back( node );
+						sharedNodes.push_back( node );
+					}
+				} else {
+					hasUnshareableStyles = true;
+
+					if ( node->isMediaValid() &&
+						 node->getSelector().select( element, applyPseudo ) ) {
+						applicableNodes.push_back( node );
+					}
 				}
 			}
 		}
@@ -105,23 +186,48 @@ std::shared_ptr<ElementDefinition> StyleSheet::getElementStyles( UIWidget* eleme
 
 	std::sort( applicableNodes.begin(), applicableNodes.end(), StyleSheetNodeSort );
 
-	if ( applicableNodes.empty() )
-		return nullptr;
+	std::shared_ptr<ElementDefinition> definition;
 
-	size_t seed = 0;
-	for ( const StyleSheetStyle* node : applicableNodes )
-		HashCombine( seed, node );
+	std::lock_guard<std::mutex> lock( mCacheMutex );
+
+	if ( !applicableNodes.empty() ) {
+		size_t seed = 0;
+		for ( const StyleSheetStyle* node : applicableNodes )
+			HashCombine( seed, node );
+
+		auto cacheIterator = mNodeCache.find( seed );
+		if ( cacheIterator != mNodeCache.end() ) {
+			definition = ( *cacheIterator ).second;
+		} else {
+			definition = std::make_shared<ElementDefinition>( applicableNodes );
+			mNodeCache[seed] = definition;
+		}
+	}
 
-	auto cacheIterator = mNodeCache.find( seed );
-	if ( cacheIterator != mNodeCache.end() ) {
-		std::shared_ptr<ElementDefinition>& definition = ( *cacheIterator ).second;
-		return definition;
+	if ( !cached ) {
+		SharedStyles& sharedStyles = mSharedStylesCache[signature];
+		sharedStyles.styles = std::move( sharedNodes );
+		sharedStyles.hasUnshareableStyles = hasUnshareableStyles;
+		if ( !hasUnshareableStyles )
+			sharedStyles.definition = definition;
 	}
 
-	auto newDefinition = std::make_shared<ElementDefinition>( applicableNodes );
-	mNodeCache[seed] = newDefinition;
+	return definition;
+}
+
+void StyleSheet::preloadElementStyles( const std::vector<UIWidget*>& elements,
+									   ThreadPool& pool ) const {
+	pool.parallelFor( 0, elements.size(), [&]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) {
+			getElementStyles( elements[i], false );
+			getElementStyles( elements[i], true );
+		}
+	} );
+}
 
-	return newDefinition;
+void StyleSheet::invalidateCache() {
+	std::lock_guard<std::mutex> lock( mCacheMutex );
+	mSharedStylesCache.clear();
 }
 
 const std::vector<std::shared_ptr<StyleSheetStyle>>& StyleSheet::getStyles() const {
@@ -141,6 +247,10 @@ bool StyleSheet::updateMediaLists( const MediaFeatures& features ) {
 		}
 	}
 
+	// The cached matches depend on the media queries validity.
+	if ( updateStyles )
+		invalidateCache();
+
 	return updateStyles;
 }
 
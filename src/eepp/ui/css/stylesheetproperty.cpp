@@ -14,7 +14,11 @@
 namespace EE { namespace UI { namespace CSS {
 
 StyleSheetProperty::StyleSheetProperty() :
-	mSpecificity( 0 ), mVolatile( false ), mImportant( false ) {}
+	mSpecificity( 0 ),
+	mVolatile( false ),
+	mImportant( false ),
+	mHasParsedValue( false ),
+	mParsedValue( 0 ) {}
 
 StyleSheetProperty::StyleSheetProperty( const PropertyDefinition* definition,
 										const std::string& value, const Uint32& index ) :
@@ -27,6 +31,8 @@ StyleSheetProperty::StyleSheetProperty( const PropertyDefinition* definition,
 	mVolatile( false ),
 	mImportant( false ),
 	mIsVarValue( false ),
+	mHasParsedValue( false ),
+	mParsedValue( 0 ),
 	mPropertyDefinition( definition ),
 	mShorthandDefinition( NULL ) {
 	cleanValue();
@@ -52,6 +58,8 @@ StyleSheetProperty::StyleSheetProperty( const bool& isVolatile,
 	mVolatile( isVolatile ),
 	mImportant( false ),
 	mIsVarValue( false ),
+	mHasParsedValue( false ),
+	mParsedValue( 0 ),
 	mPropertyDefinition( definition ),
 	mShorthandDefinition( NULL ) {
 	cleanValue();
@@ -75,6 +83,8 @@ StyleSheetProperty::StyleSheetProperty( const std::string& name, const std::stri
 	mVolatile( false ),
 	mImportant( false ),
 	mIsVarValue( false ),
+	mHasParsedValue( false ),
+	mParsedValue( 0 ),
 	mPropertyDefinition( StyleSheetSpecification::instance()->getProperty( mNameHash ) ),
 	mShorthandDefinition( NULL == mPropertyDefinition
 							  ? StyleSheetSpecification::instance()->getShorthand( mNameHash )
@@ -101,6 +111,8 @@ StyleSheetProperty::StyleSheetProperty( const std::string& name, const std::stri
 	mVolatile( isVolatile ),
 	mImportant( false ),
 	mIsVarValue( false ),
+	mHasParsedValue( false ),
+	mParsedValue( 0 ),
 	mPropertyDefinition( StyleSheetSpecification::instance()->getProperty( mNameHash ) ),
 	mShorthandDefinition( NULL == mPropertyDefinition
 							  ? StyleSheetSpecification::instance()->getShorthand( mNameHash )
@@ -115,6 +127,28 @@ StyleSheetProperty::StyleSheetProperty( const std::string& name, const std::stri
 	}
 }
 
+StyleSheetProperty::StyleSheetProperty( const std::string& name,
+										const PropertyDefinition* definition,
+										const std::string& value, const Uint32& specificity,
+										const bool& isImportant, const bool& isVolatile ) :
+	mName( name ),
+	mNameHash( String::hash( mName ) ),
+	mValue( value ),
+	mValueHash( String::hash( mValue ) ),
+	mSpecificity( specificity ),
+	mIndex( 0 ),
+	mVolatile( isVolatile ),
+	mImportant( isImportant ),
+	mIsVarValue( false ),
+	mHasParsedValue( false ),
+	mParsedValue( 0 ),
+	mPropertyDefinition( definition ),
+	mShorthandDefinition( NULL ) {
+	createIndexed();
+	checkVars();
+	mHasParsedValue = parseValue( mParsedValue );
+}
+
 Uint32 StyleSheetProperty::getId() const {
 	return NULL != mPropertyDefinition
 			   ? mPropertyDefinition->getId()
@@ -158,6 +192,7 @@ void StyleSheetProperty::setValue( const std::string& value ) {
 	mValue = value;
 	// mValueHash = String::hash( value );
 	mIsVarValue = String::startsWith( mValue, "var(" );
+	mHasParsedValue = false;
 	createIndexed();
 }
 
@@ -165,6 +200,10 @@ const bool& StyleSheetProperty::isVolatile() const {
 	return mVolatile;
 }
 
+const bool& StyleSheetProperty::isImportant() const {
+	return mImportant;
+}
+
 void StyleSheetProperty::setVolatile( const bool& isVolatile ) {
 	mVolatile = isVolatile;
 }
@@ -213,6 +252,92 @@ void StyleSheetProperty::checkVars() {
 	}
 }
 
+// Returns the alignment flags of a gravity keyword, mask receives the alignments it sets.
+static Uint32 gravityFromString( const std::string& str, Uint32& mask ) {
+	mask = UI_HALIGN_MASK;
+	if ( "left" == str )
+		return UI_HALIGN_LEFT;
+	else if ( "right" == str )
+		return UI_HALIGN_RIGHT;
+	else if ( "center_horizontal" == str )
+		return UI_HALIGN_CENTER;
+
+	mask = UI_VALIGN_MASK;
+	if ( "top" == str )
+		return UI_VALIGN_TOP;
+	else if ( "bottom" == str )
+		return UI_VALIGN_BOTTOM;
+	else if ( "center_vertical" == str )
+		return UI_VALIGN_CENTER;
+
+	mask = UI_HALIGN_MASK | UI_VALIGN_MASK;
+	if ( "center" == str )
+		return UI_HALIGN_CENTER | UI_VALIGN_CENTER;
+
+	mask = 0;
+	return 0;
+}
+
+bool StyleSheetProperty::parseValue( Uint32& value ) const {
+	if ( NULL == mPropertyDefinition || mIsVarValue || mValue.empty() )
+		return false;
+
+	if ( mPropertyDefinition->getType() == PropertyType::Color ) {
+		value = Color::fromString( mValue ).getValue();
+		return true;
+	}
+
+	switch ( mPropertyDefinition->getPropertyId() ) {
+		case PropertyId::LayoutWidth:
+		case PropertyId::LayoutHeight: {
+			std::string val( String::toLower( mValue ) );
+			bool isWidth = mPropertyDefinition->getPropertyId() == PropertyId::LayoutWidth;
+
+			if ( "match_parent" == val || ( isWidth && "match-parent" == val ) ) {
+				value = static_cast<Uint32>( SizePolicy::MatchParent );
+			} else if ( "wrap_content" == val || ( isWidth && "wrap-content" == val ) ) {
+				value = static_cast<Uint32>( SizePolicy::WrapContent );
+			} else if ( "fixed" == val ) {
+				value = static_cast<Uint32>( SizePolicy::Fixed );
+			} else {
+				return false;
+			}
+
+			return true;
+		}
+		case PropertyId::LayoutGravity:
+		case PropertyId::Gravity: {
+			std::string gravity( String::toLower( mValue ) );
+			std::vector<std::string> strings = String::split( gravity, '|' );
+			Uint32 align = 0;
+			Uint32 masks = 0;
+			Uint32 mask;
+
+			if ( mPropertyDefinition->getPropertyId() == PropertyId::LayoutGravity ) {
+				for ( auto& cur : strings )
+					align |= gravityFromString( cur, mask );
+				value = align;
+				return !strings.empty();
+			}
+
+			if ( strings.empty() )
+				strings = String::split( gravity, ' ' );
+
+			// The last keyword of each alignment wins.
+			for ( auto& cur : strings ) {
+				Uint32 flags = gravityFromString( cur, mask );
+				align = ( align & ~mask ) | flags;
+				masks |= mask;
+			}
+
+			value = align | ( masks << 16 );
+			return !strings.empty();
+		}
+		default:
+			return false;
+	}
+}
+
 static void varToVal( VariableFunctionCache& varCache, const std::string& varDef ) {
 	FunctionString functionType = FunctionString::parse( varDef );
 	if ( !functionType.getParameters().empty() ) {
@@ -294,7 +419,18 @@ bool StyleSheetProperty::asBool( bool defaultValue ) const {
 }
 
 Color StyleSheetProperty::asColor() const {
-	return Color::fromString( mValue );
+	return mHasParsedValue && mPropertyDefinition->getType() == PropertyType::Color
+			   ? Color( mParsedValue )
+			   : Color::fromString( mValue );
+}
+
+bool StyleSheetProperty::asParsedValue( Uint32& value ) const {
+	if ( mHasParsedValue ) {
+		value = mParsedValue;
+		return true;
+	}
+
+	return parseValue( value );
 }
 
 Float StyleSheetProperty::asDpDimension( const std::string& defaultValue ) const {
@@ -3,7 +3,12 @@
 
 namespace EE { namespace UI { namespace CSS {
 
-StyleSheetSelector::StyleSheetSelector() : mName( "*" ), mSpecificity( 0 ), mCacheable( true ) {
+StyleSheetSelector::StyleSheetSelector() :
+	mName( "*" ),
+	mSpecificity( 0 ),
+	mCacheable( true ),
+	mStructurallyVolatile( false ),
+	mShareable( true ) {
 	parseSelector( mName );
 }
 
@@ -11,7 +16,8 @@ StyleSheetSelector::StyleSheetSelector( const std::string& selectorName ) :
 	mName( String::toLower( selectorName ) ),
 	mSpecificity( 0 ),
 	mCacheable( true ),
-	mStructurallyVolatile( false ) {
+	mStructurallyVolatile( false ),
+	mShareable( true ) {
 	parseSelector( mName );
 }
 
@@ -92,6 +98,15 @@ void StyleSheetSelector::parseSelector( std::string selector ) {
 			}
 		}
 
+		for ( const auto& rule : mSelectorRules ) {
+			if ( rule.hasStructuralPseudoClasses() ||
+				 rule.getPatternMatch() == StyleSheetSelectorRule::DIRECT_SIBLING ||
+				 rule.getPatternMatch() == StyleSheetSelectorRule::SIBLING ) {
+				mShareable = false;
+				break;
+			}
+		}
+
 		if ( mCacheable ) {
 			for ( size_t i = 1; i < mSelectorRules.size(); i++ ) {
 				if ( mSelectorRules[i].hasPseudoClasses() ||
@@ -108,6 +123,10 @@ const bool& StyleSheetSelector::isCacheable() const {
 	return mCacheable;
 }
 
+const bool& StyleSheetSelector::isShareable() const {
+	return mShareable;
+}
+
 bool StyleSheetSelector::hasPseudoClasses() const {
 	return !mSelectorRules.empty() && mSelectorRules[0].hasPseudoClasses();
 }
@@ -102,10 +102,10 @@ std::vector<SyntaxColorScheme> SyntaxColorScheme::loadFromStream( IOStream& stre
 							style.style |= Text::Shadow;
 					}
 
-					if ( refColorScheme.mSyntaxColors.find( valueName ) !=
+					if ( refColorScheme.mSyntaxColors.find( String::hash( valueName ) ) !=
 						 refColorScheme.mSyntaxColors.end() ) {
 						colorScheme.setSyntaxStyle( valueName, style );
-					} else if ( refColorScheme.mEditorColors.find( valueName ) !=
+					} else if ( refColorScheme.mEditorColors.find( String::hash( valueName ) ) !=
 								refColorScheme.mEditorColors.end() ) {
 						colorScheme.setEditorSyntaxStyle( valueName, style );
 					}
@@ -153,32 +153,41 @@ SyntaxColorScheme::SyntaxColorScheme() {}
 SyntaxColorScheme::SyntaxColorScheme( const std::string& name,
 									  const std::unordered_map<std::string, Style>& syntaxColors,
 									  const std::unordered_map<std::string, Style>& editorColors ) :
-	mName( name ), mSyntaxColors( syntaxColors ), mEditorColors( editorColors ) {}
+	mName( name ) {
+	setSyntaxStyles( syntaxColors );
+	setEditorSyntaxStyles( editorColors );
+}
 
 static const SyntaxColorScheme::Style StyleEmpty = { Color::White };
 static const SyntaxColorScheme StyleDefault = SyntaxColorScheme::getDefault();
 
 const SyntaxColorScheme::Style& SyntaxColorScheme::getSyntaxStyle( const std::string& type ) const {
+	return getSyntaxStyle( String::hash( type ) );
+}
+
+const SyntaxColorScheme::Style&
+SyntaxColorScheme::getSyntaxStyle( const SyntaxStyleType& type ) const {
 	auto it = mSyntaxColors.find( type );
 	if ( it != mSyntaxColors.end() )
 		return it->second;
-	else if ( type == "link" )
-		return getSyntaxStyle( "function" );
+	else if ( type == SyntaxStyleTypes::Link )
+		return getSyntaxStyle( SyntaxStyleTypes::Function );
 	return StyleEmpty;
 }
 
 void SyntaxColorScheme::setSyntaxStyles( const std::unordered_map<std::string, Style>& styles ) {
-	mSyntaxColors.insert( styles.begin(), styles.end() );
+	for ( const auto& style : styles )
+		mSyntaxColors.insert( { String::hash( style.first ), style.second } );
 }
 
 void SyntaxColorScheme::setSyntaxStyle( const std::string& type,
 										const SyntaxColorScheme::Style& style ) {
-	mSyntaxColors[type] = style;
+	mSyntaxColors[String::hash( type )] = style;
 }
 
 const SyntaxColorScheme::Style&
 SyntaxColorScheme::getEditorSyntaxStyle( const std::string& type ) const {
-	auto it = mEditorColors.find( type );
+	auto it = mEditorColors.find( String::hash( type ) );
 	if ( it != mEditorColors.end() )
 		return it->second;
 	if ( type == "line_number_background" )
@@ -203,12 +212,13 @@ const Color& SyntaxColorScheme::getEditorColor( const std::string& type ) const
 
 void SyntaxColorScheme::setEditorSyntaxStyles(
 	const std::unordered_map<std::string, Style>& styles ) {
-	mEditorColors.insert( styles.begin(), styles.end() );
+	for ( const auto& style : styles )
+		mEditorColors.insert( { String::hash( style.first ), style.second } );
 }
 
 void SyntaxColorScheme::setEditorSyntaxStyle( const std::string& type,
 											  const SyntaxColorScheme::Style& style ) {
-	mEditorColors[type] = style;
+	mEditorColors[String::hash( type )] = style;
 }
 
 const std::string& SyntaxColorScheme::getName() const {
@@ -2,8 +2,29 @@
 #include <eepp/core/string.hpp>
 #include <eepp/ui/doc/syntaxdefinition.hpp>
 
+using namespace EE::System;
+
 namespace EE { namespace UI { namespace Doc {
 
+static std::string anchorPattern( const std::string& pattern ) {
+	return !pattern.empty() && pattern[0] == '^' ? pattern : "^" + pattern;
+}
+
+SyntaxPatternProgram::SyntaxPatternProgram( const SyntaxPattern& pattern ) :
+	start( anchorPattern( pattern.patterns.empty() ? "" : pattern.patterns[0] ) ),
+	end( pattern.patterns.size() > 1 ? pattern.patterns[1] : "" ),
+	type( String::hash( pattern.type ) ),
+	escape( pattern.patterns.size() >= 3 ? pattern.patterns[2][0] : 0 ),
+	lineStart( !pattern.patterns.empty() && !pattern.patterns[0].empty() &&
+			   pattern.patterns[0][0] == '^' ),
+	multiLine( pattern.patterns.size() > 1 ) {
+	hasStartSet = start.getFirstByteSet( startSet );
+	// An anchored closing pattern must be tried exactly at the offset, so it can't be skipped to
+	// the first candidate byte.
+	if ( multiLine && !pattern.patterns[1].empty() && pattern.patterns[1][0] != '^' )
+		hasEndSet = end.getFirstByteSet( endSet );
+}
+
 SyntaxDefinition::SyntaxDefinition() {}
 
 SyntaxDefinition::SyntaxDefinition( const std::string& languageName,
@@ -17,7 +38,9 @@ SyntaxDefinition::SyntaxDefinition( const std::string& languageName,
 	mPatterns( patterns ),
 	mSymbols( symbols ),
 	mComment( comment ),
-	mHeaders( headers ) {}
+	mHeaders( headers ) {
+	compilePatterns();
+}
 
 const std::vector<std::string>& SyntaxDefinition::getFiles() const {
 	return mFiles;
@@ -38,6 +61,10 @@ const std::vector<SyntaxPattern>& SyntaxDefinition::getPatterns() const {
 	return mPatterns;
 }
 
+const std::vector<SyntaxPatternProgram>& SyntaxDefinition::getPatternPrograms() const {
+	return mPatternPrograms;
+}
+
 const std::string& SyntaxDefinition::getComment() const {
 	return mComment;
 }
@@ -53,6 +80,13 @@ std::string SyntaxDefinition::getSymbol( const std::string& symbol ) const {
 	return "";
 }
 
+SyntaxStyleType SyntaxDefinition::getSymbolType( const std::string& symbol ) const {
+	auto it = mSymbols.find( symbol );
+	if ( it != mSymbols.end() && !it->second.empty() )
+		return String::hash( it->second );
+	return 0;
+}
+
 SyntaxDefinition& SyntaxDefinition::addFileType( const std::string& fileType ) {
 	mFiles.push_back( fileType );
 	return *this;
@@ -60,6 +94,7 @@ SyntaxDefinition& SyntaxDefinition::addFileType( const std::string& fileType ) {
 
 SyntaxDefinition& SyntaxDefinition::addPattern( const SyntaxPattern& pattern ) {
 	mPatterns.push_back( pattern );
+	mPatternPrograms.emplace_back( pattern );
 	return *this;
 }
 
@@ -69,6 +104,7 @@ SyntaxDefinition& SyntaxDefinition::addPatternToFront( const SyntaxPattern& patt
 	mPatterns.push_back( pattern );
 	for ( auto pa : patterns )
 		mPatterns.push_back( pa );
+	mPatternPrograms.emplace( mPatternPrograms.begin(), pattern );
 	return *this;
 }
 
@@ -102,6 +138,7 @@ SyntaxDefinition& SyntaxDefinition::setHeaders( const std::vector<std::string>&
 
 void SyntaxDefinition::clearPatterns() {
 	mPatterns.clear();
+	mPatternPrograms.clear();
 }
 
 void SyntaxDefinition::clearSymbols() {
@@ -112,4 +149,11 @@ const std::string& SyntaxDefinition::getLanguageName() const {
 	return mLanguageName;
 }
 
+void SyntaxDefinition::compilePatterns() {
+	mPatternPrograms.clear();
+	mPatternPrograms.reserve( mPatterns.size() );
+	for ( const auto& pattern : mPatterns )
+		mPatternPrograms.emplace_back( pattern );
+}
+
 }}} // namespace EE::UI::Doc
@@ -1,13 +1,39 @@
+#include <atomic>
 #include <eepp/ui/doc/syntaxhighlighter.hpp>
 #include <eepp/ui/doc/syntaxtokenizer.hpp>
+#include <mutex>
 
 namespace EE { namespace UI { namespace Doc {
 
+struct SyntaxHighlighterAsyncBatch {
+	Uint64 generation;
+	Uint64 changeId;
+	Int64 startLine;
+	int initState;
+	std::vector<std::string> texts;
+	std::vector<String::HashType> hashes;
+	std::vector<TokenizedLine> lines;
+};
+
+// Shared between the highlighter and its running job, so the job can outlive the highlighter.
+struct SyntaxHighlighterAsyncState {
+	std::atomic<Uint64> generation{0};
+	std::mutex mutex;
+	std::vector<std::shared_ptr<SyntaxHighlighterAsyncBatch>> results;
+};
+
 SyntaxHighlighter::SyntaxHighlighter( TextDocument* doc ) :
-	mDoc( doc ), mFirstInvalidLine( 0 ), mMaxWantedLine( 0 ) {
+	mDoc( doc ),
+	mFirstInvalidLine( 0 ),
+	mMaxWantedLine( 0 ),
+	mAsync( std::make_shared<SyntaxHighlighterAsyncState>() ) {
 	reset();
 }
 
+SyntaxHighlighter::~SyntaxHighlighter() {
+	cancelAsync();
+}
+
 void SyntaxHighlighter::changeDoc( TextDocument* doc ) {
 	mDoc = doc;
 	reset();
@@ -15,12 +41,16 @@ void SyntaxHighlighter::changeDoc( TextDocument* doc ) {
 }
 
 void SyntaxHighlighter::reset() {
+	cancelAsync();
+	mAsyncDefinition.reset();
 	mLines.clear();
 	mFirstInvalidLine = 0;
 	mMaxWantedLine = 0;
 }
 
 void SyntaxHighlighter::invalidate( Int64 lineIndex ) {
+	if ( mAsyncRunning )
+		cancelAsync();
 	mFirstInvalidLine = eemin( lineIndex, mFirstInvalidLine );
 	mMaxWantedLine = eemin<Int64>( mMaxWantedLine, (Int64)mDoc->linesCount() - 1 );
 }
@@ -63,6 +93,9 @@ Int64 SyntaxHighlighter::getMaxWantedLine() const {
 }
 
 bool SyntaxHighlighter::updateDirty( int visibleLinesCount ) {
+	if ( mPool )
+		return updateDirtyAsync();
+
 	if ( mFirstInvalidLine > mMaxWantedLine ) {
 		mMaxWantedLine = 0;
 	} else {
@@ -90,4 +123,165 @@ bool SyntaxHighlighter::updateDirty( int visibleLinesCount ) {
 	return false;
 }
 
+void SyntaxHighlighter::setThreadPool( std::shared_ptr<ThreadPool> pool ) {
+	if ( mPool != pool ) {
+		cancelAsync();
+		mPool = pool;
+		mFirstInvalidLine = 0;
+	}
+}
+
+const std::shared_ptr<ThreadPool>& SyntaxHighlighter::getThreadPool() const {
+	return mPool;
+}
+
+bool SyntaxHighlighter::isAsync() const {
+	return mPool != nullptr;
+}
+
+void SyntaxHighlighter::setAsyncBatchSize( const Uint32& batchSize ) {
+	mAsyncBatchSize = eemax<Uint32>( 1, batchSize );
+}
+
+const Uint32& SyntaxHighlighter::getAsyncBatchSize() const {
+	return mAsyncBatchSize;
+}
+
+bool SyntaxHighlighter::isAsyncRunning() const {
+	return mAsyncRunning;
+}
+
+int SyntaxHighlighter::getPrevLineState( const Int64& index ) const {
+	if ( index > 0 ) {
+		auto prevIt = mLines.find( index - 1 );
+		if ( prevIt != mLines.end() )
+			return prevIt->second.state;
+	}
+	return SYNTAX_TOKENIZER_STATE_NONE;
+}
+
+void SyntaxHighlighter::cancelAsync() {
+	// The running job (if any) stops as soon as it sees the new generation and its results are
+	// discarded once published.
+	mAsync->generation++;
+}
+
+bool SyntaxHighlighter::updateDirtyAsync() {
+	bool changed = applyAsyncResults();
+	if ( !mAsyncRunning && mFirstInvalidLine < (Int64)mDoc->linesCount() )
+		dispatchAsyncBatch();
+	return changed;
+}
+
+bool SyntaxHighlighter::applyAsyncResults() {
+	std::vector<std::shared_ptr<SyntaxHighlighterAsyncBatch>> results;
+	{
+		std::lock_guard<std::mutex> lock( mAsync->mutex );
+		results.swap( mAsync->results );
+	}
+
+	bool changed = false;
+
+	for ( auto& batch : results ) {
+		mAsyncRunning = false;
+
+		if ( batch->generation != mAsync->generation ||
+			 batch->changeId != mDoc->getCurrentChangeId() ||
+			 batch->startLine != mFirstInvalidLine ||
+			 batch->initState != getPrevLineState( batch->startLine ) )
+			continue;
+
+		Int64 index = batch->startLine;
+		for ( auto& line : batch->lines ) {
+			if ( index >= (Int64)mDoc->linesCount() || mDoc->line( index ).getHash() != line.hash )
+				break;
+			auto it = mLines.find( index );
+			if ( it == mLines.end() || it->second.hash != line.hash ||
+				 it->second.initState != line.initState || it->second.state != line.state ) {
+				mLines[index] = std::move( line );
+				changed = true;
+			}
+			index++;
+		}
+		mFirstInvalidLine = index;
+	}
+
+	return changed;
+}
+
+bool SyntaxHighlighter::isAsyncLineAvailable( const Int64& index ) const {
+	// Lines that weren't decoded from a memory mapped file are only highlighted ( and therefore
+	// decoded ) up to the last line requested by the editor, the rest waits until something else
+	// decodes them.
+	return index <= mMaxWantedLine || mDoc->isLineLoaded( index );
+}
+
+void SyntaxHighlighter::dispatchAsyncBatch() {
+	Int64 linesCount = (Int64)mDoc->linesCount();
+	bool lazyLines = mDoc->hasUnloadedLines();
+	int state = getPrevLineState( mFirstInvalidLine );
+
+	// Skip the lines that are already tokenized with the right initial state.
+	while ( mFirstInvalidLine < linesCount ) {
+		auto it = mLines.find( mFirstInvalidLine );
+		if ( it == mLines.end() || it->second.initState != state ||
+			 ( lazyLines && !mDoc->isLineLoaded( mFirstInvalidLine ) ) ||
+			 it->second.hash != mDoc->line( mFirstInvalidLine ).getHash() )
+			break;
+		state = it->second.state;
+		mFirstInvalidLine++;
+	}
+
+	if ( mFirstInvalidLine >= linesCount ||
+		 ( lazyLines && !isAsyncLineAvailable( mFirstInvalidLine ) ) )
+		return;
+
+	// The job works with its own copy of the definition, so it never touches the document.
+	if ( !mAsyncDefinition ||
+		 mAsyncDefinition->getLanguageName() != mDoc->getSyntaxDefinition().getLanguageName() )
+		mAsyncDefinition = std::make_shared<SyntaxDefinition>( mDoc->getSyntaxDefinition() );
+
+	auto batch = std::make_shared<SyntaxHighlighterAsyncBatch>();
+	batch->generation = mAsync->generation;
+	batch->changeId = mDoc->getCurrentChangeId();
+	batch->startLine = mFirstInvalidLine;
+	batch->initState = state;
+
+	Int64 end = eemin<Int64>( linesCount, mFirstInvalidLine + mAsyncBatchSize );
+	batch->texts.reserve( end - mFirstInvalidLine );
+	batch->hashes.reserve( end - mFirstInvalidLine );
+	for ( Int64 index = mFirstInvalidLine; index < end; index++ ) {
+		if ( lazyLines && !isAsyncLineAvailable( index ) )
+			break;
+		const TextDocumentLine& line = mDoc->line( index );
+		batch->texts.emplace_back( line.toUtf8() );
+		batch->hashes.emplace_back( line.getHash() );
+	}
+
+	std::shared_ptr<SyntaxHighlighterAsyncState> asyncState( mAsync );
+	std::shared_ptr<const SyntaxDefinition> definition( mAsyncDefinition );
+	mAsyncRunning = true;
+
+	mPool->run(
+		[asyncState, definition, batch] {
+			int lineState = batch->initState;
+			batch->lines.reserve( batch->texts.size() );
+			for ( size_t i = 0; i < batch->texts.size(); i++ ) {
+				if ( asyncState->generation != batch->generation )
+					break;
+				TokenizedLine line;
+				line.initState = lineState;
+				line.hash = batch->hashes[i];
+				auto res = SyntaxTokenizer::tokenize( *definition, batch->texts[i], lineState );
+				line.tokens = std::move( res.first );
+				line.state = lineState = res.second;
+				batch->lines.emplace_back( std::move( line ) );
+			}
+			batch->texts.clear();
+			std::lock_guard<std::mutex> lock( asyncState->mutex );
+			asyncState->results.emplace_back( batch );
+		},
+		nullptr, ThreadPool::Priority::Interactive );
+}
+
 }}} // namespace EE::UI::Doc
@@ -10,26 +10,49 @@ namespace EE { namespace UI { namespace Doc {
 // tokenizer. This allows eepp to support the same color schemes and syntax definitions from
 // lite. Making much easier to implement a complete code editor.
 
-static bool allSpaces( const std::string& str ) {
-	for ( auto& chr : str )
-		if ( ' ' != chr )
+static bool allSpaces( const std::string& text, const size_t& start, const size_t& len ) {
+	for ( size_t i = start; i < start + len; i++ )
+		if ( ' ' != text[i] )
 			return false;
 	return true;
 }
 
-static void pushToken( std::vector<SyntaxToken>& tokens, const std::string& type,
-					   const std::string& text ) {
-	if ( !tokens.empty() && ( tokens[tokens.size() - 1].type == type ||
-							  allSpaces( tokens[tokens.size() - 1].text ) ) ) {
-		tokens[tokens.size() - 1].type = type;
-		tokens[tokens.size() - 1].text += text;
-	} else {
-		tokens.push_back( {type, text} );
+// Tokens are pushed as byte spans of the line and converted to character spans once the
+// line has been tokenized.
+static void pushToken( std::vector<SyntaxToken>& tokens, const std::string& text,
+					   const SyntaxStyleType& type, const size_t& start, const size_t& len ) {
+	if ( !tokens.empty() ) {
+		SyntaxToken& last = tokens[tokens.size() - 1];
+		if ( last.type == type || allSpaces( text, last.start, last.len ) ) {
+			last.type = type;
+			last.len += len;
+			return;
+		}
 	}
+	tokens.push_back( { type, static_cast<Uint32>( start ), static_cast<Uint32>( len ) } );
+}
+
+static size_t utf8Length( const std::string& text, const size_t& start, const size_t& len ) {
+	size_t count = 0;
+	for ( size_t i = start; i < start + len; i++ )
+		if ( ( text[i] & 0xC0 ) != 0x80 )
+			count++;
+	return count;
 }
 
-bool isScaped( const std::string& text, const size_t& startIndex, const std::string& escapeStr ) {
-	char escapeByte = escapeStr.empty() ? '\\' : escapeStr[0];
+static void toCharacterSpans( std::vector<SyntaxToken>& tokens, const std::string& text ) {
+	if ( tokens.empty() )
+		return;
+	size_t charPos = utf8Length( text, 0, tokens[0].start );
+	for ( auto& token : tokens ) {
+		size_t charLen = utf8Length( text, token.start, token.len );
+		token.start = charPos;
+		token.len = charLen;
+		charPos += charLen;
+	}
+}
+
+bool isScaped( const std::string& text, const size_t& startIndex, const char& escapeByte ) {
 	int count = 0;
 	for ( int i = startIndex - 1; i >= 0; i-- ) {
 		if ( text[i] != escapeByte )
@@ -39,13 +62,19 @@ bool isScaped( const std::string& text, const size_t& startIndex, const std::str
 	return count % 2 == 1;
 }
 
-std::pair<int, int> findNonEscaped( const std::string& text, const std::string& pattern, int offset,
-									const std::string& escapeStr ) {
+std::pair<int, int> findNonEscaped( const std::string& text, const SyntaxPatternProgram& program,
+									int offset ) {
 	while ( true ) {
-		LuaPattern words( pattern );
+		if ( program.hasEndSet ) {
+			// Skip directly to the first byte that can start the closing pattern.
+			while ( offset < (int)text.size() && !program.endSet[(unsigned char)text[offset]] )
+				offset++;
+			if ( offset >= (int)text.size() )
+				return std::make_pair( -1, -1 );
+		}
 		int start, end;
-		if ( words.find( text, start, end, offset ) ) {
-			if ( !escapeStr.empty() && isScaped( text, start, escapeStr ) ) {
+		if ( program.end.find( text, start, end, offset ) ) {
+			if ( program.escape != 0 && isScaped( text, start, program.escape ) ) {
 				offset = end;
 			} else {
 				return std::make_pair( start, end );
@@ -62,48 +91,49 @@ std::pair<std::vector<SyntaxToken>, int> SyntaxTokenizer::tokenize( const Syntax
 																	const size_t& startIndex ) {
 	std::vector<SyntaxToken> tokens;
 	if ( syntax.getPatterns().empty() ) {
-		pushToken( tokens, "normal", text );
+		if ( startIndex < text.size() )
+			pushToken( tokens, text, SyntaxStyleTypes::Normal, startIndex,
+					   text.size() - startIndex );
+		toCharacterSpans( tokens, text );
 		return std::make_pair( tokens, SYNTAX_TOKENIZER_STATE_NONE );
 	}
 
+	const std::vector<SyntaxPatternProgram>& programs = syntax.getPatternPrograms();
 	size_t i = startIndex;
 	int retState = state;
 
 	while ( i < text.size() ) {
 		if ( retState != SYNTAX_TOKENIZER_STATE_NONE ) {
-			const SyntaxPattern& pattern = syntax.getPatterns()[retState];
-			std::pair<int, int> range =
-				findNonEscaped( text, pattern.patterns[1], i,
-								pattern.patterns.size() >= 3 ? pattern.patterns[2] : "" );
+			const SyntaxPatternProgram& program = programs[retState];
+			std::pair<int, int> range = findNonEscaped( text, program, i );
 			if ( range.first != -1 ) {
-				pushToken( tokens, pattern.type, text.substr( i, range.second - i ) );
+				pushToken( tokens, text, program.type, i, range.second - i );
 				retState = SYNTAX_TOKENIZER_STATE_NONE;
 				i = range.second;
 			} else {
-				pushToken( tokens, pattern.type, text.substr( i ) );
+				pushToken( tokens, text, program.type, i, text.size() - i );
 				break;
 			}
 		}
 
 		bool matched = false;
+		unsigned char curChar = i < text.size() ? text[i] : 0;
 
-		for ( size_t patternIndex = 0; patternIndex < syntax.getPatterns().size();
-			  patternIndex++ ) {
-			const SyntaxPattern& pattern = syntax.getPatterns()[patternIndex];
-			if ( i != 0 && pattern.patterns[0][0] == '^' )
+		for ( size_t patternIndex = 0; patternIndex < programs.size(); patternIndex++ ) {
+			const SyntaxPatternProgram& program = programs[patternIndex];
+			if ( i != 0 && program.lineStart )
+				continue;
+			if ( program.hasStartSet && !program.startSet[curChar] )
 				continue;
-			const std::string& patternStr(
-				pattern.patterns[0][0] == '^' ? pattern.patterns[0] : "^" + pattern.patterns[0] );
-			LuaPattern words( patternStr );
 			int start, end = 0;
-			if ( words.find( text, start, end, i ) && start != end ) {
-				if ( pattern.patterns.size() >= 3 && i > 0 &&
-					 text[i - 1] == pattern.patterns[2][0] )
+			if ( program.start.find( text, start, end, i ) && start != end ) {
+				if ( program.escape != 0 && i > 0 && text[i - 1] == program.escape )
 					continue;
-				std::string patternText( text.substr( start, end - start ) );
-				std::string type = syntax.getSymbol( patternText );
-				pushToken( tokens, type.empty() ? pattern.type : type, patternText );
-				if ( pattern.patterns.size() > 1 ) {
+				SyntaxStyleType type = syntax.getSymbols().empty()
+										   ? 0
+										   : syntax.getSymbolType( text.substr( start, end - start ) );
+				pushToken( tokens, text, type != 0 ? type : program.type, start, end - start );
+				if ( program.multiLine ) {
 					retState = patternIndex;
 				}
 				i = end;
@@ -113,11 +143,13 @@ std::pair<std::vector<SyntaxToken>, int> SyntaxTokenizer::tokenize( const Syntax
 		}
 
 		if ( !matched && i < text.size() ) {
-			pushToken( tokens, "normal", text.substr( i, 1 ) );
+			pushToken( tokens, text, SyntaxStyleTypes::Normal, i, 1 );
 			i += 1;
 		}
 	}
 
+	toCharacterSpans( tokens, text );
+
 	return std::make_pair( tokens, retState );
 }
 
@@ -1,9 +1,11 @@
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <eepp/core/debug.hpp>
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/iostreamfile.hpp>
 #include <eepp/system/iostreammemory.hpp>
+#include <eepp/system/lock.hpp>
 #include <eepp/system/log.hpp>
 #include <eepp/system/luapattern.hpp>
 #include <eepp/system/packmanager.hpp>
@@ -11,6 +13,9 @@
 #include <eepp/ui/doc/textdocument.hpp>
 #include <sstream>
 #include <string>
+#if EE_PLATFORM != EE_PLATFORM_WIN
+#include <sys/stat.h>
+#endif
 
 namespace EE { namespace UI { namespace Doc {
 
@@ -36,6 +41,7 @@ TextDocument::TextDocument( bool verbose ) :
 }
 
 TextDocument::~TextDocument() {
+	stopIndexing();
 	notifyDocumentClosed();
 }
 
@@ -48,11 +54,12 @@ bool TextDocument::isEmpty() {
 }
 
 void TextDocument::reset() {
+	stopIndexing();
 	mFilePath = mDefaultFileName;
 	mFileRealPath = FileInfo();
 	mSelection.set( { 0, 0 }, { 0, 0 } );
 	mLines.clear();
-	mLines.emplace_back( String( "\n" ) );
+	mLines.push_back( String( "\n" ) );
 	mSyntaxDefinition = SyntaxDefinitionManager::instance()->getPlainStyle();
 	mUndoStack.clear();
 	cleanChangeId();
@@ -61,13 +68,13 @@ void TextDocument::reset() {
 	notifySelectionChanged();
 }
 
-static String ptrGetLine( char* data, const size_t& size, size_t& position ) {
+static std::string ptrGetLine( char* data, const size_t& size, size_t& position ) {
 	position = 0;
 	while ( position < size && data[position] != '\n' )
 		position++;
 	if ( position < size )
 		position++;
-	return String( data, position );
+	return std::string( data, position );
 }
 
 bool TextDocument::loadFromStream( IOStream& file ) {
@@ -78,6 +85,7 @@ bool TextDocument::loadFromStream( IOStream& file, std::string path, bool callRe
 	Clock clock;
 	if ( callReset )
 		reset();
+	stopIndexing();
 	mLines.clear();
 	if ( file.isOpen() ) {
 		const size_t BLOCK_SIZE = EE_1MB;
@@ -85,7 +93,8 @@ bool TextDocument::loadFromStream( IOStream& file, std::string path, bool callRe
 		size_t pending = total;
 		size_t blockSize = eemin( total, BLOCK_SIZE );
 		size_t read = 0;
-		String lineBuffer;
+		// Lines are decoded once complete, a multi-byte character can be split between blocks.
+		std::string lineBuffer;
 		size_t position;
 		int consume;
 		char* bufferPtr;
@@ -110,7 +119,9 @@ bool TextDocument::loadFromStream( IOStream& file, std::string path, bool callRe
 				bufferPtr += position;
 				consume -= position;
 
-				if ( lineBuffer[lineBuffer.size() - 1] == '\n' || !consume ) {
+				// A line that doesn't end in the current block continues in the next one.
+				if ( lineBuffer[lineBuffer.size() - 1] == '\n' ||
+					 ( !consume && read == pending ) ) {
 					if ( mLines.empty() && lineBuffer.size() > 1 &&
 						 lineBuffer[lineBuffer.size() - 2] == '\r' ) {
 						mLineEnding = LineEnding::CRLF;
@@ -121,7 +132,7 @@ bool TextDocument::loadFromStream( IOStream& file, std::string path, bool callRe
 						lineBuffer.resize( lineBuffer.size() - 1 );
 					}
 
-					mLines.push_back( lineBuffer );
+					mLines.push_back( String( lineBuffer ) );
 					lineBuffer.resize( 0 );
 				}
 
@@ -131,20 +142,20 @@ bool TextDocument::loadFromStream( IOStream& file, std::string path, bool callRe
 				}
 			}
 
-			if ( !mLines.empty() ) {
-				const String& lastLine = mLines[mLines.size() - 1].getText();
-				if ( lastLine[lastLine.size() - 1] == '\n' ) {
-					mLines.push_back( String( "\n" ) );
-				} else {
-					mLines[mLines.size() - 1].append( "\n" );
-				}
-			}
-
 			if ( !read )
 				break;
 			pending -= read;
 			blockSize = eemin( pending, BLOCK_SIZE );
 		};
+
+		if ( !mLines.empty() ) {
+			const String& lastLine = mLines[mLines.size() - 1].getText();
+			if ( lastLine[lastLine.size() - 1] == '\n' ) {
+				mLines.push_back( String( "\n" ) );
+			} else {
+				mLines[mLines.size() - 1].append( "\n" );
+			}
+		}
 	}
 
 	if ( mLines.empty() )
@@ -161,6 +172,172 @@ bool TextDocument::loadFromStream( IOStream& file, std::string path, bool callRe
 	return true;
 }
 
+bool TextDocument::loadFromMappedFile( const std::string& path, bool callReset ) {
+	std::shared_ptr<IOStreamMappedFile> file( std::make_shared<IOStreamMappedFile>( path ) );
+	if ( !file->isOpen() )
+		return false;
+	Clock clock;
+	if ( callReset )
+		reset();
+	stopIndexing();
+	mLines.clear();
+
+	const char* data = file->getData();
+	size_t size = file->getSize();
+	size_t offset = 0;
+	// Check UTF-8 BOM header
+	if ( size >= 3 && (char)0xef == data[0] && (char)0xbb == data[1] && (char)0xbf == data[2] ) {
+		offset = 3;
+		mIsBOM = true;
+	}
+	const char* nl = static_cast<const char*>( memchr( data + offset, '\n', size - offset ) );
+	bool crlf = nl && nl > data + offset && nl[-1] == '\r';
+	if ( crlf )
+		mLineEnding = LineEnding::CRLF;
+
+	mLines.setMappedFile( file, crlf );
+	mMappedFile = file;
+	mIndexedBytes = offset;
+	mIndexerDone = false;
+	mIndexerCancel = false;
+	mIndexing = true;
+
+	// The beginning of the file is indexed right away so the document can be displayed, the rest is
+	// indexed in the background and appended with updateIndexing.
+	mIndexerOffset = indexMappedLines( offset, EE_1MB );
+	if ( mIndexerOffset < size ) {
+		mIndexer = eeNew( Thread, ( &TextDocument::indexMappedFile, this ) );
+		mIndexer->launch();
+	} else {
+		mIndexerDone = true;
+	}
+	updateIndexing();
+
+	if ( mAutoDetectIndentType )
+		guessIndentType();
+
+	notifyTextChanged();
+
+	if ( mVerbose )
+		Log::info( "Document \"%s\" mapped in %.2fms.", path.c_str(),
+				   clock.getElapsedTime().asMilliseconds() );
+	return true;
+}
+
+size_t TextDocument::indexMappedLines( size_t offset, size_t limit ) {
+	const char* data = mMappedFile->getData();
+	size_t size = mMappedFile->getSize();
+	size_t end = limit < size - offset ? offset + limit : size;
+	size_t blockLines = mLines.getBlockSize();
+	size_t start = offset;
+	size_t pos = offset;
+	size_t count = 0;
+	std::vector<MappedLines> lines;
+	// Lines are grouped in ranges of the line store block size. Indexing stops at a range boundary,
+	// so the next call continues from the returned offset.
+	while ( pos < size && ( pos < end || start == offset ) ) {
+		const char* nl = static_cast<const char*>( memchr( data + pos, '\n', size - pos ) );
+		pos = nl ? nl - data + 1 : size;
+		if ( ++count == blockLines ) {
+			lines.push_back( { start, pos - start, count } );
+			start = pos;
+			count = 0;
+		}
+	}
+	if ( pos == size && count ) {
+		lines.push_back( { start, pos - start, count } );
+		start = pos;
+	}
+	if ( !lines.empty() ) {
+		Lock l( mIndexerMutex );
+		mIndexedLines.insert( mIndexedLines.end(), lines.begin(), lines.end() );
+	}
+	mIndexedBytes = start;
+	return start;
+}
+
+void TextDocument::indexMappedFile() {
+	size_t size = mMappedFile->getSize();
+	while ( mIndexerOffset < size && !mIndexerCancel )
+		mIndexerOffset = indexMappedLines( mIndexerOffset, EE_1MB * 8 );
+	mIndexerDone = true;
+}
+
+void TextDocument::stopIndexing() {
+	if ( NULL != mIndexer ) {
+		mIndexerCancel = true;
+		mIndexer->wait();
+		eeSAFE_DELETE( mIndexer );
+	}
+	mIndexedLines.clear();
+	mMappedFile.reset();
+	mIndexing = false;
+	mIndexerCancel = false;
+}
+
+void TextDocument::updateIndexing() {
+	if ( !mIndexing )
+		return;
+	// Read before taking the lines, once done is set every range was already published.
+	bool done = mIndexerDone;
+	std::vector<MappedLines> lines;
+	{
+		Lock l( mIndexerMutex );
+		lines.swap( mIndexedLines );
+	}
+	size_t lastCount = mLines.size();
+	for ( const auto& range : lines )
+		mLines.pushMappedLines( range.offset, range.size, range.count );
+	if ( done ) {
+		// Same as loadFromStream: a line break at the end of the file starts a new empty line.
+		if ( mLines.empty() || mMappedFile->getData()[mMappedFile->getSize() - 1] == '\n' )
+			mLines.push_back( String( "\n" ) );
+		if ( NULL != mIndexer ) {
+			mIndexer->wait();
+			eeSAFE_DELETE( mIndexer );
+		}
+		mMappedFile.reset();
+		mIndexing = false;
+	}
+	if ( lastCount != mLines.size() )
+		notifyLineCountChanged( lastCount, mLines.size() );
+}
+
+void TextDocument::finishIndexing() {
+	if ( !mIndexing )
+		return;
+	if ( NULL != mIndexer )
+		mIndexer->wait();
+	mIndexerDone = true;
+	updateIndexing();
+}
+
+bool TextDocument::isIndexing() const {
+	return mIndexing;
+}
+
+Float TextDocument::getIndexingProgress() const {
+	if ( !mIndexing || !mMappedFile )
+		return 1.f;
+	return mIndexedBytes / (Float)mMappedFile->getSize();
+}
+
+bool TextDocument::isLineLoaded( const size_t& index ) const {
+	return mLines.isLineLoaded( index );
+}
+
+bool TextDocument::hasUnloadedLines() const {
+	return mLines.hasMappedLines();
+}
+
+void TextDocument::setLazyLoadingThreshold( const size_t& threshold ) {
+	mLazyLoadingThreshold = threshold;
+}
+
+const size_t& TextDocument::getLazyLoadingThreshold() const {
+	return mLazyLoadingThreshold;
+}
+
 void TextDocument::guessIndentType() {
 	int guessSpaces = 0;
 	int guessTabs = 0;
@@ -264,8 +441,13 @@ bool TextDocument::loadFromFile( const std::string& path ) {
 		}
 	}
 
-	IOStreamFile file( path, "rb" );
-	bool ret = loadFromStream( file, path, true );
+	bool ret = false;
+	if ( mLazyLoadingThreshold && FileSystem::fileSize( path ) >= mLazyLoadingThreshold )
+		ret = loadFromMappedFile( path, true );
+	if ( !ret ) {
+		IOStreamFile file( path, "rb" );
+		ret = loadFromStream( file, path, true );
+	}
 	mFilePath = path;
 	mFileRealPath = FileInfo::isLink( mFilePath ) ? FileInfo( FileInfo( mFilePath ).linksTo() )
 												  : FileInfo( mFilePath );
@@ -296,8 +478,12 @@ bool TextDocument::reload() {
 		auto selection = mSelection;
 		mUndoStack.clear();
 		cleanChangeId();
-		IOStreamFile file( path, "rb" );
-		ret = loadFromStream( file, path, false );
+		if ( mLazyLoadingThreshold && FileSystem::fileSize( path ) >= mLazyLoadingThreshold )
+			ret = loadFromMappedFile( path, false );
+		if ( !ret ) {
+			IOStreamFile file( path, "rb" );
+			ret = loadFromStream( file, path, false );
+		}
 		mFileRealPath = FileInfo::isLink( mFilePath ) ? FileInfo( FileInfo( mFilePath ).linksTo() )
 													  : FileInfo( mFilePath );
 		resetSyntax();
@@ -311,6 +497,9 @@ bool TextDocument::save( const std::string& path ) {
 	if ( path.empty() || mDefaultFileName == path )
 		return false;
 	if ( FileSystem::fileCanWrite( FileSystem::fileRemoveFileName( path ) ) ) {
+		finishIndexing();
+		if ( mLines.hasMappedLines() && mLines.getMappedFile()->getPath() == path )
+			return saveToMappedFile( path );
 		IOStreamFile file( path, "wb" );
 		mFilePath = path;
 		mSaving = true;
@@ -330,7 +519,42 @@ bool TextDocument::save( const std::string& path ) {
 	return false;
 }
 
+bool TextDocument::saveToMappedFile( const std::string& path ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	// A mapped file can't be replaced on Windows, the pending lines are decoded and the mapping is
+	// released before saving.
+	mLines.loadAll();
+	return save( path );
+#else
+	// The mapped file can't be truncated while lines are still read from it. The document is
+	// written to a temporary file that replaces the original one, the mapping keeps the original
+	// contents alive until it's released.
+	std::string target( FileInfo::isLink( path ) ? FileInfo( path ).linksTo() : path );
+	std::string tmpPath( target + ".tmp" );
+	IOStreamFile file( tmpPath, "wb" );
+	mSaving = true;
+	bool ret = save( file );
+	file.close();
+	if ( ret ) {
+		struct stat st;
+		if ( stat( target.c_str(), &st ) == 0 )
+			chmod( tmpPath.c_str(), st.st_mode );
+		ret = std::rename( tmpPath.c_str(), target.c_str() ) == 0;
+	}
+	mSaving = false;
+	if ( !ret ) {
+		FileSystem::fileRemove( tmpPath );
+		return false;
+	}
+	mFilePath = path;
+	mFileRealPath = FileInfo::isLink( mFilePath ) ? FileInfo( mFilePath ).linksTo() : mFilePath;
+	notifyDocumentSaved();
+	return true;
+#endif
+}
+
 bool TextDocument::save( IOStream& stream, bool keepUndoRedoStatus ) {
+	finishIndexing();
 	if ( !stream.isOpen() || mLines.empty() )
 		return false;
 	const std::string whitespaces( " \t\f\v\n\r" );
@@ -340,7 +564,20 @@ bool TextDocument::save( IOStream& stream, bool keepUndoRedoStatus ) {
 		stream.write( (char*)bom, sizeof( bom ) );
 	}
 	size_t lastLine = mLines.size() - 1;
+	bool writeMapped = mLines.hasMappedLines() && !mTrimTrailingWhitespaces &&
+					   mLines.isMappedCRLF() == ( mLineEnding == LineEnding::CRLF );
 	for ( size_t i = 0; i <= lastLine; i++ ) {
+		if ( writeMapped ) {
+			// Lines that were never decoded are written straight from the mapped file.
+			const char* data;
+			size_t size;
+			size_t count = mLines.getMappedLines( i, &data, &size );
+			if ( count && i + count <= lastLine ) {
+				stream.write( data, size );
+				i += count - 1;
+				continue;
+			}
+		}
 		std::string text( mLines[i].toUtf8() );
 		if ( mTrimTrailingWhitespaces && text.size() > 1 &&
 			 whitespaces.find( text[text.size() - 2] ) != std::string::npos ) {
@@ -364,7 +601,7 @@ bool TextDocument::save( IOStream& stream, bool keepUndoRedoStatus ) {
 			}
 			if ( mForceNewLineAtEndOfFile && !text.empty() && text[text.size() - 1] != '\n' ) {
 				text += "\n";
-				mLines.emplace_back( TextDocumentLine( "\n" ) );
+				mLines.push_back( TextDocumentLine( "\n" ) );
 				notifyTextChanged();
 				notifyLineChanged( i );
 				notifyLineCountChanged( lastLine, lastLine + 1 );
@@ -444,7 +681,7 @@ size_t TextDocument::linesCount() const {
 	return mLines.size();
 }
 
-std::vector<TextDocumentLine>& TextDocument::lines() {
+TextDocumentLineStore& TextDocument::lines() {
 	return mLines;
 }
 
@@ -500,9 +737,14 @@ TextPosition TextDocument::insert( TextPosition position, const String& text,
 	mLines[position.line()] = TextDocumentLine( lines[0] );
 	notifyLineChanged( position.line() );
 
-	for ( Int64 i = 1; i < (Int64)lines.size(); i++ ) {
-		mLines.insert( mLines.begin() + position.line() + i, TextDocumentLine( lines[i] ) );
-		notifyLineChanged( position.line() + i );
+	if ( lines.size() > 1 ) {
+		std::vector<TextDocumentLine> newLines;
+		newLines.reserve( lines.size() - 1 );
+		for ( size_t i = 1; i < lines.size(); i++ )
+			newLines.emplace_back( lines[i] );
+		mLines.insert( position.line() + 1, std::move( newLines ) );
+		for ( Int64 i = 1; i < (Int64)lines.size(); i++ )
+			notifyLineChanged( position.line() + i );
 	}
 
 	TextPosition cursor = positionOffset( position, text.size() );
@@ -544,8 +786,7 @@ void TextDocument::remove( TextRange range, UndoStackContainer& undoStack, const
 
 	// First delete all the lines in between the first and last one.
 	if ( range.start().line() + 1 < range.end().line() ) {
-		mLines.erase( mLines.begin() + range.start().line() + 1,
-					  mLines.begin() + range.end().line() );
+		mLines.erase( range.start().line() + 1, range.end().line() );
 		range.end().setLine( range.start().line() + 1 );
 	}
 
@@ -588,11 +829,11 @@ void TextDocument::remove( TextRange range, UndoStackContainer& undoStack, const
 			afterSelection += '\n';
 
 		firstLine.setText( beforeSelection + afterSelection );
-		mLines.erase( mLines.begin() + range.end().line() );
+		mLines.erase( range.end().line() );
 	}
 
 	if ( lines().empty() ) {
-		mLines.emplace_back( String( "\n" ) );
+		mLines.push_back( String( "\n" ) );
 	}
 	notifyTextChanged();
 	notifyLineChanged( range.start().line() );
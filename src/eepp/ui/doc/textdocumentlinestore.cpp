@@ -0,0 +1,356 @@
+#include <cstring>
+#include <eepp/core/debug.hpp>
+#include <eepp/system/lock.hpp>
+#include <eepp/ui/doc/textdocumentlinestore.hpp>
+#include <iterator>
+
+namespace EE { namespace UI { namespace Doc {
+
+TextDocumentLineStore::TextDocumentLineStore( const size_t& blockSize ) :
+	mBlockSize( eemax<size_t>( 2, blockSize ) ), mSize( 0 ) {}
+
+size_t TextDocumentLineStore::size() const {
+	return mSize;
+}
+
+bool TextDocumentLineStore::empty() const {
+	return mSize == 0;
+}
+
+void TextDocumentLineStore::clear() {
+	Lock l( mMappedMutex );
+	mBlocks.clear();
+	mBlockIndex.clear();
+	mSize = 0;
+	mMappedBlocks = 0;
+	mMappedFile.reset();
+	mMappedCRLF = false;
+}
+
+TextDocumentLine& TextDocumentLineStore::operator[]( const size_t& index ) {
+	size_t offset;
+	size_t block = findBlock( index, offset );
+	loadBlock( block );
+	return mBlocks[block].lines[offset];
+}
+
+const TextDocumentLine& TextDocumentLineStore::operator[]( const size_t& index ) const {
+	size_t offset;
+	size_t block = findBlock( index, offset );
+	loadBlock( block );
+	return mBlocks[block].lines[offset];
+}
+
+TextDocumentLine& TextDocumentLineStore::back() {
+	loadBlock( mBlocks.size() - 1 );
+	return mBlocks.back().lines.back();
+}
+
+const TextDocumentLine& TextDocumentLineStore::back() const {
+	loadBlock( mBlocks.size() - 1 );
+	return mBlocks.back().lines.back();
+}
+
+void TextDocumentLineStore::push_back( const TextDocumentLine& line ) {
+	push_back( TextDocumentLine( line ) );
+}
+
+void TextDocumentLineStore::push_back( TextDocumentLine&& line ) {
+	// Appending fills every block up to the block size, so a freshly loaded document is
+	// stored in compact blocks.
+	if ( mBlocks.empty() || mBlocks.back().data || mBlocks.back().lines.size() >= mBlockSize ) {
+		Block block;
+		block.lines.reserve( mBlockSize );
+		appendBlock( std::move( block ) );
+	}
+	mBlocks.back().lines.emplace_back( std::move( line ) );
+	addToIndex( mBlocks.size() - 1, 1 );
+	mSize++;
+}
+
+void TextDocumentLineStore::insert( const size_t& index, TextDocumentLine&& line ) {
+	if ( index >= mSize ) {
+		push_back( std::move( line ) );
+		return;
+	}
+	size_t offset;
+	size_t block = findBlock( index, offset );
+	loadBlock( block );
+	std::vector<TextDocumentLine>& lines = mBlocks[block].lines;
+	lines.emplace( lines.begin() + offset, std::move( line ) );
+	mSize++;
+	if ( lines.size() > mBlockSize * 2 ) {
+		splitBlock( block );
+	} else {
+		addToIndex( block, 1 );
+	}
+}
+
+void TextDocumentLineStore::insert( const size_t& index, std::vector<TextDocumentLine>&& lines ) {
+	if ( lines.empty() )
+		return;
+	if ( index >= mSize ) {
+		for ( auto& line : lines )
+			push_back( std::move( line ) );
+		return;
+	}
+	size_t offset;
+	size_t block = findBlock( index, offset );
+	loadBlock( block );
+	std::vector<TextDocumentLine>& blockLines = mBlocks[block].lines;
+	blockLines.insert( blockLines.begin() + offset, std::make_move_iterator( lines.begin() ),
+					   std::make_move_iterator( lines.end() ) );
+	mSize += lines.size();
+	if ( blockLines.size() > mBlockSize * 2 ) {
+		splitBlock( block );
+	} else {
+		addToIndex( block, lines.size() );
+	}
+}
+
+void TextDocumentLineStore::erase( const size_t& index ) {
+	erase( index, index + 1 );
+}
+
+void TextDocumentLineStore::erase( const size_t& first, const size_t& last ) {
+	size_t end = eemin( last, mSize );
+	if ( first >= end )
+		return;
+	size_t pending = end - first;
+	size_t offset;
+	size_t block = findBlock( first, offset );
+	// The blocks that are completely erased are contiguous, they are removed at once.
+	size_t removeFrom = 0;
+	size_t removeCount = 0;
+	while ( pending > 0 && block < mBlocks.size() ) {
+		size_t blockSize = mBlocks[block].size();
+		size_t count = eemin( pending, blockSize - offset );
+		mSize -= count;
+		pending -= count;
+		if ( count == blockSize ) {
+			// Whole blocks are dropped without decoding them.
+			if ( removeCount++ == 0 )
+				removeFrom = block;
+		} else {
+			loadBlock( block );
+			std::vector<TextDocumentLine>& lines = mBlocks[block].lines;
+			lines.erase( lines.begin() + offset, lines.begin() + offset + count );
+			addToIndex( block, -count );
+		}
+		// Only the first affected block can be partially erased from an offset.
+		offset = 0;
+		block++;
+	}
+	if ( removeCount > 0 )
+		removeBlocks( removeFrom, removeCount );
+	if ( !mBlocks.empty() )
+		mergeBlock( findBlock( eemin( first, mSize - 1 ), offset ) );
+}
+
+const size_t& TextDocumentLineStore::getBlockSize() const {
+	return mBlockSize;
+}
+
+size_t TextDocumentLineStore::getBlockCount() const {
+	return mBlocks.size();
+}
+
+void TextDocumentLineStore::setMappedFile( const std::shared_ptr<IOStreamMappedFile>& file,
+										   bool crlf ) {
+	Lock l( mMappedMutex );
+	mMappedFile = file;
+	mMappedCRLF = crlf;
+}
+
+const std::shared_ptr<IOStreamMappedFile>& TextDocumentLineStore::getMappedFile() const {
+	return mMappedFile;
+}
+
+bool TextDocumentLineStore::isMappedCRLF() const {
+	return mMappedCRLF;
+}
+
+void TextDocumentLineStore::pushMappedLines( const size_t& offset, const size_t& size,
+											 const size_t& lineCount ) {
+	if ( !mMappedFile || !mMappedFile->isOpen() || !lineCount )
+		return;
+	Block block;
+	block.data = mMappedFile->getData() + offset;
+	block.dataSize = size;
+	block.mappedLines = lineCount;
+	appendBlock( std::move( block ) );
+	mSize += lineCount;
+	mMappedBlocks++;
+}
+
+size_t TextDocumentLineStore::getMappedLines( const size_t& index, const char** data,
+											  size_t* size ) const {
+	if ( mMappedBlocks == 0 || index >= mSize )
+		return 0;
+	Lock l( mMappedMutex );
+	size_t offset;
+	const Block& b = mBlocks[findBlock( index, offset )];
+	if ( !b.data || offset != 0 )
+		return 0;
+	*data = b.data;
+	*size = b.dataSize;
+	return b.mappedLines;
+}
+
+bool TextDocumentLineStore::hasMappedLines() const {
+	return mMappedBlocks > 0;
+}
+
+bool TextDocumentLineStore::isLineLoaded( const size_t& index ) const {
+	if ( mMappedBlocks == 0 )
+		return true;
+	Lock l( mMappedMutex );
+	size_t offset;
+	return mBlocks[findBlock( index, offset )].data == nullptr;
+}
+
+void TextDocumentLineStore::loadAll() {
+	for ( size_t i = 0; i < mBlocks.size() && mMappedBlocks > 0; i++ )
+		loadBlock( i );
+	Lock l( mMappedMutex );
+	mMappedFile.reset();
+}
+
+size_t TextDocumentLineStore::findBlock( const size_t& index, size_t& offset ) const {
+	// Descends the Fenwick tree looking for the last block whose start is <= index.
+	size_t count = mBlocks.size();
+	size_t pos = 0;
+	size_t step = 1;
+	offset = index;
+	while ( step * 2 <= count )
+		step *= 2;
+	for ( ; step > 0; step /= 2 ) {
+		if ( pos + step <= count && mBlockIndex[pos + step] <= offset ) {
+			pos += step;
+			offset -= mBlockIndex[pos];
+		}
+	}
+	if ( pos >= count && count > 0 ) {
+		// index == size(), points past the last line of the last block.
+		pos = count - 1;
+		offset = mBlocks[pos].size();
+	}
+	return pos;
+}
+
+void TextDocumentLineStore::loadBlock( const size_t& block ) const {
+	if ( mMappedBlocks == 0 )
+		return;
+	// Decoding doesn't change the number of lines of the block, so it's safe to do it from a const
+	// accessor. Other threads reading the document can decode concurrently, hence the lock.
+	Lock l( mMappedMutex );
+	Block& b = const_cast<Block&>( mBlocks[block] );
+	if ( !b.data )
+		return;
+	const char* data = b.data;
+	const char* end = b.data + b.dataSize;
+	b.lines.reserve( b.mappedLines );
+	while ( data < end ) {
+		const char* nl = static_cast<const char*>( memchr( data, '\n', end - data ) );
+		size_t len = nl ? nl - data + 1 : end - data;
+		if ( nl && mMappedCRLF && len > 1 && data[len - 2] == '\r' ) {
+			String line( data, len - 2 );
+			line.push_back( '\n' );
+			b.lines.emplace_back( std::move( line ) );
+		} else if ( nl ) {
+			b.lines.emplace_back( String( data, len ) );
+		} else {
+			// The last line of the file doesn't have a line break.
+			String line( data, len );
+			line.push_back( '\n' );
+			b.lines.emplace_back( std::move( line ) );
+		}
+		data += len;
+	}
+	eeASSERT( b.lines.size() == b.mappedLines );
+	b.data = nullptr;
+	b.dataSize = 0;
+	b.mappedLines = 0;
+	mMappedBlocks--;
+}
+
+void TextDocumentLineStore::appendBlock( Block&& block ) {
+	// The new node covers the blocks ( n - lowbit( n ), n ], that is the new block plus the nodes
+	// that the previous blocks already sum up.
+	size_t node = mBlocks.size() + 1;
+	size_t sum = block.size();
+	for ( size_t child = 1; child < ( node & ( ~node + 1 ) ); child *= 2 )
+		sum += mBlockIndex[node - child];
+	if ( mBlockIndex.empty() )
+		mBlockIndex.push_back( 0 );
+	mBlockIndex.push_back( sum );
+	mBlocks.emplace_back( std::move( block ) );
+}
+
+void TextDocumentLineStore::removeBlocks( const size_t& block, const size_t& count ) {
+	for ( size_t i = block; i < block + count; i++ ) {
+		if ( mBlocks[i].data ) {
+			Lock l( mMappedMutex );
+			mMappedBlocks--;
+		}
+	}
+	mBlocks.erase( mBlocks.begin() + block, mBlocks.begin() + block + count );
+	rebuildIndex();
+}
+
+void TextDocumentLineStore::addToIndex( const size_t& block, const size_t& delta ) {
+	for ( size_t node = block + 1; node < mBlockIndex.size(); node += node & ( ~node + 1 ) )
+		mBlockIndex[node] += delta;
+}
+
+void TextDocumentLineStore::rebuildIndex() {
+	mBlockIndex.assign( mBlocks.size() + 1, 0 );
+	for ( size_t node = 1; node <= mBlocks.size(); node++ ) {
+		mBlockIndex[node] += mBlocks[node - 1].size();
+		size_t parent = node + ( node & ( ~node + 1 ) );
+		if ( parent <= mBlocks.size() )
+			mBlockIndex[parent] += mBlockIndex[node];
+	}
+}
+
+void TextDocumentLineStore::splitBlock( const size_t& block ) {
+	// The lines are spread evenly, so every new block is at least half the block size and won't
+	// be merged back or split again until enough edits land on it.
+	std::vector<TextDocumentLine> lines( std::move( mBlocks[block].lines ) );
+	size_t count = ( lines.size() + mBlockSize - 1 ) / mBlockSize;
+	std::vector<Block> newBlocks( count );
+	for ( size_t i = 0; i < count; i++ ) {
+		size_t pos = lines.size() * i / count;
+		size_t end = lines.size() * ( i + 1 ) / count;
+		newBlocks[i].lines.assign( std::make_move_iterator( lines.begin() + pos ),
+								   std::make_move_iterator( lines.begin() + end ) );
+	}
+	mBlocks.erase( mBlocks.begin() + block );
+	mBlocks.insert( mBlocks.begin() + block, std::make_move_iterator( newBlocks.begin() ),
+					std::make_move_iterator( newBlocks.end() ) );
+	rebuildIndex();
+}
+
+void TextDocumentLineStore::mergeBlock( const size_t& block ) {
+	// Merge small blocks with a neighbour so that removals don't leave the store fragmented.
+	// Blocks that are not decoded yet are left as they are.
+	if ( mBlocks[block].data || mBlocks[block].lines.size() >= mBlockSize / 2 )
+		return;
+	size_t target = block;
+	size_t source = block + 1;
+	if ( block > 0 && !mBlocks[block - 1].data &&
+		 mBlocks[block - 1].lines.size() + mBlocks[block].lines.size() <= mBlockSize ) {
+		target = block - 1;
+		source = block;
+	} else if ( block + 1 >= mBlocks.size() || mBlocks[block + 1].data ||
+				mBlocks[block].lines.size() + mBlocks[block + 1].lines.size() > mBlockSize ) {
+		return;
+	}
+	std::vector<TextDocumentLine>& lines = mBlocks[target].lines;
+	lines.insert( lines.end(), std::make_move_iterator( mBlocks[source].lines.begin() ),
+				  std::make_move_iterator( mBlocks[source].lines.end() ) );
+	mBlocks.erase( mBlocks.begin() + source );
+	rebuildIndex();
+}
+
+}}} // namespace EE::UI::Doc
@@ -256,6 +256,8 @@ void UICodeEditor::draw() {
 		drawWhitespaces( lineRange, startScroll, lineHeight );
 	}
 
+	updateGlyphRunsState();
+
 	for ( int i = lineRange.first; i <= lineRange.second; i++ ) {
 		for ( auto& module : mModules )
 			module->drawBeforeLineText( this, i, { startScroll.x, startScroll.y + lineHeight * i },
@@ -268,6 +270,8 @@ void UICodeEditor::draw() {
 									   charSize, lineHeight );
 	}
 
+	clearGlyphRuns( lineRange );
+
 	drawCursor( startScroll, lineHeight, cursor );
 
 	if ( mShowLineNumber ) {
@@ -302,6 +306,9 @@ void UICodeEditor::scheduledUpdate( const Time& ) {
 		}
 	}
 
+	if ( mDoc->isIndexing() )
+		mDoc->updateIndexing();
+
 	if ( mHighlighter.updateDirty( getVisibleLinesCount() ) ) {
 		invalidateDraw();
 	}
@@ -591,6 +598,7 @@ void UICodeEditor::updateColorScheme() {
 
 void UICodeEditor::setColorScheme( const SyntaxColorScheme& colorScheme ) {
 	mColorScheme = colorScheme;
+	mGlyphRuns.clear();
 	updateColorScheme();
 	invalidateDraw();
 }
@@ -607,6 +615,10 @@ TextDocument& UICodeEditor::getDocument() {
 	return *mDoc.get();
 }
 
+SyntaxHighlighter* UICodeEditor::getHighlighter() {
+	return &mHighlighter;
+}
+
 void UICodeEditor::setDocument( std::shared_ptr<TextDocument> doc ) {
 	if ( mDoc.get() != doc.get() ) {
 		mDoc->unregisterClient( this );
@@ -615,6 +627,7 @@ void UICodeEditor::setDocument( std::shared_ptr<TextDocument> doc ) {
 		mDoc = doc;
 		mDoc->registerClient( this );
 		mHighlighter.changeDoc( mDoc.get() );
+		mGlyphRuns.clear();
 		invalidateEditor();
 		invalidateDraw();
 		onDocumentChanged();
@@ -920,6 +933,14 @@ void UICodeEditor::onPaddingChange() {
 
 void UICodeEditor::findLongestLine() {
 	if ( mHorizontalScrollBarEnabled ) {
+		if ( mDoc->hasUnloadedLines() ) {
+			// Measuring every line would decode the whole document, only the lines that have been
+			// displayed are taken into account.
+			std::pair<int, int> lineRange = getVisibleLineRange();
+			for ( int lineIndex = lineRange.first; lineIndex <= lineRange.second; lineIndex++ )
+				mLongestLineWidth = eemax( mLongestLineWidth, getLineWidth( lineIndex ) );
+			return;
+		}
 		mLongestLineWidth = 0;
 		for ( size_t lineIndex = 0; lineIndex < mDoc->linesCount(); lineIndex++ ) {
 			mLongestLineWidth = eemax( mLongestLineWidth, getLineWidth( lineIndex ) );
@@ -1008,11 +1029,14 @@ void UICodeEditor::onDocumentSelectionChange( const Doc::TextRange& ) {
 }
 
 void UICodeEditor::onDocumentLineCountChange( const size_t&, const size_t& ) {
+	// The lines after the change moved, their runs are rebuilt as they're drawn.
+	mGlyphRuns.clear();
 	updateScrollBar();
 }
 
 void UICodeEditor::onDocumentLineChanged( const Int64& lineIndex ) {
 	mHighlighter.invalidate( lineIndex );
+	mGlyphRuns.erase( lineIndex );
 }
 
 void UICodeEditor::onDocumentUndoRedo( const TextDocument::UndoRedo& ) {
@@ -1787,16 +1811,129 @@ void UICodeEditor::drawWordMatch( const String& text, const std::pair<int, int>&
 	primitives.setForceDraw( true );
 }
 
+// Lines longer than this are drawn token by token, skipping the tokens outside of the screen.
+static const size_t GLYPH_RUN_MAX_LINE_LENGTH = 4096;
+
+void UICodeEditor::updateGlyphRunsState() {
+	// Everything besides the line and its tokens that changes the geometry of a line.
+	size_t state = std::hash<Font*>()( mFont );
+	auto combine = [&state]( size_t value ) {
+		state ^= value + 0x9e3779b9 + ( state << 6 ) + ( state >> 2 );
+	};
+	combine( std::hash<Float>()( mFontStyleConfig.CharacterSize ) );
+	combine( mFontStyleConfig.Style );
+	combine( mTabWidth );
+	combine( std::hash<Float>()( mAlpha ) );
+	combine( std::hash<std::string>()( mColorScheme.getName() ) );
+	if ( state != mGlyphRunsState ) {
+		mGlyphRunsState = state;
+		mGlyphRuns.clear();
+	}
+}
+
+void UICodeEditor::clearGlyphRuns( const std::pair<int, int>& lineRange ) {
+	// Keeps the runs of the lines around the visible ones, so scrolling back doesn't rebuild them.
+	Int64 visibleLines = lineRange.second - lineRange.first + 1;
+	if ( mGlyphRuns.size() <= static_cast<size_t>( visibleLines * 4 ) )
+		return;
+	Int64 first = lineRange.first - visibleLines;
+	Int64 last = lineRange.second + visibleLines;
+	for ( auto it = mGlyphRuns.begin(); it != mGlyphRuns.end(); ) {
+		if ( it->first < first || it->first > last ) {
+			it = mGlyphRuns.erase( it );
+		} else {
+			++it;
+		}
+	}
+}
+
+bool UICodeEditor::buildGlyphRun( GlyphRun& run, const Int64& index, const Float& fontSize,
+								  const Float& lineHeight ) {
+	auto& tokens = mHighlighter.getLine( index );
+	const String& lineText = mDoc->line( index ).getText();
+	Text line( "", mFont, fontSize );
+	line.setTabWidth( mTabWidth );
+	Float x = 0;
+	run.vertices.clear();
+	run.colors.clear();
+	run.backgrounds.clear();
+	for ( auto& token : tokens ) {
+		String text( lineText.substr( token.start, token.len ) );
+		Float textWidth = getTextWidth( text );
+		const SyntaxColorScheme::Style& style = mColorScheme.getSyntaxStyle( token.type );
+		line.setStyleConfig( mFontStyleConfig );
+		if ( style.style )
+			line.setStyle( style.style );
+		// Shadows and outlines are drawn in separate passes, they can't be batched.
+		if ( ( line.getStyle() & Text::Shadow ) || line.getOutlineThickness() != 0 )
+			return false;
+		if ( style.background != Color::Transparent ) {
+			run.backgrounds.emplace_back( Rectf( Vector2f( x, 0 ), Sizef( textWidth, lineHeight ) ),
+										  Color( style.background ).blendAlpha( mAlpha ) );
+		}
+		line.setColor( Color( style.color ).blendAlpha( mAlpha ) );
+		line.setString( text );
+		line.appendGeometry( run.vertices, run.colors, Vector2f( x, 0 ) );
+		x += textWidth;
+	}
+	run.texture = line.getFontTexture();
+	return true;
+}
+
 void UICodeEditor::drawLineText( const Int64& index, Vector2f position, const Float& fontSize,
 								 const Float& lineHeight ) {
+	const TextDocumentLine& docLine = mDoc->line( index );
+
+	if ( docLine.size() > GLYPH_RUN_MAX_LINE_LENGTH ) {
+		drawLineTextUncached( index, position, fontSize, lineHeight );
+		return;
+	}
+
+	size_t tokensHash = 0;
+	for ( const auto& token : mHighlighter.getLine( index ) ) {
+		size_t value = ( static_cast<size_t>( token.type ) << 32 ) ^
+					   ( static_cast<size_t>( token.start ) << 16 ) ^ token.len;
+		tokensHash ^= value + 0x9e3779b9 + ( tokensHash << 6 ) + ( tokensHash >> 2 );
+	}
+
+	GlyphRun& run = mGlyphRuns[index];
+
+	if ( NULL == run.texture || run.lineHash != docLine.getHash() ||
+		 run.tokensHash != tokensHash ) {
+		run.lineHash = docLine.getHash();
+		run.tokensHash = tokensHash;
+
+		if ( !buildGlyphRun( run, index, fontSize, lineHeight ) ) {
+			mGlyphRuns.erase( index );
+			drawLineTextUncached( index, position, fontSize, lineHeight );
+			return;
+		}
+	}
+
+	if ( !run.backgrounds.empty() ) {
+		Primitives primitives;
+		for ( const auto& background : run.backgrounds ) {
+			primitives.setColor( background.second );
+			primitives.drawRectangle( Rectf( background.first.getPosition() + position,
+											 background.first.getSize() ) );
+		}
+	}
+
+	Text::drawGeometry( run.texture, run.vertices, run.colors, position );
+}
+
+void UICodeEditor::drawLineTextUncached( const Int64& index, Vector2f position,
+										 const Float& fontSize, const Float& lineHeight ) {
 	auto& tokens = mHighlighter.getLine( index );
+	const String& lineText = mDoc->line( index ).getText();
 	Primitives primitives;
+	Text line( "", mFont, fontSize );
+	line.setTabWidth( mTabWidth );
 	for ( auto& token : tokens ) {
-		Float textWidth = getTextWidth( token.text );
+		String text( lineText.substr( token.start, token.len ) );
+		Float textWidth = getTextWidth( text );
 		if ( position.x + textWidth >= mScreenPos.x &&
 			 position.x <= mScreenPos.x + mSize.getWidth() ) {
-			Text line( "", mFont, fontSize );
-			line.setTabWidth( mTabWidth );
 			const SyntaxColorScheme::Style& style = mColorScheme.getSyntaxStyle( token.type );
 			line.setStyleConfig( mFontStyleConfig );
 			if ( style.style )
@@ -1806,7 +1943,7 @@ void UICodeEditor::drawLineText( const Int64& index, Vector2f position, const Fl
 				primitives.drawRectangle( Rectf( position, Sizef( textWidth, lineHeight ) ) );
 			}
 			line.setColor( Color( style.color ).blendAlpha( mAlpha ) );
-			line.setString( token.text );
+			line.setString( text );
 			line.draw( position.x, position.y );
 		} else if ( position.x > mScreenPos.x + mSize.getWidth() ) {
 			break;
@@ -0,0 +1,580 @@
+#include <cstring>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/iostreamfile.hpp>
+#include <eepp/system/packmanager.hpp>
+#include <eepp/system/scopedbuffer.hpp>
+#include <eepp/ui/css/keyframesdefinition.hpp>
+#include <eepp/ui/css/shorthanddefinition.hpp>
+#include <eepp/ui/css/stylesheetparser.hpp>
+#include <eepp/ui/css/stylesheetselectorrule.hpp>
+#include <eepp/ui/css/stylesheetspecification.hpp>
+#include <eepp/ui/uicompiledlayout.hpp>
+#include <pugixml/pugixml.hpp>
+#include <unordered_map>
+
+using namespace EE::UI::CSS;
+
+namespace EE { namespace UI {
+
+#define UI_COMPILED_LAYOUT_MAGIC "EEUILAYT"
+#define UI_COMPILED_LAYOUT_VERSION 1
+
+namespace {
+
+enum PropertyFlags : Uint8 { PropertyImportant = 1 << 0, PropertyVolatile = 1 << 1 };
+
+class BufferWriter {
+  public:
+	std::string data;
+
+	void write( const void* value, size_t size ) {
+		data.append( reinterpret_cast<const char*>( value ), size );
+	}
+
+	void writeUint8( Uint8 value ) { write( &value, sizeof( value ) ); }
+
+	void writeUint32( Uint32 value ) { write( &value, sizeof( value ) ); }
+
+	void writeFloat( Float value ) { write( &value, sizeof( value ) ); }
+
+	void patchUint32( size_t offset, Uint32 value ) {
+		memcpy( &data[offset], &value, sizeof( value ) );
+	}
+};
+
+// Every read is bounds checked, a truncated or corrupted buffer only invalidates the reader.
+class BufferReader {
+  public:
+	BufferReader( const char* data, size_t size ) :
+		mPtr( data ), mEnd( data + size ), mValid( true ) {}
+
+	bool read( void* value, size_t size ) {
+		if ( !mValid || static_cast<size_t>( mEnd - mPtr ) < size ) {
+			mValid = false;
+			return false;
+		}
+		memcpy( value, mPtr, size );
+		mPtr += size;
+		return true;
+	}
+
+	Uint8 readUint8() {
+		Uint8 value = 0;
+		read( &value, sizeof( value ) );
+		return value;
+	}
+
+	Uint32 readUint32() {
+		Uint32 value = 0;
+		read( &value, sizeof( value ) );
+		return value;
+	}
+
+	Float readFloat() {
+		Float value = 0;
+		read( &value, sizeof( value ) );
+		return value;
+	}
+
+	std::string readString() {
+		Uint32 length = readUint32();
+		if ( !mValid || static_cast<size_t>( mEnd - mPtr ) < length ) {
+			mValid = false;
+			return std::string();
+		}
+		std::string str( mPtr, length );
+		mPtr += length;
+		return str;
+	}
+
+	// Reads the number of elements of a table, every element takes at least a byte.
+	Uint32 readCount() {
+		Uint32 count = readUint32();
+		if ( count > static_cast<size_t>( mEnd - mPtr ) )
+			mValid = false;
+		return mValid ? count : 0;
+	}
+
+	// Reads an element of a table, an index out of range invalidates the reader.
+	template <typename T> const T& readIndexed( const std::vector<T>& table, const T& invalid ) {
+		Uint32 index = readUint32();
+		if ( index >= table.size() )
+			mValid = false;
+		return mValid ? table[index] : invalid;
+	}
+
+	const bool& isValid() const { return mValid; }
+
+  protected:
+	const char* mPtr;
+	const char* mEnd;
+	bool mValid;
+};
+
+class StringXmlWriter : public pugi::xml_writer {
+  public:
+	std::string data;
+
+	virtual void write( const void* buffer, size_t size ) {
+		data.append( reinterpret_cast<const char*>( buffer ), size );
+	}
+};
+
+static bool isWidgetName( const std::string& name ) {
+	return static_cast<bool>( UIWidgetCreator::getWidgetFactory( name ) );
+}
+
+// A widget with child elements that are not widgets nor styles reads them on loadFromXmlNode.
+static bool hasItemChildren( const pugi::xml_node& node ) {
+	for ( pugi::xml_node child = node.first_child(); child; child = child.next_sibling() ) {
+		if ( child.type() != pugi::node_element )
+			continue;
+
+		std::string name( String::toLower( std::string( child.name() ) ) );
+
+		if ( name != "style" && !isWidgetName( name ) )
+			return true;
+	}
+
+	return false;
+}
+
+class LayoutCompiler {
+  public:
+	// Compiles the node and its siblings, returns the number of nodes written.
+	Uint32 compileNodes( pugi::xml_node node, Uint32& count ) {
+		Uint32 written = 0;
+
+		for ( pugi::xml_node widget = node; widget; widget = widget.next_sibling() ) {
+			std::string name( String::toLower( std::string( widget.name() ) ) );
+
+			if ( isWidgetName( name ) ) {
+				if ( hasItemChildren( widget ) ) {
+					StringXmlWriter writer;
+					widget.print( writer, "", pugi::format_raw );
+					writeNodeHeader( UICompiledLayout::Fragment, intern( writer.data ) );
+					mNodes.writeUint32( 0 );
+				} else {
+					size_t offset = writeNodeHeader( UICompiledLayout::Widget, getType( name ) );
+					writeAttributes( widget );
+
+					Uint32 childCount = 0;
+					Uint32 descendantCount =
+						widget.first_child() ? compileNodes( widget.first_child(), childCount ) : 0;
+
+					mNodes.patchUint32( offset, childCount );
+					mNodes.patchUint32( offset + sizeof( Uint32 ), descendantCount );
+					written += descendantCount;
+				}
+			} else if ( name == "style" ) {
+				StyleSheetParser parser;
+
+				if ( !parser.loadFromString( widget.text().as_string() ) )
+					continue;
+
+				writeNodeHeader( UICompiledLayout::Style, mStyleSheetCount++ );
+				mNodes.writeUint32( 0 );
+				writeStyleSheet( parser.getStyleSheet() );
+			} else {
+				continue;
+			}
+
+			count++;
+			written++;
+		}
+
+		return written;
+	}
+
+	void write( IOStream& stream ) {
+		BufferWriter header;
+		header.write( UI_COMPILED_LAYOUT_MAGIC, 8 );
+		header.writeUint32( UI_COMPILED_LAYOUT_VERSION );
+
+		header.writeUint32( mStrings.size() );
+		for ( auto& str : mStrings ) {
+			header.writeUint32( str.size() );
+			header.write( str.data(), str.size() );
+		}
+
+		for ( auto* table : { &mTypes, &mPropertyNames, &mMediaQueries } ) {
+			header.writeUint32( table->size() );
+			for ( auto& index : *table )
+				header.writeUint32( index );
+		}
+
+		header.writeUint32( mStyleSheetCount );
+		header.writeUint32( mNodeCount );
+
+		stream.write( header.data.data(), header.data.size() );
+		stream.write( mStyleSheets.data.data(), mStyleSheets.data.size() );
+		stream.write( mNodes.data.data(), mNodes.data.size() );
+	}
+
+  protected:
+	std::vector<std::string> mStrings;
+	std::unordered_map<std::string, Uint32> mStringIds;
+	std::vector<Uint32> mTypes;
+	std::unordered_map<std::string, Uint32> mTypeIds;
+	std::vector<Uint32> mPropertyNames;
+	std::unordered_map<std::string, Uint32> mPropertyNameIds;
+	std::vector<Uint32> mMediaQueries;
+	std::unordered_map<std::string, Uint32> mMediaQueryIds;
+	BufferWriter mStyleSheets;
+	Uint32 mStyleSheetCount{ 0 };
+	BufferWriter mNodes;
+	Uint32 mNodeCount{ 0 };
+
+	Uint32 intern( const std::string& str ) {
+		auto it = mStringIds.find( str );
+		if ( it != mStringIds.end() )
+			return it->second;
+		mStrings.push_back( str );
+		return mStringIds[str] = mStrings.size() - 1;
+	}
+
+	Uint32 getTableIndex( std::vector<Uint32>& table,
+						  std::unordered_map<std::string, Uint32>& ids, const std::string& str ) {
+		auto it = ids.find( str );
+		if ( it != ids.end() )
+			return it->second;
+		table.push_back( intern( str ) );
+		return ids[str] = table.size() - 1;
+	}
+
+	Uint32 getType( const std::string& name ) { return getTableIndex( mTypes, mTypeIds, name ); }
+
+	// The styles with the same media query share the list, 0 means no media query.
+	Uint32 getMediaQuery( const MediaQueryList::ptr& list ) {
+		return list ? getTableIndex( mMediaQueries, mMediaQueryIds, list->getQueryString() ) + 1
+					: 0;
+	}
+
+	// Writes the type and the index of the node, the child count and the descendant count are
+	// returned to be patched.
+	size_t writeNodeHeader( UICompiledLayout::NodeType type, Uint32 index ) {
+		mNodeCount++;
+		mNodes.writeUint8( type );
+		mNodes.writeUint32( index );
+		size_t offset = mNodes.data.size();
+		mNodes.writeUint32( 0 );
+		mNodes.writeUint32( 0 );
+		return offset;
+	}
+
+	void writeProperty( BufferWriter& writer, const StyleSheetProperty& property ) {
+		writer.writeUint32(
+			getTableIndex( mPropertyNames, mPropertyNameIds, property.getName() ) );
+		writer.writeUint32( intern( property.getValue() ) );
+		writer.writeUint32( property.getSpecificity() );
+		writer.writeUint8( ( property.isImportant() ? PropertyImportant : 0 ) |
+						   ( property.isVolatile() ? PropertyVolatile : 0 ) );
+	}
+
+	void writeProperties( BufferWriter& writer, const StyleSheetProperties& properties ) {
+		writer.writeUint32( properties.size() );
+		for ( auto& property : properties )
+			writeProperty( writer, property.second );
+	}
+
+	// The attributes are converted to properties as UIWidget::loadFromXmlNode does.
+	void writeAttributes( const pugi::xml_node& node ) {
+		std::vector<StyleSheetProperty> properties;
+
+		for ( pugi::xml_attribute_iterator ait = node.attributes_begin();
+			  ait != node.attributes_end(); ++ait ) {
+			StyleSheetProperty prop( ait->name(), ait->value(), false,
+									 StyleSheetSelectorRule::SpecificityInline );
+
+			if ( prop.getShorthandDefinition() != NULL ) {
+				auto shorthandProperties = prop.getShorthandDefinition()->parse( ait->value() );
+
+				for ( auto& property : shorthandProperties )
+					properties.emplace_back( std::move( property ) );
+			} else {
+				properties.emplace_back( std::move( prop ) );
+			}
+		}
+
+		mNodes.writeUint32( properties.size() );
+		for ( auto& property : properties )
+			writeProperty( mNodes, property );
+	}
+
+	void writeStyleSheet( const StyleSheet& styleSheet ) {
+		mStyleSheets.writeUint32( styleSheet.getStyles().size() );
+
+		for ( auto& style : styleSheet.getStyles() ) {
+			mStyleSheets.writeUint32( intern( style->getSelector().getName() ) );
+			mStyleSheets.writeUint32( getMediaQuery( style->getMediaQueryList() ) );
+			writeProperties( mStyleSheets, style->getProperties() );
+
+			mStyleSheets.writeUint32( style->getVariables().size() );
+			for ( auto& variable : style->getVariables() ) {
+				mStyleSheets.writeUint32( intern( variable.second.getName() ) );
+				mStyleSheets.writeUint32( intern( variable.second.getValue() ) );
+				mStyleSheets.writeUint32( variable.second.getSpecificity() );
+			}
+		}
+
+		mStyleSheets.writeUint32( styleSheet.getKeyframes().size() );
+
+		for ( auto& keyframes : styleSheet.getKeyframes() ) {
+			mStyleSheets.writeUint32( intern( keyframes.second.getName() ) );
+			mStyleSheets.writeUint32( keyframes.second.getKeyframeBlocks().size() );
+
+			for ( auto& block : keyframes.second.getKeyframeBlocks() ) {
+				mStyleSheets.writeFloat( block.second.normalizedTime );
+				writeProperties( mStyleSheets, block.second.properties );
+			}
+		}
+	}
+};
+
+} // namespace
+
+bool UICompiledLayout::compile( const pugi::xml_node& node, IOStream& stream ) {
+	if ( !stream.isOpen() )
+		return false;
+
+	LayoutCompiler compiler;
+	Uint32 count = 0;
+	compiler.compileNodes( node, count );
+	compiler.write( stream );
+	return true;
+}
+
+bool UICompiledLayout::compileFromString( const std::string& layoutString, IOStream& stream ) {
+	pugi::xml_document doc;
+	pugi::xml_parse_result result = doc.load_string( layoutString.c_str() );
+
+	if ( !result ) {
+		Log::error( "Couldn't compile UI Layout from string: %s", layoutString.c_str() );
+		Log::error( "Error description: %s", result.description() );
+		Log::error( "Error offset: %d", result.offset );
+		return false;
+	}
+
+	return compile( doc.first_child(), stream );
+}
+
+bool UICompiledLayout::compileFromFile( const std::string& layoutPath,
+										const std::string& outputPath ) {
+	pugi::xml_document doc;
+	pugi::xml_parse_result result = doc.load_file( layoutPath.c_str() );
+
+	if ( !result ) {
+		Log::error( "Couldn't compile UI Layout: %s", layoutPath.c_str() );
+		Log::error( "Error description: %s", result.description() );
+		Log::error( "Error offset: %d", result.offset );
+		return false;
+	}
+
+	IOStreamFile stream( outputPath, "wb" );
+	return compile( doc.first_child(), stream );
+}
+
+UICompiledLayout::UICompiledLayout() : mLoaded( false ) {}
+
+bool UICompiledLayout::loadFromFile( const std::string& path ) {
+	if ( FileSystem::fileExists( path ) ) {
+		std::string data;
+		return FileSystem::fileGet( path, data ) && load( data.data(), data.size() );
+	} else if ( PackManager::instance()->isFallbackToPacksActive() ) {
+		std::string packPath( path );
+		Pack* pack = PackManager::instance()->exists( packPath );
+		ScopedBuffer buffer;
+
+		if ( NULL != pack && pack->isOpen() && pack->extractFileToMemory( packPath, buffer ) )
+			return loadFromMemory( buffer.get(), buffer.length() );
+	}
+
+	return false;
+}
+
+bool UICompiledLayout::loadFromMemory( const void* buffer, size_t bufferSize ) {
+	return load( reinterpret_cast<const char*>( buffer ), bufferSize );
+}
+
+bool UICompiledLayout::loadFromStream( IOStream& stream ) {
+	if ( !stream.isOpen() )
+		return false;
+
+	ios_size bufferSize = stream.getSize();
+	TScopedBuffer<char> scopedBuffer( bufferSize );
+	stream.read( scopedBuffer.get(), scopedBuffer.length() );
+	return load( scopedBuffer.get(), scopedBuffer.length() );
+}
+
+const bool& UICompiledLayout::isLoaded() const {
+	return mLoaded;
+}
+
+void UICompiledLayout::clear() {
+	mFactories.clear();
+	mStyleSheets.clear();
+	mFragments.clear();
+	mNodes.clear();
+	mLoaded = false;
+}
+
+bool UICompiledLayout::load( const char* data, size_t size ) {
+	clear();
+
+	BufferReader reader( data, size );
+	char magic[8];
+
+	if ( !reader.read( magic, sizeof( magic ) ) ||
+		 memcmp( magic, UI_COMPILED_LAYOUT_MAGIC, sizeof( magic ) ) != 0 ||
+		 reader.readUint32() != UI_COMPILED_LAYOUT_VERSION ) {
+		Log::error( "UICompiledLayout: invalid compiled layout" );
+		return false;
+	}
+
+	const std::string empty;
+	std::vector<std::string> strings( reader.readCount() );
+	for ( size_t i = 0; i < strings.size() && reader.isValid(); i++ )
+		strings[i] = reader.readString();
+
+	auto readString = [&]() -> const std::string& { return reader.readIndexed( strings, empty ); };
+
+	// The types and the property definitions are resolved once per layout.
+	Uint32 typeCount = reader.readCount();
+	for ( Uint32 i = 0; i < typeCount && reader.isValid(); i++ ) {
+		const std::string& name = readString();
+		mFactories.push_back( UIWidgetCreator::getWidgetFactory( name ) );
+
+		if ( !mFactories.back() && reader.isValid() )
+			Log::warning( "UICompiledLayout: widget %s is not registered", name.c_str() );
+	}
+
+	typedef std::pair<const std::string*, const PropertyDefinition*> PropertyName;
+	const PropertyName invalidName( &empty, NULL );
+	std::vector<PropertyName> propertyNames( reader.readCount() );
+	for ( size_t i = 0; i < propertyNames.size() && reader.isValid(); i++ ) {
+		const std::string& name = readString();
+		propertyNames[i] = std::make_pair(
+			&name, StyleSheetSpecification::instance()->getProperty( String::hash( name ) ) );
+	}
+
+	// Index 0 means no media query.
+	std::vector<MediaQueryList::ptr> mediaQueries( 1 + reader.readCount() );
+	for ( size_t i = 1; i < mediaQueries.size() && reader.isValid(); i++ )
+		mediaQueries[i] = MediaQueryList::parse( readString() );
+
+	Uint32 styleSheetCount = reader.readCount();
+	Uint32 nodeCount = reader.readCount();
+
+	auto readProperty = [&]() {
+		const PropertyName& name = reader.readIndexed( propertyNames, invalidName );
+		const std::string& value = readString();
+		Uint32 specificity = reader.readUint32();
+		Uint8 flags = reader.readUint8();
+		return StyleSheetProperty( *name.first, name.second, value, specificity,
+								   ( flags & PropertyImportant ) != 0,
+								   ( flags & PropertyVolatile ) != 0 );
+	};
+
+	auto readProperties = [&]() {
+		StyleSheetProperties properties;
+		Uint32 count = reader.readCount();
+		for ( Uint32 i = 0; i < count && reader.isValid(); i++ ) {
+			StyleSheetProperty property( readProperty() );
+			properties.emplace( std::make_pair( property.getId(), std::move( property ) ) );
+		}
+		return properties;
+	};
+
+	for ( Uint32 i = 0; i < styleSheetCount && reader.isValid(); i++ ) {
+		StyleSheet styleSheet;
+		Uint32 styleCount = reader.readCount();
+
+		for ( Uint32 s = 0; s < styleCount && reader.isValid(); s++ ) {
+			const std::string& selector = readString();
+			const MediaQueryList::ptr& media = reader.readIndexed( mediaQueries, mediaQueries[0] );
+			StyleSheetProperties properties( readProperties() );
+			StyleSheetVariables variables;
+			Uint32 variableCount = reader.readCount();
+
+			for ( Uint32 v = 0; v < variableCount && reader.isValid(); v++ ) {
+				const std::string& name = readString();
+				const std::string& value = readString();
+				Uint32 specificity = reader.readUint32();
+				variables[String::hash( name )] = StyleSheetVariable( name, value, specificity );
+			}
+
+			if ( reader.isValid() )
+				styleSheet.addStyle(
+					std::make_shared<StyleSheetStyle>( selector, properties, variables, media ) );
+		}
+
+		Uint32 keyframesCount = reader.readCount();
+
+		for ( Uint32 k = 0; k < keyframesCount && reader.isValid(); k++ ) {
+			KeyframesDefinition keyframes;
+			keyframes.name = readString();
+			Uint32 blockCount = reader.readCount();
+
+			for ( Uint32 b = 0; b < blockCount && reader.isValid(); b++ ) {
+				Float time = reader.readFloat();
+				keyframes.keyframeBlocks[time] = { time, readProperties() };
+			}
+
+			styleSheet.addKeyframes( keyframes );
+		}
+
+		mStyleSheets.emplace_back( std::move( styleSheet ) );
+	}
+
+	mNodes.resize( nodeCount );
+
+	for ( Uint32 i = 0; i < nodeCount && reader.isValid(); i++ ) {
+		CompiledNode& node = mNodes[i];
+		node.type = static_cast<NodeType>( reader.readUint8() );
+		node.index = reader.readUint32();
+		node.childCount = reader.readUint32();
+		node.descendantCount = reader.readUint32();
+
+		bool valid = node.descendantCount < nodeCount - i;
+
+		switch ( node.type ) {
+			case Widget:
+				valid = valid && node.index < mFactories.size();
+				break;
+			case Style:
+				valid = valid && node.index < mStyleSheets.size();
+				break;
+			case Fragment:
+				valid = valid && node.index < strings.size();
+				if ( valid ) {
+					mFragments.emplace_back( strings[node.index] );
+					node.index = mFragments.size() - 1;
+				}
+				break;
+			default:
+				valid = false;
+		}
+
+		if ( !valid ) {
+			Log::error( "UICompiledLayout: invalid compiled layout" );
+			clear();
+			return false;
+		}
+
+		Uint32 count = reader.readCount();
+		node.properties.reserve( count );
+		for ( Uint32 p = 0; p < count && reader.isValid(); p++ )
+			node.properties.emplace_back( readProperty() );
+	}
+
+	if ( !reader.isValid() ) {
+		Log::error( "UICompiledLayout: truncated compiled layout" );
+		clear();
+		return false;
+	}
+
+	mLoaded = true;
+	return true;
+}
+
+}} // namespace EE::UI
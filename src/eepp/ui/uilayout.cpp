@@ -7,13 +7,14 @@ UILayout* UILayout::New() {
 	return eeNew( UILayout, () );
 }
 
-UILayout::UILayout() : UIWidget( "layout" ), mDirtyLayout( false ), mPacking( false ) {
+UILayout::UILayout() :
+	UIWidget( "layout" ), mDirtyLayout( false ), mPacking( false ), mLayoutScheduled( false ) {
 	mNodeFlags |= NODE_FLAG_LAYOUT;
 	unsetFlags( UI_TAB_FOCUSABLE );
 }
 
 UILayout::UILayout( const std::string& tag ) :
-	UIWidget( tag ), mDirtyLayout( false ), mPacking( false ) {
+	UIWidget( tag ), mDirtyLayout( false ), mPacking( false ), mLayoutScheduled( false ) {
 	mNodeFlags |= NODE_FLAG_LAYOUT;
 	unsetFlags( UI_TAB_FOCUSABLE );
 }
@@ -87,6 +88,9 @@ void UILayout::tryUpdateLayout() {
 }
 
 void UILayout::updateLayoutTree() {
+	// Any pending update of the descendants is covered by this one.
+	mLayoutScheduled = false;
+
 	updateLayout();
 
 	for ( auto layout : mLayouts ) {
@@ -359,6 +359,14 @@ void UINode::updateDebugData() {
 				String::format( "\nmargin: %.2f %.2f %.2f %.2f", m.Top, m.Right, m.Bottom, m.Left );
 		}
 
+		text += String::format( "\nnodes drawn: %u culled: %u", mSceneNode->getDrawnNodesCount(),
+								mSceneNode->getCulledNodesCount() );
+
+		if ( NULL != mUISceneNode )
+			text += String::format( "\nlayouts updated: %u in %.2f ms",
+									mUISceneNode->getLayoutUpdateCount(),
+									mUISceneNode->getLayoutUpdateTime().asMilliseconds() );
+
 		widget->setTooltipText( text );
 	}
 }
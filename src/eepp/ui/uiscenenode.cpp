@@ -11,6 +11,7 @@
 #include <eepp/system/virtualfilesystem.hpp>
 #include <eepp/ui/css/mediaquery.hpp>
 #include <eepp/ui/css/stylesheetparser.hpp>
+#include <eepp/ui/uicompiledlayout.hpp>
 #include <eepp/ui/uieventdispatcher.hpp>
 #include <eepp/ui/uiiconthememanager.hpp>
 #include <eepp/ui/uilayout.hpp>
@@ -38,7 +39,9 @@ UISceneNode::UISceneNode( EE::Window::Window* window ) :
 	mUpdatingLayouts( false ),
 	mUIThemeManager( UIThemeManager::New() ),
 	mUIIconThemeManager( UIIconThemeManager::New()->setFallbackThemeManager( mUIThemeManager ) ),
-	mKeyBindings( mWindow->getInput() ) {
+	mKeyBindings( mWindow->getInput() ),
+	mLayoutUpdateCount( 0 ),
+	mFrameLayoutUpdateCount( 0 ) {
 	// Reset size since the SceneNode already set it but needs to set the size from zero to emmit
 	// the required events to its childs.
 	mSize = Sizef();
@@ -204,14 +207,67 @@ std::vector<UIWidget*> UISceneNode::loadNode( pugi::xml_node node, Node* parent
 	return rootWidgets;
 }
 
+std::vector<UIWidget*> UISceneNode::loadCompiledNodes( const UICompiledLayout& layout,
+													   size_t& index, size_t count, Node* parent ) {
+	std::vector<UIWidget*> rootWidgets;
+
+	if ( NULL == parent )
+		parent = this;
+
+	for ( size_t i = 0; i < count && index < layout.mNodes.size(); i++ ) {
+		const UICompiledLayout::CompiledNode& node = layout.mNodes[index++];
+
+		switch ( node.type ) {
+			case UICompiledLayout::Widget: {
+				const UIWidgetCreator::RegisterWidgetCb& factory = layout.mFactories[node.index];
+				UIWidget* uiwidget = factory ? factory() : NULL;
+
+				if ( NULL == uiwidget ) {
+					index += node.descendantCount;
+					break;
+				}
+
+				rootWidgets.push_back( uiwidget );
+
+				uiwidget->setParent( parent );
+				uiwidget->loadFromProperties( node.properties );
+
+				loadCompiledNodes( layout, index, node.childCount, uiwidget );
+
+				uiwidget->onWidgetCreated();
+				break;
+			}
+			case UICompiledLayout::Style:
+				combineStyleSheet( layout.mStyleSheets[node.index], false );
+				break;
+			case UICompiledLayout::Fragment: {
+				pugi::xml_document doc;
+
+				if ( doc.load_string( layout.mFragments[node.index].c_str() ) ) {
+					std::vector<UIWidget*> widgets = loadNode( doc.first_child(), parent );
+					rootWidgets.insert( rootWidgets.end(), widgets.begin(), widgets.end() );
+				}
+				break;
+			}
+		}
+	}
+
+	return rootWidgets;
+}
+
 UIWidget* UISceneNode::loadLayoutNodes( pugi::xml_node node, Node* parent ) {
+	return loadLayout( node.attribute( "id" ).as_string(),
+					   [&]() { return loadNode( node, parent ); } );
+}
+
+UIWidget* UISceneNode::loadLayout( const std::string& id,
+								   const std::function<std::vector<UIWidget*>()>& loadNodes ) {
 	Clock clock;
 	UISceneNode* prevUISceneNode = SceneManager::instance()->getUISceneNode();
 	SceneManager::instance()->setCurrentUISceneNode( this );
-	std::string id( node.attribute( "id" ).as_string() );
 	mIsLoading = true;
 	Clock innerClock;
-	std::vector<UIWidget*> widgets = loadNode( node, parent );
+	std::vector<UIWidget*> widgets = loadNodes();
 
 	if ( mVerbose ) {
 		std::sort(
@@ -225,7 +281,7 @@ UIWidget* UISceneNode::loadLayoutNodes( pugi::xml_node node, Node* parent ) {
 
 		mTimes.clear();
 
-		Log::debug( "UISceneNode::loadLayoutNodes loaded nodes%s in: %.2f ms",
+		Log::debug( "UISceneNode::loadLayout loaded nodes%s in: %.2f ms",
 					id.empty() ? "" : std::string( " (id=" + id + ")" ).c_str(),
 					innerClock.getElapsed().asMilliseconds() );
 	}
@@ -234,7 +290,7 @@ UIWidget* UISceneNode::loadLayoutNodes( pugi::xml_node node, Node* parent ) {
 		widget->reloadStyle( true, true, true );
 
 	if ( mVerbose ) {
-		Log::debug( "UISceneNode::loadLayoutNodes reloaded styles in: %.2f ms",
+		Log::debug( "UISceneNode::loadLayout reloaded styles in: %.2f ms",
 					innerClock.getElapsed().asMilliseconds() );
 	}
 
@@ -242,7 +298,7 @@ UIWidget* UISceneNode::loadLayoutNodes( pugi::xml_node node, Node* parent ) {
 	SceneManager::instance()->setCurrentUISceneNode( prevUISceneNode );
 
 	if ( mVerbose ) {
-		Log::debug( "UISceneNode::loadLayoutNodes loaded in: %.2f ms",
+		Log::debug( "UISceneNode::loadLayout loaded in: %.2f ms",
 					clock.getElapsedTime().asMilliseconds() );
 	}
 
@@ -288,8 +344,24 @@ bool UISceneNode::hasStyleSheet() {
 	return !mStyleSheet.isEmpty();
 }
 
+static void getWidgets( Node* node, std::vector<UIWidget*>& widgets ) {
+	for ( Node* child = node->getFirstChild(); NULL != child; child = child->getNextNode() ) {
+		if ( child->isWidget() )
+			widgets.push_back( child->asType<UIWidget>() );
+		getWidgets( child, widgets );
+	}
+}
+
 void UISceneNode::reloadStyle( const bool& disableAnimations ) {
 	if ( NULL != mChild ) {
+		if ( mThreadPool ) {
+			// Matching the selectors is the expensive part of the restyle, the styles are resolved
+			// in parallel first so that reloading each widget only hits the style cache.
+			std::vector<UIWidget*> widgets;
+			getWidgets( this, widgets );
+			mStyleSheet.preloadElementStyles( widgets, *mThreadPool );
+		}
+
 		Node* child = mChild;
 
 		while ( NULL != child ) {
@@ -389,6 +461,41 @@ UIWidget* UISceneNode::loadLayoutFromPack( Pack* pack, const std::string& FilePa
 	return NULL;
 }
 
+UIWidget* UISceneNode::loadLayoutFromCompiled( const UICompiledLayout& layout, Node* parent ) {
+	if ( !layout.isLoaded() )
+		return NULL;
+
+	return loadLayout( "", [&]() {
+		size_t index = 0;
+		return loadCompiledNodes( layout, index, layout.mNodes.size(),
+								  NULL != parent ? parent : this );
+	} );
+}
+
+UIWidget* UISceneNode::loadLayoutFromCompiledFile( const std::string& layoutPath,
+												   Node* parent ) {
+	UICompiledLayout layout;
+
+	if ( !layout.loadFromFile( layoutPath ) ) {
+		Log::error( "Couldn't load compiled UI Layout: %s", layoutPath.c_str() );
+		return NULL;
+	}
+
+	return loadLayoutFromCompiled( layout, parent );
+}
+
+UIWidget* UISceneNode::loadLayoutFromCompiledMemory( const void* buffer, size_t bufferSize,
+													 Node* parent ) {
+	UICompiledLayout layout;
+
+	if ( !layout.loadFromMemory( buffer, bufferSize ) ) {
+		Log::error( "Couldn't load compiled UI Layout from buffer" );
+		return NULL;
+	}
+
+	return loadLayoutFromCompiled( layout, parent );
+}
+
 void UISceneNode::setInternalSize( const Sizef& size ) {
 	if ( size != mDpSize ) {
 		mDpSize = size;
@@ -475,6 +582,11 @@ void UISceneNode::update( const Time& elapsed ) {
 		invalidationDepth--;
 	}
 
+	mLayoutUpdateTime = mFrameLayoutUpdateTime;
+	mLayoutUpdateCount = mFrameLayoutUpdateCount;
+	mFrameLayoutUpdateTime = Time::Zero;
+	mFrameLayoutUpdateCount = 0;
+
 	SceneManager::instance()->setCurrentUISceneNode( uiSceneNode );
 }
 
@@ -483,7 +595,9 @@ void UISceneNode::onWidgetDelete( Node* node ) {
 		UIWidget* widget = node->asType<UIWidget>();
 
 		if ( node->isLayout() ) {
-			mDirtyLayouts.erase( node->asType<UILayout>() );
+			UILayout* layout = node->asType<UILayout>();
+			layout->mLayoutScheduled = false;
+			mDirtyLayouts.erase( layout );
 		}
 
 		mDirtyStyle.erase( widget );
@@ -588,39 +702,21 @@ void UISceneNode::invalidateStyleState( UIWidget* node, bool disableCSSAnimation
 void UISceneNode::invalidateLayout( UILayout* node ) {
 	eeASSERT( NULL != node );
 
-	if ( node->isClosing() )
-		return;
-
-	Node* itNode = NULL;
-
-	if ( mDirtyLayouts.count( node ) > 0 )
+	if ( node->isClosing() || node->mLayoutScheduled )
 		return;
 
-	if ( node->getParent()->isLayout() ) {
-		for ( auto& dirtyNode : mDirtyLayouts ) {
-			if ( NULL != dirtyNode && dirtyNode->isParentOf( node ) &&
-				 node->getParent()->isLayout() ) {
-				return;
-			}
-		}
-
-		std::vector<std::unordered_set<UILayout*>::iterator> itEraseList;
+	// An ancestor layout waiting for its update will also update this one, since the layout trees
+	// are updated through their child layouts. Any dirty descendant is skipped when updated.
+	Node* parent = node->getParent();
 
-		for ( auto it = mDirtyLayouts.begin(); it != mDirtyLayouts.end(); ++it ) {
-			itNode = *it;
-
-			if ( NULL != itNode && node->isParentOf( itNode ) && itNode->getParent()->isLayout() ) {
-				itEraseList.push_back( it );
-			} else if ( NULL == itNode ) {
-				itEraseList.push_back( it );
-			}
-		}
+	while ( NULL != parent && parent->isLayout() ) {
+		if ( parent->asType<UILayout>()->mLayoutScheduled )
+			return;
 
-		for ( auto ite = itEraseList.begin(); ite != itEraseList.end(); ++ite ) {
-			mDirtyLayouts.erase( *ite );
-		}
+		parent = parent->getParent();
 	}
 
+	node->mLayoutScheduled = true;
 	mDirtyLayouts.insert( node );
 }
 
@@ -630,14 +726,44 @@ void UISceneNode::setIsLoading( bool isLoading ) {
 
 void UISceneNode::updateDirtyLayouts() {
 	if ( !mDirtyLayouts.empty() ) {
+		Clock clock;
 		mUpdatingLayouts = true;
 
+		// The layouts are updated top-down, the ancestors first, so every layout is updated once
+		// with the final size of its parent. Updating a layout tree unschedules its descendants.
+		mLayoutUpdateList.clear();
+
 		for ( UILayout* layout : mDirtyLayouts ) {
-			layout->updateLayoutTree();
+			size_t depth = 0;
+
+			for ( Node* node = layout->getParent(); NULL != node; node = node->getParent() )
+				depth++;
+
+			mLayoutUpdateList.emplace_back( depth, layout );
 		}
 
 		mDirtyLayouts.clear();
+
+		std::sort( mLayoutUpdateList.begin(), mLayoutUpdateList.end() );
+
+		Uint32 count = 0;
+
+		for ( auto& item : mLayoutUpdateList ) {
+			if ( item.second->mLayoutScheduled ) {
+				item.second->updateLayoutTree();
+				count++;
+			}
+		}
+
+		mLayoutUpdateList.clear();
 		mUpdatingLayouts = false;
+
+		Time elapsed( clock.getElapsedTime() );
+		mFrameLayoutUpdateTime += elapsed;
+		mFrameLayoutUpdateCount += count;
+
+		if ( mVerbose )
+			Log::debug( "Layouts updated: %u in %.2f ms", count, elapsed.asMilliseconds() );
 	}
 }
 
@@ -673,6 +799,14 @@ const bool& UISceneNode::isUpdatingLayouts() const {
 	return mUpdatingLayouts;
 }
 
+const Time& UISceneNode::getLayoutUpdateTime() const {
+	return mLayoutUpdateTime;
+}
+
+const Uint32& UISceneNode::getLayoutUpdateCount() const {
+	return mLayoutUpdateCount;
+}
+
 UIIconThemeManager* UISceneNode::getUIIconThemeManager() const {
 	return mUIIconThemeManager;
 }
@@ -856,4 +990,12 @@ UIEventDispatcher* UISceneNode::getUIEventDispatcher() const {
 	return static_cast<UIEventDispatcher*>( mEventDispatcher );
 }
 
+void UISceneNode::setThreadPool( std::shared_ptr<ThreadPool> pool ) {
+	mThreadPool = pool;
+}
+
+const std::shared_ptr<ThreadPool>& UISceneNode::getThreadPool() const {
+	return mThreadPool;
+}
+
 }} // namespace EE::UI
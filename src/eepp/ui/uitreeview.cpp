@@ -1,4 +1,4 @@
-#include <deque>
+#include <cstring>
 #include <eepp/graphics/renderer/renderer.hpp>
 #include <eepp/ui/uilinearlayout.hpp>
 #include <eepp/ui/uipushbutton.hpp>
@@ -39,48 +39,93 @@ UITreeView::MetadataForIndex& UITreeView::getIndexMetadata( const ModelIndex& in
 	return mViewMetadata[index.data()];
 }
 
-template <typename Callback> void UITreeView::traverseTree( Callback callback ) const {
-	if ( !getModel() )
-		return;
-	auto& model = *getModel();
-	int indentLevel = 0;
-	Float yOffset = getHeaderHeight();
-	int rowIndex = -1;
-	std::function<IterationDecision( const ModelIndex& )> traverseIndex =
-		[&]( const ModelIndex& index ) {
-			if ( index.isValid() ) {
-				auto& metadata = getIndexMetadata( index );
-				rowIndex++;
-				IterationDecision decision = callback( rowIndex, index, indentLevel, yOffset );
-				if ( decision == IterationDecision::Break || decision == IterationDecision::Stop )
-					return decision;
-				yOffset += getRowHeight();
-				if ( !metadata.open ) {
-					return IterationDecision::Continue;
-				}
-			}
-			if ( indentLevel >= 0 && !index.isValid() )
-				return IterationDecision::Continue;
-			++indentLevel;
-			int rowCount = model.rowCount( index );
-			for ( int i = 0; i < rowCount; ++i ) {
-				IterationDecision decision =
-					traverseIndex( model.index( i, model.treeColumn(), index ) );
-				if ( decision == IterationDecision::Break || decision == IterationDecision::Stop )
-					return decision;
-			}
-			--indentLevel;
-			return IterationDecision::Continue;
-		};
-	int rootCount = model.rowCount();
-	for ( int rootIndex = 0; rootIndex < rootCount; ++rootIndex ) {
+template <typename Callback>
+void UITreeView::traverseTree( Callback callback, size_t fromRow ) const {
+	const auto& rows = getFlatRows();
+	Float rowHeight = getRowHeight();
+	Float yOffset = getHeaderHeight() + fromRow * rowHeight;
+	for ( size_t i = fromRow; i < rows.size(); i++ ) {
 		IterationDecision decision =
-			traverseIndex( model.index( rootIndex, model.treeColumn(), ModelIndex() ) );
+			callback( (int)i, rows[i].index, rows[i].indentLevel, yOffset );
 		if ( decision == IterationDecision::Break || decision == IterationDecision::Stop )
 			break;
+		yOffset += rowHeight;
+	}
+}
+
+void UITreeView::flattenTree( const ModelIndex& parent, size_t indentLevel,
+							  std::vector<FlatRow>& rows ) const {
+	auto& model = *getModel();
+	size_t rowCount = model.rowCount( parent );
+	for ( size_t i = 0; i < rowCount; ++i ) {
+		ModelIndex index( model.index( i, model.treeColumn(), parent ) );
+		if ( !index.isValid() )
+			continue;
+		rows.push_back( { index, indentLevel } );
+		if ( getIndexMetadata( index ).open )
+			flattenTree( index, indentLevel + 1, rows );
 	}
 }
 
+const std::vector<UITreeView::FlatRow>& UITreeView::getFlatRows() const {
+	if ( mFlatRowsDirty ) {
+		mFlatRows.clear();
+		if ( getModel() )
+			flattenTree( {}, 0, mFlatRows );
+		mFlatRowsDirty = false;
+	}
+	return mFlatRows;
+}
+
+size_t UITreeView::getFirstVisibleRow() const {
+	Float rowHeight = getRowHeight();
+	Float first = rowHeight > 0 ? eefloor( ( mScrollOffset.y - getHeaderHeight() ) / rowHeight ) - 1
+								: 0;
+	return first > 0 ? static_cast<size_t>( first ) : 0;
+}
+
+Int64 UITreeView::findFlatRow( const ModelIndex& index ) const {
+	const auto& rows = getFlatRows();
+	if ( !index.isValid() || rows.empty() )
+		return -1;
+	// The indexes searched are usually visible or close to the visible rows.
+	Int64 start = eemin<Int64>( getFirstVisibleRow(), rows.size() - 1 );
+	Int64 count = rows.size();
+	for ( Int64 distance = 0; start + distance < count || start - distance >= 0; distance++ ) {
+		if ( start + distance < count && rows[start + distance].index == index )
+			return start + distance;
+		if ( distance > 0 && start - distance >= 0 && rows[start - distance].index == index )
+			return start - distance;
+	}
+	return -1;
+}
+
+void UITreeView::setExpanded( const ModelIndex& index, bool expanded ) {
+	auto& metadata = getIndexMetadata( index );
+	if ( metadata.open == expanded )
+		return;
+	metadata.open = expanded;
+
+	if ( !mFlatRowsDirty ) {
+		Int64 pos = findFlatRow( index );
+		if ( pos >= 0 ) {
+			size_t indentLevel = mFlatRows[pos].indentLevel;
+			if ( expanded ) {
+				std::vector<FlatRow> rows;
+				flattenTree( index, indentLevel + 1, rows );
+				mFlatRows.insert( mFlatRows.begin() + pos + 1, rows.begin(), rows.end() );
+			} else {
+				size_t last = pos + 1;
+				while ( last < mFlatRows.size() && mFlatRows[last].indentLevel > indentLevel )
+					last++;
+				mFlatRows.erase( mFlatRows.begin() + pos + 1, mFlatRows.begin() + last );
+			}
+		}
+	}
+
+	createOrUpdateColumns();
+}
+
 void UITreeView::createOrUpdateColumns() {
 	if ( !getModel() )
 		return;
@@ -89,12 +134,12 @@ void UITreeView::createOrUpdateColumns() {
 }
 
 size_t UITreeView::getItemCount() const {
-	size_t count = 0;
-	traverseTree( [&]( const int&, const ModelIndex&, const size_t&, const Float& ) {
-		count++;
-		return IterationDecision::Continue;
-	} );
-	return count;
+	return getFlatRows().size();
+}
+
+void UITreeView::onModelUpdate( unsigned flags ) {
+	mFlatRowsDirty = true;
+	UIAbstractTableView::onModelUpdate( flags );
 }
 
 void UITreeView::onColumnSizeChange( const size_t& colIndex, bool fromUserInteraction ) {
@@ -123,10 +168,8 @@ UIWidget* UITreeView::setupCell( UITableCell* widget, UIWidget* rowWidget,
 			auto idx = mouseEvent->getNode()->getParent()->asType<UITableRow>()->getCurIndex();
 			if ( mouseEvent->getFlags() & EE_BUTTON_LMASK ) {
 				if ( getModel()->rowCount( idx ) ) {
-					auto& data = getIndexMetadata( idx );
-					data.open = !data.open;
-					createOrUpdateColumns();
-					onOpenTreeModelIndex( idx, data.open );
+					setExpanded( idx, !isExpanded( idx ) );
+					onOpenTreeModelIndex( idx, isExpanded( idx ) );
 				} else {
 					onOpenModelIndex( idx, event );
 				}
@@ -141,10 +184,8 @@ UIWidget* UITreeView::setupCell( UITableCell* widget, UIWidget* rowWidget,
 					auto idx =
 						mouseEvent->getNode()->getParent()->asType<UITableRow>()->getCurIndex();
 					if ( getModel()->rowCount( idx ) ) {
-						auto& data = getIndexMetadata( idx );
-						data.open = !data.open;
-						createOrUpdateColumns();
-						onOpenTreeModelIndex( idx, data.open );
+						setExpanded( idx, !isExpanded( idx ) );
+						onOpenTreeModelIndex( idx, isExpanded( idx ) );
 					}
 				}
 			}
@@ -280,7 +321,7 @@ void UITreeView::drawChilds() {
 		updateRow( realIndex, index, yOffset )->nodeDraw();
 		realIndex++;
 		return IterationDecision::Continue;
-	} );
+	}, getFirstVisibleRow() );
 
 	if ( mHeader && mHeader->isVisible() )
 		mHeader->nodeDraw();
@@ -317,7 +358,8 @@ Node* UITreeView::overFind( const Vector2f& point ) {
 					if ( pOver )
 						return IterationDecision::Stop;
 					return IterationDecision::Continue;
-				} );
+				},
+				getFirstVisibleRow() );
 			if ( !pOver )
 				pOver = this;
 		}
@@ -342,7 +384,7 @@ void UITreeView::setAllExpanded( const ModelIndex& index, bool expanded ) {
 			setAllExpanded( curIndex, expanded );
 	}
 
-	createOrUpdateColumns();
+	mFlatRowsDirty = true;
 }
 
 void UITreeView::expandAll( const ModelIndex& index ) {
@@ -397,20 +439,47 @@ void UITreeView::setExpandersAsIcons( bool expandersAsIcons ) {
 	mExpandersAsIcons = expandersAsIcons;
 }
 
-Float UITreeView::getMaxColumnContentWidth( const size_t& colIndex, bool ) {
+Float UITreeView::getMaxColumnContentWidth( const size_t& colIndex, bool bestGuess ) {
 	Float lWidth = 0;
+	const auto& rows = getFlatRows();
+	if ( rows.empty() )
+		return lWidth;
 	getUISceneNode()->setIsLoading( true );
-	traverseTree( [&, colIndex]( const int&, const ModelIndex& index, const size_t& indentLevel,
-								 const Float& yOffset ) {
-		UIWidget* widget = updateCell(
-			0, getModel()->index( index.row(), colIndex, index.parent() ), indentLevel, yOffset );
+	Float yOffset = getHeaderHeight();
+	auto worstCaseFunc = [&]( const FlatRow& row ) {
+		UIWidget* widget =
+			updateCell( 0, getModel()->index( row.index.row(), colIndex, row.index.parent() ),
+						row.indentLevel, yOffset );
 		if ( widget->isType( UI_TYPE_PUSHBUTTON ) ) {
 			Float w = widget->asType<UIPushButton>()->getContentSize().getWidth();
 			if ( w > lWidth )
 				lWidth = w;
 		}
-		return IterationDecision::Continue;
-	} );
+	};
+	if ( bestGuess ) {
+		// Only the rows with the longest text are measured, an indentation level is counted as
+		// two characters.
+		std::multimap<size_t, size_t> lengths;
+		for ( size_t i = 0; i < rows.size(); i++ ) {
+			Variant data( getModel()->data(
+				getModel()->index( rows[i].index.row(), colIndex, rows[i].index.parent() ) ) );
+			size_t length = data.is( Variant::Type::String ) ? data.asString().length()
+							: data.is( Variant::Type::cstr ) ? strlen( data.asCStr() )
+															 : 0;
+			if ( (Int64)colIndex == (Int64)getModel()->treeColumn() )
+				length += rows[i].indentLevel * 2;
+			if ( lengths.size() < 10 || length > lengths.begin()->first ) {
+				lengths.insert( { length, i } );
+				if ( lengths.size() > 10 )
+					lengths.erase( lengths.begin() );
+			}
+		}
+		for ( auto& length : lengths )
+			worstCaseFunc( rows[length.second] );
+	} else {
+		for ( const auto& row : rows )
+			worstCaseFunc( row );
+	}
 	getUISceneNode()->setIsLoading( false );
 	return lWidth;
 }
@@ -428,77 +497,43 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 
 	switch ( event.getKeyCode() ) {
 		case KEY_PAGEUP: {
-			int pageSize = eefloor( getVisibleArea().getHeight() / getRowHeight() ) - 1;
-			std::deque<std::pair<ModelIndex, Float>> deque;
-			Float curY;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					deque.push_back( { index, offsetY } );
-					if ( (int)deque.size() > pageSize )
-						deque.pop_front();
-					if ( index == curIndex )
-						return IterationDecision::Break;
-					return IterationDecision::Continue;
-				} );
-			curY = deque.front().second - getHeaderHeight();
-			getSelection().set( deque.front().first );
+			const auto& rows = getFlatRows();
+			if ( rows.empty() )
+				return 1;
+			Int64 pageSize =
+				eemax<Int64>( 1, eefloor( getVisibleArea().getHeight() / getRowHeight() ) - 1 );
+			Int64 pos = findFlatRow( curIndex );
+			if ( pos < 0 )
+				pos = rows.size() - 1;
+			Int64 target = eemax<Int64>( 0, pos - pageSize + 1 );
+			Float curY = target * getRowHeight();
+			getSelection().set( rows[target].index );
 			scrollToPosition(
 				{ { mScrollOffset.x, curY },
-				  { columnData( deque.front().first.column() ).width, getRowHeight() } } );
+				  { columnData( rows[target].index.column() ).width, getRowHeight() } } );
 			return 1;
 		}
 		case KEY_PAGEDOWN: {
-			int pageSize = eefloor( getVisibleArea().getHeight() / getRowHeight() ) - 1;
-			int counted = 0;
-			bool foundStart = false;
-			bool resultFound = false;
-			ModelIndex foundIndex;
-			Float curY;
-			Float lastOffsetY;
-			ModelIndex lastIndex;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					if ( index == curIndex ) {
-						foundStart = true;
-					} else if ( foundStart ) {
-						counted++;
-						if ( counted == pageSize ) {
-							foundIndex = index;
-							curY = offsetY;
-							resultFound = true;
-							return IterationDecision::Break;
-						}
-					}
-					lastOffsetY = offsetY;
-					lastIndex = index;
-					return IterationDecision::Continue;
-				} );
-			if ( !resultFound ) {
-				foundIndex = lastIndex;
-				curY = lastOffsetY;
-			}
-			curY += getRowHeight();
-			getSelection().set( foundIndex );
-			scrollToPosition( { { mScrollOffset.x, curY },
-								{ columnData( foundIndex.column() ).width, getRowHeight() } } );
+			const auto& rows = getFlatRows();
+			if ( rows.empty() )
+				return 1;
+			Int64 pageSize =
+				eemax<Int64>( 1, eefloor( getVisibleArea().getHeight() / getRowHeight() ) - 1 );
+			Int64 pos = findFlatRow( curIndex );
+			Int64 last = rows.size() - 1;
+			Int64 target = pos >= 0 ? eemin<Int64>( pos + pageSize, last ) : last;
+			Float curY = getHeaderHeight() + target * getRowHeight() + getRowHeight();
+			getSelection().set( rows[target].index );
+			scrollToPosition(
+				{ { mScrollOffset.x, curY },
+				  { columnData( rows[target].index.column() ).width, getRowHeight() } } );
 			return 1;
 		}
 		case KEY_UP: {
-			ModelIndex prevIndex;
-			ModelIndex foundIndex;
-			Float curY = 0;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					if ( index == curIndex ) {
-						foundIndex = prevIndex;
-						curY = offsetY;
-						return IterationDecision::Break;
-					}
-					prevIndex = index;
-					return IterationDecision::Continue;
-				} );
-			if ( foundIndex.isValid() ) {
-				getSelection().set( foundIndex );
+			Int64 pos = findFlatRow( curIndex );
+			if ( pos > 0 ) {
+				Float curY = getHeaderHeight() + pos * getRowHeight();
+				getSelection().set( getFlatRows()[pos - 1].index );
 				if ( curY < mScrollOffset.y + getHeaderHeight() + getRowHeight() ||
 					 curY > mScrollOffset.y + getPixelsSize().getHeight() - mPaddingPx.Top -
 								mPaddingPx.Bottom - getRowHeight() ) {
@@ -510,21 +545,15 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 			return 1;
 		}
 		case KEY_DOWN: {
-			ModelIndex prevIndex;
-			ModelIndex foundIndex;
-			Float curY = 0;
-			traverseTree(
-				[&]( const int&, const ModelIndex& index, const size_t&, const Float& offsetY ) {
-					if ( prevIndex == curIndex ) {
-						foundIndex = index;
-						curY = offsetY;
-						return IterationDecision::Break;
-					}
-					prevIndex = index;
-					return IterationDecision::Continue;
-				} );
-			if ( foundIndex.isValid() ) {
-				getSelection().set( foundIndex );
+			const auto& rows = getFlatRows();
+			// Without selection the first row is selected.
+			Int64 target = curIndex.isValid() ? findFlatRow( curIndex ) : -1;
+			if ( curIndex.isValid() && target < 0 )
+				return 1;
+			target++;
+			if ( target < (Int64)rows.size() ) {
+				Float curY = getHeaderHeight() + target * getRowHeight();
+				getSelection().set( rows[target].index );
 				if ( curY < mScrollOffset.y ||
 					 curY > mScrollOffset.y + getPixelsSize().getHeight() - mPaddingPx.Top -
 								mPaddingPx.Bottom - getRowHeight() ) {
@@ -539,12 +568,8 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		}
 		case KEY_END: {
 			scrollToBottom();
-			ModelIndex lastIndex;
-			traverseTree( [&]( const int&, const ModelIndex& index, const size_t&, const Float& ) {
-				lastIndex = index;
-				return IterationDecision::Continue;
-			} );
-			getSelection().set( lastIndex );
+			const auto& rows = getFlatRows();
+			getSelection().set( rows.empty() ? ModelIndex() : rows.back().index );
 			return 1;
 		}
 		case KEY_HOME: {
@@ -554,10 +579,8 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		}
 		case KEY_RIGHT: {
 			if ( curIndex.isValid() && getModel()->rowCount( curIndex ) ) {
-				auto& metadata = getIndexMetadata( curIndex );
-				if ( !metadata.open ) {
-					metadata.open = true;
-					createOrUpdateColumns();
+				if ( !isExpanded( curIndex ) ) {
+					setExpanded( curIndex, true );
 					return 0;
 				}
 				getSelection().set( getModel()->index( 0, getModel()->treeColumn(), curIndex ) );
@@ -566,10 +589,8 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		}
 		case KEY_LEFT: {
 			if ( curIndex.isValid() && getModel()->rowCount( curIndex ) ) {
-				auto& metadata = getIndexMetadata( curIndex );
-				if ( metadata.open ) {
-					metadata.open = false;
-					createOrUpdateColumns();
+				if ( isExpanded( curIndex ) ) {
+					setExpanded( curIndex, false );
 					return 0;
 				}
 			}
@@ -583,9 +604,7 @@ Uint32 UITreeView::onKeyDown( const KeyEvent& event ) {
 		case KEY_SPACE: {
 			if ( curIndex.isValid() ) {
 				if ( getModel()->rowCount( curIndex ) ) {
-					auto& metadata = getIndexMetadata( curIndex );
-					metadata.open = !metadata.open;
-					createOrUpdateColumns();
+					setExpanded( curIndex, !isExpanded( curIndex ) );
 				} else {
 					onOpenModelIndex( curIndex, &event );
 				}
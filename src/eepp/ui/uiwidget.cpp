@@ -1471,36 +1471,15 @@ bool UIWidget::applyProperty( const StyleSheetProperty& attribute ) {
 			setSkinColor( attribute.asColor() );
 			break;
 		case PropertyId::Gravity: {
-			std::string gravity = attribute.asString();
-			String::toLowerInPlace( gravity );
-			std::vector<std::string> strings = String::split( gravity, '|' );
+			Uint32 gravity;
 
-			if ( strings.empty() ) {
-				strings = String::split( gravity, ' ' );
-			}
-
-			if ( !strings.empty() ) {
-				for ( std::size_t i = 0; i < strings.size(); i++ ) {
-					std::string cur = strings[i];
-					String::toLowerInPlace( cur );
+			if ( attribute.asParsedValue( gravity ) ) {
+				// The masks of the alignments set are kept in the high half.
+				if ( ( gravity >> 16 ) & UI_HALIGN_MASK )
+					setHorizontalAlign( gravity & UI_HALIGN_MASK );
 
-					if ( "left" == cur )
-						setHorizontalAlign( UI_HALIGN_LEFT );
-					else if ( "right" == cur )
-						setHorizontalAlign( UI_HALIGN_RIGHT );
-					else if ( "center_horizontal" == cur )
-						setHorizontalAlign( UI_HALIGN_CENTER );
-					else if ( "top" == cur )
-						setVerticalAlign( UI_VALIGN_TOP );
-					else if ( "bottom" == cur )
-						setVerticalAlign( UI_VALIGN_BOTTOM );
-					else if ( "center_vertical" == cur ) {
-						setVerticalAlign( UI_VALIGN_CENTER );
-					} else if ( "center" == cur ) {
-						setHorizontalAlign( UI_HALIGN_CENTER );
-						setVerticalAlign( UI_VALIGN_CENTER );
-					}
-				}
+				if ( ( gravity >> 16 ) & UI_VALIGN_MASK )
+					setVerticalAlign( gravity & UI_VALIGN_MASK );
 
 				notifyLayoutAttrChange();
 			}
@@ -1559,47 +1538,20 @@ bool UIWidget::applyProperty( const StyleSheetProperty& attribute ) {
 			setLayoutWeight( attribute.asFloat() );
 			break;
 		case PropertyId::LayoutGravity: {
-			std::string gravityStr = attribute.asString();
-			String::toLowerInPlace( gravityStr );
-			std::vector<std::string> strings = String::split( gravityStr, '|' );
-			Uint32 gravity = 0;
-			if ( strings.size() ) {
-				for ( std::size_t i = 0; i < strings.size(); i++ ) {
-					std::string cur = strings[i];
-					String::toLowerInPlace( cur );
-
-					if ( "left" == cur )
-						gravity |= UI_HALIGN_LEFT;
-					else if ( "right" == cur )
-						gravity |= UI_HALIGN_RIGHT;
-					else if ( "center_horizontal" == cur )
-						gravity |= UI_HALIGN_CENTER;
-					else if ( "top" == cur )
-						gravity |= UI_VALIGN_TOP;
-					else if ( "bottom" == cur )
-						gravity |= UI_VALIGN_BOTTOM;
-					else if ( "center_vertical" == cur ) {
-						gravity |= UI_VALIGN_CENTER;
-					} else if ( "center" == cur ) {
-						gravity |= UI_VALIGN_CENTER | UI_HALIGN_CENTER;
-					}
-				}
+			Uint32 gravity;
 
+			if ( attribute.asParsedValue( gravity ) )
 				setLayoutGravity( gravity );
-			}
 			break;
 		}
 		case PropertyId::LayoutWidth: {
-			std::string val = attribute.asString();
-			String::toLowerInPlace( val );
-
-			if ( "match_parent" == val || "match-parent" == val ) {
-				setLayoutWidthPolicy( SizePolicy::MatchParent );
-			} else if ( "wrap_content" == val || "wrap-content" == val ) {
-				setLayoutWidthPolicy( SizePolicy::WrapContent );
-			} else if ( "fixed" == val ) {
-				setLayoutWidthPolicy( SizePolicy::Fixed );
-				unsetFlags( UI_AUTO_SIZE );
+			Uint32 policy;
+
+			if ( attribute.asParsedValue( policy ) ) {
+				setLayoutWidthPolicy( static_cast<SizePolicy>( policy ) );
+
+				if ( SizePolicy::Fixed == static_cast<SizePolicy>( policy ) )
+					unsetFlags( UI_AUTO_SIZE );
 			} else {
 				unsetFlags( UI_AUTO_SIZE );
 				setLayoutWidthPolicy( SizePolicy::Fixed );
@@ -1613,16 +1565,13 @@ bool UIWidget::applyProperty( const StyleSheetProperty& attribute ) {
 			break;
 		}
 		case PropertyId::LayoutHeight: {
-			std::string val = attribute.asString();
-			String::toLowerInPlace( val );
-
-			if ( "match_parent" == val ) {
-				setLayoutHeightPolicy( SizePolicy::MatchParent );
-			} else if ( "wrap_content" == val ) {
-				setLayoutHeightPolicy( SizePolicy::WrapContent );
-			} else if ( "fixed" == val ) {
-				setLayoutHeightPolicy( SizePolicy::Fixed );
-				unsetFlags( UI_AUTO_SIZE );
+			Uint32 policy;
+
+			if ( attribute.asParsedValue( policy ) ) {
+				setLayoutHeightPolicy( static_cast<SizePolicy>( policy ) );
+
+				if ( SizePolicy::Fixed == static_cast<SizePolicy>( policy ) )
+					unsetFlags( UI_AUTO_SIZE );
 			} else {
 				unsetFlags( UI_AUTO_SIZE );
 				setLayoutHeightPolicy( SizePolicy::Fixed );
@@ -1802,6 +1751,18 @@ void UIWidget::loadFromXmlNode( const pugi::xml_node& node ) {
 	endAttributesTransaction();
 }
 
+void UIWidget::loadFromProperties( const std::vector<StyleSheetProperty>& properties ) {
+	beginAttributesTransaction();
+
+	for ( auto& property : properties ) {
+		if ( NULL != mStyle )
+			mStyle->setStyleSheetProperty( property );
+		applyProperty( property );
+	}
+
+	endAttributesTransaction();
+}
+
 std::string UIWidget::getLayoutWidthPolicyString() const {
 	SizePolicy rules = getLayoutWidthPolicy();
 
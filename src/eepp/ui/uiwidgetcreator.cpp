@@ -120,6 +120,26 @@ UIWidget* UIWidgetCreator::createFromName( std::string widgetName ) {
 	return NULL;
 }
 
+UIWidgetCreator::RegisterWidgetCb UIWidgetCreator::getWidgetFactory( std::string widgetName ) {
+	createBaseWidgetList();
+
+	String::toLowerInPlace( widgetName );
+
+	auto registeredIt = registeredWidget.find( widgetName );
+
+	if ( registeredIt != registeredWidget.end() )
+		return registeredIt->second;
+
+	auto callbackIt = widgetCallback.find( widgetName );
+
+	if ( callbackIt != widgetCallback.end() ) {
+		CustomWidgetCb cb( callbackIt->second );
+		return [cb, widgetName]() { return cb( widgetName ); };
+	}
+
+	return RegisterWidgetCb();
+}
+
 void UIWidgetCreator::addCustomWidgetCallback( std::string widgetName,
 											   const UIWidgetCreator::CustomWidgetCb& cb ) {
 	widgetCallback[String::toLower( widgetName )] = cb;
@@ -1633,6 +1633,12 @@ void UIWindow::loadFromXmlNode( const pugi::xml_node& node ) {
 	show();
 }
 
+void UIWindow::loadFromProperties( const std::vector<StyleSheetProperty>& properties ) {
+	UIWidget::loadFromProperties( properties );
+
+	show();
+}
+
 void UIWindow::preDraw() {}
 
 void UIWindow::postDraw() {}
@@ -0,0 +1,161 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+#include <eepp/ui/doc/syntaxhighlighter.hpp>
+#include <random>
+
+using namespace EE::UI::Doc;
+
+// Stress test of the asynchronous SyntaxHighlighter: edits a huge C++ document while it's being
+// highlighted in the thread pool. Every frame updates the highlighter and reads the visible
+// lines, as UICodeEditor does, and some frames edit the document ( opening and closing block
+// comments, removing lines and pasting blocks ). Once the edits finish and the highlighting
+// completes, every line is compared against a synchronous tokenization of the document.
+// Reports the time spent by the frames and the time needed to highlight the whole document.
+// Usage: eepp-highlighter-perf-test [lines] [edits] [threads]
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const int VISIBLE_LINES = 60;
+
+static std::string generateDocument( size_t lines ) {
+	std::string src;
+	for ( size_t i = 0; i < lines; i++ ) {
+		switch ( i % 8 ) {
+			case 0:
+				src += "/* Block comment that spans\n";
+				break;
+			case 1:
+				src += "   two lines " + String::toString( i ) + " */\n";
+				break;
+			case 2:
+				src += "int function_" + String::toString( i ) + "( int value ) {\n";
+				break;
+			case 3:
+				src += "\tconst char* str = \"string \\\" with escapes\"; // comment\n";
+				break;
+			case 4:
+				src += "\treturn value * 0x" + String::toString( i ) + " + 3.14f;\n";
+				break;
+			case 5:
+				src += "}\n";
+				break;
+			case 6:
+				src += "#define MACRO_" + String::toString( i ) + "( x ) ( ( x ) + 1 )\n";
+				break;
+			default:
+				src += "\n";
+				break;
+		}
+	}
+	return src;
+}
+
+static double elapsed( const BenchClock::time_point& start ) {
+	return std::chrono::duration<double, std::milli>( BenchClock::now() - start ).count();
+}
+
+static void edit( TextDocument& doc, SyntaxHighlighter& highlighter, std::mt19937& rng ) {
+	Int64 line = rng() % doc.linesCount();
+
+	switch ( rng() % 4 ) {
+		case 0:
+			doc.insert( { line, 0 }, "/*" );
+			break;
+		case 1:
+			doc.insert( { line, 0 }, "*/\n" );
+			break;
+		case 2:
+			doc.remove( { { line, 0 }, { line + 1, 0 } } );
+			break;
+		default:
+			doc.insert( { line, 0 }, generateDocument( 1000 ) );
+			break;
+	}
+
+	highlighter.invalidate( line );
+}
+
+static size_t verify( TextDocument& doc, SyntaxHighlighter& highlighter ) {
+	int state = SYNTAX_TOKENIZER_STATE_NONE;
+	size_t mismatches = 0;
+
+	for ( size_t i = 0; i < doc.linesCount(); i++ ) {
+		auto res = SyntaxTokenizer::tokenize( doc.getSyntaxDefinition(), doc.line( i ).toUtf8(),
+											  state );
+		const std::vector<SyntaxToken>& tokens = highlighter.getLine( i );
+		state = res.second;
+
+		bool equal = tokens.size() == res.first.size();
+		for ( size_t t = 0; equal && t < tokens.size(); t++ )
+			equal = tokens[t].type == res.first[t].type && tokens[t].start == res.first[t].start &&
+					tokens[t].len == res.first[t].len;
+
+		if ( !equal )
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	size_t lines = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 200000;
+	size_t edits = argc > 2 ? std::strtoul( argv[2], NULL, 10 ) : 500;
+	Uint32 threads = argc > 3 ? std::strtoul( argv[3], NULL, 10 ) : 2;
+	std::string src( generateDocument( lines ) );
+	TextDocument doc( false );
+	std::mt19937 rng( 42 );
+
+	doc.loadFromMemory( (const Uint8*)src.data(), src.size() );
+	doc.setSyntaxDefinition( SyntaxDefinitionManager::instance()->getStyleByLanguageName( "C++" ) );
+
+	SyntaxHighlighter highlighter( &doc );
+	highlighter.setThreadPool( ThreadPool::createShared( eemax<Uint32>( 1, threads ) ) );
+
+	auto start = BenchClock::now();
+	double maxFrame = 0;
+	double totalFrames = 0;
+	size_t frames = 0;
+	size_t done = 0;
+	Int64 scroll = 0;
+
+	while ( done < edits || highlighter.isAsyncRunning() ||
+			highlighter.getFirstInvalidLine() < (Int64)doc.linesCount() ) {
+		auto frameStart = BenchClock::now();
+
+		highlighter.updateDirty( VISIBLE_LINES );
+
+		// Jumps around the document from time to time, as if the user scrolled.
+		if ( frames % 50 == 0 )
+			scroll = rng() % doc.linesCount();
+		for ( Int64 i = scroll; i < eemin<Int64>( scroll + VISIBLE_LINES, doc.linesCount() ); i++ )
+			highlighter.getLine( i );
+
+		if ( done < edits && frames % 5 == 0 ) {
+			edit( doc, highlighter, rng );
+			done++;
+		}
+
+		double frame = elapsed( frameStart );
+		maxFrame = eemax( maxFrame, frame );
+		totalFrames += frame;
+		frames++;
+
+		Sys::sleep( Milliseconds( 1 ) );
+	}
+
+	double total = elapsed( start );
+	size_t mismatches = verify( doc, highlighter );
+
+	std::printf( "SyntaxHighlighter async: %zu lines ( %zu initial ), %u threads, batch %u\n",
+				 doc.linesCount(), lines, threads, highlighter.getAsyncBatchSize() );
+	std::printf( "%-24s %zu\n", "edits", done );
+	std::printf( "%-24s %zu\n", "frames", frames );
+	std::printf( "%-24s %.2f\n", "frame avg ms", totalFrames / frames );
+	std::printf( "%-24s %.2f\n", "frame max ms", maxFrame );
+	std::printf( "%-24s %.2f\n", "highlighted in ms", total );
+	std::printf( "%-24s %zu\n", "mismatched lines", mismatches );
+
+	return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
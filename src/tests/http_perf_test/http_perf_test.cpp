@@ -0,0 +1,593 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+#include <mutex>
+
+// Measures the HTTP async requests throughput ( requests per second ) against a local stand-in
+// server, running every request in its own thread ( as the async requests used to run ) and
+// running them from the async client I/O loop, with and without pipelining.
+// Then checks the response cache against the same server: fresh responses, revalidated
+// responses and responses loaded from the disk store by a new cache, and the responses that must
+// not be stored: bodies that don't fit and responses to requests with credentials.
+// Last checks the segmented downloads against a server of a single file: the ranges requested and
+// the file written, the fallback to a single connection when the server doesn't accept ranges or
+// ignores them, the retry of a failed range and the failure when a range can't be completed.
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const unsigned int SEGMENTS = 4;
+
+// A minimal HTTP/1.1 server: answers every request with the same body, keeps the connections
+// alive and answers the pipelined requests in order. The body has an ETag, the conditional
+// requests with the same ETag are answered with a 304.
+class StandInServer {
+  public:
+	StandInServer( size_t bodySize ) :
+		mBody( bodySize, 'x' ),
+		mRequests( 0 ),
+		mRunning( true ),
+		mThread( &StandInServer::run, this ) {
+		mListener.listen( Socket::AnyPort, IpAddress::LocalHost );
+		mThread.launch();
+	}
+
+	~StandInServer() {
+		mRunning = false;
+		mThread.wait();
+	}
+
+	unsigned short getPort() const { return mListener.getLocalPort(); }
+
+	const std::string& getBody() const { return mBody; }
+
+	size_t getRequestsCount() const { return mRequests; }
+
+	void setCacheControl( const std::string& cacheControl ) {
+		std::lock_guard<std::mutex> lock( mMutex );
+		mCacheControl = cacheControl;
+	}
+
+  protected:
+	struct Client {
+		TcpSocket socket;
+		std::string input;
+	};
+
+	std::string mBody;
+	std::string mCacheControl;
+	std::mutex mMutex;
+	std::atomic<size_t> mRequests;
+	std::atomic<bool> mRunning;
+	TcpListener mListener;
+	std::vector<std::unique_ptr<Client>> mClients;
+	Thread mThread;
+
+	void run() {
+		SocketSelector selector;
+
+		while ( mRunning ) {
+			selector.clear();
+			selector.add( mListener );
+
+			for ( auto& client : mClients )
+				selector.add( client->socket );
+
+			if ( !selector.wait( Milliseconds( 50 ) ) )
+				continue;
+
+			if ( selector.isReady( mListener ) ) {
+				std::unique_ptr<Client> client( new Client() );
+
+				if ( mListener.accept( client->socket ) == Socket::Done )
+					mClients.emplace_back( std::move( client ) );
+			}
+
+			for ( auto it = mClients.begin(); it != mClients.end(); ) {
+				if ( selector.isReady( ( *it )->socket ) && !serve( **it ) ) {
+					it = mClients.erase( it );
+				} else {
+					++it;
+				}
+			}
+		}
+	}
+
+	bool serve( Client& client ) {
+		char buffer[4096];
+		std::size_t received;
+
+		if ( client.socket.receive( buffer, sizeof( buffer ), received ) != Socket::Done )
+			return false;
+
+		client.input.append( buffer, received );
+
+		std::string output;
+		std::size_t end;
+		bool close = false;
+
+		while ( !close && ( end = client.input.find( "\r\n\r\n" ) ) != std::string::npos ) {
+			std::string header( String::toLower( client.input.substr( 0, end ) ) );
+			bool notModified = header.find( "if-none-match: \"v1\"" ) != std::string::npos;
+			close = header.find( "connection: close" ) != std::string::npos;
+			client.input.erase( 0, end + 4 );
+			mRequests++;
+
+			std::lock_guard<std::mutex> lock( mMutex );
+			output += String::format(
+				"HTTP/1.1 %s\r\nContent-Length: %zu\r\nConnection: %s\r\nETag: \"v1\"\r\n%s%s\r\n",
+				notModified ? "304 Not Modified" : "200 OK", notModified ? 0 : mBody.size(),
+				close ? "close" : "keep-alive",
+				mCacheControl.empty() ? "" : ( "Cache-Control: " + mCacheControl ).c_str(),
+				mCacheControl.empty() ? "" : "\r\n" );
+
+			if ( !notModified )
+				output += mBody;
+		}
+
+		if ( !output.empty() && client.socket.send( output.data(), output.size() ) != Socket::Done )
+			return false;
+
+		return !close;
+	}
+};
+
+// A minimal HTTP/1.1 server of a single file that honors the Range field, answering with a 206
+// and its Content-Range. It can also misbehave as the servers the segmented downloads handle.
+class RangeServer {
+  public:
+	enum Mode {
+		// Every range is answered.
+		RangesHonored,
+		// The HEAD response has no Accept-Ranges field.
+		NoAcceptRanges,
+		// The ranges are answered with a 200 and the whole file.
+		RangesIgnored,
+		// One range after the first segment is answered with half of its data.
+		ShortRangeOnce,
+		// Every range after the first segment is answered with half of its data.
+		ShortRanges,
+		// Every range after the first segment is answered with the Content-Range of the next byte.
+		WrongContentRange
+	};
+
+	RangeServer( size_t fileSize ) :
+		mFile( fileSize, '\0' ),
+		mMode( RangesHonored ),
+		mShortRangeSent( false ),
+		mFullRequests( 0 ),
+		mRunning( true ),
+		mThread( &RangeServer::run, this ) {
+		for ( size_t i = 0; i < fileSize; i++ )
+			mFile[i] = (char)( i * 31 + i / 7 );
+
+		mListener.listen( Socket::AnyPort, IpAddress::LocalHost );
+		mThread.launch();
+	}
+
+	~RangeServer() {
+		mRunning = false;
+		mThread.wait();
+	}
+
+	unsigned short getPort() const { return mListener.getLocalPort(); }
+
+	const std::string& getFile() const { return mFile; }
+
+	void reset( Mode mode ) {
+		std::lock_guard<std::mutex> lock( mMutex );
+		mMode = mode;
+		mShortRangeSent = false;
+		mRanges.clear();
+		mFullRequests = 0;
+	}
+
+	std::vector<std::pair<Uint64, Uint64>> getRanges() {
+		std::lock_guard<std::mutex> lock( mMutex );
+		std::vector<std::pair<Uint64, Uint64>> ranges( mRanges );
+		std::sort( ranges.begin(), ranges.end() );
+		return ranges;
+	}
+
+	// The requests of the whole file, without a Range field.
+	size_t getFullRequestsCount() const { return mFullRequests; }
+
+  protected:
+	struct Client {
+		TcpSocket socket;
+		std::string input;
+	};
+
+	std::string mFile;
+	Mode mMode;
+	bool mShortRangeSent;
+	std::mutex mMutex;
+	std::vector<std::pair<Uint64, Uint64>> mRanges;
+	std::atomic<size_t> mFullRequests;
+	std::atomic<bool> mRunning;
+	TcpListener mListener;
+	std::vector<std::unique_ptr<Client>> mClients;
+	Thread mThread;
+
+	void run() {
+		SocketSelector selector;
+
+		while ( mRunning ) {
+			selector.clear();
+			selector.add( mListener );
+
+			for ( auto& client : mClients )
+				selector.add( client->socket );
+
+			if ( !selector.wait( Milliseconds( 50 ) ) )
+				continue;
+
+			if ( selector.isReady( mListener ) ) {
+				std::unique_ptr<Client> client( new Client() );
+
+				if ( mListener.accept( client->socket ) == Socket::Done )
+					mClients.emplace_back( std::move( client ) );
+			}
+
+			for ( auto it = mClients.begin(); it != mClients.end(); ) {
+				if ( selector.isReady( ( *it )->socket ) && !serve( **it ) ) {
+					it = mClients.erase( it );
+				} else {
+					++it;
+				}
+			}
+		}
+	}
+
+	std::string respond( const std::string& header ) {
+		std::lock_guard<std::mutex> lock( mMutex );
+		std::size_t rangePos = header.find( "range: bytes=" );
+		unsigned long long first = 0;
+		unsigned long long last = 0;
+		bool head = String::startsWith( header, "head " );
+
+		if ( head || std::string::npos == rangePos || mMode == RangesIgnored ||
+			 std::sscanf( header.c_str() + rangePos + 13, "%llu-%llu", &first, &last ) != 2 ||
+			 first > last || last >= mFile.size() ) {
+			// The ranges ignored are not counted, they're aborted as soon as the 200 arrives.
+			if ( !head && std::string::npos == rangePos )
+				mFullRequests++;
+
+			return String::format( "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n%s\r\n",
+								   mFile.size(),
+								   mMode == NoAcceptRanges ? "" : "Accept-Ranges: bytes\r\n" ) +
+				   ( head ? "" : mFile );
+		}
+
+		std::string body( mFile.substr( first, last - first + 1 ) );
+		bool misbehave = first > 0 && ( mMode == ShortRanges || mMode == WrongContentRange ||
+										( mMode == ShortRangeOnce && !mShortRangeSent ) );
+
+		if ( misbehave )
+			mShortRangeSent = true;
+
+		mRanges.emplace_back( first, last );
+
+		if ( misbehave && mMode == WrongContentRange ) {
+			first++;
+			last++;
+		} else if ( misbehave ) {
+			body.resize( body.size() / 2 );
+		}
+
+		return String::format( "HTTP/1.1 206 Partial Content\r\n"
+							   "Content-Range: bytes %llu-%llu/%zu\r\nContent-Length: %zu\r\n\r\n",
+							   first, last, mFile.size(), body.size() ) +
+			   body;
+	}
+
+	bool serve( Client& client ) {
+		char buffer[4096];
+		std::size_t received;
+
+		if ( client.socket.receive( buffer, sizeof( buffer ), received ) != Socket::Done )
+			return false;
+
+		client.input.append( buffer, received );
+
+		std::size_t end;
+
+		while ( ( end = client.input.find( "\r\n\r\n" ) ) != std::string::npos ) {
+			std::string output( respond( String::toLower( client.input.substr( 0, end ) ) ) );
+			client.input.erase( 0, end + 4 );
+
+			if ( client.socket.send( output.data(), output.size() ) != Socket::Done )
+				return false;
+		}
+
+		return true;
+	}
+};
+
+static void printResult( const char* mode, size_t requests, size_t failed, double seconds,
+						 Uint32 threads ) {
+	std::printf( "%-28s %9zu %7zu %12.0f %8u\n", mode, requests, failed, requests / seconds,
+				 threads );
+}
+
+static void benchmarkThreadPerRequest( StandInServer& server, size_t requests ) {
+	std::atomic<size_t> failed{ 0 };
+	std::vector<std::unique_ptr<Thread>> threads;
+	auto start = BenchClock::now();
+
+	for ( size_t i = 0; i < requests; i++ ) {
+		threads.emplace_back( std::make_unique<Thread>( [&] {
+			Http http( "127.0.0.1", server.getPort() );
+			Http::Response response = http.sendRequest( Http::Request( "/" ), Seconds( 10 ) );
+			if ( response.getStatus() != Http::Response::Ok ||
+				 response.getBody().size() != server.getBody().size() )
+				failed++;
+		} ) );
+		threads.back()->launch();
+	}
+
+	for ( auto& thread : threads )
+		thread->wait();
+
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+
+	printResult( "thread per request", requests, failed, seconds, requests );
+}
+
+static void benchmarkAsyncClient( StandInServer& server, size_t requests, Uint32 maxConnections,
+								  Uint32 maxPipelined ) {
+	Http::AsyncClient client;
+	client.setMaxConnectionsPerHost( maxConnections );
+	client.setMaxPipelinedRequests( maxPipelined );
+
+	Http http( "127.0.0.1", server.getPort() );
+	http.setAsyncClient( &client );
+
+	std::atomic<size_t> done{ 0 };
+	std::atomic<size_t> failed{ 0 };
+	std::mutex mutex;
+	std::condition_variable finished;
+	auto start = BenchClock::now();
+
+	for ( size_t i = 0; i < requests; i++ ) {
+		http.sendAsyncRequest(
+			[&]( const Http&, Http::Request&, Http::Response& response ) {
+				if ( response.getStatus() != Http::Response::Ok ||
+					 response.getBody().size() != server.getBody().size() )
+					failed++;
+				if ( ++done == requests ) {
+					std::lock_guard<std::mutex> lock( mutex );
+					finished.notify_all();
+				}
+			},
+			Http::Request( "/" ), Seconds( 10 ) );
+	}
+
+	{
+		std::unique_lock<std::mutex> lock( mutex );
+		finished.wait( lock, [&] { return done == requests; } );
+	}
+
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+
+	std::string mode( String::format( "async %u conn, pipeline %u", maxConnections,
+									  maxPipelined ) );
+	printResult( mode.c_str(), requests, failed, seconds, client.getThreadCount() );
+}
+
+static bool benchmarkCache( StandInServer& server, size_t requests, const char* mode,
+							Http::Cache& cache, const std::string& cacheControl,
+							const Http::Cache::Metrics& expected, size_t expectedServerRequests,
+							const Http::Request& request = Http::Request( "/" ) ) {
+	size_t failed = 0;
+	size_t serverRequests = server.getRequestsCount();
+	server.setCacheControl( cacheControl );
+	cache.resetMetrics();
+
+	Http http( "127.0.0.1", server.getPort() );
+	http.setCache( &cache );
+
+	auto start = BenchClock::now();
+
+	for ( size_t i = 0; i < requests; i++ ) {
+		Http::Response response = http.sendRequest( request, Seconds( 10 ) );
+
+		if ( response.getStatus() != Http::Response::Ok ||
+			 response.getBody().size() != server.getBody().size() )
+			failed++;
+	}
+
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+	Http::Cache::Metrics metrics = cache.getMetrics();
+	serverRequests = server.getRequestsCount() - serverRequests;
+
+	std::printf( "%-28s %9zu %7zu %12.0f %6llu %6llu %6llu %6llu %7zu %12llu\n", mode, requests,
+				 failed, requests / seconds, (unsigned long long)metrics.hits,
+				 (unsigned long long)metrics.revalidations, (unsigned long long)metrics.misses,
+				 (unsigned long long)metrics.stores, serverRequests,
+				 (unsigned long long)metrics.bytesSaved );
+
+	bool ok = 0 == failed && metrics.hits == expected.hits &&
+			  metrics.revalidations == expected.revalidations &&
+			  metrics.misses == expected.misses && metrics.stores == expected.stores &&
+			  serverRequests == expectedServerRequests;
+
+	if ( !ok )
+		std::printf( "%-28s unexpected cache metrics\n", mode );
+
+	return ok;
+}
+
+static Http::Cache::Metrics cacheMetrics( Uint64 hits, Uint64 revalidations, Uint64 misses,
+										  Uint64 stores ) {
+	Http::Cache::Metrics metrics;
+	metrics.hits = hits;
+	metrics.revalidations = revalidations;
+	metrics.misses = misses;
+	metrics.stores = stores;
+	return metrics;
+}
+
+static bool checkSegmentedDownload( RangeServer& server, const char* mode,
+									RangeServer::Mode serverMode, bool expectComplete,
+									size_t expectedRanges, size_t expectedFullRequests ) {
+	std::string path( Sys::getTempPath() + "eepp-http-perf-test-segmented" );
+	server.reset( serverMode );
+	FileSystem::fileRemove( path );
+
+	Http http( "127.0.0.1", server.getPort() );
+	Http::Request request( "/file" );
+	request.setSegments( SEGMENTS );
+
+	auto start = BenchClock::now();
+	Http::Response response = http.downloadRequest( request, path, Seconds( 10 ) );
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+
+	std::string file;
+	FileSystem::fileGet( path, file );
+	FileSystem::fileRemove( path );
+
+	std::vector<std::pair<Uint64, Uint64>> ranges( server.getRanges() );
+	bool ok = expectComplete
+				  ? response.getStatus() == Http::Response::Ok && file == server.getFile()
+				  : response.getStatus() == Http::Response::InvalidResponse;
+	ok = ok && ranges.size() == expectedRanges &&
+		 server.getFullRequestsCount() == expectedFullRequests;
+
+	// The ranges must be consecutive and cover the whole file, a retried range is requested again.
+	if ( ok && !ranges.empty() ) {
+		Uint64 next = 0;
+
+		for ( const auto& range : ranges ) {
+			if ( range.first == next )
+				next = range.second + 1;
+			else if ( range.second + 1 != next )
+				ok = false;
+		}
+
+		ok = ok && next == server.getFile().size();
+	}
+
+	std::printf( "%-28s %7zu %7zu %7d %10.1f %s\n", mode, ranges.size(),
+				 server.getFullRequestsCount(), (int)response.getStatus(), seconds * 1000,
+				 ok ? "ok" : "FAILED" );
+
+	return ok;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	size_t requests = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 1000;
+	size_t bodySize = argc > 2 ? std::strtoul( argv[2], NULL, 10 ) : 1024;
+
+	StandInServer server( bodySize );
+
+	std::printf( "HTTP async requests: %zu requests, %zu bytes body\n", requests, bodySize );
+	std::printf( "%-28s %9s %7s %12s %8s\n", "mode", "requests", "failed", "requests/s",
+				 "threads" );
+
+	benchmarkThreadPerRequest( server, requests );
+	benchmarkAsyncClient( server, requests, 1, 1 );
+	benchmarkAsyncClient( server, requests, 6, 1 );
+	benchmarkAsyncClient( server, requests, 6, 8 );
+
+	std::printf( "\nHTTP response cache: %zu requests, %zu bytes body\n", requests, bodySize );
+	std::printf( "%-28s %9s %7s %12s %6s %6s %6s %6s %7s %12s\n", "mode", "requests", "failed",
+				 "requests/s", "hits", "304", "misses", "stores", "server", "bytes saved" );
+
+	bool ok = true;
+	std::string diskPath( Sys::getTempPath() + "eepp-http-perf-test-cache" );
+
+	{
+		Http::Cache cache;
+		ok = benchmarkCache( server, requests, "no cache policy ( 304 )", cache, "",
+							 cacheMetrics( 0, requests - 1, 1, 1 ), requests ) &&
+			 ok;
+	}
+
+	{
+		Http::Cache cache;
+		ok = benchmarkCache( server, requests, "no-cache ( 304 )", cache, "no-cache",
+							 cacheMetrics( 0, requests - 1, 1, 1 ), requests ) &&
+			 ok;
+	}
+
+	{
+		Http::Cache cache;
+		ok = benchmarkCache( server, requests, "no-store", cache, "no-store",
+							 cacheMetrics( 0, 0, requests, 0 ), requests ) &&
+			 ok;
+	}
+
+	{
+		Http::Cache cache( diskPath );
+		cache.clear();
+		ok = benchmarkCache( server, requests, "max-age", cache, "max-age=3600",
+							 cacheMetrics( requests - 1, 0, 1, 1 ), 1 ) &&
+			 ok;
+	}
+
+	{
+		// A new cache ( as in the next run of the program ) loads the responses from disk.
+		Http::Cache cache( diskPath );
+		ok = benchmarkCache( server, requests, "max-age, from disk", cache, "max-age=3600",
+							 cacheMetrics( requests, 0, 0, 0 ), 0 ) &&
+			 ok;
+		cache.clear();
+	}
+
+	{
+		// Nothing is stored, the bodies don't fit in memory and there's no disk store.
+		Http::Cache cache( "", bodySize - 1 );
+		ok = benchmarkCache( server, requests, "over the memory size", cache, "max-age=3600",
+							 cacheMetrics( 0, 0, requests, 0 ), requests ) &&
+			 ok;
+	}
+
+	Http::Request authorized( "/" );
+	authorized.setField( "Authorization", "Bearer token" );
+
+	{
+		Http::Cache cache;
+		ok = benchmarkCache( server, requests, "authorization", cache, "max-age=3600",
+							 cacheMetrics( 0, 0, requests, 0 ), requests, authorized ) &&
+			 ok;
+	}
+
+	{
+		Http::Cache cache;
+		ok = benchmarkCache( server, requests, "authorization, public", cache,
+							 "public, max-age=3600", cacheMetrics( requests - 1, 0, 1, 1 ), 1,
+							 authorized ) &&
+			 ok;
+	}
+
+	RangeServer rangeServer( 4 * 1024 * 1024 + 17 );
+
+	std::printf( "\nHTTP segmented download: %zu bytes file, %u segments\n",
+				 rangeServer.getFile().size(), SEGMENTS );
+	std::printf( "%-28s %7s %7s %7s %10s\n", "mode", "ranges", "full", "status", "ms" );
+
+	ok = checkSegmentedDownload( rangeServer, "ranges", RangeServer::RangesHonored, true,
+								 SEGMENTS, 0 ) &&
+		 ok;
+	ok = checkSegmentedDownload( rangeServer, "no Accept-Ranges", RangeServer::NoAcceptRanges,
+								 true, 0, 1 ) &&
+		 ok;
+	ok = checkSegmentedDownload( rangeServer, "ranges ignored ( 200 )", RangeServer::RangesIgnored,
+								 true, 0, 1 ) &&
+		 ok;
+	ok = checkSegmentedDownload( rangeServer, "short range, retried", RangeServer::ShortRangeOnce,
+								 true, SEGMENTS + 1, 0 ) &&
+		 ok;
+	ok = checkSegmentedDownload( rangeServer, "short ranges", RangeServer::ShortRanges, false,
+								 SEGMENTS + ( SEGMENTS - 1 ), 0 ) &&
+		 ok;
+	ok = checkSegmentedDownload( rangeServer, "wrong Content-Range",
+								 RangeServer::WrongContentRange, false, SEGMENTS + ( SEGMENTS - 1 ),
+								 0 ) &&
+		 ok;
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
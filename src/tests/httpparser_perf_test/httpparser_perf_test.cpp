@@ -0,0 +1,361 @@
+#include "../../eepp/network/http/httpresponseparser.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+#include <random>
+
+// Checks the incremental HTTP response parser feeding every response at once, one byte at a time
+// and split at random points: headers, chunk sizes and trailers split across reads, chunked and
+// gzip bodies, interim ( 1xx ) responses and the bytes of the next pipelined response.
+// Then measures the parsing throughput of long chunked bodies, plain and gzip compressed, checking
+// that the memory used by the parser doesn't grow with the body.
+// Usage: eepp-httpparser-perf-test [body megabytes]
+
+using namespace EE::Network::Private;
+
+typedef std::chrono::steady_clock BenchClock;
+
+static const int RANDOM_SPLITS = 200;
+
+// The body of the streamed responses repeats this pattern, short enough to compress well.
+static const std::size_t PATTERN_SIZE = 16 * 1024;
+
+// The parser keeps the header, the trailer and the chunk size being read, nothing of the body.
+static const std::size_t MAX_PARSER_BUFFER = 1024;
+
+struct ResponseCase {
+	std::string name;
+	std::string response;
+	// The bytes received after the response, that belong to the next one.
+	std::string next;
+	int status;
+	std::string body;
+	std::vector<std::pair<std::string, std::string>> fields;
+	// A field that must not be found ( i.e. of an interim response ).
+	std::string absentField;
+	bool keepAlive;
+	// The body ends when the connection is closed.
+	bool untilClose;
+};
+
+class StreamParser : public HttpResponseParser {
+  public:
+	std::size_t getBufferCapacity() const { return mHeader.capacity(); }
+};
+
+static std::string makeBody( std::size_t size ) {
+	std::string body( size, '\0' );
+
+	for ( std::size_t i = 0; i < size; i++ )
+		body[i] = (char)( 'a' + ( i * 7 + i / 13 ) % 26 );
+
+	return body;
+}
+
+static std::string gzip( const std::string& data ) {
+	IOStreamString compressed;
+
+	{
+		IOStreamDeflate deflate( compressed, Compression::MODE_GZIP );
+		deflate.write( data.data(), data.size() );
+	}
+
+	return compressed.getStream();
+}
+
+static std::string chunked( const std::string& data, const std::vector<std::size_t>& sizes,
+							const std::string& trailer ) {
+	std::string output;
+	std::size_t pos = 0;
+
+	for ( std::size_t i = 0; pos < data.size(); i++ ) {
+		std::size_t size = eemin( sizes[i % sizes.size()], data.size() - pos );
+		// Upper and lower case sizes, some of them with a chunk extension.
+		output += String::format( i % 2 ? "%zX" : "%zx", size ) +
+				  ( i % 3 ? "" : ";name=value" ) + "\r\n" + data.substr( pos, size ) + "\r\n";
+		pos += size;
+	}
+
+	return output + "0\r\n" + trailer + "\r\n";
+}
+
+static std::vector<ResponseCase> responseCases() {
+	std::vector<ResponseCase> cases;
+	std::mt19937 random( 1 );
+	std::string body( 5000, '\0' );
+
+	// Random text, so the compressed body spans many chunks.
+	for ( auto& c : body )
+		c = (char)( 'a' + random() % 26 );
+
+	std::string compressed( gzip( body ) );
+	std::string next( "HTTP/1.1 204 No Content\r\n\r\n" );
+
+	cases.push_back(
+		{ "content-length",
+		  String::format( "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\nX-Test:  a value \r\n\r\n",
+						  body.size() ) +
+			  body,
+		  next,
+		  200,
+		  body,
+		  { { "content-length", String::toString( body.size() ) }, { "x-test", "a value" } },
+		  "",
+		  true,
+		  false } );
+
+	cases.push_back(
+		{ "chunked, trailer",
+		  "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" +
+			  chunked( body, { 1, 16, 4096, 100 }, "X-Checksum: abc\r\nX-Count: 2\r\n" ),
+		  next,
+		  200,
+		  body,
+		  { { "transfer-encoding", "chunked" }, { "x-checksum", "abc" }, { "x-count", "2" } },
+		  "",
+		  true,
+		  false } );
+
+	cases.push_back( { "gzip",
+					   String::format( "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\n"
+									   "Content-Length: %zu\r\n\r\n",
+									   compressed.size() ) +
+						   compressed,
+					   next,
+					   200,
+					   body,
+					   { { "content-encoding", "gzip" } },
+					   "",
+					   true,
+					   false } );
+
+	cases.push_back(
+		{ "chunked gzip, trailer",
+		  "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n" +
+			  chunked( compressed, { 7, 300, 1 }, "X-Checksum: def\r\n" ),
+		  next,
+		  200,
+		  body,
+		  { { "content-encoding", "gzip" }, { "x-checksum", "def" } },
+		  "",
+		  true,
+		  false } );
+
+	cases.push_back( { "1xx, then final",
+					   "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 103 Early Hints\r\n"
+					   "Link: </style.css>; rel=preload\r\n\r\nHTTP/1.1 201 Created\r\n"
+					   "Content-Length: 5\r\n\r\nhello",
+					   next,
+					   201,
+					   "hello",
+					   { { "content-length", "5" } },
+					   "link",
+					   true,
+					   false } );
+
+	cases.push_back( { "HTTP/1.0, until close",
+					   "HTTP/1.0 200 OK\r\nServer: test\r\n\r\n" + body,
+					   "",
+					   200,
+					   body,
+					   { { "server", "test" } },
+					   "",
+					   false,
+					   true } );
+
+	return cases;
+}
+
+// Feeds the response and the next one in pieces of the size returned by pieceSize.
+// @return The first difference with the expected response, empty if none.
+static std::string parseResponse( const ResponseCase& test,
+								  const std::function<std::size_t()>& pieceSize ) {
+	HttpResponseParser parser;
+	std::string data( test.response + test.next );
+	std::string body;
+	std::string rest;
+	int headers = 0;
+
+	parser.setHeaderCallback( [&]( HttpResponseParser& ) {
+		headers++;
+		return true;
+	} );
+	parser.setBodyCallback( [&]( const char* data, std::size_t size ) {
+		body.append( data, size );
+		return true;
+	} );
+
+	for ( std::size_t pos = 0; pos < data.size(); ) {
+		std::size_t size = eemin( pieceSize(), data.size() - pos );
+		std::size_t consumed = parser.isDone() ? 0 : parser.parse( data.data() + pos, size );
+
+		if ( parser.hasError() )
+			return String::format( "parse error at byte %zu", pos + consumed );
+
+		rest.append( data, pos + consumed, size - consumed );
+		pos += size;
+	}
+
+	if ( test.untilClose )
+		parser.finish();
+
+	if ( !parser.isDone() )
+		return "the response didn't end";
+
+	if ( headers != 1 )
+		return String::format( "the header was received %d times", headers );
+
+	if ( parser.getStatus() != test.status )
+		return String::format( "status %d", parser.getStatus() );
+
+	if ( body != test.body )
+		return String::format( "body of %zu bytes differs", body.size() );
+
+	for ( const auto& field : test.fields ) {
+		std::string value( parser.getField( field.first.c_str() ).toString() );
+
+		if ( value != field.second )
+			return field.first + ": \"" + value + "\"";
+	}
+
+	if ( !test.absentField.empty() && parser.hasField( test.absentField.c_str() ) )
+		return test.absentField + " found";
+
+	if ( parser.isKeepAlive() != test.keepAlive )
+		return "keep alive";
+
+	if ( rest != test.next )
+		return String::format( "%zu bytes left for the next response", rest.size() );
+
+	if ( !rest.empty() ) {
+		parser.reset();
+
+		if ( parser.parse( rest.data(), rest.size() ) != rest.size() || !parser.isDone() ||
+			 parser.getStatus() != 204 )
+			return "the next response wasn't parsed";
+	}
+
+	return "";
+}
+
+static bool checkResponses() {
+	std::mt19937 random( 1 );
+	bool ok = true;
+
+	for ( const auto& test : responseCases() ) {
+		std::size_t size = test.response.size() + test.next.size();
+		std::string error( parseResponse( test, [&]() { return size; } ) );
+		std::string mode( "at once" );
+
+		if ( error.empty() ) {
+			error = parseResponse( test, []() -> std::size_t { return 1; } );
+			mode = "one byte at a time";
+		}
+
+		for ( int i = 0; i < RANDOM_SPLITS && error.empty(); i++ ) {
+			// Half of the runs with short pieces, to split most lines, the rest anywhere.
+			std::size_t maxPiece = i % 2 ? 32 : size;
+			error = parseResponse( test, [&]() { return 1 + random() % maxPiece; } );
+			mode = String::format( "random split %d", i );
+		}
+
+		std::printf( "%-28s %8zu %s%s%s\n", test.name.c_str(), test.response.size(),
+					 error.empty() ? "ok" : "FAILED ", error.empty() ? "" : mode.c_str(),
+					 error.empty() ? "" : ( ": " + error ).c_str() );
+
+		ok = ok && error.empty();
+	}
+
+	return ok;
+}
+
+// Streams a chunked response of bodySize bytes ( or its gzip compressed form ) from the repeated
+// pattern, feeding the parser in pieces of 16 KiB as a socket would.
+static bool benchmarkStream( std::size_t bodySize, bool compressed ) {
+	std::string pattern( makeBody( PATTERN_SIZE ) );
+	std::string payload;
+
+	if ( compressed ) {
+		IOStreamString stream;
+
+		{
+			IOStreamDeflate deflate( stream, Compression::MODE_GZIP );
+
+			for ( std::size_t i = 0; i < bodySize / PATTERN_SIZE; i++ )
+				deflate.write( pattern.data(), pattern.size() );
+		}
+
+		payload = stream.getStream();
+	} else {
+		payload = pattern + pattern + pattern + pattern;
+	}
+
+	StreamParser parser;
+	std::size_t received = 0;
+	std::size_t maxBuffer = 0;
+	bool valid = true;
+
+	parser.setBodyCallback( [&]( const char* data, std::size_t size ) {
+		for ( std::size_t i = 0; i < size && valid; i++ )
+			valid = data[i] == pattern[( received + i ) % PATTERN_SIZE];
+
+		received += size;
+		return valid;
+	} );
+
+	std::string header( compressed ? "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\n"
+									 "Transfer-Encoding: chunked\r\n\r\n"
+								   : "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" );
+	// The plain payload is sent as many times as needed, the compressed one only once.
+	std::string chunk( String::format( "%zx\r\n", payload.size() ) + payload + "\r\n" );
+	std::size_t chunks = compressed ? 1 : bodySize / payload.size();
+	auto feed = [&]( const std::string& data ) {
+		for ( std::size_t pos = 0; pos < data.size() && !parser.hasError();
+			  pos += 16 * 1024 ) {
+			parser.parse( data.data() + pos, eemin<std::size_t>( 16 * 1024, data.size() - pos ) );
+			maxBuffer = eemax( maxBuffer, parser.getBufferCapacity() );
+		}
+	};
+
+	auto start = BenchClock::now();
+
+	feed( header );
+
+	for ( std::size_t i = 0; i < chunks; i++ )
+		feed( chunk );
+
+	feed( "0\r\n\r\n" );
+
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+	std::size_t expected = compressed ? bodySize / PATTERN_SIZE * PATTERN_SIZE
+									  : chunks * payload.size();
+	bool ok = parser.isDone() && valid && received == expected && maxBuffer <= MAX_PARSER_BUFFER;
+
+	std::printf( "%-28s %10zu %10zu %10.0f %10zu %s\n",
+				 compressed ? "chunked gzip" : "chunked", received,
+				 compressed ? payload.size() : chunks * chunk.size(),
+				 received / seconds / ( 1024 * 1024 ), maxBuffer, ok ? "ok" : "FAILED" );
+
+	return ok;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	std::size_t megabytes = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 256;
+	bool ok = true;
+
+	std::printf( "HTTP response parser: at once, one byte at a time and %d random splits\n",
+				 RANDOM_SPLITS );
+	std::printf( "%-28s %8s %s\n", "response", "bytes", "result" );
+
+	ok = checkResponses() && ok;
+
+	std::printf( "\nHTTP response parser streaming: %zu MiB bodies\n", megabytes );
+	std::printf( "%-28s %10s %10s %10s %10s %s\n", "mode", "body", "wire", "MiB/s",
+				 "buffer", "result" );
+
+	ok = benchmarkStream( megabytes * 1024 * 1024, false ) && ok;
+	ok = benchmarkStream( megabytes * 1024 * 1024, true ) && ok;
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cstdio>
+#include <eepp/ee.hpp>
+#include <random>
+
+// Measures the cold start of layouts loaded from XML and from their compiled form
+// ( UICompiledLayout ): the first load and the average of the following loads, the style reload
+// included. The compiled form is read from memory on every load, the preloaded form reuses the
+// same UICompiledLayout.
+// The forms alternate on every run, each run starting with the next form, so none of them is
+// always measured warm after the others. Only the very first load is a cold start, use --only to
+// measure a single form per process.
+// After measuring, checks that both forms create the same widget tree and that truncated or
+// corrupted compiled buffers are handled, exiting with a failure if they don't.
+// Without arguments it loads a generated layout, assets/layouts/test_widgets.xml and the main
+// layout of ecode ( assets/layouts/ecode.xml ).
+// Usage: eepp-layout-perf-test [--only=xml|compiled|preloaded] [layout.xml ...]
+
+static const int RUNS = 20;
+
+static const int CORRUPTED_BUFFERS = 2000;
+
+enum LayoutForm { FormXml, FormCompiled, FormPreloaded, FormCount };
+
+static const char* FORM_NAMES[FormCount] = { "xml", "compiled", "preloaded" };
+
+static std::string generateLayout( size_t rows, size_t cols ) {
+	std::string xml( "<vbox id=\"root\" layout_width=\"match_parent\" "
+					 "layout_height=\"match_parent\">\n"
+					 "<style>\n"
+					 ".cell { padding: 2dp 4dp; margin: 1dp; color: #eeeeee; }\n"
+					 ".row:hover > .cell { background-color: #333333; }\n"
+					 "@media screen and (max-width: 400dp) { .cell { padding: 0dp; } }\n"
+					 "</style>\n" );
+
+	for ( size_t row = 0; row < rows; row++ ) {
+		xml += "<hbox class=\"row\" layout_width=\"match_parent\" layout_height=\"wrap_content\">";
+
+		for ( size_t col = 0; col < cols; col++ ) {
+			std::string id( String::toString( row ) + "_" + String::toString( col ) );
+
+			if ( col % 2 == 0 ) {
+				xml += "<TextView id=\"text_" + id + "\" class=\"cell\" layout_width=\"0dp\" "
+					   "layout_weight=\"1\" layout_height=\"wrap_content\" text=\"Cell " +
+					   id + "\" />";
+			} else {
+				xml += "<PushButton id=\"button_" + id + "\" class=\"cell button\" "
+					   "layout_width=\"wrap_content\" layout_height=\"wrap_content\" "
+					   "text=\"Button\" padding=\"4dp\" />";
+			}
+		}
+
+		xml += "</hbox>\n";
+	}
+
+	return xml + "</vbox>\n";
+}
+
+static void closeLayout( UISceneNode* uiSceneNode ) {
+	uiSceneNode->getRoot()->childsCloseAll();
+	SceneManager::instance()->update();
+}
+
+static Float timeLoad( UISceneNode* uiSceneNode, const CSS::StyleSheet& styleSheet,
+					   const std::function<UIWidget*()>& load ) {
+	// Every load starts from the theme style sheet, since the layout styles are combined.
+	uiSceneNode->setStyleSheet( styleSheet );
+
+	Clock clock;
+	load();
+	Float time = clock.getElapsedTime().asMilliseconds();
+
+	closeLayout( uiSceneNode );
+
+	return time;
+}
+
+static std::string formatTime( const Float& time, bool measured ) {
+	return measured ? String::format( "%9.2f", time ) : String::format( "%9s", "-" );
+}
+
+static void benchmark( UISceneNode* uiSceneNode, const std::string& name, const std::string& xml,
+					   int only ) {
+	CSS::StyleSheet styleSheet( uiSceneNode->getStyleSheet() );
+	IOStreamString compiled;
+	Clock clock;
+
+	if ( !UICompiledLayout::compileFromString( xml, compiled ) ) {
+		std::printf( "%-24s couldn't be compiled\n", name.c_str() );
+		return;
+	}
+
+	Float compileTime = clock.getElapsedTime().asMilliseconds();
+	UICompiledLayout layout;
+	layout.loadFromMemory( compiled.getStreamPointer(), compiled.getSize() );
+
+	std::function<UIWidget*()> loaders[FormCount] = {
+		[&]() { return uiSceneNode->loadLayoutFromString( xml ); },
+		[&]() {
+			return uiSceneNode->loadLayoutFromCompiledMemory( compiled.getStreamPointer(),
+															  compiled.getSize() );
+		},
+		[&]() { return uiSceneNode->loadLayoutFromCompiled( layout ); } };
+	Float first[FormCount] = { 0, 0, 0 };
+	Float total[FormCount] = { 0, 0, 0 };
+
+	for ( int i = 0; i <= RUNS; i++ ) {
+		for ( int j = 0; j < FormCount; j++ ) {
+			int form = ( i + j ) % FormCount;
+
+			if ( only != -1 && only != form )
+				continue;
+
+			Float time = timeLoad( uiSceneNode, styleSheet, loaders[form] );
+
+			if ( i == 0 )
+				first[form] = time;
+			else
+				total[form] += time;
+		}
+	}
+
+	uiSceneNode->setStyleSheet( styleSheet );
+
+	std::string times;
+
+	for ( int form = 0; form < FormCount; form++ ) {
+		bool measured = only == -1 || only == form;
+		times += " " + formatTime( first[form], measured ) + " " +
+				 formatTime( total[form] / RUNS, measured );
+	}
+
+	std::printf( "%-24s %8zu %8zu %8.2f%s\n", name.c_str(), xml.size(),
+				 (size_t)compiled.getSize(), compileTime, times.c_str() );
+}
+
+static void dumpTree( Node* node, std::string& tree, size_t depth ) {
+	static const char* properties[] = { "text",	   "color",	  "background-color",
+										"padding", "margin",  "layout-gravity",
+										"gravity", "visible", "enabled" };
+
+	for ( Node* child = node->getFirstChild(); NULL != child; child = child->getNextNode() ) {
+		tree += std::string( depth, '\t' );
+
+		if ( child->isWidget() ) {
+			UIWidget* widget = child->asType<UIWidget>();
+			tree += widget->getElementTag() + "#" + widget->getId();
+
+			for ( const auto& cls : widget->getStyleSheetClasses() )
+				tree += "." + cls;
+
+			for ( const auto& property : properties )
+				tree += std::string( " " ) + property + "=" + widget->getPropertyString( property );
+		}
+
+		tree += String::format( " %.2f,%.2f %.2fx%.2f\n", child->getPosition().x,
+								child->getPosition().y, child->getPixelsSize().getWidth(),
+								child->getPixelsSize().getHeight() );
+
+		dumpTree( child, tree, depth + 1 );
+	}
+}
+
+static std::string loadTree( UISceneNode* uiSceneNode, const CSS::StyleSheet& styleSheet,
+							 const std::function<UIWidget*()>& load ) {
+	std::string tree;
+
+	uiSceneNode->setStyleSheet( styleSheet );
+	load();
+	SceneManager::instance()->update();
+	dumpTree( uiSceneNode->getRoot(), tree, 0 );
+	closeLayout( uiSceneNode );
+
+	return tree;
+}
+
+static std::string getLine( const std::string& text, size_t pos ) {
+	size_t start = pos > 0 ? text.rfind( '\n', pos - 1 ) : std::string::npos;
+	start = std::string::npos == start ? 0 : start + 1;
+	return text.substr( start, text.find( '\n', start ) - start );
+}
+
+static bool checkLayout( UISceneNode* uiSceneNode, const std::string& name,
+						 const std::string& xml ) {
+	CSS::StyleSheet styleSheet( uiSceneNode->getStyleSheet() );
+	IOStreamString compiled;
+
+	if ( !UICompiledLayout::compileFromString( xml, compiled ) ) {
+		std::printf( "%-24s FAILED: couldn't be compiled\n", name.c_str() );
+		return false;
+	}
+
+	const std::string& data = compiled.getStream();
+	std::string xmlTree( loadTree( uiSceneNode, styleSheet, [&]() {
+		return uiSceneNode->loadLayoutFromString( xml );
+	} ) );
+	std::string compiledTree( loadTree( uiSceneNode, styleSheet, [&]() {
+		return uiSceneNode->loadLayoutFromCompiledMemory( data.data(), data.size() );
+	} ) );
+
+	uiSceneNode->setStyleSheet( styleSheet );
+
+	if ( xmlTree != compiledTree ) {
+		size_t pos = 0;
+
+		while ( pos < xmlTree.size() && pos < compiledTree.size() &&
+				xmlTree[pos] == compiledTree[pos] )
+			pos++;
+
+		std::printf( "%-24s FAILED: the compiled widget tree differs\n  xml:      %s\n"
+					 "  compiled: %s\n",
+					 name.c_str(), getLine( xmlTree, pos ).c_str(),
+					 getLine( compiledTree, pos ).c_str() );
+		return false;
+	}
+
+	for ( size_t size = 0; size < data.size(); size++ ) {
+		UICompiledLayout layout;
+
+		if ( layout.loadFromMemory( data.data(), size ) ) {
+			std::printf( "%-24s FAILED: loaded a buffer truncated to %zu of %zu bytes\n",
+						 name.c_str(), size, data.size() );
+			return false;
+		}
+	}
+
+	// A corrupted buffer can still be a valid layout, it only must not crash the loader.
+	std::mt19937 random( 1 );
+	std::string corrupted;
+
+	for ( int i = 0; i < CORRUPTED_BUFFERS; i++ ) {
+		corrupted = data;
+		corrupted[random() % corrupted.size()] ^= (char)( 1 << ( random() % 8 ) );
+		UICompiledLayout layout;
+		layout.loadFromMemory( corrupted.data(), corrupted.size() );
+	}
+
+	std::printf( "%-24s OK: %zu widget tree lines, %zu truncated and %d corrupted buffers\n",
+				 name.c_str(), (size_t)std::count( xmlTree.begin(), xmlTree.end(), '\n' ),
+				 data.size(), CORRUPTED_BUFFERS );
+
+	return true;
+}
+
+static bool checkProperties() {
+	// Compiled layouts restore their properties pre-parsed, they must read as the XML ones.
+	static const char* properties[][2] = {
+		{ "layout-width", "match_parent" },	   { "layout-width", "wrap-content" },
+		{ "layout-height", "wrap_content" },   { "layout-height", "fixed" },
+		{ "layout-width", "20dp" },			   { "layout-gravity", "left|center_vertical" },
+		{ "layout-gravity", "right|center_horizontal" },
+		{ "layout-gravity", "" },			   { "gravity", "center" },
+		{ "gravity", "left|bottom" },		   { "gravity", "top" },
+		{ "gravity", "center|left" },		   { "background-color", "#ff000080" },
+		{ "color", "red" },					   { "color", "var(--font)" },
+		{ "text-stroke-color", "rgba(1,2,3,0.5)" } };
+	bool success = true;
+
+	for ( const auto& property : properties ) {
+		CSS::StyleSheetProperty xml( property[0], property[1] );
+		CSS::StyleSheetProperty compiled(
+			property[0], CSS::StyleSheetSpecification::instance()->getProperty( property[0] ),
+			property[1], 0, false, false );
+		Uint32 xmlValue = 0;
+		Uint32 compiledValue = 0;
+		bool xmlParsed = xml.asParsedValue( xmlValue );
+		bool compiledParsed = compiled.asParsedValue( compiledValue );
+
+		if ( xmlParsed != compiledParsed || xmlValue != compiledValue ||
+			 xml.asColor() != compiled.asColor() ) {
+			std::printf( "property %s: %s FAILED: xml %d:%08x %08x, compiled %d:%08x %08x\n",
+						 property[0], property[1], xmlParsed, xmlValue, xml.asColor().getValue(),
+						 compiledParsed, compiledValue, compiled.asColor().getValue() );
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	EE::Window::Window* win = Engine::instance()->createWindow(
+		WindowSettings( 1024, 768, "eepp - Layout Perf Test" ), ContextSettings( true ) );
+	int exitCode = EXIT_SUCCESS;
+
+	if ( win->isOpen() ) {
+		FileSystem::changeWorkingDirectory( Sys::getProcessPath() );
+		FontTrueType* font =
+			FontTrueType::New( "NotoSans-Regular", "assets/fonts/NotoSans-Regular.ttf" );
+		UISceneNode* uiSceneNode = UISceneNode::New();
+		SceneManager::instance()->add( uiSceneNode );
+		UITheme* theme = UITheme::load( "breeze", "breeze", "", font, "assets/ui/breeze.css" );
+		uiSceneNode->setStyleSheet( theme->getStyleSheet() );
+		uiSceneNode->getUIThemeManager()
+			->setDefaultEffectsEnabled( true )
+			->setDefaultTheme( theme )
+			->setDefaultFont( font )
+			->add( theme );
+
+		// The custom widgets of the ecode layout.
+		UIWidgetCreator::registerWidget( "searchbar", []() -> UIWidget* {
+			return UILinearLayout::NewWithTag( "searchbar", UIOrientation::Horizontal );
+		} );
+		UIWidgetCreator::registerWidget( "locatebar", []() -> UIWidget* {
+			return UILinearLayout::NewWithTag( "locatebar", UIOrientation::Horizontal );
+		} );
+		UIWidgetCreator::registerWidget( "globalsearchbar", []() -> UIWidget* {
+			return UILinearLayout::NewWithTag( "globalsearchbar", UIOrientation::Vertical );
+		} );
+
+		std::vector<std::pair<std::string, std::string>> layouts;
+		int only = -1;
+
+		for ( int i = 1; i < argc; i++ ) {
+			std::string arg( argv[i] );
+			std::string xml;
+
+			if ( String::startsWith( arg, "--only=" ) ) {
+				for ( int form = 0; form < FormCount; form++ )
+					if ( arg.substr( 7 ) == FORM_NAMES[form] )
+						only = form;
+			} else if ( FileSystem::fileGet( arg, xml ) ) {
+				layouts.emplace_back( FileSystem::fileNameFromPath( arg ), xml );
+			}
+		}
+
+		if ( layouts.empty() ) {
+			std::string xml;
+			layouts.emplace_back( "generated 200x10", generateLayout( 200, 10 ) );
+			if ( FileSystem::fileGet( "assets/layouts/test_widgets.xml", xml ) )
+				layouts.emplace_back( "test_widgets.xml", xml );
+			if ( FileSystem::fileGet( "assets/layouts/ecode.xml", xml ) )
+				layouts.emplace_back( "ecode.xml", xml );
+		}
+
+		std::printf( "%-24s %8s %8s %8s %9s %9s %9s %9s %9s %9s\n", "layout", "xml", "compiled",
+					 "compile", "xml 1st", "xml avg", "bin 1st", "bin avg", "pre 1st",
+					 "pre avg" );
+
+		for ( auto& layout : layouts )
+			benchmark( uiSceneNode, layout.first, layout.second, only );
+
+		if ( !checkProperties() )
+			exitCode = EXIT_FAILURE;
+
+		for ( auto& layout : layouts )
+			if ( !checkLayout( uiSceneNode, layout.first, layout.second ) )
+				exitCode = EXIT_FAILURE;
+	}
+
+	Engine::destroySingleton();
+	MemoryManager::showResults();
+
+	return exitCode;
+}
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+
+// Measures the Log throughput ( messages per second ) with 1 to N threads writing at the same
+// time, processing the writes from the calling threads and from the asynchronous writer thread.
+// The log is written to a rotated file in the temporary directory.
+
+typedef std::chrono::steady_clock BenchClock;
+
+enum class Mode { Sync, AsyncBlock, AsyncDrop };
+
+static const char* modeName( const Mode& mode ) {
+	switch ( mode ) {
+		case Mode::AsyncBlock:
+			return "async block";
+		case Mode::AsyncDrop:
+			return "async drop";
+		default:
+			return "sync";
+	}
+}
+
+static void benchmark( const Mode& mode, Uint32 producers, size_t messagesPerProducer ) {
+	Log* log = Log::instance();
+	log->setAsync( mode != Mode::Sync, 8192 );
+	log->setOverflowPolicy( LogLevel::Info, mode == Mode::AsyncDrop ? LogOverflowPolicy::Drop
+																	: LogOverflowPolicy::Block );
+	Uint64 dropped = log->getDroppedCount();
+	auto start = BenchClock::now();
+
+	std::vector<std::unique_ptr<Thread>> threads;
+	for ( Uint32 p = 0; p < producers; p++ ) {
+		threads.emplace_back( std::make_unique<Thread>( [p, messagesPerProducer] {
+			for ( size_t i = 0; i < messagesPerProducer; i++ )
+				Log::info( "producer %u message %zu: the quick brown fox jumps over the lazy dog",
+						   p, i );
+		} ) );
+		threads.back()->launch();
+	}
+
+	for ( auto& thread : threads )
+		thread->wait();
+
+	double enqueued = std::chrono::duration<double>( BenchClock::now() - start ).count();
+
+	log->flush();
+
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+	size_t total = producers * messagesPerProducer;
+
+	std::printf( "%-12s %9u %14.0f %14.0f %10llu\n", modeName( mode ), producers,
+				 total / enqueued, total / seconds,
+				 static_cast<unsigned long long>( log->getDroppedCount() - dropped ) );
+
+	log->setAsync( false );
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	size_t messages = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 200000;
+	Uint32 cpus = eemax<Uint32>( 1, Sys::getCPUCount() );
+	std::vector<Uint32> producerCounts;
+	for ( Uint32 producers = 1; producers < eemax<Uint32>( cpus, 4 ); producers *= 2 )
+		producerCounts.push_back( producers );
+	producerCounts.push_back( eemax<Uint32>( cpus, 4 ) );
+
+	Log* log = Log::create( LogLevel::Info, false, true );
+	log->save( Sys::getTempPath() );
+	log->setFileRotation( 16 * 1024 * 1024, 2 );
+
+	std::printf( "Log: %zu messages per test, written to %slog.log\n", messages,
+				 Sys::getTempPath().c_str() );
+	std::printf( "%-12s %9s %14s %14s %10s\n", "mode", "producers", "written/s", "flushed/s",
+				 "dropped" );
+
+	for ( auto mode : { Mode::Sync, Mode::AsyncBlock, Mode::AsyncDrop } )
+		for ( auto producers : producerCounts )
+			benchmark( mode, producers, messages / producers );
+
+	return EXIT_SUCCESS;
+}
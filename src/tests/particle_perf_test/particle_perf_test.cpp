@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+
+// Measures the ParticleSystem update throughput ( particles per millisecond ) of a single system
+// and of many systems updated in parallel by a ThreadPool. Doesn't need a window, the systems are
+// never drawn.
+
+typedef std::chrono::steady_clock BenchClock;
+
+static std::vector<ParticleSystem*> createSystems( Uint32 count, Uint32 particles,
+												   ParticleEffect effect ) {
+	std::vector<ParticleSystem*> systems;
+
+	for ( Uint32 i = 0; i < count; i++ ) {
+		ParticleSystem* system = eeNew( ParticleSystem, () );
+		system->create( effect, particles, 0, Vector2f( 100.f * i, 100.f ), 16, true );
+		systems.push_back( system );
+	}
+
+	return systems;
+}
+
+static void benchmark( const char* name, ParticleEffect effect, Uint32 particles, Uint32 frames,
+					   Uint32 systemCount, ThreadPool* pool ) {
+	std::vector<ParticleSystem*> systems =
+		createSystems( systemCount, particles / systemCount, effect );
+	Time frameTime( Milliseconds( 16 ) );
+	auto start = BenchClock::now();
+
+	for ( Uint32 i = 0; i < frames; i++ )
+		ParticleSystem::update( systems, frameTime, pool );
+
+	double ms = std::chrono::duration<double, std::milli>( BenchClock::now() - start ).count();
+	Uint64 alive = 0;
+
+	for ( auto& system : systems ) {
+		alive += system->getAliveCount();
+		eeDelete( system );
+	}
+
+	std::printf( "%-10s %8u %8u %8u %12.3f %16.0f\n", name, systemCount,
+				 pool ? pool->numThreads() : 0, static_cast<Uint32>( alive ), ms / frames,
+				 static_cast<double>( particles ) * frames / ms );
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	Uint32 particles = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 1000000;
+	Uint32 frames = argc > 2 ? std::strtoul( argv[2], NULL, 10 ) : 100;
+	Uint32 cpus = eemax<Uint32>( 1, Sys::getCPUCount() );
+	std::unique_ptr<ThreadPool> pool( ThreadPool::createUnique( cpus ) );
+
+	std::printf( "ParticleSystem::update: %u particles, %u frames\n", particles, frames );
+	std::printf( "%-10s %8s %8s %8s %12s %16s\n", "effect", "systems", "threads", "alive",
+				 "ms/frame", "particles/ms" );
+
+	benchmark( "nofx", ParticleEffect::Nofx, particles, frames, 1, NULL );
+	benchmark( "fire", ParticleEffect::Fire, particles, frames, 1, NULL );
+	benchmark( "fire", ParticleEffect::Fire, particles, frames, 16, NULL );
+	benchmark( "fire", ParticleEffect::Fire, particles, frames, 16, pool.get() );
+
+	return EXIT_SUCCESS;
+}
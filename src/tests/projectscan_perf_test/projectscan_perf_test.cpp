@@ -0,0 +1,151 @@
+#include "../../tools/codeeditor/projectdirectorytree.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+#include <future>
+
+// Measures the time needed to scan a synthetic project tree with the thread pool using from 1 to
+// N threads. The tree is generated in the temporary directory the first time ( it's reused while
+// the number of entries doesn't change ), with a root .gitignore and nested .gitignore files.
+// It also measures the latency of the fuzzy matching of the files while typing a pattern in the
+// locate bar.
+// Usage: eepp-projectscan-perf-test [entries] [path]
+
+static const char* ROOT_GITIGNORE = "# Synthetic project\n"
+									"*.o\n"
+									"*.tmp\n"
+									"build/\n"
+									"/generated\n"
+									"!keep.o\n"
+									"**/cache_*\n"
+									"src/*/ignored_[0-9].c\n";
+
+static const char* NESTED_GITIGNORE = "*.txt\n"
+									  "!readme.txt\n";
+
+static const char* EXTENSIONS[] = { ".cpp", ".hpp", ".o", ".txt", ".c", ".tmp", ".md", ".lua" };
+
+static bool writeFile( const std::string& path, const std::string& data = "" ) {
+	return FileSystem::fileWrite( path, (const Uint8*)data.c_str(), data.size() );
+}
+
+static size_t generateTree( const std::string& root, size_t entries ) {
+	const size_t filesPerDir = 100;
+	const size_t dirsPerDir = 20;
+	size_t dirsCount = eemax<size_t>( 1, entries / ( filesPerDir + 1 ) );
+	size_t created = 0;
+
+	FileSystem::makeDir( root );
+	writeFile( root + ".gitignore", ROOT_GITIGNORE );
+
+	for ( const char* dir : { "build", "generated" } ) {
+		FileSystem::makeDir( root + dir );
+		for ( size_t i = 0; i < filesPerDir; i++ )
+			writeFile( root + dir + "/file_" + String::toString( i ) + ".cpp" );
+	}
+
+	// The directories are numbered breadth-first, every directory has dirsPerDir children.
+	std::vector<std::string> dirs{ root + "src/" };
+	FileSystem::makeDir( dirs[0] );
+
+	for ( size_t d = 0; d < dirsCount; d++ ) {
+		std::string dir( dirs[d] );
+
+		if ( d % 16 == 0 )
+			writeFile( dir + ".gitignore", NESTED_GITIGNORE );
+
+		for ( size_t i = 0; i < filesPerDir; i++ ) {
+			std::string name( i % 10 == 0 ? "cache_" : "file_" );
+			writeFile( dir + name + String::toString( i ) +
+					   EXTENSIONS[i % ( sizeof( EXTENSIONS ) / sizeof( EXTENSIONS[0] ) )] );
+		}
+
+		writeFile( dir + "readme.txt" );
+		writeFile( dir + "keep.o" );
+		writeFile( dir + "ignored_" + String::toString( d % 10 ) + ".c" );
+		created += filesPerDir + 3;
+
+		for ( size_t c = 0; c < dirsPerDir && dirs.size() < dirsCount; c++ ) {
+			dirs.push_back( dir + "dir_" + String::toString( c ) + "/" );
+			FileSystem::makeDir( dirs.back() );
+			created++;
+		}
+	}
+
+	return created;
+}
+
+static void benchmark( const std::string& root, Uint32 threads,
+					   const std::vector<std::string>& patterns ) {
+	std::shared_ptr<ThreadPool> pool = ThreadPool::createShared( threads );
+	ProjectDirectoryTree tree( root, pool );
+	std::promise<void> done;
+	size_t progressReports = 0;
+	Clock clock;
+
+	tree.scan( [&]( ProjectDirectoryTree& ) { done.set_value(); }, patterns, true,
+			   [&]( ProjectDirectoryTree& ) { progressReports++; } );
+	done.get_future().wait();
+
+	std::printf( "%8u %12.2f %10zu %12zu %10zu\n", threads,
+				 clock.getElapsedTime().asMilliseconds(), tree.getFilesCount(),
+				 tree.getDirectories().size(), progressReports );
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	size_t entries = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 500000;
+	std::string root( argc > 2 ? argv[2] : Sys::getTempPath() + "eepp-projectscan-bench" );
+	FileSystem::dirAddSlashAtEnd( root );
+	std::string stamp( root + ".entries" );
+	std::string generated;
+
+	FileSystem::fileGet( stamp, generated );
+
+	if ( generated != String::toString( entries ) ) {
+		Clock clock;
+		size_t created = generateTree( root, entries );
+		writeFile( stamp, String::toString( entries ) );
+		std::printf( "Generated %zu entries in %s in %.2fms\n", created, root.c_str(),
+					 clock.getElapsedTime().asMilliseconds() );
+	}
+
+	Uint32 cpus = eemax<Uint32>( 1, Sys::getCPUCount() );
+	std::vector<Uint32> threadCounts;
+	for ( Uint32 threads = 1; threads < eemax<Uint32>( cpus, 4 ); threads *= 2 )
+		threadCounts.push_back( threads );
+	threadCounts.push_back( eemax<Uint32>( cpus, 4 ) );
+
+	for ( auto& patterns :
+		  { std::vector<std::string>(), std::vector<std::string>{ "%.cpp$", "%.hpp$", "%.c$" } } ) {
+		std::printf( "Scan of %s, %s\n", root.c_str(),
+					 patterns.empty() ? "every file" : "only source files" );
+		std::printf( "%8s %12s %10s %12s %10s\n", "threads", "ms", "files", "directories",
+					 "progress" );
+		for ( auto threads : threadCounts )
+			benchmark( root, threads, patterns );
+	}
+
+	// Every keystroke refines the previous match, a new pattern scores every file again.
+	std::shared_ptr<ThreadPool> pool = ThreadPool::createShared( eemax<Uint32>( cpus, 2 ) );
+	ProjectDirectoryTree tree( root, pool );
+	std::promise<void> done;
+	tree.scan( [&]( ProjectDirectoryTree& ) { done.set_value(); } );
+	done.get_future().wait();
+
+	std::printf( "Fuzzy match of %zu files\n", tree.getFilesCount() );
+	std::printf( "%-16s %10s %10s\n", "pattern", "ms", "first" );
+	for ( const std::string& pattern : { std::string( "file_41.hpp" ), std::string( "rdmtxt" ) } ) {
+		for ( size_t length = 1; length <= pattern.size(); length++ ) {
+			Clock clock;
+			std::vector<size_t> matches( tree.fuzzyMatch( pattern.substr( 0, length ), 100 ) );
+			std::printf( "%-16s %10.2f %10s\n", pattern.substr( 0, length ).c_str(),
+						 clock.getElapsedTime().asMilliseconds(),
+						 matches.empty() ? "-"
+										 : FileSystem::fileNameFromPath(
+											   tree.getFiles()[matches[0]] )
+											   .c_str() );
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+#include "../../tools/codeeditor/projectsearch.hpp"
+#include "../../tools/codeeditor/projectsearchindex.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+#include <future>
+
+// Compares the latency of the project search reading every file against the search filtered by
+// the trigram index. The synthetic project is generated in the temporary directory the first time
+// ( it's reused while the number of files doesn't change ).
+// Usage: eepp-projectsearch-perf-test [files] [path]
+
+static const char* WORDS[] = { "int",   "return", "const", "void",  "auto",  "static", "struct",
+							   "class", "for",    "while", "if",    "else",  "std",    "vector",
+							   "size",  "begin",  "end",   "value", "count", "index",  "data" };
+
+static std::string generateFile( size_t seed, size_t lines ) {
+	const size_t wordsCount = sizeof( WORDS ) / sizeof( WORDS[0] );
+	std::string text;
+	size_t state = seed * 2654435761u + 1;
+	for ( size_t l = 0; l < lines; l++ ) {
+		text += "\t";
+		for ( size_t w = 0; w < 8; w++ ) {
+			state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+			text += WORDS[( state >> 33 ) % wordsCount];
+			text += w % 3 == 2 ? "_" + String::toString( ( state >> 40 ) % 1000 ) + " " : " ";
+		}
+		text += ";\n";
+	}
+	// A few files contain a rare identifier.
+	if ( seed % 97 == 0 )
+		text += "\tuniqueIdentifier_" + String::toString( seed ) + "();\n";
+	return text;
+}
+
+static std::vector<std::string> generateProject( const std::string& root, size_t count ) {
+	std::vector<std::string> files;
+	FileSystem::makeDir( root );
+	for ( size_t i = 0; i < count; i++ ) {
+		std::string dir( root + "dir_" + String::toString( i / 200 ) + "/" );
+		if ( i % 200 == 0 )
+			FileSystem::makeDir( dir );
+		files.push_back( dir + "file_" + String::toString( i ) + ".cpp" );
+	}
+	return files;
+}
+
+static void writeProject( const std::vector<std::string>& files ) {
+	for ( size_t i = 0; i < files.size(); i++ ) {
+		std::string text( generateFile( i, 200 ) );
+		FileSystem::fileWrite( files[i], (const Uint8*)text.c_str(), text.size() );
+	}
+}
+
+static std::shared_ptr<ProjectSearchIndex> buildIndex( const std::string& indexPath,
+													   const std::vector<std::string>& files,
+													   std::shared_ptr<ThreadPool> pool ) {
+	std::shared_ptr<ProjectSearchIndex> index(
+		std::make_shared<ProjectSearchIndex>( indexPath, pool ) );
+	std::promise<void> ready;
+	index->build( files, [&]( ProjectSearchIndex& ) { ready.set_value(); } );
+	ready.get_future().wait();
+	return index;
+}
+
+static void search( const char* name, const std::vector<std::string>& files,
+					const std::string& text, std::shared_ptr<ProjectSearchIndex> index ) {
+	Clock clock;
+	size_t matches = 0;
+	size_t filesMatched = 0;
+	ProjectSearch::find(
+		files, text,
+		[&]( const ProjectSearch::Result& res ) {
+			filesMatched = res.size();
+			for ( auto& file : res )
+				matches += file.results.size();
+		},
+		true, false, index );
+	double first = clock.getElapsedTime().asMilliseconds();
+	clock.restart();
+	ProjectSearch::find(
+		files, text, []( const ProjectSearch::Result& ) {}, true, false, index );
+	std::printf( "%-10s %-22s %10.2f %10.2f %8zu %8zu\n", name, text.c_str(), first,
+				 clock.getElapsedTime().asMilliseconds(), filesMatched, matches );
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	size_t count = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 20000;
+	std::string root( argc > 2 ? argv[2] : Sys::getTempPath() + "eepp-projectsearch-bench" );
+	FileSystem::dirAddSlashAtEnd( root );
+	std::string stamp( root + ".files" );
+	std::string indexPath( root + ".index" );
+	std::string generated;
+	std::vector<std::string> files( generateProject( root, count ) );
+
+	FileSystem::fileGet( stamp, generated );
+
+	if ( generated != String::toString( count ) ) {
+		Clock clock;
+		writeProject( files );
+		FileSystem::fileWrite( stamp, (const Uint8*)String::toString( count ).c_str(),
+							   String::toString( count ).size() );
+		std::printf( "Generated %zu files in %s in %.2fms\n", count, root.c_str(),
+					 clock.getElapsedTime().asMilliseconds() );
+	}
+
+	std::shared_ptr<ThreadPool> pool =
+		ThreadPool::createShared( eemax<Uint32>( 2, Sys::getCPUCount() ) );
+
+	FileSystem::fileRemove( indexPath );
+	Clock clock;
+	std::shared_ptr<ProjectSearchIndex> index( buildIndex( indexPath, files, pool ) );
+	std::printf( "Index built in %.2fms: %zu files, %zu trigrams, %.2f MiB on disk\n",
+				 clock.getElapsedTime().asMilliseconds(), index->getFilesCount(),
+				 index->getTrigramsCount(),
+				 FileSystem::fileSize( indexPath ) / ( 1024.0 * 1024.0 ) );
+
+	// Loading the saved index only needs to check the modification time of every file.
+	clock.restart();
+	index = buildIndex( indexPath, files, pool );
+	std::printf( "Index loaded and validated in %.2fms\n",
+				 clock.getElapsedTime().asMilliseconds() );
+
+	// A posting that runs past its data must discard the whole saved index.
+	std::string saved;
+	std::string corruptPath( root + ".corrupt" );
+	FileSystem::fileGet( indexPath, saved );
+	saved.back() = static_cast<char>( 0xFF );
+	FileSystem::fileWrite( corruptPath, (const Uint8*)saved.c_str(), saved.size() );
+	ProjectSearchIndex corrupt( corruptPath, pool );
+	bool corruptLoaded = corrupt.load();
+	FileSystem::fileRemove( corruptPath );
+	if ( corruptLoaded || corrupt.getFilesCount() != 0 || corrupt.getTrigramsCount() != 0 ) {
+		std::printf( "FAILED: a corrupt index was loaded\n" );
+		return EXIT_FAILURE;
+	}
+
+	std::printf( "%-10s %-22s %10s %10s %8s %8s\n", "search", "text", "first ms", "again ms",
+				 "files", "matches" );
+	for ( const char* text : { "uniqueIdentifier_970", "uniqueIdentifier", "vector_1", "return",
+							   "notInTheProject" } ) {
+		search( "files", files, text, nullptr );
+		search( "index", files, text, index );
+	}
+
+	// A single big file measures the throughput of the search itself.
+	std::string bigFile( root + "big.cpp" );
+	if ( FileSystem::fileSize( bigFile ) == 0 ) {
+		IOStreamFile big( bigFile, "wb" );
+		for ( size_t i = 0; i < 2000; i++ ) {
+			std::string text( generateFile( i, 500 ) );
+			big.write( text.c_str(), text.size() );
+		}
+	}
+	double size = FileSystem::fileSize( bigFile ) / ( 1024.0 * 1024.0 );
+	for ( bool caseSensitive : { true, false } ) {
+		Clock clock;
+		ProjectSearch::find(
+			{ bigFile }, "notInTheProject", []( const ProjectSearch::Result& ) {},
+			caseSensitive );
+		double ms = clock.getElapsedTime().asMilliseconds();
+		std::printf( "%.2f MiB file, %s: %.2fms, %.2f MiB/s\n", size,
+					 caseSensitive ? "case sensitive" : "case insensitive", ms,
+					 size / ( ms / 1000.0 ) );
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+#include <eepp/ui/doc/syntaxtokenizer.hpp>
+
+using namespace EE::UI::Doc;
+
+// Measures the SyntaxTokenizer throughput ( MB/s ) per language. The corpus of every language is
+// built from the files found in the path ( by default the eepp sources and assets ), repeated
+// until it reaches the requested size. The tokenizer is compared against a reference
+// implementation of the previous tokenizer, that built a LuaPattern for every pattern at every
+// position. The token count of both must match.
+// Usage: eepp-syntax-perf-test [path] [MB per language]
+
+typedef std::chrono::steady_clock BenchClock;
+
+struct Corpus {
+	const SyntaxDefinition* syntax;
+	std::vector<std::string> lines;
+	size_t bytes{ 0 };
+};
+
+static bool allSpaces( const std::string& str ) {
+	for ( auto& chr : str )
+		if ( ' ' != chr )
+			return false;
+	return true;
+}
+
+static void pushToken( std::vector<std::pair<std::string, std::string>>& tokens,
+					   const std::string& type, const std::string& text ) {
+	if ( !tokens.empty() && ( tokens.back().first == type || allSpaces( tokens.back().second ) ) ) {
+		tokens.back().first = type;
+		tokens.back().second += text;
+	} else {
+		tokens.push_back( { type, text } );
+	}
+}
+
+static bool isEscaped( const std::string& text, const size_t& startIndex,
+					   const std::string& escapeStr ) {
+	char escapeByte = escapeStr.empty() ? '\\' : escapeStr[0];
+	int count = 0;
+	for ( int i = startIndex - 1; i >= 0; i-- ) {
+		if ( text[i] != escapeByte )
+			break;
+		count++;
+	}
+	return count % 2 == 1;
+}
+
+static std::pair<int, int> findNonEscaped( const std::string& text, const std::string& pattern,
+										   int offset, const std::string& escapeStr ) {
+	while ( true ) {
+		LuaPattern words( pattern );
+		int start, end;
+		if ( words.find( text, start, end, offset ) ) {
+			if ( !escapeStr.empty() && isEscaped( text, start, escapeStr ) ) {
+				offset = end;
+			} else {
+				return std::make_pair( start, end );
+			}
+		} else {
+			return std::make_pair( -1, -1 );
+		}
+	}
+}
+
+// The tokenizer as it was before the patterns were precompiled.
+static std::pair<size_t, int> referenceTokenize( const SyntaxDefinition& syntax,
+												 const std::string& text, const int& state ) {
+	std::vector<std::pair<std::string, std::string>> tokens;
+	if ( syntax.getPatterns().empty() ) {
+		pushToken( tokens, "normal", text );
+		return std::make_pair( tokens.size(), SYNTAX_TOKENIZER_STATE_NONE );
+	}
+
+	size_t i = 0;
+	int retState = state;
+
+	while ( i < text.size() ) {
+		if ( retState != SYNTAX_TOKENIZER_STATE_NONE ) {
+			const SyntaxPattern& pattern = syntax.getPatterns()[retState];
+			std::pair<int, int> range =
+				findNonEscaped( text, pattern.patterns[1], i,
+								pattern.patterns.size() >= 3 ? pattern.patterns[2] : "" );
+			if ( range.first != -1 ) {
+				pushToken( tokens, pattern.type, text.substr( i, range.second - i ) );
+				retState = SYNTAX_TOKENIZER_STATE_NONE;
+				i = range.second;
+			} else {
+				pushToken( tokens, pattern.type, text.substr( i ) );
+				break;
+			}
+		}
+
+		bool matched = false;
+
+		for ( size_t patternIndex = 0; patternIndex < syntax.getPatterns().size();
+			  patternIndex++ ) {
+			const SyntaxPattern& pattern = syntax.getPatterns()[patternIndex];
+			if ( i != 0 && pattern.patterns[0][0] == '^' )
+				continue;
+			const std::string& patternStr(
+				pattern.patterns[0][0] == '^' ? pattern.patterns[0] : "^" + pattern.patterns[0] );
+			LuaPattern words( patternStr );
+			int start, end = 0;
+			if ( words.find( text, start, end, i ) && start != end ) {
+				if ( pattern.patterns.size() >= 3 && i > 0 &&
+					 text[i - 1] == pattern.patterns[2][0] )
+					continue;
+				std::string patternText( text.substr( start, end - start ) );
+				std::string type = syntax.getSymbol( patternText );
+				pushToken( tokens, type.empty() ? pattern.type : type, patternText );
+				if ( pattern.patterns.size() > 1 )
+					retState = patternIndex;
+				i = end;
+				matched = true;
+				break;
+			}
+		}
+
+		if ( !matched && i < text.size() ) {
+			pushToken( tokens, "normal", text.substr( i, 1 ) );
+			i += 1;
+		}
+	}
+
+	return std::make_pair( tokens.size(), retState );
+}
+
+static void collectFiles( const std::string& path, std::vector<std::string>& files ) {
+	for ( auto& name : FileSystem::filesGetInPath( path, true ) ) {
+		if ( name.empty() || name[0] == '.' )
+			continue;
+		std::string filePath( path + name );
+		if ( FileSystem::isDirectory( filePath ) ) {
+			collectFiles( filePath + FileSystem::getOSSlash(), files );
+		} else {
+			files.push_back( filePath );
+		}
+	}
+}
+
+static std::vector<Corpus> buildCorpora( const std::string& path, size_t bytesPerLanguage ) {
+	std::map<std::string, Corpus> corpora;
+	std::vector<std::string> files;
+	const SyntaxDefinition& plain = SyntaxDefinitionManager::instance()->getPlainStyle();
+
+	collectFiles( path, files );
+
+	for ( auto& file : files ) {
+		const SyntaxDefinition& syntax =
+			SyntaxDefinitionManager::instance()->getStyleByExtension( file );
+		if ( &syntax == &plain )
+			continue;
+
+		Corpus& corpus = corpora[syntax.getLanguageName()];
+		corpus.syntax = &syntax;
+		std::string data;
+		if ( corpus.bytes >= bytesPerLanguage || !FileSystem::fileGet( file, data ) )
+			continue;
+
+		for ( auto& line : String::split( data, '\n', true ) ) {
+			corpus.lines.push_back( line + "\n" );
+			corpus.bytes += line.size() + 1;
+		}
+	}
+
+	std::vector<Corpus> result;
+
+	for ( auto& it : corpora ) {
+		Corpus& corpus = it.second;
+		if ( corpus.lines.empty() )
+			continue;
+		size_t sourceLines = corpus.lines.size();
+		for ( size_t i = 0; corpus.bytes < bytesPerLanguage; i = ( i + 1 ) % sourceLines ) {
+			corpus.lines.push_back( corpus.lines[i] );
+			corpus.bytes += corpus.lines[i].size();
+		}
+		result.emplace_back( std::move( corpus ) );
+	}
+
+	return result;
+}
+
+static void benchmark( const Corpus& corpus ) {
+	const SyntaxDefinition& syntax = *corpus.syntax;
+	size_t tokens = 0;
+	size_t referenceTokens = 0;
+	int state = SYNTAX_TOKENIZER_STATE_NONE;
+	auto start = BenchClock::now();
+
+	for ( auto& line : corpus.lines ) {
+		auto res = SyntaxTokenizer::tokenize( syntax, line, state );
+		tokens += res.first.size();
+		state = res.second;
+	}
+
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+
+	state = SYNTAX_TOKENIZER_STATE_NONE;
+	start = BenchClock::now();
+
+	for ( auto& line : corpus.lines ) {
+		auto res = referenceTokenize( syntax, line, state );
+		referenceTokens += res.first;
+		state = res.second;
+	}
+
+	double referenceSeconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+	double mb = corpus.bytes / ( 1024. * 1024. );
+
+	std::printf( "%-16s %10zu %8.2f %12.2f %12.2f %8.2fx %s\n", syntax.getLanguageName().c_str(),
+				 corpus.lines.size(), mb, mb / referenceSeconds, mb / seconds,
+				 referenceSeconds / seconds, tokens == referenceTokens ? "ok" : "MISMATCH" );
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	std::string path( argc > 1 ? argv[1] : Sys::getProcessPath() + "../" );
+	size_t bytesPerLanguage =
+		( argc > 2 ? std::strtoul( argv[2], NULL, 10 ) : 4 ) * 1024 * 1024;
+	FileSystem::dirAddSlashAtEnd( path );
+
+	std::vector<Corpus> corpora( buildCorpora( path, bytesPerLanguage ) );
+
+	std::printf( "SyntaxTokenizer::tokenize: corpus from %s\n", path.c_str() );
+	std::printf( "%-16s %10s %8s %12s %12s %9s %s\n", "language", "lines", "MB", "before MB/s",
+				 "after MB/s", "speedup", "tokens" );
+
+	for ( auto& corpus : corpora )
+		benchmark( corpus );
+
+	return EXIT_SUCCESS;
+}
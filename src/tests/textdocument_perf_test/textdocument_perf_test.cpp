@@ -0,0 +1,170 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+#include <eepp/ui/doc/textdocument.hpp>
+#include <random>
+
+#if EE_PLATFORM == EE_PLATFORM_LINUX
+#include <unistd.h>
+#endif
+
+using namespace EE::UI::Doc;
+
+// Compares the TextDocument line storage against the previous layout, a single
+// std::vector<TextDocumentLine>: load time, resident memory and the latency of inserting and
+// removing lines at random positions. The document is loaded decoded in the line store blocks and
+// memory mapped, with the lines decoded on demand ( only the blocks touched by the edits are ).
+// The resident memory of the mapped document includes the pages of the file read while indexing.
+// The documents are kept alive until the end, so every measure only accounts its own memory.
+// Usage: eepp-textdocument-perf-test [lines] [edits]
+
+typedef std::chrono::steady_clock BenchClock;
+
+struct EditLatency {
+	double insertAvg{ 0 };
+	double insertMax{ 0 };
+	double eraseAvg{ 0 };
+	double eraseMax{ 0 };
+};
+
+static double elapsed( const BenchClock::time_point& start ) {
+	return std::chrono::duration<double, std::milli>( BenchClock::now() - start ).count();
+}
+
+static double getResidentMB() {
+#if EE_PLATFORM == EE_PLATFORM_LINUX
+	long pages = 0;
+	FILE* file = fopen( "/proc/self/statm", "r" );
+	if ( file ) {
+		if ( fscanf( file, "%*s %ld", &pages ) != 1 )
+			pages = 0;
+		fclose( file );
+	}
+	return pages * (double)sysconf( _SC_PAGESIZE ) / EE_1MB;
+#else
+	return 0;
+#endif
+}
+
+static std::string generateFile( size_t lines ) {
+	std::string path( Sys::getTempPath() + "eepp-textdocument-bench.log" );
+	IOStreamFile file( path, "wb" );
+	std::string line;
+
+	for ( size_t i = 0; i < lines; i++ ) {
+		line = "2020-06-01 12:" + String::toString( i % 60 ) + ":" + String::toString( i % 59 ) +
+			   ".000 [info] request " + String::toString( i ) + " served in " +
+			   String::toString( i % 97 ) + " ms from host-" + String::toString( i % 13 ) + "\n";
+		file.write( line.c_str(), line.size() );
+	}
+
+	return path;
+}
+
+static std::vector<TextDocumentLine> loadVector( const std::string& path ) {
+	std::vector<TextDocumentLine> lines;
+	std::string data;
+	FileSystem::fileGet( path, data );
+	size_t pos = 0;
+
+	while ( pos < data.size() ) {
+		size_t nl = data.find( '\n', pos );
+		size_t end = nl == std::string::npos ? data.size() : nl + 1;
+		lines.emplace_back( String::fromUtf8( data.substr( pos, end - pos ) ) );
+		pos = end;
+	}
+
+	return lines;
+}
+
+template <typename Lines>
+static EditLatency edit( Lines& lines, size_t edits, std::mt19937& rng,
+						 const std::function<void( Lines&, size_t )>& insert,
+						 const std::function<void( Lines&, size_t )>& erase ) {
+	EditLatency latency;
+
+	for ( size_t i = 0; i < edits; i++ ) {
+		size_t index = rng() % lines.size();
+		auto start = BenchClock::now();
+		insert( lines, index );
+		double time = elapsed( start ) * 1000;
+		latency.insertAvg += time / edits;
+		latency.insertMax = eemax( latency.insertMax, time );
+
+		index = rng() % lines.size();
+		start = BenchClock::now();
+		erase( lines, index );
+		time = elapsed( start ) * 1000;
+		latency.eraseAvg += time / edits;
+		latency.eraseMax = eemax( latency.eraseMax, time );
+	}
+
+	return latency;
+}
+
+static void print( const char* name, double loadTime, double memory, const EditLatency& latency ) {
+	std::printf( "%-16s %10.2f %10.2f %12.2f %12.2f %12.2f %12.2f\n", name, loadTime, memory,
+				 latency.insertAvg, latency.insertMax, latency.eraseAvg, latency.eraseMax );
+}
+
+static EditLatency editStore( TextDocument& doc, size_t edits, std::mt19937& rng ) {
+	return edit<TextDocumentLineStore>(
+		doc.lines(), edits, rng,
+		[]( TextDocumentLineStore& lines, size_t index ) {
+			lines.insert( index, TextDocumentLine( String( "inserted line\n" ) ) );
+		},
+		[]( TextDocumentLineStore& lines, size_t index ) { lines.erase( index ); } );
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	size_t lineCount = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 500000;
+	size_t edits = argc > 2 ? std::strtoul( argv[2], NULL, 10 ) : 500;
+	std::string path( generateFile( lineCount ) );
+	std::mt19937 rng( 42 );
+
+	std::printf( "%zu lines, %.2f MB, %zu random line inserts and removals\n", lineCount,
+				 FileSystem::fileSize( path ) / (double)EE_1MB, edits );
+	std::printf( "%-16s %10s %10s %12s %12s %12s %12s\n", "layout", "load ms", "RSS MB",
+				 "insert avg us", "insert max us", "erase avg us", "erase max us" );
+
+	double memory = getResidentMB();
+	auto start = BenchClock::now();
+	std::vector<TextDocumentLine> vector( loadVector( path ) );
+	double loadTime = elapsed( start );
+	memory = getResidentMB() - memory;
+	print( "vector", loadTime, memory,
+		   edit<std::vector<TextDocumentLine>>(
+			   vector, edits, rng,
+			   []( std::vector<TextDocumentLine>& lines, size_t index ) {
+				   lines.emplace( lines.begin() + index, String( "inserted line\n" ) );
+			   },
+			   []( std::vector<TextDocumentLine>& lines, size_t index ) {
+				   lines.erase( lines.begin() + index );
+			   } ) );
+
+	TextDocument blocks( false );
+	blocks.setLazyLoadingThreshold( 0 );
+	memory = getResidentMB();
+	start = BenchClock::now();
+	blocks.loadFromFile( path );
+	loadTime = elapsed( start );
+	memory = getResidentMB() - memory;
+	print( "blocks", loadTime, memory, editStore( blocks, edits, rng ) );
+
+	TextDocument mapped( false );
+	mapped.setLazyLoadingThreshold( 1 );
+	memory = getResidentMB();
+	start = BenchClock::now();
+	mapped.loadFromFile( path );
+	double firstScreen = elapsed( start );
+	mapped.finishIndexing();
+	loadTime = elapsed( start );
+	memory = getResidentMB() - memory;
+	print( "mapped", loadTime, memory, editStore( mapped, edits, rng ) );
+	std::printf( "mapped: first screen available in %.2f ms\n", firstScreen );
+
+	FileSystem::fileRemove( path );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <eepp/ee.hpp>
+
+// Measures the ThreadPool throughput ( tasks per second ) and the queue latency ( time from the
+// moment a task is queued until it starts running ) with several threads queueing work at the same
+// time, for pools from 1 to the number of CPUs.
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double percentile( std::vector<double>& values, double p ) {
+	if ( values.empty() )
+		return 0;
+	size_t index = eemin( values.size() - 1, static_cast<size_t>( values.size() * p ) );
+	std::nth_element( values.begin(), values.begin() + index, values.end() );
+	return values[index];
+}
+
+static void benchmark( Uint32 workers, Uint32 producers, size_t tasksPerProducer ) {
+	std::unique_ptr<ThreadPool> pool( ThreadPool::createUnique( workers ) );
+	size_t total = producers * tasksPerProducer;
+	std::vector<double> latencies( total );
+	std::atomic<size_t> done{ 0 };
+	std::atomic<Uint64> sink{ 0 };
+	auto start = BenchClock::now();
+
+	std::vector<std::unique_ptr<Thread>> threads;
+	for ( Uint32 p = 0; p < producers; p++ ) {
+		threads.emplace_back( std::make_unique<Thread>( [&, p] {
+			for ( size_t i = 0; i < tasksPerProducer; i++ ) {
+				size_t index = p * tasksPerProducer + i;
+				auto queued = BenchClock::now();
+				pool->run(
+					[&, index, queued] {
+						latencies[index] =
+							std::chrono::duration<double, std::micro>( BenchClock::now() - queued )
+								.count();
+						// A tiny amount of work per task.
+						Uint64 hash = index;
+						for ( int k = 0; k < 64; k++ )
+							hash = hash * 31 + k;
+						sink += hash;
+						done++;
+					},
+					nullptr,
+					i % 8 == 0 ? ThreadPool::Priority::Interactive
+							   : ThreadPool::Priority::Background );
+			}
+		} ) );
+		threads.back()->launch();
+	}
+
+	for ( auto& thread : threads )
+		thread->wait();
+
+	while ( done < total )
+		Sys::sleep( Milliseconds( 0.1f ) );
+
+	double seconds = std::chrono::duration<double>( BenchClock::now() - start ).count();
+
+	std::printf( "%7u %9u %14.0f %10.1f %10.1f %10.1f\n", workers, producers, total / seconds,
+				 percentile( latencies, 0.5 ), percentile( latencies, 0.99 ),
+				 percentile( latencies, 0.999 ) );
+}
+
+static void benchmarkParallelFor( Uint32 workers, size_t count ) {
+	std::unique_ptr<ThreadPool> pool( ThreadPool::createUnique( workers ) );
+	std::vector<Uint64> values( count );
+	auto start = BenchClock::now();
+	pool->parallelFor( 0, count, [&]( size_t begin, size_t end ) {
+		for ( size_t i = begin; i < end; i++ ) {
+			Uint64 hash = i;
+			for ( int k = 0; k < 32; k++ )
+				hash = hash * 31 + k;
+			values[i] = hash;
+		}
+	} );
+	double ms = std::chrono::duration<double, std::milli>( BenchClock::now() - start ).count();
+	std::printf( "%7u %14.2f\n", workers, ms );
+}
+
+EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	size_t tasks = argc > 1 ? std::strtoul( argv[1], NULL, 10 ) : 200000;
+	Uint32 cpus = eemax<Uint32>( 1, Sys::getCPUCount() );
+	std::vector<Uint32> workerCounts;
+	for ( Uint32 workers = 1; workers < cpus; workers *= 2 )
+		workerCounts.push_back( workers );
+	workerCounts.push_back( cpus );
+
+	std::printf( "ThreadPool run(): %zu tasks per producer\n", tasks );
+	std::printf( "%7s %9s %14s %10s %10s %10s\n", "workers", "producers", "tasks/s", "p50 us",
+				 "p99 us", "p99.9 us" );
+	for ( auto workers : workerCounts ) {
+		benchmark( workers, 1, tasks );
+		benchmark( workers, cpus, tasks / cpus );
+	}
+
+	std::printf( "\nThreadPool parallelFor(): %zu elements\n", tasks * 50 );
+	std::printf( "%7s %14s\n", "workers", "ms" );
+	for ( auto workers : workerCounts )
+		benchmarkParallelFor( workers, tasks * 50 );
+
+	return EXIT_SUCCESS;
+}
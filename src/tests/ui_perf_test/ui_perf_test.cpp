@@ -19,11 +19,12 @@ class TestModel : public Model {
 		}
 	};
 
-	size_t getRows() const { return 10000; }
+	size_t getRows() const { return mRows; }
 	size_t getCols() const { return 4; }
-	size_t getChilds() const { return 50; }
+	size_t getChilds() const { return mChilds; }
 
-	TestModel() : Model() {
+	TestModel( size_t rows = 10000, size_t childs = 50 ) :
+		Model(), mRows( rows ), mChilds( childs ) {
 		for ( size_t row = 0; row < getRows(); ++row ) {
 			NodeT* n = new NodeT();
 			n->parent = &mRoot;
@@ -54,6 +55,8 @@ class TestModel : public Model {
 
 	virtual size_t columnCount( const ModelIndex& = ModelIndex() ) const { return getCols(); }
 
+	size_t mRows;
+	size_t mChilds;
 	NodeT mRoot;
 	const NodeT& node( const ModelIndex& index ) const {
 		if ( !index.isValid() )
@@ -103,6 +106,163 @@ class TestModel : public Model {
 
 EE::Window::Window* win = NULL;
 
+// Measures the UITreeView with a tree of 1M nodes: expanding all of them, drawing while scrolling
+// and expanding / contracting a single node. Run with --tree-benchmark.
+static void treeBenchmark( UISceneNode* uiSceneNode ) {
+	Clock clock;
+	auto model = std::make_shared<TestModel>( 20000, 49 );
+	Log::notice( "Tree benchmark: model with %zu nodes created in %.2fms",
+				 model->getRows() * ( model->getChilds() + 1 ),
+				 clock.getElapsedTime().asMilliseconds() );
+
+	UITreeView* view = UITreeView::New();
+	view->setLayoutSizePolicy( SizePolicy::MatchParent, SizePolicy::MatchParent );
+	view->setParent( uiSceneNode->getRoot() );
+	clock.restart();
+	view->setModel( model );
+	SceneManager::instance()->update();
+	Log::notice( "Tree benchmark: setModel: %.2fms", clock.getElapsedTime().asMilliseconds() );
+
+	clock.restart();
+	view->expandAll();
+	SceneManager::instance()->update();
+	Log::notice( "Tree benchmark: expandAll: %.2fms", clock.getElapsedTime().asMilliseconds() );
+
+	const int frames = 200;
+	clock.restart();
+	for ( int i = 0; i < frames; i++ ) {
+		view->getVerticalScrollBar()->setValue( i / (Float)frames );
+		SceneManager::instance()->update();
+		win->clear();
+		SceneManager::instance()->draw();
+		win->display();
+	}
+	Log::notice( "Tree benchmark: scroll and draw: %.2fms per frame",
+				 clock.getElapsedTime().asMilliseconds() / frames );
+
+	ModelIndex index( model->index( model->getRows() / 2, 0, {} ) );
+	clock.restart();
+	for ( int i = 0; i < 100; i++ ) {
+		view->setExpanded( index, false );
+		view->setExpanded( index, true );
+	}
+	Log::notice( "Tree benchmark: contract and expand a node: %.2fms",
+				 clock.getElapsedTime().asMilliseconds() / 100 );
+
+	view->close();
+}
+
+// Measures the insertion of 20k widgets in nested layouts and the layout pass that follows it.
+// Run with --layout-benchmark.
+static void layoutBenchmark( UISceneNode* uiSceneNode ) {
+	const size_t rows = 200;
+	const size_t cols = 100;
+	Clock clock;
+	UILinearLayout* vlay = UILinearLayout::NewVertical();
+	vlay->setLayoutSizePolicy( SizePolicy::MatchParent, SizePolicy::MatchParent );
+	vlay->setParent( uiSceneNode->getRoot() );
+
+	for ( size_t row = 0; row < rows; row++ ) {
+		UILinearLayout* hlay = UILinearLayout::NewHorizontal();
+		hlay->setLayoutSizePolicy( SizePolicy::MatchParent, SizePolicy::WrapContent );
+		hlay->setParent( vlay );
+
+		for ( size_t col = 0; col < cols; col++ ) {
+			UIWidget* widget = UIWidget::New();
+			widget->setLayoutSizePolicy( SizePolicy::Fixed, SizePolicy::Fixed );
+			widget->setSize( Sizef( 4, 4 ) );
+			widget->setLayoutWeight( 1 );
+			widget->setParent( hlay );
+		}
+	}
+
+	Log::notice( "Layout benchmark: %zu widgets inserted in %.2fms", rows * cols,
+				 clock.getElapsedTime().asMilliseconds() );
+
+	clock.restart();
+	SceneManager::instance()->update();
+	Log::notice( "Layout benchmark: first update: %.2fms, layouts: %u in %.2fms",
+				 clock.getElapsedTime().asMilliseconds(), uiSceneNode->getLayoutUpdateCount(),
+				 uiSceneNode->getLayoutUpdateTime().asMilliseconds() );
+
+	const int frames = 100;
+	Time layoutTime;
+	clock.restart();
+	for ( int i = 0; i < frames; i++ ) {
+		vlay->setLayoutMargin( Rectf( i % 2, 0, 0, 0 ) );
+		SceneManager::instance()->update();
+		layoutTime += uiSceneNode->getLayoutUpdateTime();
+	}
+	Log::notice( "Layout benchmark: relayout: %.2fms per frame, layouts: %.2fms per frame",
+				 clock.getElapsedTime().asMilliseconds() / frames,
+				 layoutTime.asMilliseconds() / frames );
+
+	vlay->close();
+}
+
+static void drawFrame() {
+	SceneManager::instance()->update();
+	win->clear();
+	SceneManager::instance()->draw();
+	win->display();
+}
+
+// Checks that the children of a frame buffered window are drawn into its frame buffer while the
+// window is partly outside the screen: moves it to the left until its child is outside the
+// screen, invalidates the child and moves the window back. Run with --window-cull-test.
+static bool windowCullTest( UISceneNode* uiSceneNode ) {
+	UIWindow* window =
+		UIWindow::NewOpt( UIWindow::SIMPLE_LAYOUT,
+						  UIWindow::StyleConfig( UI_WIN_NO_DECORATION | UI_WIN_FRAME_BUFFER ) );
+	window->setParent( uiSceneNode->getRoot() );
+	window->setSize( 400, 300 );
+	window->setPosition( 200, 200 );
+	window->setEnabled( true );
+	window->setVisible( true );
+
+	UIWidget* child = UIWidget::New();
+	child->setBackgroundColor( Color::Red );
+	child->setParent( window->getContainer() );
+	child->setPosition( 10, 100 );
+	child->setSize( 50, 100 );
+
+	drawFrame();
+
+	// The child ends up outside the screen, but the frame buffer still needs it.
+	window->setPosition( -300, 200 );
+	child->setBackgroundColor( Color::Blue );
+	drawFrame();
+
+	auto childColor = [window, child]() -> Color {
+		Texture* texture = window->getFrameBuffer()->getTexture();
+		Sizef size( child->getPixelsSize() );
+		Vector2f center(
+			child->convertToWorldSpace( Vector2f( size.getWidth() / 2, size.getHeight() / 2 ) ) -
+			window->getScreenPos() );
+		texture->lock();
+		// The center of the child is at the same height in both orientations of the texture.
+		Color color( texture->getPixel( center.x, center.y ) );
+		texture->unlock();
+		return color;
+	};
+
+	Color offScreen( NULL != window->getFrameBuffer() ? childColor() : Color::Transparent );
+
+	window->setPosition( 200, 200 );
+	drawFrame();
+
+	Color onScreen( NULL != window->getFrameBuffer() ? childColor() : Color::Transparent );
+	bool passed = offScreen == Color::Blue && onScreen == Color::Blue;
+
+	Log::notice( "Window cull test: child color off screen: %s, back on screen: %s: %s",
+				 offScreen.toHexString().c_str(), onScreen.toHexString().c_str(),
+				 passed ? "passed" : "failed" );
+
+	window->close();
+
+	return passed;
+}
+
 void mainLoop() {
 	win->getInput()->update();
 
@@ -142,6 +302,7 @@ void mainLoop() {
 }
 
 EE_MAIN_FUNC int main( int argc, char* argv[] ) {
+	int exitCode = EXIT_SUCCESS;
 	win = Engine::instance()->createWindow( WindowSettings( 1024, 768, "eepp - UI Perf Test" ),
 											ContextSettings( true ) );
 
@@ -352,11 +513,25 @@ EE_MAIN_FUNC int main( int argc, char* argv[] ) {
 		drop->getListBox()->setSelected( 0 );
 		wind->show();*/
 
+		for ( int i = 1; i < argc; i++ ) {
+			if ( std::string( argv[i] ) == "--window-cull-test" ) {
+				if ( !windowCullTest( uiSceneNode ) )
+					exitCode = EXIT_FAILURE;
+				win->close();
+			} else if ( std::string( argv[i] ) == "--tree-benchmark" ) {
+				treeBenchmark( uiSceneNode );
+				win->close();
+			} else if ( std::string( argv[i] ) == "--layout-benchmark" ) {
+				layoutBenchmark( uiSceneNode );
+				win->close();
+			}
+		}
+
 		win->runMainLoop( &mainLoop );
 	}
 
 	Engine::destroySingleton();
 	MemoryManager::showResults();
 
-	return EXIT_SUCCESS;
+	return exitCode;
 }
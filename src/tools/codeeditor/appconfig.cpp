@@ -72,6 +72,7 @@ void AppConfig::load( std::string& confPath, std::string& keybindingsPath,
 	editor.linter = ini.getValueB( "editor", "linter", true );
 	editor.showDocInfo = ini.getValueB( "editor", "show_doc_info", true );
 	editor.hideTabBarOnSingleTab = ini.getValueB( "editor", "hide_tab_bar_on_single_tab", true );
+	workspace.searchIndex = ini.getValueB( "workspace", "search_index", true );
 }
 
 void AppConfig::save( const std::vector<std::string>& recentFiles,
@@ -117,6 +118,7 @@ void AppConfig::save( const std::vector<std::string>& recentFiles,
 	ini.setValueB( "editor", "linter", editor.linter );
 	ini.setValueB( "editor", "show_doc_info", editor.showDocInfo );
 	ini.setValueB( "editor", "hide_tab_bar_on_single_tab", editor.hideTabBarOnSingleTab );
+	ini.setValueB( "workspace", "search_index", workspace.searchIndex );
 	ini.writeFile();
 	iniState.writeFile();
 }
@@ -58,10 +58,15 @@ struct CodeEditorConfig {
 	int lineBreakingColumn{ 100 };
 };
 
+struct WorkspaceConfig {
+	bool searchIndex{ true };
+};
+
 struct AppConfig {
 	WindowConfig window;
 	CodeEditorConfig editor;
 	UIConfig ui;
+	WorkspaceConfig workspace;
 	IniFile ini;
 	IniFile iniState;
 
@@ -462,7 +462,7 @@ void AutoCompleteModule::updateSuggestions( const std::string& symbol, UICodeEdi
 #if AUTO_COMPLETE_THREADED
 		mPool->run(
 			[this, symbol, symbols, editor] { runUpdateSuggestions( symbol, symbols, editor ); },
-			[] {} );
+			[] {}, ThreadPool::Priority::Interactive );
 #else
 		runUpdateSuggestions( symbol, symbols, editor );
 #endif
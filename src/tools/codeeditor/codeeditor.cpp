@@ -474,7 +474,7 @@ void App::initLocateBar() {
 			Vector2f pos( mLocateInput->convertToWorldSpace( { 0, 0 } ) );
 			pos.y -= mLocateTable->getPixelsSize().getHeight();
 			mLocateTable->setPixelsPosition( pos );
-			if ( !mDirTreeReady )
+			if ( !mDirTree )
 				return;
 			updateLocateTable();
 		}
@@ -723,7 +723,8 @@ void App::initGlobalSearchBar() {
 	mGlobalSearchHistoryList =
 		mGlobalSearchBarLayout->find<UIDropDownList>( "global_search_history" );
 	mGlobalSearchBarLayout->addCommand( "search-in-files", [&, caseSensitiveChk, wholeWordChk] {
-		if ( mDirTree && mDirTree->getFilesCount() > 0 && !mGlobalSearchInput->getText().empty() ) {
+		if ( mDirTree && mDirTreeReady && mDirTree->getFilesCount() > 0 &&
+			 !mGlobalSearchInput->getText().empty() ) {
 			UILoader* loader = UILoader::New();
 			loader->setId( "loader" );
 			loader->setRadius( 48 );
@@ -777,7 +778,8 @@ void App::initGlobalSearchBar() {
 						loader->close();
 					} );
 				},
-				caseSensitiveChk->isChecked(), wholeWordChk->isChecked() );
+				caseSensitiveChk->isChecked(), wholeWordChk->isChecked(),
+				std::atomic_load( &mSearchIndex ) );
 		}
 	} );
 	mGlobalSearchBarLayout->addCommand( "close-global-searchbar", [&] {
@@ -965,6 +967,7 @@ App::App() : mThreadPool( ThreadPool::createShared( eemax<int>( 2, Sys::getCPUCo
 
 App::~App() {
 	saveConfig();
+	resetSearchIndex();
 	eeSAFE_DELETE( mEditorSplitter );
 	eeSAFE_DELETE( mAutoCompleteModule );
 	eeSAFE_DELETE( mLinterModule );
@@ -1813,6 +1816,7 @@ void App::onCodeEditorCreated( UICodeEditor* editor, TextDocument& doc ) {
 	editor->setEnableColorPickerOnSelection( config.colorPickerSelection );
 	editor->setColorPreview( config.colorPreview );
 	editor->setFont( mFontMono );
+	editor->getHighlighter()->setThreadPool( mThreadPool );
 	doc.setAutoCloseBrackets( !mConfig.editor.autoCloseBrackets.empty() );
 	doc.setAutoCloseBracketsPairs( makeAutoClosePairs( mConfig.editor.autoCloseBrackets ) );
 	doc.setAutoDetectIndentType( config.autoDetectIndentType );
@@ -2157,17 +2161,53 @@ void App::removeFolderWatches() {
 	}
 }
 
+void App::resetSearchIndex() {
+	std::shared_ptr<ProjectSearchIndex> index( std::atomic_load( &mSearchIndex ) );
+	if ( index ) {
+		index->cancel();
+		std::atomic_store( &mSearchIndex, std::shared_ptr<ProjectSearchIndex>() );
+	}
+}
+
+void App::loadSearchIndex( const std::string& path, const std::vector<std::string>& files ) {
+	resetSearchIndex();
+#if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
+	if ( !mConfig.workspace.searchIndex || mConfigPath.empty() )
+		return;
+	std::string indexDir( mConfigPath + "projects" );
+	if ( !FileSystem::fileExists( indexDir ) )
+		FileSystem::makeDir( indexDir );
+	FileSystem::dirAddSlashAtEnd( indexDir );
+	std::string indexPath( indexDir + MD5::fromString( path ).toHexString() + ".idx" );
+	Clock* clock = eeNew( Clock, () );
+	std::shared_ptr<ProjectSearchIndex> index(
+		std::make_shared<ProjectSearchIndex>( indexPath, mThreadPool ) );
+	std::atomic_store( &mSearchIndex, index );
+	index->build( files, [clock]( ProjectSearchIndex& index ) {
+		Log::info( "Search index updated in: %.2fms. Indexed %zu files.",
+				   clock->getElapsedTime().asMilliseconds(), index.getFilesCount() );
+		eeDelete( clock );
+	} );
+#endif
+}
+
 void App::loadDirTree( const std::string& path ) {
 	Clock* clock = eeNew( Clock, () );
+	mDirTreeReady = false;
+	resetSearchIndex();
 	mDirTree = std::make_unique<ProjectDirectoryTree>( path, mThreadPool );
 	Log::info( "Loading DirTree: %s", path.c_str() );
 	mDirTree->scan(
-		[&, clock]( ProjectDirectoryTree& dirTree ) {
+		[&, clock, path]( ProjectDirectoryTree& dirTree ) {
 			Log::info( "DirTree read in: %.2fms. Found %ld files.",
 					   clock->getElapsedTime().asMilliseconds(), dirTree.getFilesCount() );
 			eeDelete( clock );
 			mDirTreeReady = true;
-			mUISceneNode->runOnMainThread( [&] { updateLocateTable(); } );
+			std::vector<std::string> files( dirTree.getFiles() );
+			mUISceneNode->runOnMainThread( [&, path, files] {
+				updateLocateTable();
+				loadSearchIndex( path, files );
+			} );
 			if ( mFileWatcher ) {
 				removeFolderWatches();
 				auto newDirs = dirTree.getDirectories();
@@ -2175,7 +2215,14 @@ void App::loadDirTree( const std::string& path ) {
 					mFolderWatches.insert( mFileWatcher->addWatch( dir, mFileSystemListener ) );
 			}
 		},
-		SyntaxDefinitionManager::instance()->getExtensionsPatternsSupported() );
+		SyntaxDefinitionManager::instance()->getExtensionsPatternsSupported(), true,
+		[&]( ProjectDirectoryTree& ) {
+			// The locate bar shows the files found while the scan is still running.
+			mUISceneNode->runOnMainThread( [&] {
+				if ( mLocateTable && mLocateTable->isVisible() )
+					updateLocateTable();
+			} );
+		} );
 }
 
 void App::initProjectTreeView( const std::string& path ) {
@@ -2325,6 +2372,7 @@ void App::init( const std::string& file, const Float& pidelDensity ) {
 		PixelDensity::setPixelDensity( eemax( mWindow->getScale(), mConfig.window.pixelDensity ) );
 
 		mUISceneNode = UISceneNode::New();
+		mUISceneNode->setThreadPool( mThreadPool );
 
 		mFont = loadFont( "sans-serif", mConfig.ui.serifFont, "assets/fonts/NotoSans-Regular.ttf" );
 		mFontMono =
@@ -2585,6 +2633,21 @@ void App::init( const std::string& file, const Float& pidelDensity ) {
 #if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN
 		mFileWatcher = new efsw::FileWatcher();
 		mFileSystemListener = new FileSystemListener( mEditorSplitter );
+		mFileSystemListener->setFileChangeCallback( [&]( const std::string& path, bool removed ) {
+			if ( removed ) {
+				std::shared_ptr<ProjectSearchIndex> index( std::atomic_load( &mSearchIndex ) );
+				if ( index )
+					index->remove( path );
+				return;
+			}
+			// The files created after the scan are added to the tree, only the files of the
+			// project are indexed.
+			mUISceneNode->runOnMainThread( [&, path] {
+				std::shared_ptr<ProjectSearchIndex> index( std::atomic_load( &mSearchIndex ) );
+				if ( index && mDirTree && mDirTree->addFile( path ) )
+					index->update( path );
+			} );
+		} );
 		mFileWatcher->watch();
 #endif
 
@@ -5,6 +5,7 @@
 #include "filesystemlistener.hpp"
 #include "projectdirectorytree.hpp"
 #include "projectsearch.hpp"
+#include "projectsearchindex.hpp"
 #include "uitreeviewglobalsearch.hpp"
 #include <eepp/ee.hpp>
 #include <efsw/efsw.hpp>
@@ -198,6 +199,8 @@ class App : public UICodeEditorSplitter::Client {
 		mGlobalSearchHistory;
 	size_t mMenuIconSize;
 	bool mDirTreeReady{ false };
+	// Accessed with std::atomic_load since the file system listener updates it from its thread.
+	std::shared_ptr<ProjectSearchIndex> mSearchIndex;
 	std::unordered_set<Doc::TextDocument*> mTmpDocs;
 	std::string mCurrentProject;
 	FontTrueType* mFont{ nullptr };
@@ -215,6 +218,10 @@ class App : public UICodeEditorSplitter::Client {
 
 	void loadDirTree( const std::string& path );
 
+	void loadSearchIndex( const std::string& path, const std::vector<std::string>& files );
+
+	void resetSearchIndex();
+
 	void showSidePanel( bool show );
 
 	void onFileDropped( String file );
@@ -4,7 +4,23 @@ FileSystemListener::FileSystemListener( UICodeEditorSplitter* splitter ) : mSpli
 
 void FileSystemListener::handleFileAction( efsw::WatchID, const std::string& dir,
 										   const std::string& filename, efsw::Action action,
-										   std::string ) {
+										   std::string oldFilename ) {
+	if ( mFileChangeCallback ) {
+		switch ( action ) {
+			case efsw::Actions::Add:
+			case efsw::Actions::Modified:
+				mFileChangeCallback( dir + filename, false );
+				break;
+			case efsw::Actions::Delete:
+				mFileChangeCallback( dir + filename, true );
+				break;
+			case efsw::Actions::Moved:
+				mFileChangeCallback( dir + oldFilename, true );
+				mFileChangeCallback( dir + filename, false );
+				break;
+		}
+	}
+
 	if ( action == efsw::Actions::Modified ) {
 		FileInfo file( dir + filename );
 		if ( file.isLink() )
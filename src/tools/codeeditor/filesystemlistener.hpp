@@ -12,15 +12,23 @@ using namespace EE::UI::Tools;
 
 class FileSystemListener : public efsw::FileWatchListener {
   public:
+	/** Called from the watcher thread when a file is created, modified or removed. */
+	typedef std::function<void( const std::string& path, bool removed )> FileChangeCallback;
+
 	FileSystemListener( UICodeEditorSplitter* codeSplitter );
 
 	virtual ~FileSystemListener() {}
 
 	void handleFileAction( efsw::WatchID, const std::string& dir, const std::string& filename,
-						   efsw::Action action, std::string );
+						   efsw::Action action, std::string oldFilename );
+
+	void setFileChangeCallback( const FileChangeCallback& callback ) {
+		mFileChangeCallback = callback;
+	}
 
   protected:
 	UICodeEditorSplitter* mSplitter;
+	FileChangeCallback mFileChangeCallback;
 
 	bool isFileOpen( const FileInfo& file );
 
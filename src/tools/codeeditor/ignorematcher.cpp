@@ -11,11 +11,10 @@
 #define PATHSEP '/'
 #define CASE( c, caseInsensitive ) ( caseInsensitive ? std::tolower( c ) : ( c ) )
 
-bool gitignore_glob_match( const std::string& text, const std::string& glob,
-						   bool caseInsensitive = false ) {
+static bool gitignore_glob_match( const char* text, size_t n, const std::string& glob,
+								  bool caseInsensitive = false ) {
 	size_t i = 0;
 	size_t j = 0;
-	size_t n = text.size();
 	size_t m = glob.size();
 	size_t text1_backup = std::string::npos;
 	size_t glob1_backup = std::string::npos;
@@ -32,9 +31,12 @@ bool gitignore_glob_match( const std::string& text, const std::string& glob,
 			i++;
 		j++;
 	} else if ( glob.find( '/' ) == std::string::npos ) {
-		size_t sep = text.rfind( PATHSEP );
-		if ( sep != std::string::npos )
-			i = sep + 1;
+		for ( size_t sep = n; sep > 0; sep-- ) {
+			if ( text[sep - 1] == PATHSEP ) {
+				i = sep;
+				break;
+			}
+		}
 	}
 	while ( i < n ) {
 		if ( j < m ) {
@@ -160,57 +162,137 @@ bool GitIgnoreMatcher::parse() {
 	std::vector<std::string> patterns = String::split( patternFile );
 	for ( auto& pattern : patterns ) {
 		bool negates = false;
-		if ( pattern.empty() )
-			continue;
-		if ( pattern[0] == '#' )
-			continue;
-		pattern = String::rTrim( pattern, ' ' );
+		bool dirOnly = false;
 		pattern = String::rTrim( pattern, '\r' );
+		pattern = String::rTrim( pattern, ' ' );
+		if ( pattern.empty() || pattern[0] == '#' )
+			continue;
 		if ( pattern[0] == '!' ) {
 			negates = true;
 			pattern = String::lTrim( pattern, '!' );
-			mHasNegates = true;
 		}
-		pattern = String::rTrim( pattern, '/' );
-		mPatterns.emplace_back( std::make_pair( pattern, negates ) );
+		if ( pattern.back() == '/' ) {
+			dirOnly = true;
+			pattern = String::rTrim( pattern, '/' );
+		}
+		if ( !pattern.empty() )
+			addRule( pattern, negates, dirOnly );
 	}
-	mPatterns.emplace_back( std::make_pair( "/.git", false ) ); // Also ignore the .git folder
-	return !mPatterns.empty();
+	addRule( "/.git", false, false ); // Also ignore the .git folder
+	return mRulesCount > 0;
 }
 
-bool GitIgnoreMatcher::match( const std::string& value ) const {
-	for ( size_t i = 0; i < mPatterns.size(); i++ ) {
-		if ( gitignore_glob_match( value, mPatterns[i].first ) ) {
-			if ( mHasNegates ) {
-				for ( size_t n = i + 1; i < mPatterns.size(); i++ ) {
-					// Check if there's a positive negate after the match
-					if ( mPatterns[n].second && gitignore_glob_match( value, mPatterns[n].first ) )
-						return false;
-				}
+void GitIgnoreMatcher::addRule( std::string pattern, bool negates, bool dirOnly ) {
+	Rule rule{ pattern, mRulesCount++, negates, dirOnly };
+	bool isGlob = pattern.find_first_of( "*?[\\" ) != std::string::npos;
+
+	if ( !isGlob && pattern.find( '/' ) == std::string::npos ) {
+		mNames[pattern].emplace_back( std::move( rule ) );
+	} else if ( !isGlob ) {
+		// Patterns with a slash are relative to the directory of the .gitignore file.
+		mPaths[String::lTrim( pattern, '/' )].emplace_back( std::move( rule ) );
+	} else if ( pattern.size() > 2 && pattern[0] == '*' && pattern[1] == '.' &&
+				pattern.find_first_of( "*?[\\/", 1 ) == std::string::npos ) {
+		mSuffixes[pattern.substr( 1 )].emplace_back( std::move( rule ) );
+	} else {
+		mGlobs.emplace_back( std::move( rule ) );
+	}
+}
+
+IgnoreMatcher::Decision GitIgnoreMatcher::decide( const char* path, size_t size,
+												  bool isDir ) const {
+	const Rule* last = NULL;
+
+	// Keeps the last rule of the list that applies to the path, if it's after the current one.
+	auto consider = [&]( const RuleMap& map, const std::string& key ) {
+		auto it = map.find( key );
+		if ( it == map.end() )
+			return;
+		for ( auto rule = it->second.rbegin(); rule != it->second.rend(); ++rule ) {
+			if ( !rule->dirOnly || isDir ) {
+				if ( NULL == last || rule->index > last->index )
+					last = &*rule;
+				return;
 			}
-			return true;
+		}
+	};
+
+	size_t nameStart = size;
+	while ( nameStart > 0 && path[nameStart - 1] != '/' )
+		nameStart--;
+
+	if ( !mNames.empty() )
+		consider( mNames, std::string( path + nameStart, size - nameStart ) );
+
+	if ( !mPaths.empty() )
+		consider( mPaths, std::string( path, size ) );
+
+	if ( !mSuffixes.empty() ) {
+		for ( size_t i = nameStart; i < size; i++ ) {
+			if ( path[i] == '.' )
+				consider( mSuffixes, std::string( path + i, size - i ) );
 		}
 	}
-	return false;
+
+	for ( auto rule = mGlobs.rbegin(); rule != mGlobs.rend(); ++rule ) {
+		if ( NULL != last && rule->index < last->index )
+			break;
+		if ( ( !rule->dirOnly || isDir ) && gitignore_glob_match( path, size, rule->glob ) ) {
+			last = &*rule;
+			break;
+		}
+	}
+
+	if ( NULL == last )
+		return Decision::None;
+
+	return last->negates ? Decision::Include : Decision::Ignore;
 }
 
-IgnoreMatcherManager::IgnoreMatcherManager( std::string rootPath ) {
-	FileSystem::dirAddSlashAtEnd( rootPath );
-	GitIgnoreMatcher git( rootPath );
-	if ( git.canMatch() )
-		mMatcher = std::make_unique<GitIgnoreMatcher>( rootPath );
+IgnoreMatcherManager::IgnoreMatcherManager( std::string rootPath ) :
+	IgnoreMatcherManager( rootPath, nullptr ) {}
+
+IgnoreMatcherManager::IgnoreMatcherManager( std::string path,
+											std::shared_ptr<const IgnoreMatcherManager> parent ) :
+	mParent( parent ) {
+	FileSystem::dirAddSlashAtEnd( path );
+	mPath = path;
+	std::unique_ptr<GitIgnoreMatcher> git = std::make_unique<GitIgnoreMatcher>( path );
+	if ( git->canMatch() )
+		mMatcher = std::move( git );
 }
 
 bool IgnoreMatcherManager::foundMatch() const {
+	return mMatcher != nullptr || ( mParent && mParent->foundMatch() );
+}
+
+bool IgnoreMatcherManager::hasMatcher() const {
 	return mMatcher != nullptr;
 }
 
-bool IgnoreMatcherManager::match( const std::string& value ) const {
-	eeASSERT( foundMatch() );
-	return mMatcher->match( value );
+bool IgnoreMatcherManager::match( const std::string& value, bool isDir ) const {
+	return matchPath( mPath + value, isDir );
+}
+
+bool IgnoreMatcherManager::matchPath( const std::string& path, bool isDir ) const {
+	// The patterns of the deepest ignore file have precedence over the ones of its parents.
+	for ( const IgnoreMatcherManager* manager = this; NULL != manager;
+		  manager = manager->mParent.get() ) {
+		const std::string& base = manager->mPath;
+
+		if ( !manager->mMatcher || path.size() <= base.size() ||
+			 path.compare( 0, base.size(), base ) != 0 )
+			continue;
+
+		IgnoreMatcher::Decision decision = manager->mMatcher->decide(
+			path.c_str() + base.size(), path.size() - base.size(), isDir );
+
+		if ( IgnoreMatcher::Decision::None != decision )
+			return IgnoreMatcher::Decision::Ignore == decision;
+	}
+	return false;
 }
 
 const std::string& IgnoreMatcherManager::getPath() const {
-	eeASSERT( foundMatch() );
-	return mMatcher->getPath();
+	return mPath;
 }
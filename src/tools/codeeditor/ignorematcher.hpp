@@ -2,7 +2,9 @@
 #define EE_TOOLS_IGNOREMATCHER_HPP
 
 #include <eepp/system/filesystem.hpp>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using namespace EE;
@@ -10,13 +12,25 @@ using namespace EE::System;
 
 class IgnoreMatcher {
   public:
+	enum class Decision {
+		None,	//! No pattern matches the path.
+		Ignore, //! The last pattern matching the path ignores it.
+		Include //! The last pattern matching the path is a negation.
+	};
+
 	IgnoreMatcher( const std::string& rootPath );
 
 	virtual ~IgnoreMatcher();
 
 	virtual bool canMatch() = 0;
 
-	virtual bool match( const std::string& value ) const = 0;
+	/** @param path The path relative to the matcher path.
+	 * @param isDir If the path is a directory. */
+	virtual Decision decide( const char* path, size_t size, bool isDir ) const = 0;
+
+	bool match( const std::string& value, bool isDir = false ) const {
+		return Decision::Ignore == decide( value.c_str(), value.size(), isDir );
+	}
 
 	const std::string& getPath() const { return mPath; }
 
@@ -32,27 +46,58 @@ class GitIgnoreMatcher : public IgnoreMatcher {
 
 	bool canMatch() override;
 
-	bool match( const std::string& value ) const override;
+	Decision decide( const char* path, size_t size, bool isDir ) const override;
 
   protected:
+	struct Rule {
+		std::string glob;
+		size_t index;
+		bool negates;
+		bool dirOnly;
+	};
+
+	typedef std::unordered_map<std::string, std::vector<Rule>> RuleMap;
+
+	// The patterns are compiled by kind: literal names match the basename, "*.ext" patterns match
+	// the basename suffixes, anchored literal paths match the whole path and only the rest are
+	// matched as globs. The rules keep their order in the file since the last match wins.
+	RuleMap mNames;
+	RuleMap mSuffixes;
+	RuleMap mPaths;
+	std::vector<Rule> mGlobs;
+	size_t mRulesCount{ 0 };
+
 	bool parse() override;
 
-	std::vector<std::pair<std::string, bool>> mPatterns;
-	bool mHasNegates{false};
+	void addRule( std::string pattern, bool negates, bool dirOnly );
 };
 
 class IgnoreMatcherManager {
   public:
 	IgnoreMatcherManager( std::string rootPath );
 
+	/** Creates the matcher of a subdirectory, the patterns of the parent directories still apply
+	 * to the paths not matched by the patterns of the subdirectory. */
+	IgnoreMatcherManager( std::string path, std::shared_ptr<const IgnoreMatcherManager> parent );
+
+	/** @return If the directory or any of its parents has an ignore file. */
 	bool foundMatch() const;
 
-	bool match( const std::string& value ) const;
+	/** @return If the path ( relative to getPath() ) is ignored. */
+	bool match( const std::string& value, bool isDir = false ) const;
+
+	/** @return If the absolute path is ignored by this matcher or its parents. */
+	bool matchPath( const std::string& path, bool isDir ) const;
+
+	/** @return If the directory has its own ignore file. */
+	bool hasMatcher() const;
 
 	const std::string& getPath() const;
 
   protected:
+	std::string mPath;
 	std::unique_ptr<IgnoreMatcher> mMatcher;
+	std::shared_ptr<const IgnoreMatcherManager> mParent;
 };
 
 #endif // EE_TOOLS_IGNOREMATCHER_HPP
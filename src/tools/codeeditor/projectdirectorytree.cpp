@@ -1,87 +1,401 @@
 #include "projectdirectorytree.hpp"
 #include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <eepp/system/clock.hpp>
+#include <eepp/system/fileinfo.hpp>
 #include <eepp/system/filesystem.hpp>
+#include <eepp/system/lock.hpp>
 #include <eepp/system/luapattern.hpp>
+#include <mutex>
+#include <unordered_set>
+
+// The number of files scored by every task of a fuzzy match.
+#define FUZZY_MATCH_CHUNK_SIZE 16384
+
+// Folds only ASCII letters, as std::tolower does in the "C" locale.
+static inline char foldCase( char c ) {
+	return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+static std::string toLowerASCII( std::string str ) {
+	for ( auto& c : str )
+		c = foldCase( c );
+	return str;
+}
+
+// One bit per letter and digit, the rest of the characters share the remaining bits. A name can
+// only match a pattern if it contains every bit of the pattern.
+static Uint64 charactersMask( const std::string& lowerStr ) {
+	Uint64 mask = 0;
+	for ( auto c : lowerStr ) {
+		Uint8 ch = static_cast<Uint8>( c );
+		if ( ch >= 'a' && ch <= 'z' )
+			mask |= 1ULL << ( ch - 'a' );
+		else if ( ch >= '0' && ch <= '9' )
+			mask |= 1ULL << ( 26 + ch - '0' );
+		else if ( ch != ' ' )
+			mask |= 1ULL << ( 36 + ch % 28 );
+	}
+	return mask;
+}
+
+// String::fuzzyMatch with the lowercase strings precomputed, it returns the same scores.
+static int fuzzyScore( const char* str, const char* lowerStr, const char* ptn,
+					   const char* lowerPtn ) {
+	int score = 0;
+	int run = 0;
+	while ( *str && *ptn ) {
+		while ( *str == ' ' ) {
+			str++;
+			lowerStr++;
+		}
+		while ( *ptn == ' ' ) {
+			ptn++;
+			lowerPtn++;
+		}
+		if ( !*str )
+			break;
+		if ( *lowerStr == *lowerPtn ) {
+			score += run * 10 - ( *str != *ptn );
+			run++;
+			ptn++;
+			lowerPtn++;
+		} else {
+			score -= 10;
+			run = 0;
+		}
+		str++;
+		lowerStr++;
+	}
+	if ( *ptn )
+		return INT_MIN;
+	return score - static_cast<int>( strlen( str ) );
+}
+
+namespace {
+
+struct FuzzyMatch {
+	int score;
+	Uint32 index;
+};
+
+// The best scores first, the files found first win the ties.
+inline bool isBetterMatch( const FuzzyMatch& a, const FuzzyMatch& b ) {
+	return a.score > b.score || ( a.score == b.score && a.index < b.index );
+}
+
+} // namespace
+
+// The state shared by the tasks of a scan.
+struct ProjectDirectoryTree::ScanState {
+	ScanCompleteEvent scanComplete;
+	ScanProgressEvent scanProgress;
+	std::vector<std::string> acceptedPatterns;
+	bool ignoreHidden{ true };
+	// Directories queued or being scanned.
+	std::atomic<size_t> pending{ 0 };
+	std::atomic<bool> cancelled{ false };
+	// Guarded by mFilesMutex.
+	Clock progressClock;
+	std::mutex mutex;
+	std::condition_variable finishedCond;
+	bool finished{ false };
+	// The real paths of the directories scanned or queued, so a directory reached by several
+	// paths ( symbolic links ) is only scanned once. Guarded by mutex.
+	std::unordered_set<std::string> visited;
+};
 
 ProjectDirectoryTree::ProjectDirectoryTree( const std::string& path,
 											std::shared_ptr<ThreadPool> threadPool ) :
-	mPath( path ), mPool( threadPool ), mIsReady( false ), mIgnoreMatcher( path ) {
+	mPath( path ), mPool( threadPool ), mIsReady( false ) {
 	FileSystem::dirAddSlashAtEnd( mPath );
 }
 
+ProjectDirectoryTree::~ProjectDirectoryTree() {
+	if ( mScan ) {
+		mScan->cancelled = true;
+		std::unique_lock<std::mutex> lock( mScan->mutex );
+		mScan->finishedCond.wait( lock, [&] { return mScan->finished; } );
+	}
+}
+
 void ProjectDirectoryTree::scan( const ProjectDirectoryTree::ScanCompleteEvent& scanComplete,
 								 const std::vector<std::string>& acceptedPattern,
-								 const bool& ignoreHidden ) {
+								 const bool& ignoreHidden,
+								 const ProjectDirectoryTree::ScanProgressEvent& scanProgress ) {
+	mScan = std::make_shared<ScanState>();
+	mScan->scanComplete = scanComplete;
+	mScan->scanProgress = scanProgress;
+	mScan->acceptedPatterns = acceptedPattern;
+	mScan->ignoreHidden = ignoreHidden;
+	mScan->pending = 1;
+	{
+		std::string realPath( FileSystem::getRealPath( mPath ) );
+		FileSystem::dirAddSlashAtEnd( realPath );
+		mScan->visited.insert( realPath );
+	}
+	{
+		Lock l( mFilesMutex );
+		mDirectories.push_back( mPath );
+	}
+	queueDirectory( mScan, mPath, nullptr );
+}
+
+void ProjectDirectoryTree::queueDirectory(
+	std::shared_ptr<ScanState> state, std::string directory,
+	std::shared_ptr<const IgnoreMatcherManager> ignoreMatcher ) {
 #if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
-	mPool->run(
-		[&, acceptedPattern, ignoreHidden] {
+	mPool->run( [this, state, directory, ignoreMatcher] {
+		scanDirectory( state, directory, ignoreMatcher );
+	}, nullptr );
+#else
+	scanDirectory( state, directory, ignoreMatcher );
 #endif
-			Lock l( mFilesMutex );
-			mDirectories.push_back( mPath );
-			if ( !acceptedPattern.empty() ) {
-				std::vector<std::string> files;
-				std::vector<std::string> names;
-				std::vector<LuaPattern> patterns;
-				for ( auto& strPattern : acceptedPattern )
-					patterns.emplace_back( LuaPattern( strPattern ) );
-				std::set<std::string> info;
-				getDirectoryFiles( files, names, mPath, info, ignoreHidden, mIgnoreMatcher );
-				size_t namesCount = names.size();
-				bool found;
-				for ( size_t i = 0; i < namesCount; i++ ) {
-					found = false;
-					for ( auto& pattern : patterns ) {
-						if ( pattern.matches( names[i] ) ) {
-							found = true;
-							break;
-						}
-					}
-					if ( found ) {
-						mFiles.emplace_back( std::move( files[i] ) );
-						mNames.emplace_back( std::move( names[i] ) );
+}
+
+void ProjectDirectoryTree::scanDirectory(
+	std::shared_ptr<ScanState> state, const std::string& directory,
+	std::shared_ptr<const IgnoreMatcherManager> ignoreMatcher ) {
+	if ( !state->cancelled ) {
+		auto dirMatcher = std::make_shared<IgnoreMatcherManager>( directory, ignoreMatcher );
+		if ( dirMatcher->hasMatcher() )
+			ignoreMatcher = dirMatcher;
+
+		bool canIgnore = ignoreMatcher && ignoreMatcher->foundMatch();
+		std::vector<std::string> files;
+		std::vector<std::string> names;
+		std::vector<std::string> lowerNames;
+		std::vector<Uint64> nameMasks;
+		std::vector<std::string> directories;
+		// The real path of every directory, and the directories that are links, checked last.
+		std::vector<std::string> realDirectories;
+		std::vector<std::string> links;
+		std::vector<std::string> realLinks;
+		std::vector<LuaPattern> patterns;
+		std::vector<std::string> pathFiles =
+			FileSystem::filesGetInPath( directory, false, false, state->ignoreHidden );
+		std::string realDirectory;
+
+		for ( auto& file : pathFiles ) {
+			std::string fullpath( directory + file );
+			bool isDirectory = FileSystem::isDirectory( fullpath );
+
+			if ( canIgnore && ignoreMatcher->matchPath( fullpath, isDirectory ) )
+				continue;
+
+			if ( isDirectory ) {
+				FileInfo dirInfo( fullpath, true );
+				if ( realDirectory.empty() ) {
+					realDirectory = FileSystem::getRealPath( directory );
+					FileSystem::dirAddSlashAtEnd( realDirectory );
+				}
+				if ( dirInfo.isLink() ) {
+					// The links to the directory or any of its parents would be scanned forever.
+					std::string target( dirInfo.linksTo() );
+					FileSystem::dirAddSlashAtEnd( target );
+					if ( target.size() <= 1 || String::startsWith( realDirectory, target ) )
+						continue;
+					links.emplace_back( fullpath + FileSystem::getOSSlash() );
+					realLinks.emplace_back( std::move( target ) );
+				} else {
+					directories.emplace_back( fullpath + FileSystem::getOSSlash() );
+					realDirectories.emplace_back( realDirectory + file +
+												  FileSystem::getOSSlash() );
+				}
+				continue;
+			}
+
+			if ( !state->acceptedPatterns.empty() ) {
+				if ( patterns.empty() ) {
+					for ( auto& strPattern : state->acceptedPatterns )
+						patterns.emplace_back( LuaPattern( strPattern ) );
+				}
+
+				bool found = false;
+				for ( auto& pattern : patterns ) {
+					if ( pattern.matches( file ) ) {
+						found = true;
+						break;
 					}
 				}
-			} else {
-				std::set<std::string> info;
-				getDirectoryFiles( mFiles, mNames, mPath, info, ignoreHidden, mIgnoreMatcher );
+				if ( !found )
+					continue;
+			}
+
+			lowerNames.emplace_back( toLowerASCII( file ) );
+			nameMasks.emplace_back( charactersMask( lowerNames.back() ) );
+			files.emplace_back( std::move( fullpath ) );
+			names.emplace_back( std::move( file ) );
+		}
+
+		if ( !directories.empty() || !links.empty() ) {
+			// Only the directories not reached before are scanned. The real directories are
+			// checked first, so they're preferred over the links to them.
+			std::lock_guard<std::mutex> lock( state->mutex );
+			size_t count = 0;
+			for ( size_t i = 0; i < directories.size(); i++ ) {
+				if ( state->visited.insert( std::move( realDirectories[i] ) ).second ) {
+					if ( count != i )
+						directories[count] = std::move( directories[i] );
+					count++;
+				}
+			}
+			directories.resize( count );
+			for ( size_t i = 0; i < links.size(); i++ ) {
+				if ( state->visited.insert( std::move( realLinks[i] ) ).second )
+					directories.emplace_back( std::move( links[i] ) );
 			}
+		}
+
+		bool reportProgress = false;
+
+		if ( !files.empty() || !directories.empty() ) {
+			Lock l( mFilesMutex );
+			mFiles.insert( mFiles.end(), std::make_move_iterator( files.begin() ),
+						   std::make_move_iterator( files.end() ) );
+			mNames.insert( mNames.end(), std::make_move_iterator( names.begin() ),
+						   std::make_move_iterator( names.end() ) );
+			mLowerNames.insert( mLowerNames.end(), std::make_move_iterator( lowerNames.begin() ),
+								std::make_move_iterator( lowerNames.end() ) );
+			mNameMasks.insert( mNameMasks.end(), nameMasks.begin(), nameMasks.end() );
+			mDirectories.insert( mDirectories.end(), directories.begin(), directories.end() );
+
+			if ( state->scanProgress && !files.empty() &&
+				 state->progressClock.getElapsedTime() >= Milliseconds( 100 ) ) {
+				state->progressClock.restart();
+				reportProgress = true;
+			}
+		}
+
+		if ( reportProgress )
+			state->scanProgress( *this );
+
+		state->pending += directories.size();
+
+		for ( auto& dir : directories )
+			queueDirectory( state, std::move( dir ), ignoreMatcher );
+	}
+
+	if ( --state->pending == 0 ) {
+		if ( !state->cancelled ) {
 			mIsReady = true;
-#if EE_PLATFORM == EE_PLATFORM_EMSCRIPTEN && !defined( __EMSCRIPTEN_PTHREADS__ )
-			if ( scanComplete )
-				scanComplete( *this );
-#endif
-#if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
-		},
-		[scanComplete, this] {
-			if ( scanComplete )
-				scanComplete( *this );
-		} );
-#endif
+			if ( state->scanComplete )
+				state->scanComplete( *this );
+		}
+
+		std::lock_guard<std::mutex> lock( state->mutex );
+		state->finished = true;
+		state->finishedCond.notify_all();
+	}
+}
+
+std::vector<size_t> ProjectDirectoryTree::fuzzyMatch( const std::string& match,
+													  const size_t& max ) const {
+	std::string lowerMatch( toLowerASCII( match ) );
+	Uint64 matchMask = charactersMask( lowerMatch );
+	std::shared_ptr<const std::vector<Uint32>> candidates;
+	Lock l( mFilesMutex );
+	size_t count = mNames.size();
+
+	// A pattern that extends the previous one can only match the files the previous one matched.
+	{
+		std::lock_guard<std::mutex> lock( mFuzzyMutex );
+		if ( mFuzzyMatches && mFuzzyFilesCount == count && !mFuzzyPattern.empty() &&
+			 String::startsWith( match, mFuzzyPattern ) )
+			candidates = mFuzzyMatches;
+	}
+
+	size_t total = candidates ? candidates->size() : count;
+	std::mutex resultsMutex;
+	// The matches of every chunk, keyed by the chunk start to keep the files order.
+	typedef std::pair<size_t, std::vector<Uint32>> ChunkMatches;
+	std::vector<ChunkMatches> chunkMatches;
+	std::vector<FuzzyMatch> best;
+
+	auto scoreChunk = [&]( size_t begin, size_t end ) {
+		std::vector<Uint32> matches;
+		// A min-heap of the best max matches of the chunk.
+		std::vector<FuzzyMatch> heap;
+		for ( size_t i = begin; i < end; i++ ) {
+			Uint32 index = candidates ? ( *candidates )[i] : static_cast<Uint32>( i );
+			if ( ( mNameMasks[index] & matchMask ) != matchMask )
+				continue;
+			int score = fuzzyScore( mNames[index].c_str(), mLowerNames[index].c_str(),
+									match.c_str(), lowerMatch.c_str() );
+			if ( score == INT_MIN )
+				continue;
+			matches.push_back( index );
+			FuzzyMatch fuzzyMatch{ score, index };
+			if ( heap.size() < max ) {
+				heap.push_back( fuzzyMatch );
+				std::push_heap( heap.begin(), heap.end(), isBetterMatch );
+			} else if ( max > 0 && isBetterMatch( fuzzyMatch, heap.front() ) ) {
+				std::pop_heap( heap.begin(), heap.end(), isBetterMatch );
+				heap.back() = fuzzyMatch;
+				std::push_heap( heap.begin(), heap.end(), isBetterMatch );
+			}
+		}
+		std::lock_guard<std::mutex> lock( resultsMutex );
+		chunkMatches.emplace_back( begin, std::move( matches ) );
+		best.insert( best.end(), heap.begin(), heap.end() );
+	};
+
+	if ( total > FUZZY_MATCH_CHUNK_SIZE ) {
+		mPool->parallelFor( 0, total, scoreChunk, FUZZY_MATCH_CHUNK_SIZE,
+							ThreadPool::Priority::Interactive );
+	} else {
+		scoreChunk( 0, total );
+	}
+
+	std::sort( best.begin(), best.end(), isBetterMatch );
+	if ( best.size() > max )
+		best.resize( max );
+
+	std::sort( chunkMatches.begin(), chunkMatches.end(),
+			   []( const ChunkMatches& a, const ChunkMatches& b ) { return a.first < b.first; } );
+	std::shared_ptr<std::vector<Uint32>> allMatches( std::make_shared<std::vector<Uint32>>() );
+	for ( auto& chunk : chunkMatches )
+		allMatches->insert( allMatches->end(), chunk.second.begin(), chunk.second.end() );
+
+	{
+		std::lock_guard<std::mutex> lock( mFuzzyMutex );
+		mFuzzyPattern = match;
+		mFuzzyMatches = allMatches;
+		mFuzzyFilesCount = count;
+	}
+
+	std::vector<size_t> indices;
+	indices.reserve( best.size() );
+	for ( auto& fuzzyMatch : best )
+		indices.push_back( fuzzyMatch.index );
+	return indices;
 }
 
 std::shared_ptr<FileListModel> ProjectDirectoryTree::fuzzyMatchTree( const std::string& match,
 																	 const size_t& max ) const {
-	std::multimap<int, int, std::greater<int>> matchesMap;
+	std::vector<size_t> indices( fuzzyMatch( match, max ) );
 	std::vector<std::string> files;
 	std::vector<std::string> names;
-	for ( size_t i = 0; i < mNames.size(); i++ )
-		matchesMap.insert( { String::fuzzyMatch( mNames[i], match ), i } );
-	for ( auto& res : matchesMap ) {
-		if ( names.size() < max ) {
-			names.emplace_back( mNames[res.second] );
-			files.emplace_back( mFiles[res.second] );
-		}
+	files.reserve( indices.size() );
+	names.reserve( indices.size() );
+	Lock l( mFilesMutex );
+	for ( auto& index : indices ) {
+		names.emplace_back( mNames[index] );
+		files.emplace_back( mFiles[index] );
 	}
 	return std::make_shared<FileListModel>( files, names );
 }
 
 std::shared_ptr<FileListModel> ProjectDirectoryTree::matchTree( const std::string& match,
 																const size_t& max ) const {
+	Lock l( mFilesMutex );
 	std::vector<std::string> files;
 	std::vector<std::string> names;
-	std::string lowerMatch( String::toLower( match ) );
+	std::string lowerMatch( toLowerASCII( match ) );
 	for ( size_t i = 0; i < mNames.size(); i++ ) {
-		if ( String::toLower( mNames[i] ).find( lowerMatch ) != std::string::npos ) {
+		if ( mLowerNames[i].find( lowerMatch ) != std::string::npos ) {
 			names.emplace_back( mNames[i] );
 			files.emplace_back( mFiles[i] );
 			if ( max == names.size() )
@@ -93,15 +407,18 @@ std::shared_ptr<FileListModel> ProjectDirectoryTree::matchTree( const std::strin
 
 void ProjectDirectoryTree::asyncFuzzyMatchTree( const std::string& match, const size_t& max,
 												ProjectDirectoryTree::MatchResultCb res ) const {
-	mPool->run( [&, match, max, res]() { res( fuzzyMatchTree( match, max ) ); }, []() {} );
+	mPool->run( [&, match, max, res]() { res( fuzzyMatchTree( match, max ) ); }, []() {},
+				ThreadPool::Priority::Interactive );
 }
 
 void ProjectDirectoryTree::asyncMatchTree( const std::string& match, const size_t& max,
 										   ProjectDirectoryTree::MatchResultCb res ) const {
-	mPool->run( [&, match, max, res]() { res( matchTree( match, max ) ); }, []() {} );
+	mPool->run( [&, match, max, res]() { res( matchTree( match, max ) ); }, []() {},
+				ThreadPool::Priority::Interactive );
 }
 
 std::shared_ptr<FileListModel> ProjectDirectoryTree::asModel( const size_t& max ) const {
+	Lock l( mFilesMutex );
 	if ( mNames.empty() )
 		return std::make_shared<FileListModel>( std::vector<std::string>(),
 												std::vector<std::string>() );
@@ -116,6 +433,7 @@ std::shared_ptr<FileListModel> ProjectDirectoryTree::asModel( const size_t& max
 }
 
 size_t ProjectDirectoryTree::getFilesCount() const {
+	Lock l( mFilesMutex );
 	return mFiles.size();
 }
 
@@ -128,49 +446,72 @@ const std::vector<std::string>& ProjectDirectoryTree::getDirectories() const {
 }
 
 bool ProjectDirectoryTree::isFileInTree( const std::string& filePath ) const {
+	Lock l( mFilesMutex );
 	return std::find( mFiles.begin(), mFiles.end(), filePath ) != mFiles.end();
 }
 
 bool ProjectDirectoryTree::isDirInTree( const std::string& dirTree ) const {
 	std::string dir( FileSystem::fileRemoveFileName( dirTree ) );
 	FileSystem::dirAddSlashAtEnd( dir );
+	Lock l( mFilesMutex );
 	return std::find( mDirectories.begin(), mDirectories.end(), dirTree ) != mDirectories.end();
 }
 
-void ProjectDirectoryTree::getDirectoryFiles( std::vector<std::string>& files,
-											  std::vector<std::string>& names,
-											  std::string directory,
-											  std::set<std::string> currentDirs,
-											  const bool& ignoreHidden,
-											  const IgnoreMatcherManager& ignoreMatcher ) {
-	currentDirs.insert( directory );
-	std::string localDirPath( directory.substr(
-		ignoreMatcher.foundMatch() ? ignoreMatcher.getPath().size() : mPath.size() ) );
-	std::vector<std::string> pathFiles =
-		FileSystem::filesGetInPath( directory, false, false, ignoreHidden );
-	for ( auto& file : pathFiles ) {
-		std::string fullpath( directory + file );
-		std::string localpath( localDirPath + file );
-		if ( ignoreMatcher.foundMatch() && ignoreMatcher.match( localpath ) )
-			continue;
-		if ( FileSystem::isDirectory( fullpath ) ) {
-			fullpath += FileSystem::getOSSlash();
-			FileInfo dirInfo( fullpath, true );
-			if ( dirInfo.isLink() ) {
-				fullpath = dirInfo.linksTo();
-				FileSystem::dirAddSlashAtEnd( fullpath );
-				if ( currentDirs.find( fullpath ) == currentDirs.end() )
-					continue;
-				mDirectories.push_back( fullpath );
-			} else {
-				mDirectories.push_back( fullpath );
+bool ProjectDirectoryTree::addFile( const std::string& filePath ) {
+	if ( !mIsReady || !mScan )
+		return false;
+
+	std::string dir( FileSystem::fileRemoveFileName( filePath ) );
+	std::string file( FileSystem::fileNameFromPath( filePath ) );
+	FileSystem::dirAddSlashAtEnd( dir );
+
+	if ( isFileInTree( filePath ) )
+		return true;
+
+	if ( file.empty() || ( mScan->ignoreHidden && file[0] == '.' ) ||
+		 FileSystem::isDirectory( filePath ) )
+		return false;
+
+	{
+		Lock l( mFilesMutex );
+		if ( std::find( mDirectories.begin(), mDirectories.end(), dir ) == mDirectories.end() )
+			return false;
+	}
+
+	if ( !mScan->acceptedPatterns.empty() ) {
+		bool found = false;
+		for ( auto& strPattern : mScan->acceptedPatterns ) {
+			if ( LuaPattern( strPattern ).matches( file ) ) {
+				found = true;
+				break;
 			}
-			IgnoreMatcherManager dirMatcher( fullpath );
-			getDirectoryFiles( files, names, fullpath, currentDirs, ignoreHidden,
-							   dirMatcher.foundMatch() ? dirMatcher : ignoreMatcher );
-		} else {
-			files.emplace_back( fullpath );
-			names.emplace_back( file );
 		}
+		if ( !found )
+			return false;
 	}
+
+	// The ignore files from the root to the directory of the file, as the scan applies them.
+	std::shared_ptr<const IgnoreMatcherManager> ignoreMatcher;
+	for ( size_t pos = mPath.size() - 1; pos != std::string::npos && pos < dir.size();
+		  pos = dir.find_first_of( "/\\", pos + 1 ) ) {
+		auto dirMatcher =
+			std::make_shared<IgnoreMatcherManager>( dir.substr( 0, pos + 1 ), ignoreMatcher );
+		if ( dirMatcher->hasMatcher() )
+			ignoreMatcher = dirMatcher;
+	}
+
+	if ( ignoreMatcher && ignoreMatcher->matchPath( filePath, false ) )
+		return false;
+
+	std::string lowerName( toLowerASCII( file ) );
+	Lock l( mFilesMutex );
+	mNameMasks.emplace_back( charactersMask( lowerName ) );
+	mLowerNames.emplace_back( std::move( lowerName ) );
+	mFiles.emplace_back( filePath );
+	mNames.emplace_back( std::move( file ) );
+	return true;
+}
+
+bool ProjectDirectoryTree::isReady() const {
+	return mIsReady;
 }
@@ -2,13 +2,14 @@
 #define EE_TOOLS_PROJECTDIRECTORYTREE_HPP
 
 #include "ignorematcher.hpp"
+#include <atomic>
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/threadpool.hpp>
 #include <eepp/ui/models/model.hpp>
 #include <functional>
 #include <map>
 #include <memory>
-#include <set>
+#include <mutex>
 #include <string>
 
 using namespace EE;
@@ -46,13 +47,26 @@ class FileListModel : public Model {
 class ProjectDirectoryTree {
   public:
 	typedef std::function<void( ProjectDirectoryTree& dirTree )> ScanCompleteEvent;
+	typedef std::function<void( ProjectDirectoryTree& dirTree )> ScanProgressEvent;
 	typedef std::function<void( std::shared_ptr<FileListModel> )> MatchResultCb;
 
 	ProjectDirectoryTree( const std::string& path, std::shared_ptr<ThreadPool> threadPool );
 
+	/** Cancels the scan in progress and waits for its tasks to finish. */
+	~ProjectDirectoryTree();
+
+	/** Scans the directory tree. Every directory is listed by its own task of the thread pool,
+	 * the .gitignore files found in the tree apply to their directory and subdirectories.
+	 * @param scanProgress Called periodically from the worker threads while scanning, the files
+	 * found so far can already be matched. */
 	void scan( const ScanCompleteEvent& scanComplete,
 			   const std::vector<std::string>& acceptedPattern = {},
-			   const bool& ignoreHidden = true );
+			   const bool& ignoreHidden = true, const ScanProgressEvent& scanProgress = nullptr );
+
+	/** @return The indices of the best max files whose name fuzzy matches the pattern, the best
+	 * match first. The names are scored in parallel. When the pattern extends the previous one
+	 * only the files matched by the previous pattern are scored again. */
+	std::vector<size_t> fuzzyMatch( const std::string& match, const size_t& max ) const;
 
 	std::shared_ptr<FileListModel> fuzzyMatchTree( const std::string& match,
 												   const size_t& max ) const;
@@ -76,19 +90,40 @@ class ProjectDirectoryTree {
 
 	bool isDirInTree( const std::string& dirTree ) const;
 
+	/** Adds a file created after the scan, if the scan would have listed it: it must be inside
+	 * a directory of the tree, not hidden ( when hidden files are ignored ), not ignored and match
+	 * the accepted patterns.
+	 * @return If the file is part of the tree. */
+	bool addFile( const std::string& filePath );
+
+	/** @return If the scan finished. */
+	bool isReady() const;
+
   protected:
+	struct ScanState;
+
 	std::string mPath;
 	std::shared_ptr<ThreadPool> mPool;
 	std::vector<std::string> mFiles;
 	std::vector<std::string> mNames;
+	std::vector<std::string> mLowerNames;
+	// The characters contained by every name, to discard the names that can't match quickly.
+	std::vector<Uint64> mNameMasks;
 	std::vector<std::string> mDirectories;
-	bool mIsReady;
-	Mutex mFilesMutex;
-	IgnoreMatcherManager mIgnoreMatcher;
-
-	void getDirectoryFiles( std::vector<std::string>& files, std::vector<std::string>& names,
-							std::string directory, std::set<std::string> currentDirs,
-							const bool& ignoreHidden, const IgnoreMatcherManager& ignoreMatcher );
+	std::atomic<bool> mIsReady;
+	mutable Mutex mFilesMutex;
+	std::shared_ptr<ScanState> mScan;
+	// The files matched by the last fuzzy match pattern.
+	mutable std::mutex mFuzzyMutex;
+	mutable std::string mFuzzyPattern;
+	mutable std::shared_ptr<const std::vector<Uint32>> mFuzzyMatches;
+	mutable size_t mFuzzyFilesCount{ 0 };
+
+	void queueDirectory( std::shared_ptr<ScanState> state, std::string directory,
+						 std::shared_ptr<const IgnoreMatcherManager> ignoreMatcher );
+
+	void scanDirectory( std::shared_ptr<ScanState> state, const std::string& directory,
+						std::shared_ptr<const IgnoreMatcherManager> ignoreMatcher );
 };
 
 #endif // EE_TOOLS_PROJECTDIRECTORYTREE_HPP
@@ -1,100 +1,247 @@
 #include "projectsearch.hpp"
+#include "projectsearchindex.hpp"
+#include <cctype>
+#include <cstring>
 #include <eepp/system/filesystem.hpp>
+#include <eepp/system/iostreamfile.hpp>
+#include <eepp/system/iostreammappedfile.hpp>
 
-static int countNewLines( const std::string& text, const size_t& start, const size_t& end ) {
-	const char* startPtr = text.c_str() + start;
-	const char* endPtr = text.c_str() + end;
-	size_t count = 0;
-	if ( startPtr != endPtr ) {
-		count = *startPtr == '\n' ? 1 : 0;
-		while ( ++startPtr && startPtr != endPtr ) {
-			if ( '\n' == *startPtr )
-				count++;
-		};
-	}
-	return count;
+#if defined( __AVX2__ )
+#define PROJECT_SEARCH_AVX2
+#include <immintrin.h>
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || defined( _M_AMD64 ) || \
+	( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define PROJECT_SEARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#endif
+
+// Files bigger than this are memory mapped.
+#define SEARCH_MAP_MIN_SIZE ( 256 * 1024 )
+
+static inline Uint32 countBits( Uint32 value ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+	return __builtin_popcount( value );
+#else
+	value = value - ( ( value >> 1 ) & 0x55555555 );
+	value = ( value & 0x33333333 ) + ( ( value >> 2 ) & 0x33333333 );
+	return ( ( ( value + ( value >> 4 ) ) & 0x0F0F0F0F ) * 0x01010101 ) >> 24;
+#endif
 }
 
-static String textLine( const std::string& fileText, const size_t& fromPos, size_t& relCol ) {
-	size_t start = 0;
-	size_t end = 0;
-	const char* stringStartPtr = fileText.c_str();
-	const char* startPtr = fileText.c_str() + fromPos;
-	const char* ptr = startPtr;
-	while ( stringStartPtr != ptr && *--ptr != '\n' ) {
-	}
-	const char* nlStartPtr = ptr + 1;
-	start = ptr - stringStartPtr + 1;
-	ptr = startPtr;
-	while ( ++ptr && *ptr != '\0' && *ptr != '\n' ) {
+static inline Uint32 firstBit( Uint32 value ) {
+#if defined( __GNUC__ ) || defined( __clang__ )
+	return __builtin_ctz( value );
+#elif defined( _MSC_VER )
+	unsigned long index;
+	_BitScanForward( &index, value );
+	return index;
+#else
+	Uint32 index = 0;
+	while ( !( value & 1 ) ) {
+		value >>= 1;
+		index++;
 	}
-	end = ptr - stringStartPtr;
-	relCol = String( fileText.substr( start, startPtr - nlStartPtr ) ).size();
-	return fileText.substr( start, end - start );
+	return index;
+#endif
 }
 
-static std::vector<ProjectSearch::ResultData::Result>
-searchInFileHorspool( const std::string& file, const std::string& text, const bool& caseSensitive,
-					  const bool& wholeWord, const String::BMH::OccTable& occ ) {
-	std::vector<ProjectSearch::ResultData::Result> res;
-	std::string fileText;
-	Int64 lSearchRes = 0;
-	Int64 searchRes = 0;
-	size_t totNl = 0;
-	FileSystem::fileGet( file, fileText );
-	if ( !caseSensitive ) {
-		std::string fileTextOriginal( fileText );
-		String::toLowerInPlace( fileText );
-		do {
-			searchRes = String::BMH::find( fileText, text, searchRes, occ );
-			if ( searchRes != -1 ) {
-				if ( wholeWord && !String::isWholeWord( fileText, text, searchRes ) ) {
-					lSearchRes = searchRes;
-					searchRes += text.size();
-					continue;
-				}
-				TextPosition pos;
-				size_t relCol;
-				totNl += countNewLines( fileText, lSearchRes, searchRes );
-				String str( textLine( fileTextOriginal, searchRes, relCol ) );
-				pos.setLine( totNl );
-				pos.setColumn( relCol );
-				res.push_back( { str, pos } );
-				lSearchRes = searchRes;
-				searchRes += text.size();
+static inline char foldCase( char c ) {
+	return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+static inline bool isWordChar( char c ) {
+	return std::isalnum( static_cast<unsigned char>( c ) ) != 0;
+}
+
+namespace {
+
+// Finds every occurrence of a literal in a buffer and counts the lines in the same pass.
+// Blocks of the buffer are compared against the first and the last byte of the text, and only the
+// positions where both match are verified. The newlines of every block are counted from the same
+// loads. Case insensitive searches fold ASCII letters, as String::toLower did before.
+class TextMatcher {
+  public:
+	TextMatcher( const std::string& text, bool caseSensitive, bool wholeWord ) :
+		mText( text ), mCaseSensitive( caseSensitive ), mWholeWord( wholeWord ) {
+		if ( !caseSensitive )
+			for ( auto& c : mText )
+				c = foldCase( c );
+	}
+
+	// Calls onMatch( offset, line ) for every match, the matches don't overlap.
+	template <typename MatchCb> void find( const char* data, size_t size, MatchCb onMatch ) const {
+		const size_t len = mText.size();
+		if ( 0 == len || len > size )
+			return;
+		size_t i = 0;
+		size_t line = 0;
+		size_t next = 0;
+
+#if defined( PROJECT_SEARCH_AVX2 ) || defined( PROJECT_SEARCH_SSE2 )
+#if defined( PROJECT_SEARCH_AVX2 )
+		const size_t width = 32;
+		const __m256i first = _mm256_set1_epi8( mText[0] );
+		const __m256i last = _mm256_set1_epi8( mText[len - 1] );
+		const __m256i newLine = _mm256_set1_epi8( '\n' );
+		const __m256i upperBegin = _mm256_set1_epi8( 'A' - 1 );
+		const __m256i upperEnd = _mm256_set1_epi8( 'Z' + 1 );
+		const __m256i caseBit = _mm256_set1_epi8( 0x20 );
+		auto fold = [&]( __m256i block ) {
+			__m256i upper = _mm256_and_si256( _mm256_cmpgt_epi8( block, upperBegin ),
+											  _mm256_cmpgt_epi8( upperEnd, block ) );
+			return _mm256_or_si256( block, _mm256_and_si256( upper, caseBit ) );
+		};
+#else
+		const size_t width = 16;
+		const __m128i first = _mm_set1_epi8( mText[0] );
+		const __m128i last = _mm_set1_epi8( mText[len - 1] );
+		const __m128i newLine = _mm_set1_epi8( '\n' );
+		const __m128i upperBegin = _mm_set1_epi8( 'A' - 1 );
+		const __m128i upperEnd = _mm_set1_epi8( 'Z' + 1 );
+		const __m128i caseBit = _mm_set1_epi8( 0x20 );
+		auto fold = [&]( __m128i block ) {
+			__m128i upper = _mm_and_si128( _mm_cmpgt_epi8( block, upperBegin ),
+										   _mm_cmplt_epi8( block, upperEnd ) );
+			return _mm_or_si128( block, _mm_and_si128( upper, caseBit ) );
+		};
+#endif
+
+		for ( ; i + width + len - 1 <= size; i += width ) {
+#if defined( PROJECT_SEARCH_AVX2 )
+			__m256i blockFirst = _mm256_loadu_si256( (const __m256i*)( data + i ) );
+			__m256i blockLast = _mm256_loadu_si256( (const __m256i*)( data + i + len - 1 ) );
+			Uint32 lines = static_cast<Uint32>(
+				_mm256_movemask_epi8( _mm256_cmpeq_epi8( blockFirst, newLine ) ) );
+			if ( !mCaseSensitive ) {
+				blockFirst = fold( blockFirst );
+				blockLast = fold( blockLast );
 			}
-		} while ( searchRes != -1 );
-	} else {
-		do {
-			searchRes = String::BMH::find( fileText, text, searchRes, occ );
-			if ( searchRes != -1 ) {
-				if ( wholeWord && !String::isWholeWord( fileText, text, searchRes ) ) {
-					lSearchRes = searchRes;
-					searchRes += text.size();
-					continue;
+			Uint32 candidates = static_cast<Uint32>( _mm256_movemask_epi8(
+				_mm256_and_si256( _mm256_cmpeq_epi8( blockFirst, first ),
+								  _mm256_cmpeq_epi8( blockLast, last ) ) ) );
+#else
+			__m128i blockFirst = _mm_loadu_si128( (const __m128i*)( data + i ) );
+			__m128i blockLast = _mm_loadu_si128( (const __m128i*)( data + i + len - 1 ) );
+			Uint32 lines = _mm_movemask_epi8( _mm_cmpeq_epi8( blockFirst, newLine ) );
+			if ( !mCaseSensitive ) {
+				blockFirst = fold( blockFirst );
+				blockLast = fold( blockLast );
+			}
+			Uint32 candidates = _mm_movemask_epi8( _mm_and_si128(
+				_mm_cmpeq_epi8( blockFirst, first ), _mm_cmpeq_epi8( blockLast, last ) ) );
+#endif
+			while ( candidates ) {
+				Uint32 bit = firstBit( candidates );
+				size_t pos = i + bit;
+				candidates &= candidates - 1;
+				if ( pos >= next && matches( data, size, pos ) ) {
+					next = pos + len;
+					if ( !mWholeWord || isWholeWord( data, size, pos ) )
+						onMatch( pos, line + countBits( lines & ( ( 1u << bit ) - 1 ) ) );
 				}
-				TextPosition pos;
-				size_t relCol;
-				totNl += countNewLines( fileText, lSearchRes, searchRes );
-				std::string str = textLine( fileText, searchRes, relCol );
-				pos.setLine( totNl );
-				pos.setColumn( relCol );
-				res.push_back( { str, pos } );
-				lSearchRes = searchRes;
-				searchRes += text.size();
 			}
-		} while ( searchRes != -1 );
+			line += countBits( lines );
+		}
+#endif
+
+		for ( ; i + len <= size; i++ ) {
+			if ( i >= next && matches( data, size, i ) ) {
+				next = i + len;
+				if ( !mWholeWord || isWholeWord( data, size, i ) )
+					onMatch( i, line );
+			}
+			if ( data[i] == '\n' )
+				line++;
+		}
+	}
+
+  protected:
+	std::string mText;
+	bool mCaseSensitive;
+	bool mWholeWord;
+
+	bool matches( const char* data, size_t, size_t pos ) const {
+		const char* text = mText.c_str();
+		if ( mCaseSensitive )
+			return memcmp( data + pos, text, mText.size() ) == 0;
+		for ( size_t i = 0; i < mText.size(); i++ )
+			if ( foldCase( data[pos + i] ) != text[i] )
+				return false;
+		return true;
 	}
+
+	bool isWholeWord( const char* data, size_t size, size_t pos ) const {
+		return ( 0 == pos || !isWordChar( data[pos - 1] ) ) &&
+			   ( pos + mText.size() >= size || !isWordChar( data[pos + mText.size()] ) );
+	}
+};
+
+} // namespace
+
+static std::vector<ProjectSearch::ResultData::Result>
+searchInFile( const std::string& file, const TextMatcher& matcher ) {
+	std::vector<ProjectSearch::ResultData::Result> res;
+	// Big files are mapped, small files are cheaper to read into a buffer reused by the thread.
+	static thread_local std::vector<char> buffer;
+	std::unique_ptr<IOStreamMappedFile> mappedFile;
+	const char* data = NULL;
+	size_t size = 0;
+	{
+		IOStreamFile stream( file );
+		if ( !stream.isOpen() )
+			return res;
+		size = stream.getSize();
+		if ( size < SEARCH_MAP_MIN_SIZE ) {
+			buffer.resize( size );
+			size = stream.read( buffer.data(), size );
+			data = buffer.data();
+		}
+	}
+	if ( NULL == data ) {
+		mappedFile = std::make_unique<IOStreamMappedFile>( file );
+		if ( !mappedFile->isOpen() )
+			return res;
+		data = mappedFile->getData();
+		size = mappedFile->getSize();
+	}
+
+	size_t lineStart = 0;
+	size_t lineNum = std::string::npos;
+	String line;
+
+	matcher.find( data, size, [&]( size_t offset, size_t lineMatched ) {
+		// The line text is decoded once per line, even if it contains many matches.
+		if ( lineMatched != lineNum ) {
+			lineNum = lineMatched;
+			lineStart = offset;
+			while ( lineStart > 0 && data[lineStart - 1] != '\n' )
+				lineStart--;
+			const char* end =
+				static_cast<const char*>( memchr( data + offset, '\n', size - offset ) );
+			line = String::fromUtf8( data + lineStart, end ? end : data + size );
+		}
+		// The column is counted in code points.
+		size_t column = 0;
+		for ( size_t i = lineStart; i < offset; i++ )
+			if ( ( data[i] & 0xC0 ) != 0x80 )
+				column++;
+		res.push_back( { line, TextPosition( lineMatched, column ), offset } );
+	} );
+
 	return res;
 }
 
 void ProjectSearch::find( const std::vector<std::string> files, const std::string& string,
-						  ResultCb result, bool caseSensitive, bool wholeWord ) {
+						  ResultCb result, bool caseSensitive, bool wholeWord,
+						  std::shared_ptr<ProjectSearchIndex> index ) {
 	Result res;
-	const auto occ =
-		String::BMH::createOccTable( (const unsigned char*)string.c_str(), string.size() );
-	for ( auto& file : files ) {
-		auto fileRes = searchInFileHorspool( file, string, caseSensitive, wholeWord, occ );
+	TextMatcher matcher( string, caseSensitive, wholeWord );
+	for ( auto& file : index && index->isReady() ? index->filter( files, string ) : files ) {
+		auto fileRes = searchInFile( file, matcher );
 		if ( !fileRes.empty() )
 			res.push_back( { file, fileRes } );
 	}
@@ -108,21 +255,21 @@ struct FindData {
 	ProjectSearch::Result res;
 };
 
-void ProjectSearch::find( const std::vector<std::string> files, std::string string,
-						  std::shared_ptr<ThreadPool> pool, ResultCb result, bool caseSensitive,
-						  bool wholeWord ) {
-	if ( files.empty() )
+static void findInFiles( const std::vector<std::string>& files, const std::string& string,
+						 std::shared_ptr<ThreadPool> pool, ProjectSearch::ResultCb result,
+						 bool caseSensitive, bool wholeWord ) {
+	if ( files.empty() ) {
 		result( {} );
+		return;
+	}
 	FindData* findData = eeNew( FindData, () );
 	findData->resCount = files.size();
-	if ( !caseSensitive )
-		String::toLowerInPlace( string );
-	const auto occ =
-		String::BMH::createOccTable( (const unsigned char*)string.c_str(), string.size() );
+	std::shared_ptr<const TextMatcher> matcher(
+		std::make_shared<TextMatcher>( string, caseSensitive, wholeWord ) );
 	for ( auto& file : files ) {
 		pool->run(
-			[findData, file, string, caseSensitive, wholeWord, occ] {
-				auto fileRes = searchInFileHorspool( file, string, caseSensitive, wholeWord, occ );
+			[findData, file, matcher] {
+				auto fileRes = searchInFile( file, *matcher );
 				if ( !fileRes.empty() ) {
 					Lock l( findData->resMutex );
 					findData->res.push_back( { file, fileRes } );
@@ -142,3 +289,23 @@ void ProjectSearch::find( const std::vector<std::string> files, std::string stri
 			} );
 	}
 }
+
+void ProjectSearch::find( const std::vector<std::string> files, std::string string,
+						  std::shared_ptr<ThreadPool> pool, ResultCb result, bool caseSensitive,
+						  bool wholeWord, std::shared_ptr<ProjectSearchIndex> index ) {
+	if ( !caseSensitive )
+		String::toLowerInPlace( string );
+	// Only the files that contain every trigram of the text are read.
+	if ( index && index->isReady() && string.size() >= 3 ) {
+		std::shared_ptr<std::vector<std::string>> candidates =
+			std::make_shared<std::vector<std::string>>();
+		pool->run( [index, files, string, candidates] {
+					   *candidates = index->filter( files, string );
+				   },
+				   [candidates, string, pool, result, caseSensitive, wholeWord] {
+					   findInFiles( *candidates, string, pool, result, caseSensitive, wholeWord );
+				   } );
+		return;
+	}
+	findInFiles( files, string, pool, result, caseSensitive, wholeWord );
+}
@@ -14,13 +14,18 @@ using namespace EE::System;
 using namespace EE::UI::Doc;
 using namespace EE::UI::Models;
 
+class ProjectSearchIndex;
+
 class ProjectSearch {
   public:
 	struct ResultData {
 		struct Result {
-			Result( const String& line, const TextPosition& pos ) : line( line ), position( pos ) {}
+			Result( const String& line, const TextPosition& pos, Uint64 offset = 0 ) :
+				line( line ), position( pos ), offset( offset ) {}
 			String line;
 			TextPosition position;
+			/** The byte offset of the match in the file. */
+			Uint64 offset;
 		};
 		std::string file;
 		std::vector<Result> results;
@@ -125,12 +130,15 @@ class ProjectSearch {
 		return std::make_shared<ResultModel>( result );
 	}
 
+	/** Finds the text in the files. When an index is provided and ready only the files that can
+	 * contain the text are read. */
 	static void find( const std::vector<std::string> files, const std::string& string,
-					  ResultCb result, bool caseSensitive, bool wholeWord = false );
+					  ResultCb result, bool caseSensitive, bool wholeWord = false,
+					  std::shared_ptr<ProjectSearchIndex> index = nullptr );
 
 	static void find( const std::vector<std::string> files, std::string string,
 					  std::shared_ptr<ThreadPool> pool, ResultCb result, bool caseSensitive,
-					  bool wholeWord = false );
+					  bool wholeWord = false, std::shared_ptr<ProjectSearchIndex> index = nullptr );
 };
 
 #endif // PROJECTSEARCH_HPP
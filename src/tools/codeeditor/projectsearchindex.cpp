@@ -0,0 +1,480 @@
+#include "projectsearchindex.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <eepp/system/fileinfo.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/iostreamfile.hpp>
+#include <unordered_set>
+
+#define PROJECT_SEARCH_INDEX_MAGIC "EEPSIDX1"
+
+const Uint64 ProjectSearchIndex::MAX_FILE_SIZE = 16 * 1024 * 1024;
+
+static const Uint8* getFoldTable() {
+	static const std::array<Uint8, 256> table = [] {
+		std::array<Uint8, 256> fold;
+		for ( int i = 0; i < 256; i++ )
+			fold[i] = ( i >= 'A' && i <= 'Z' ) ? i - 'A' + 'a' : i;
+		return fold;
+	}();
+	return table.data();
+}
+
+static void writeVarint( std::vector<Uint8>& data, Uint32 value ) {
+	while ( value >= 0x80 ) {
+		data.push_back( static_cast<Uint8>( value | 0x80 ) );
+		value >>= 7;
+	}
+	data.push_back( static_cast<Uint8>( value ) );
+}
+
+static Uint32 readVarint( const Uint8*& ptr ) {
+	Uint32 value = 0;
+	int shift = 0;
+	while ( *ptr & 0x80 ) {
+		value |= static_cast<Uint32>( *ptr++ & 0x7F ) << shift;
+		shift += 7;
+	}
+	value |= static_cast<Uint32>( *ptr++ ) << shift;
+	return value;
+}
+
+static void decodePosting( const std::vector<Uint8>& data, Uint32 count,
+						   std::vector<Uint32>& ids ) {
+	const Uint8* ptr = data.data();
+	Uint32 id = 0;
+	ids.resize( count );
+	for ( Uint32 i = 0; i < count; i++ ) {
+		id += readVarint( ptr );
+		ids[i] = id;
+	}
+}
+
+/** Checks that a loaded posting decodes exactly count increasing ids of known files, ending in
+ * last, without reading past its data. */
+static bool isValidPosting( const std::vector<Uint8>& data, Uint32 count, Uint32 last,
+							size_t files ) {
+	const Uint8* ptr = data.data();
+	const Uint8* end = ptr + data.size();
+	Uint64 id = 0;
+	for ( Uint32 i = 0; i < count; i++ ) {
+		Uint64 delta = 0;
+		int shift = 0;
+		do {
+			if ( ptr == end || shift > 28 )
+				return false;
+			delta |= static_cast<Uint64>( *ptr & 0x7F ) << shift;
+			shift += 7;
+		} while ( *ptr++ & 0x80 );
+		if ( i > 0 && 0 == delta )
+			return false;
+		id += delta;
+		if ( id >= files )
+			return false;
+	}
+	return ptr == end && ( 0 == count || id == last );
+}
+
+ProjectSearchIndex::ProjectSearchIndex( const std::string& indexPath,
+										std::shared_ptr<ThreadPool> pool ) :
+	mIndexPath( indexPath ), mPool( pool ) {}
+
+ProjectSearchIndex::~ProjectSearchIndex() {
+	if ( mReady && mModified )
+		save();
+}
+
+void ProjectSearchIndex::cancel() {
+	mCancelled = true;
+}
+
+void ProjectSearchIndex::runTask( const std::function<void()>& task ) {
+	// The task keeps the index alive, so it's never destroyed while it's being updated.
+	std::shared_ptr<ProjectSearchIndex> self( shared_from_this() );
+#if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
+	mPool->run( [self, task] { task(); }, nullptr );
+#else
+	task();
+#endif
+}
+
+void ProjectSearchIndex::getTrigrams( const char* data, size_t size,
+									  std::vector<Uint32>& trigrams ) {
+	// One bit per possible trigram, cleared after every use.
+	static thread_local std::vector<Uint64> seen( ( 1 << 24 ) / 64 );
+	const Uint8* fold = getFoldTable();
+	const Uint8* text = reinterpret_cast<const Uint8*>( data );
+	trigrams.clear();
+	if ( size < 3 )
+		return;
+	Uint32 trigram = ( fold[text[0]] << 8 ) | fold[text[1]];
+	for ( size_t i = 2; i < size; i++ ) {
+		trigram = ( ( trigram << 8 ) | fold[text[i]] ) & 0xFFFFFF;
+		Uint64& word = seen[trigram >> 6];
+		Uint64 bit = 1ULL << ( trigram & 63 );
+		if ( !( word & bit ) ) {
+			word |= bit;
+			trigrams.push_back( trigram );
+		}
+	}
+	for ( auto& t : trigrams )
+		seen[t >> 6] = 0;
+}
+
+void ProjectSearchIndex::build( const std::vector<std::string>& files,
+								const ProjectSearchIndex::ReadyCb& onReady ) {
+	runTask( [this, files, onReady] {
+		if ( mFiles.empty() )
+			load();
+
+		mPool->parallelFor(
+			0, files.size(),
+			[&]( size_t begin, size_t end ) {
+				for ( size_t i = begin; i < end && !mCancelled; i++ ) {
+					FileInfo info( files[i] );
+					{
+						std::lock_guard<std::mutex> lock( mMutex );
+						auto it = mIds.find( files[i] );
+						if ( it != mIds.end() &&
+							 mFiles[it->second].modificationTime == info.getModificationTime() &&
+							 mFiles[it->second].size == info.getSize() )
+							continue;
+					}
+					if ( info.exists() && info.getSize() <= MAX_FILE_SIZE ) {
+						indexFile( files[i], info.getModificationTime(), info.getSize() );
+					} else {
+						remove( files[i] );
+					}
+				}
+			},
+			64, ThreadPool::Priority::Background );
+
+		if ( mCancelled )
+			return;
+
+		{
+			std::unordered_set<std::string> listed( files.begin(), files.end() );
+			std::lock_guard<std::mutex> lock( mMutex );
+			std::vector<std::string> removed;
+			for ( auto& id : mIds )
+				if ( listed.find( id.first ) == listed.end() &&
+					 mUpdated.find( id.first ) == mUpdated.end() )
+					removed.push_back( id.first );
+			mUpdated.clear();
+			for ( auto& path : removed )
+				removeFile( path );
+		}
+
+		if ( mModified )
+			save();
+
+		mReady = true;
+
+		if ( onReady )
+			onReady( *this );
+	} );
+}
+
+void ProjectSearchIndex::update( const std::string& path ) {
+	{
+		std::lock_guard<std::mutex> lock( mMutex );
+		removeFile( path );
+		// The build in progress only keeps the files of its list and the ones updated.
+		if ( !mReady )
+			mUpdated.insert( path );
+	}
+
+	runTask( [this, path] {
+		if ( mCancelled )
+			return;
+		FileInfo info( path );
+		if ( info.exists() && !info.isDirectory() && info.getSize() <= MAX_FILE_SIZE )
+			indexFile( path, info.getModificationTime(), info.getSize() );
+	} );
+}
+
+void ProjectSearchIndex::remove( const std::string& path ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	removeFile( path );
+}
+
+bool ProjectSearchIndex::isReady() const {
+	return mReady;
+}
+
+void ProjectSearchIndex::indexFile( const std::string& path, Uint64 modificationTime,
+									Uint64 size ) {
+	std::string data;
+	std::vector<Uint32> trigrams;
+	if ( !FileSystem::fileGet( path, data ) )
+		return;
+	getTrigrams( data.c_str(), data.size(), trigrams );
+	addFile( path, modificationTime, size, trigrams );
+}
+
+void ProjectSearchIndex::addFile( const std::string& path, Uint64 modificationTime, Uint64 size,
+								  const std::vector<Uint32>& trigrams ) {
+	std::lock_guard<std::mutex> lock( mMutex );
+	removeFile( path );
+
+	Uint32 id = static_cast<Uint32>( mFiles.size() );
+	mFiles.push_back( { path, modificationTime, size, false } );
+	mIds[path] = id;
+	mModified = true;
+
+	for ( auto& trigram : trigrams ) {
+		Posting& posting = mPostings[trigram];
+		writeVarint( posting.data, id - posting.last );
+		posting.last = id;
+		posting.count++;
+	}
+
+	if ( mDeletedCount > 1024 && mDeletedCount > mFiles.size() / 4 )
+		compact();
+}
+
+void ProjectSearchIndex::removeFile( const std::string& path ) {
+	auto it = mIds.find( path );
+	if ( it == mIds.end() )
+		return;
+	mFiles[it->second].deleted = true;
+	mDeletedCount++;
+	mIds.erase( it );
+	mModified = true;
+}
+
+void ProjectSearchIndex::compact() {
+	if ( 0 == mDeletedCount )
+		return;
+
+	std::vector<Uint32> remap( mFiles.size(), UINT32_MAX );
+	std::vector<FileEntry> files;
+	files.reserve( mFiles.size() - mDeletedCount );
+
+	for ( size_t i = 0; i < mFiles.size(); i++ ) {
+		if ( !mFiles[i].deleted ) {
+			remap[i] = static_cast<Uint32>( files.size() );
+			files.emplace_back( std::move( mFiles[i] ) );
+		}
+	}
+
+	std::vector<Uint32> ids;
+
+	for ( auto it = mPostings.begin(); it != mPostings.end(); ) {
+		Posting& posting = it->second;
+		decodePosting( posting.data, posting.count, ids );
+		posting.data.clear();
+		posting.last = 0;
+		posting.count = 0;
+		for ( auto& id : ids ) {
+			if ( remap[id] != UINT32_MAX ) {
+				writeVarint( posting.data, remap[id] - posting.last );
+				posting.last = remap[id];
+				posting.count++;
+			}
+		}
+		if ( 0 == posting.count ) {
+			it = mPostings.erase( it );
+		} else {
+			posting.data.shrink_to_fit();
+			++it;
+		}
+	}
+
+	mFiles = std::move( files );
+	mIds.clear();
+	for ( size_t i = 0; i < mFiles.size(); i++ )
+		mIds[mFiles[i].path] = static_cast<Uint32>( i );
+	mDeletedCount = 0;
+}
+
+void ProjectSearchIndex::clear() {
+	mFiles.clear();
+	mIds.clear();
+	mPostings.clear();
+	mDeletedCount = 0;
+}
+
+std::vector<std::string> ProjectSearchIndex::filter( const std::vector<std::string>& files,
+													 const std::string& text ) const {
+	std::vector<Uint32> trigrams;
+	getTrigrams( text.c_str(), text.size(), trigrams );
+
+	if ( trigrams.empty() || !mReady )
+		return files;
+
+	std::lock_guard<std::mutex> lock( mMutex );
+	std::vector<const Posting*> postings;
+	std::vector<Uint32> ids;
+
+	for ( auto& trigram : trigrams ) {
+		auto it = mPostings.find( trigram );
+		if ( it == mPostings.end() ) {
+			postings.clear();
+			break;
+		}
+		postings.push_back( &it->second );
+	}
+
+	// The shortest lists are intersected first.
+	std::sort( postings.begin(), postings.end(),
+			   []( const Posting* a, const Posting* b ) { return a->count < b->count; } );
+
+	if ( !postings.empty() ) {
+		std::vector<Uint32> other;
+		decodePosting( postings[0]->data, postings[0]->count, ids );
+		for ( size_t i = 1; i < postings.size() && !ids.empty(); i++ ) {
+			decodePosting( postings[i]->data, postings[i]->count, other );
+			ids.erase( std::set_intersection( ids.begin(), ids.end(), other.begin(), other.end(),
+											  ids.begin() ),
+					   ids.end() );
+		}
+	}
+
+	std::vector<bool> candidates( mFiles.size(), false );
+	for ( auto& id : ids )
+		if ( id < candidates.size() )
+			candidates[id] = true;
+
+	std::vector<std::string> res;
+	for ( auto& file : files ) {
+		auto it = mIds.find( file );
+		if ( it == mIds.end() || candidates[it->second] )
+			res.push_back( file );
+	}
+	return res;
+}
+
+size_t ProjectSearchIndex::getFilesCount() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mIds.size();
+}
+
+size_t ProjectSearchIndex::getTrigramsCount() const {
+	std::lock_guard<std::mutex> lock( mMutex );
+	return mPostings.size();
+}
+
+bool ProjectSearchIndex::save() {
+	std::lock_guard<std::mutex> lock( mMutex );
+	compact();
+
+	IOStreamFile file( mIndexPath + ".tmp", "wb" );
+	if ( !file.isOpen() )
+		return false;
+
+	auto write = [&file]( const void* data, size_t size ) {
+		file.write( static_cast<const char*>( data ), size );
+	};
+
+	Uint32 count = static_cast<Uint32>( mFiles.size() );
+	write( PROJECT_SEARCH_INDEX_MAGIC, 8 );
+	write( &count, sizeof( count ) );
+
+	for ( auto& entry : mFiles ) {
+		Uint32 length = static_cast<Uint32>( entry.path.size() );
+		write( &length, sizeof( length ) );
+		write( entry.path.c_str(), length );
+		write( &entry.modificationTime, sizeof( entry.modificationTime ) );
+		write( &entry.size, sizeof( entry.size ) );
+	}
+
+	count = static_cast<Uint32>( mPostings.size() );
+	write( &count, sizeof( count ) );
+
+	for ( auto& it : mPostings ) {
+		Uint32 bytes = static_cast<Uint32>( it.second.data.size() );
+		write( &it.first, sizeof( it.first ) );
+		write( &it.second.count, sizeof( it.second.count ) );
+		write( &it.second.last, sizeof( it.second.last ) );
+		write( &bytes, sizeof( bytes ) );
+		write( it.second.data.data(), bytes );
+	}
+
+	file.close();
+
+	// The previous index is replaced only once the new one is complete.
+	if ( std::rename( ( mIndexPath + ".tmp" ).c_str(), mIndexPath.c_str() ) != 0 )
+		return false;
+
+	mModified = false;
+	return true;
+}
+
+bool ProjectSearchIndex::load() {
+	std::string data;
+	if ( !FileSystem::fileGet( mIndexPath, data ) )
+		return false;
+
+	std::lock_guard<std::mutex> lock( mMutex );
+	const char* ptr = data.c_str();
+	const char* end = ptr + data.size();
+
+	auto read = [&]( void* value, size_t size ) {
+		if ( static_cast<size_t>( end - ptr ) < size )
+			return false;
+		memcpy( value, ptr, size );
+		ptr += size;
+		return true;
+	};
+
+	Uint32 count;
+	char magic[8];
+	if ( !read( magic, 8 ) || memcmp( magic, PROJECT_SEARCH_INDEX_MAGIC, 8 ) != 0 ||
+		 !read( &count, sizeof( count ) ) )
+		return false;
+
+	// Every file takes at least its path length, modification time and size.
+	if ( static_cast<size_t>( end - ptr ) / ( sizeof( Uint32 ) + 2 * sizeof( Uint64 ) ) < count )
+		return false;
+
+	clear();
+	mFiles.resize( count );
+
+	for ( Uint32 i = 0; i < count; i++ ) {
+		Uint32 length;
+		if ( !read( &length, sizeof( length ) ) || static_cast<size_t>( end - ptr ) < length ) {
+			clear();
+			return false;
+		}
+		mFiles[i].path.assign( ptr, length );
+		ptr += length;
+		mFiles[i].deleted = false;
+		if ( !read( &mFiles[i].modificationTime, sizeof( Uint64 ) ) ||
+			 !read( &mFiles[i].size, sizeof( Uint64 ) ) ) {
+			clear();
+			return false;
+		}
+		mIds[mFiles[i].path] = i;
+	}
+
+	if ( !read( &count, sizeof( count ) ) ) {
+		clear();
+		return false;
+	}
+
+	for ( Uint32 i = 0; i < count; i++ ) {
+		Uint32 trigram;
+		Uint32 bytes;
+		Posting posting;
+		if ( !read( &trigram, sizeof( trigram ) ) || !read( &posting.count, sizeof( Uint32 ) ) ||
+			 !read( &posting.last, sizeof( Uint32 ) ) || !read( &bytes, sizeof( bytes ) ) ||
+			 static_cast<size_t>( end - ptr ) < bytes || posting.last >= mFiles.size() ) {
+			clear();
+			return false;
+		}
+		posting.data.assign( ptr, ptr + bytes );
+		ptr += bytes;
+		if ( !isValidPosting( posting.data, posting.count, posting.last, mFiles.size() ) ) {
+			clear();
+			return false;
+		}
+		mPostings[trigram] = std::move( posting );
+	}
+
+	mModified = false;
+	return true;
+}
@@ -0,0 +1,115 @@
+#ifndef PROJECTSEARCHINDEX_HPP
+#define PROJECTSEARCHINDEX_HPP
+
+#include <atomic>
+#include <eepp/config.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace EE;
+using namespace EE::System;
+
+/** @brief A trigram index of the files of a project.
+**	Every file is indexed by the set of case-folded trigrams ( sequences of three bytes ) it
+**	contains. A search only needs to read the files that contain every trigram of the searched
+**	text. The index is saved to disk and, when loaded again, only the files modified since then are
+**	indexed again.
+**	The index must be owned by a std::shared_ptr, the tasks that update it keep it alive. */
+class ProjectSearchIndex : public std::enable_shared_from_this<ProjectSearchIndex> {
+  public:
+	typedef std::function<void( ProjectSearchIndex& )> ReadyCb;
+
+	/** @param indexPath The file where the index is saved. */
+	ProjectSearchIndex( const std::string& indexPath, std::shared_ptr<ThreadPool> pool );
+
+	/** Saves the index if it was modified. */
+	~ProjectSearchIndex();
+
+	/** Stops the build in progress, the index is not saved since it's incomplete. */
+	void cancel();
+
+	/** Loads the saved index and updates it in background: the new and modified files are
+	 * indexed, the files that are not in the list anymore are removed. The index is saved when
+	 * done. */
+	void build( const std::vector<std::string>& files, const ReadyCb& onReady = nullptr );
+
+	/** Indexes the file again in background, or removes it if it doesn't exist anymore. Until
+	 * then the file is treated as not indexed. A file that wasn't indexed yet ( i.e. a file
+	 * created after the build ) is added, the caller must only update the files of the project. */
+	void update( const std::string& path );
+
+	void remove( const std::string& path );
+
+	/** @return If the build finished. */
+	bool isReady() const;
+
+	/** @return The files of the list that can contain the text, ignoring the case. The files
+	 * that are not indexed are always returned. */
+	std::vector<std::string> filter( const std::vector<std::string>& files,
+									 const std::string& text ) const;
+
+	/** @return The number of files indexed. */
+	size_t getFilesCount() const;
+
+	size_t getTrigramsCount() const;
+
+	bool load();
+
+	bool save();
+
+	/** Files bigger than this are not indexed. */
+	static const Uint64 MAX_FILE_SIZE;
+
+  protected:
+	struct FileEntry {
+		std::string path;
+		Uint64 modificationTime;
+		Uint64 size;
+		bool deleted;
+	};
+
+	// The ids of the files that contain a trigram, delta and varint encoded.
+	struct Posting {
+		std::vector<Uint8> data;
+		Uint32 last{ 0 };
+		Uint32 count{ 0 };
+	};
+
+	std::string mIndexPath;
+	std::shared_ptr<ThreadPool> mPool;
+	mutable std::mutex mMutex;
+	// A file modified gets a new id, the old one is marked as deleted until the index is
+	// compacted.
+	std::vector<FileEntry> mFiles;
+	std::unordered_map<std::string, Uint32> mIds;
+	std::unordered_map<Uint32, Posting> mPostings;
+	// The files updated while the build is in progress.
+	std::unordered_set<std::string> mUpdated;
+	size_t mDeletedCount{ 0 };
+	bool mModified{ false };
+	std::atomic<bool> mReady{ false };
+	std::atomic<bool> mCancelled{ false };
+
+	static void getTrigrams( const char* data, size_t size, std::vector<Uint32>& trigrams );
+
+	void indexFile( const std::string& path, Uint64 modificationTime, Uint64 size );
+
+	void addFile( const std::string& path, Uint64 modificationTime, Uint64 size,
+				  const std::vector<Uint32>& trigrams );
+
+	void removeFile( const std::string& path );
+
+	void compact();
+
+	void clear();
+
+	void runTask( const std::function<void()>& task );
+};
+
+#endif // PROJECTSEARCHINDEX_HPP
@@ -56,11 +56,9 @@ UIPushButton* UITreeViewCellGlobalSearch::updateText( const std::string& text )
 		auto tokens =
 			SyntaxTokenizer::tokenize( styleDef, text, SYNTAX_TOKENIZER_STATE_NONE, to ).first;
 
-		size_t start = to;
 		for ( auto& token : tokens ) {
 			mTextBox->setFontFillColor( pp->getColorScheme().getSyntaxStyle( token.type ).color,
-										start, start + token.text.size() );
-			start += token.text.size();
+										token.start, token.start + token.len );
 		}
 	}
 	return this;